@@ -6,12 +6,21 @@
 
 #include "testbinhelper.h"
 
+#include "auxiliary/binfilehelper.h"
+
+#include <QDir>
+#include <QStandardPaths>
+
+#include <cstdio>
+#include <cstring>
+
 TestBinHelper::TestBinHelper(QObject *parent) : QObject(parent)
 {
 }
 
 void TestBinHelper::initTestCase()
 {
+    QStandardPaths::setTestModeEnabled(true);
 }
 
 void TestBinHelper::cleanupTestCase()
@@ -35,4 +44,40 @@ void TestBinHelper::testLoadBinary()
     QSKIP("Not implemented yet.");
 }
 
+void TestBinHelper::testMapFile()
+{
+    // The mapping gives the same bytes as reading the file, and the file handle stays usable.
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    QVERIFY(QDir().mkpath(dir));
+    QByteArray content;
+    for (int i = 0; i < 100000; i++)
+        content.append(static_cast<char>(i * 7));
+    QFile file(QDir(dir).filePath("testmapfile.dat"));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(content), static_cast<qint64>(content.size()));
+    file.close();
+
+    BinFileHelper helper;
+    QVERIFY(helper.mapFile() == nullptr);
+    QVERIFY(helper.openFile("testmapfile.dat") != nullptr);
+    const uchar *data = helper.mapFile();
+    QVERIFY(data != nullptr);
+    QCOMPARE(helper.getMappedData(), data);
+    QCOMPARE(helper.getMappedSize(), static_cast<qint64>(content.size()));
+    QVERIFY(memcmp(data, content.constData(), content.size()) == 0);
+    // Mapping again returns the same mapping.
+    QCOMPARE(helper.mapFile(), data);
+
+    char buffer[16];
+    QVERIFY(fseek(helper.getFileHandle(), 5000, SEEK_SET) == 0);
+    QCOMPARE(fread(buffer, 1, sizeof(buffer), helper.getFileHandle()), sizeof(buffer));
+    QVERIFY(memcmp(buffer, data + 5000, sizeof(buffer)) == 0);
+
+    helper.closeFile();
+    QVERIFY(helper.getMappedData() == nullptr);
+    QCOMPARE(helper.getMappedSize(), 0);
+
+    QVERIFY(file.remove());
+}
+
 QTEST_GUILESS_MAIN(TestBinHelper)
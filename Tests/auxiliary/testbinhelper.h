@@ -25,6 +25,8 @@ private slots:
 
     void testLoadBinary_data();
     void testLoadBinary();
+
+    void testMapFile();
 };
 
 #endif // TESTBINHELPER_H
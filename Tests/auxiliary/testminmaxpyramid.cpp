@@ -0,0 +1,90 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "testminmaxpyramid.h"
+
+#include "auxiliary/minmaxpyramid.h"
+
+#include <cmath>
+
+TestMinMaxPyramid::TestMinMaxPyramid() : QObject()
+{
+}
+
+void TestMinMaxPyramid::smallRanges()
+{
+    MinMaxPyramid pyramid;
+    for (int i = 0; i < 100; i++)
+        pyramid.append(i);
+    QCOMPARE(pyramid.size(), 100);
+
+    // Ranges of up to two samples per pixel are plotted as they are
+    QVector<int> indices;
+    pyramid.decimate(10, 50, 20, &indices);
+    QCOMPARE(indices.size(), 40);
+    QCOMPARE(indices.first(), 10);
+    QCOMPARE(indices.last(), 49);
+
+    // Out of bounds ranges are clipped
+    indices.clear();
+    pyramid.decimate(-5, 1000, 1000, &indices);
+    QCOMPARE(indices.size(), 100);
+
+    pyramid.clear();
+    QCOMPARE(pyramid.size(), 0);
+    indices.clear();
+    pyramid.decimate(0, 100, 10, &indices);
+    QVERIFY(indices.isEmpty());
+}
+
+void TestMinMaxPyramid::decimation_data()
+{
+    QTest::addColumn<int>("first");
+    QTest::addColumn<int>("last");
+    QTest::addColumn<int>("pixels");
+
+    QTest::newRow("whole series") << 0 << 200000 << 1000;
+    QTest::newRow("unaligned range") << 12345 << 187654 << 800;
+    QTest::newRow("narrow plot") << 3 << 150001 << 50;
+}
+
+void TestMinMaxPyramid::decimation()
+{
+    QFETCH(int, first);
+    QFETCH(int, last);
+    QFETCH(int, pixels);
+
+    // A slow wave with a few spikes and NaN gaps
+    constexpr int samples = 200000;
+    QVector<double> values(samples);
+    MinMaxPyramid pyramid;
+    for (int i = 0; i < samples; i++)
+    {
+        values[i] = std::sin(i * 0.0005) + (i % 9973 == 0 ? 5 : 0);
+        if (i % 20011 == 7)
+            values[i] = qQNaN();
+        pyramid.append(values[i]);
+    }
+
+    QVector<int> indices;
+    pyramid.decimate(first, last, pixels, &indices);
+
+    // A few points per pixel, in order, within the range
+    QVERIFY(indices.size() < 12 * pixels + 100);
+    QVERIFY(indices.first() >= first);
+    QVERIFY(indices.last() < last);
+    for (int i = 1; i < indices.size(); i++)
+        QVERIFY(indices[i] > indices[i - 1]);
+
+    // Every spike and every gap is kept
+    for (int i = first; i < last; i++)
+    {
+        if (std::isnan(values[i]) || values[i] > 2)
+            QVERIFY(indices.contains(i));
+    }
+}
+
+QTEST_GUILESS_MAIN(TestMinMaxPyramid)
@@ -0,0 +1,23 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QtTest>
+#include <QObject>
+
+class TestMinMaxPyramid : public QObject
+{
+        Q_OBJECT
+
+    public:
+        TestMinMaxPyramid();
+
+    private slots:
+        void smallRanges();
+        void decimation_data();
+        void decimation();
+};
@@ -0,0 +1,117 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "testobservabilityengine.h"
+
+#include "auxiliary/observabilityengine.h"
+#include "auxiliary/geolocation.h"
+#include "ksnumbers.h"
+#include "skyobjects/skypoint.h"
+
+TestObservabilityEngine::TestObservabilityEngine() : QObject()
+{
+}
+
+void TestObservabilityEngine::compareWithSkyPoint_data()
+{
+    QTest::addColumn<double>("ra");
+    QTest::addColumn<double>("dec");
+    QTest::addColumn<double>("latitude");
+
+    QTest::newRow("M31 from 40N") << 10.6847 << 41.2690 << 40.0;
+    QTest::newRow("M42 from 40N") << 83.8221 << -5.3911 << 40.0;
+    QTest::newRow("Polaris from 40N") << 37.9546 << 89.2641 << 40.0;
+    QTest::newRow("M42 from 33S") << 83.8221 << -5.3911 << -33.0;
+    QTest::newRow("47 Tuc from 33S") << 6.0236 << -72.0813 << -33.0;
+}
+
+void TestObservabilityEngine::compareWithSkyPoint()
+{
+    QFETCH(double, ra);
+    QFETCH(double, dec);
+    QFETCH(double, latitude);
+
+    const GeoLocation geo(dms(2.35), dms(latitude));
+    const KStarsDateTime start(QDate(2022, 10, 1), QTime(18, 0), Qt::UTC);
+    const KStarsDateTime end = start.addSecs(12 * 3600.0);
+
+    ObservabilityEngine engine(&geo, start, end, 3600);
+    QCOMPARE(engine.sampleCount(), 12);
+
+    const ObservabilityEngine::Visibility visibility = engine.evaluate({ ra, dec, true }, { 15, 90 });
+
+    // The engine brings the target to the middle of the night, SkyPoint to each instant
+    int samples = 0;
+    double maxAltitude = -90;
+    for (int i = 0; i < engine.sampleCount(); i++)
+    {
+        const KStarsDateTime t = engine.time(i);
+        KSNumbers num(t.djd());
+        SkyPoint p(ra / 15.0, dec);
+        p.updateCoordsNow(&num);
+        const CachingDms LST(geo.GSTtoLST(t.gst()));
+        p.EquatorialToHorizontal(&LST, geo.lat());
+
+        if (i == 0)
+        {
+            QVERIFY(std::abs(visibility.startAltitude - p.alt().Degrees()) < 0.01);
+            double deltaAz = std::abs(visibility.startAzimuth - p.az().Degrees());
+            deltaAz = std::min(deltaAz, 360 - deltaAz);
+            // Azimuth is meaningless close to the zenith
+            if (p.alt().Degrees() < 85)
+                QVERIFY(deltaAz < 0.05);
+        }
+        if (p.alt().Degrees() >= 15 + 0.01)
+            samples++;
+        maxAltitude = std::max(maxAltitude, p.alt().Degrees());
+    }
+
+    QVERIFY(std::abs(visibility.samples - samples) <= 1);
+    QVERIFY(std::abs(visibility.maxAltitude - maxAltitude) < 0.01);
+}
+
+void TestObservabilityEngine::windows()
+{
+    const GeoLocation geo(dms(0), dms(45));
+    const KStarsDateTime start(QDate(2022, 3, 20), QTime(0, 0), Qt::UTC);
+
+    // A day by steps of 10 minutes, a target on the equator is up for about half of it
+    ObservabilityEngine engine(&geo, start, start.addSecs(24 * 3600.0), 600);
+    QCOMPARE(engine.sampleCount(), 144);
+    QCOMPARE(engine.time(6).djd(), start.addSecs(3600.0).djd());
+
+    const QVector<ObservabilityEngine::Position> positions { { 0, 0, false }, { 180, 0, false }, { 0, -60, false } };
+    const auto results = engine.evaluate(positions, { 0, 90 });
+    QCOMPARE(results.size(), 3);
+
+    for (int i = 0; i < 2; i++)
+    {
+        QVERIFY(std::abs(results[i].samples - 72) <= 2);
+        int total = 0;
+        for (const auto &window : results[i].windows)
+        {
+            QVERIFY(window.first <= window.last);
+            total += window.last - window.first + 1;
+        }
+        QCOMPARE(total, results[i].samples);
+        QVERIFY(std::abs(results[i].maxAltitude - 45) < 0.5);
+    }
+
+    // Never rises above 45N
+    QCOMPARE(results[2].samples, 0);
+    QVERIFY(results[2].windows.isEmpty());
+    QVERIFY(results[2].maxAltitude < 0);
+
+    // The same objects evaluated one by one, and in batches
+    QVector<ObservabilityEngine::Position> many;
+    for (int i = 0; i < 1000; i++)
+        many.append({ i * 0.36, -60 + i * 0.15, false });
+    const auto batch = engine.evaluate(many, { 20, 70 });
+    for (int i = 0; i < many.size(); i += 97)
+        QCOMPARE(batch[i].samples, engine.evaluate(many[i], { 20, 70 }).samples);
+}
+
+QTEST_GUILESS_MAIN(TestObservabilityEngine)
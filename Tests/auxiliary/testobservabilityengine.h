@@ -0,0 +1,23 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QtTest>
+#include <QObject>
+
+class TestObservabilityEngine : public QObject
+{
+        Q_OBJECT
+
+    public:
+        TestObservabilityEngine();
+
+    private slots:
+        void compareWithSkyPoint_data();
+        void compareWithSkyPoint();
+        void windows();
+};
@@ -0,0 +1,239 @@
+/*
+    Tests for the camera capture pipeline.
+
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "test_capturepipeline.h"
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QRandomGenerator>
+#include <QThread>
+
+using ISD::CaptureFrame;
+using ISD::CapturePipeline;
+
+namespace
+{
+
+QSharedPointer<CaptureFrame> newFrame()
+{
+    QSharedPointer<CaptureFrame> frame(new CaptureFrame());
+    frame->receivedTimer.start();
+    frame->data = QByteArray(16, 'x');
+    return frame;
+}
+
+// Sleeps a few milliseconds so that stages overlap and finish out of step.
+void randomDelay()
+{
+    QThread::msleep(QRandomGenerator::global()->bounded(5));
+}
+
+}
+
+TestCapturePipeline::TestCapturePipeline() : QObject() {}
+
+void TestCapturePipeline::testOrdering()
+{
+    constexpr int frames = 40;
+    CapturePipeline pipeline;
+    QMutex mutex;
+    QMap<int, QList<quint64>> seen;
+
+    for (int stage = CapturePipeline::STAGE_PERSIST; stage < CapturePipeline::STAGE_COUNT; stage++)
+    {
+        pipeline.setHandler(static_cast<CapturePipeline::Stage>(stage), [&, stage](CaptureFrame & frame)
+        {
+            if (stage != CapturePipeline::STAGE_DISPLAY)
+                randomDelay();
+            QMutexLocker locker(&mutex);
+            seen[stage].append(frame.sequence);
+            return true;
+        });
+    }
+
+    for (int i = 0; i < frames; i++)
+        pipeline.submit(newFrame());
+
+    QTRY_COMPARE(seen[CapturePipeline::STAGE_DISPLAY].size(), frames);
+    for (int stage = CapturePipeline::STAGE_PERSIST; stage < CapturePipeline::STAGE_COUNT; stage++)
+    {
+        QCOMPARE(seen[stage].size(), frames);
+        for (int i = 0; i < frames; i++)
+            QCOMPARE(seen[stage][i], static_cast<quint64>(i));
+    }
+}
+
+void TestCapturePipeline::testBackPressure()
+{
+    constexpr int capacity = 2;
+    CapturePipeline pipeline(capacity, 10);
+    QAtomicInt inFlight(0), maxInFlight(0), displayed(0);
+    QList<quint64> order;
+
+    pipeline.setHandler(CapturePipeline::STAGE_PERSIST, [&](CaptureFrame &)
+    {
+        const int current = inFlight.fetchAndAddOrdered(1) + 1;
+        int previous = maxInFlight.loadAcquire();
+        while (current > previous && !maxInFlight.testAndSetOrdered(previous, current))
+            previous = maxInFlight.loadAcquire();
+        // A slow disk.
+        QThread::msleep(10);
+        return true;
+    });
+    pipeline.setHandler(CapturePipeline::STAGE_ANALYZE, [&](CaptureFrame &)
+    {
+        inFlight.fetchAndAddOrdered(-1);
+        return true;
+    });
+    pipeline.setHandler(CapturePipeline::STAGE_DISPLAY, [&](CaptureFrame & frame)
+    {
+        order.append(frame.sequence);
+        displayed.fetchAndAddOrdered(1);
+        return true;
+    });
+
+    // The disk takes 100 ms for the frames, submitting them must not wait for it.
+    QElapsedTimer timer;
+    timer.start();
+    int started = 0;
+    for (int i = 0; i < 10; i++)
+    {
+        if (pipeline.submit(newFrame()))
+            started++;
+    }
+    QVERIFY(timer.elapsed() < 50);
+    QCOMPARE(started, capacity);
+    QCOMPARE(pipeline.backlog(), 10 - capacity);
+
+    QTRY_COMPARE(displayed.loadAcquire(), 10);
+    QCOMPARE(pipeline.backlog(), 0);
+    QVERIFY(maxInFlight.loadAcquire() <= capacity);
+    for (int i = 0; i < 10; i++)
+        QCOMPARE(order[i], static_cast<quint64>(i));
+}
+
+void TestCapturePipeline::testBoundedBacklog()
+{
+    constexpr int capacity = 2, maxBacklog = 3, frames = 12;
+    CapturePipeline pipeline(capacity, maxBacklog);
+    QSignalSpy saturation(&pipeline, &CapturePipeline::saturated);
+    QAtomicInt analyzed(0);
+    QList<quint64> order;
+
+    pipeline.setHandler(CapturePipeline::STAGE_ANALYZE, [&](CaptureFrame &)
+    {
+        // A slow analysis.
+        QThread::msleep(20);
+        analyzed.fetchAndAddOrdered(1);
+        return true;
+    });
+    pipeline.setHandler(CapturePipeline::STAGE_DISPLAY, [&](CaptureFrame & frame)
+    {
+        order.append(frame.sequence);
+        return true;
+    });
+
+    for (int i = 0; i < frames; i++)
+    {
+        pipeline.submit(newFrame());
+        QVERIFY(pipeline.backlog() <= maxBacklog);
+        // Frames still holding their data are in the worker stages or in the backlog.
+        QVERIFY(i + 1 - analyzed.loadAcquire() <= capacity + maxBacklog);
+    }
+    QVERIFY(pipeline.isSaturated());
+    QCOMPARE(saturation.count(), 1);
+    QCOMPARE(saturation.first().first().toBool(), true);
+
+    QTRY_COMPARE(order.size(), frames);
+    QCOMPARE(pipeline.backlog(), 0);
+    QVERIFY(!pipeline.isSaturated());
+    QCOMPARE(saturation.count(), 2);
+    QCOMPARE(saturation.last().first().toBool(), false);
+    for (int i = 0; i < frames; i++)
+        QCOMPARE(order[i], static_cast<quint64>(i));
+}
+
+void TestCapturePipeline::testFailure()
+{
+    CapturePipeline pipeline;
+    int decoded = 0, analyzed = 0, displayed = 0, failures = 0;
+    QList<int> errors;
+
+    pipeline.setHandler(CapturePipeline::STAGE_PERSIST, [](CaptureFrame & frame)
+    {
+        // Fail every other frame.
+        if (frame.sequence % 2)
+        {
+            frame.errorType = 1;
+            return false;
+        }
+        return true;
+    });
+    pipeline.setHandler(CapturePipeline::STAGE_DECODE, [&](CaptureFrame &)
+    {
+        decoded++;
+        return true;
+    });
+    pipeline.setHandler(CapturePipeline::STAGE_ANALYZE, [&](CaptureFrame &)
+    {
+        analyzed++;
+        return true;
+    });
+    pipeline.setHandler(CapturePipeline::STAGE_DISPLAY, [&](CaptureFrame & frame)
+    {
+        displayed++;
+        if (frame.failed)
+        {
+            errors.append(frame.errorType);
+            failures++;
+        }
+        return true;
+    });
+
+    for (int i = 0; i < 6; i++)
+        pipeline.submit(newFrame());
+
+    QTRY_COMPARE(displayed, 6);
+    QCOMPARE(failures, 3);
+    QCOMPARE(decoded, 3);
+    QCOMPARE(analyzed, 3);
+    QCOMPARE(errors, QList<int>({1, 1, 1}));
+}
+
+void TestCapturePipeline::testLatency()
+{
+    CapturePipeline pipeline;
+    int displayed = 0;
+
+    pipeline.setHandler(CapturePipeline::STAGE_DECODE, [](CaptureFrame &)
+    {
+        QThread::msleep(3);
+        return true;
+    });
+    pipeline.setHandler(CapturePipeline::STAGE_DISPLAY, [&](CaptureFrame &)
+    {
+        displayed++;
+        return true;
+    });
+
+    for (int i = 0; i < 5; i++)
+        pipeline.submit(newFrame());
+    QTRY_COMPARE(displayed, 5);
+
+    for (int stage = CapturePipeline::STAGE_RECEIVE; stage < CapturePipeline::STAGE_COUNT; stage++)
+        QCOMPARE(pipeline.latency(static_cast<CapturePipeline::Stage>(stage)).count(), 5ull);
+
+    const ISD::LatencyHistogram decode = pipeline.latency(CapturePipeline::STAGE_DECODE);
+    QVERIFY(decode.mean() >= 3);
+    QVERIFY(decode.max() >= decode.mean());
+    // Nothing below 2 ms since every decode sleeps 3 ms.
+    QCOMPARE(decode.bucket(0) + decode.bucket(1), 0ull);
+    QVERIFY(decode.percentile(95) >= 4);
+}
+
+QTEST_GUILESS_MAIN(TestCapturePipeline)
@@ -0,0 +1,43 @@
+/*
+    Tests for the camera capture pipeline.
+
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "indi/capturepipeline.h"
+#include <QtTest/QtTest>
+
+class TestCapturePipeline : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TestCapturePipeline();
+
+private slots:
+    /**
+     * @brief Frames leave every stage in submission order, even when stage durations vary.
+     */
+    void testOrdering();
+    /**
+     * @brief No more frames than the capacity are ever between receive and display, and submitting to
+     * a full pipeline does not block, the frames wait in the backlog and keep their order.
+     */
+    void testBackPressure();
+    /**
+     * @brief With a slow analyze stage, the backlog never grows beyond its cap, the pipeline reports its
+     * saturation and no frame is dropped.
+     */
+    void testBoundedBacklog();
+    /**
+     * @brief A failing stage skips the following ones, but the frame is still displayed.
+     */
+    void testFailure();
+    /**
+     * @brief Latency histograms account for every frame in every stage.
+     */
+    void testLatency();
+};
@@ -8,6 +8,7 @@
 #include <QtConcurrent/QtConcurrentRun>
 #include <qtestcase.h>
 #include "catalogsdb.h"
+#include "mastersnapshot.h"
 #include "skymesh.h"
 
 using namespace CatalogsDB;
@@ -83,6 +84,93 @@ class TestCatalogsDB_DBManager : public QObject
         QVERIFY(num_obj > 0);
     }
 
+    void master_snapshot()
+    {
+        const int num_trixels = SkyMesh::Create(m_manager.htmesh_level())->size();
+        const int num_objects = m_manager.get_master_statistics().second.total_count;
+
+        MasterSnapshot snapshot;
+        QVERIFY(!snapshot.open(m_manager.db_file_name(), m_manager.htmesh_level(),
+                               num_objects));
+
+        const auto &success = m_manager.compile_master_snapshot();
+        QVERIFY2(success.first, qPrintable(success.second));
+        QVERIFY(snapshot.open(m_manager.db_file_name(), m_manager.htmesh_level(),
+                              num_objects));
+        QVERIFY(!snapshot.open(m_manager.db_file_name(), m_manager.htmesh_level(),
+                               num_objects + 1));
+        QVERIFY(snapshot.open(m_manager.db_file_name(), m_manager.htmesh_level(),
+                              num_objects));
+
+        int num_read = 0;
+        for (int trixel = 0; trixel < num_trixels; trixel++)
+        {
+            const auto &known = m_manager.get_objects_in_trixel_no_nulls(trixel);
+            const auto &null  = m_manager.get_objects_in_trixel_null_mag(trixel);
+
+            // Loading down to a limit and then further matches a single load
+            std::vector<CatalogObject> known_snapshot;
+            snapshot.read_known_mag(trixel, 8, known_snapshot);
+            for (const auto &object : known_snapshot)
+                QVERIFY(object.mag() < 8);
+            snapshot.read_known_mag(trixel, 99, known_snapshot);
+
+            std::vector<CatalogObject> null_snapshot;
+            snapshot.read_null_mag(trixel, null_snapshot);
+
+            QCOMPARE(known_snapshot.size(), known.size());
+            QCOMPARE(null_snapshot.size(), null.size());
+            for (size_t i = 0; i < known.size(); i++)
+            {
+                // Same order by magnitude, objects of equal magnitude may be swapped
+                QCOMPARE(known_snapshot[i].mag(), known[i].mag());
+
+                const auto found =
+                    std::find(known_snapshot.cbegin(), known_snapshot.cend(), known[i]);
+                QVERIFY(found != known_snapshot.cend());
+                QCOMPARE(found->name(), known[i].name());
+                QCOMPARE(found->a(), known[i].a());
+                QCOMPARE(found->ra0(), known[i].ra0());
+            }
+            for (const auto &object : null)
+                QVERIFY(std::find(null_snapshot.cbegin(), null_snapshot.cend(), object) !=
+                        null_snapshot.cend());
+
+            num_read += known_snapshot.size() + null_snapshot.size();
+        }
+        QCOMPARE(num_read, num_objects);
+
+        // Recompiling the master catalog invalidates the snapshot
+        snapshot.close();
+        QVERIFY(m_manager.compile_master_catalog());
+        QVERIFY(!snapshot.open(m_manager.db_file_name(), m_manager.htmesh_level(),
+                               num_objects));
+    }
+
+    void getting_objects_in_trixel_from_snapshot()
+    {
+        const int num_trixels = SkyMesh::Create(m_manager.htmesh_level())->size();
+        QVERIFY(m_manager.compile_master_snapshot().first);
+
+        MasterSnapshot snapshot;
+        QVERIFY(snapshot.open(m_manager.db_file_name(), m_manager.htmesh_level(),
+                              m_manager.get_master_statistics().second.total_count));
+        int num_obj = 0;
+
+        QBENCHMARK
+        {
+            for (int trixel = 0; trixel < num_trixels; trixel++)
+            {
+                std::vector<CatalogObject> objects;
+                snapshot.read_known_mag(trixel, 99, objects);
+                snapshot.read_null_mag(trixel, objects);
+                num_obj += objects.size();
+            }
+        }
+
+        QVERIFY(num_obj > 0);
+    }
+
     void find_by_name()
     {
         const auto &obj  = some_object();
@@ -0,0 +1,166 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QtTest>
+
+#include <QObject>
+#include <QTemporaryDir>
+#include "ekos/analyze/analyzestore.h"
+
+class TestAnalyzeStore : public QObject
+{
+        Q_OBJECT
+
+    public:
+        TestAnalyzeStore();
+        ~TestAnalyzeStore() override = default;
+
+    private slots:
+        void replayTest();
+        void appendTest();
+        void rebuildTest();
+
+    private:
+        // Replays the store into one line per record, in the format of the log
+        static QStringList replay(const Ekos::AnalyzeStore &store);
+        static void write(const QString &filename, const QByteArray &content, QIODevice::OpenMode mode);
+};
+
+#include "testanalyzestore.moc"
+
+using Ekos::AnalyzeStore;
+
+namespace
+{
+const QByteArray header = "#KStars version 3.6.0. Analyze log version 1.0.\n\n"
+                          "AnalyzeStartTime,2022-10-01 20:00:00.000,CEST\n";
+const QByteArray session = "GuideStats,1.000,0.50,-0.25,10,-20,25.5,120.0,3\n"
+                           "CaptureStarting,1.500,60.000,Red\n"
+                           "MountCoords,2.000,10.5000,45.2500,180.0000,60.0000,1,0.1000\n"
+                           "MountCoords,2.500,10.5000,45.2500,180.0000,60.0000,0\n"
+                           "GuideStats,3.000,bad,-0.25,10,-20,25.5,120.0,3\n"
+                           "GuideStats,4.000,0.75,0.25,0,5,30.0,118.0,4\r\n";
+}
+
+TestAnalyzeStore::TestAnalyzeStore() : QObject()
+{
+}
+
+QStringList TestAnalyzeStore::replay(const AnalyzeStore &store)
+{
+    QStringList records;
+    AnalyzeStore::Callbacks callbacks;
+    callbacks.guideStats = [&](double time, double raError, double decError, int raPulse, int decPulse,
+                               double snr, double skyBg, int numStars)
+    {
+        records << QString("GuideStats,%1,%2,%3,%4,%5,%6,%7,%8").arg(time).arg(raError).arg(decError)
+                .arg(raPulse).arg(decPulse).arg(snr).arg(skyBg).arg(numStars);
+    };
+    callbacks.mountCoords = [&](double time, double ra, double dec, double az, double alt, int pierSide, double ha)
+    {
+        records << QString("MountCoords,%1,%2,%3,%4,%5,%6,%7").arg(time).arg(ra).arg(dec).arg(az).arg(alt)
+                .arg(pierSide).arg(ha);
+    };
+    callbacks.line = [&](const QString & line)
+    {
+        records << line;
+    };
+    store.replay(callbacks);
+    return records;
+}
+
+void TestAnalyzeStore::write(const QString &filename, const QByteArray &content, QIODevice::OpenMode mode)
+{
+    QFile file(filename);
+    QVERIFY(file.open(mode));
+    QCOMPARE(file.write(content), static_cast<qint64>(content.size()));
+}
+
+void TestAnalyzeStore::replayTest()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString log = dir.filePath("session.analyze");
+    write(log, header + session + "CaptureComplete,5.000", QIODevice::WriteOnly);
+
+    AnalyzeStore store;
+    QVERIFY(store.open(log));
+    QVERIFY(store.isMapped());
+    QVERIFY(QFile::exists(AnalyzeStore::companionFilename(log)));
+
+    // Samples are replayed in their place among the text lines, malformed ones are kept as text
+    const QStringList expected =
+    {
+        "#KStars version 3.6.0. Analyze log version 1.0.",
+        "AnalyzeStartTime,2022-10-01 20:00:00.000,CEST",
+        "GuideStats,1,0.5,-0.25,10,-20,25.5,120,3",
+        "CaptureStarting,1.500,60.000,Red",
+        "MountCoords,2,10.5,45.25,180,60,1,0.1",
+        "MountCoords,2.5,10.5,45.25,180,60,0,0",
+        "GuideStats,3.000,bad,-0.25,10,-20,25.5,120.0,3",
+        "GuideStats,4,0.75,0.25,0,5,30,118,4",
+        "CaptureComplete,5.000"
+    };
+    QCOMPARE(replay(store), expected);
+    QCOMPARE(store.guideSampleCount(), 2);
+    QCOMPARE(store.mountSampleCount(), 2);
+    QCOMPARE(store.lineCount(), 5);
+
+    // A second load reads the companion as it is
+    const qint64 size = QFileInfo(AnalyzeStore::companionFilename(log)).size();
+    AnalyzeStore again;
+    QVERIFY(again.open(log));
+    QCOMPARE(replay(again), expected);
+    QCOMPARE(QFileInfo(AnalyzeStore::companionFilename(log)).size(), size);
+}
+
+void TestAnalyzeStore::appendTest()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString log = dir.filePath("session.analyze");
+    write(log, header + session, QIODevice::WriteOnly);
+
+    AnalyzeStore store;
+    QVERIFY(store.open(log));
+    const QStringList before = replay(store);
+    const qint64 size = QFileInfo(AnalyzeStore::companionFilename(log)).size();
+    store.close();
+
+    // Lines logged since are appended to the companion
+    write(log, "GuideStats,6.000,1.00,1.00,1,1,20.0,100.0,2\n", QIODevice::WriteOnly | QIODevice::Append);
+    QVERIFY(store.open(log));
+    QCOMPARE(replay(store), before + QStringList{ "GuideStats,6,1,1,1,1,20,100,2" });
+    QCOMPARE(store.guideSampleCount(), 3);
+    QVERIFY(QFileInfo(AnalyzeStore::companionFilename(log)).size() > size);
+}
+
+void TestAnalyzeStore::rebuildTest()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString log = dir.filePath("session.analyze");
+    write(log, header + session, QIODevice::WriteOnly);
+
+    AnalyzeStore store;
+    QVERIFY(store.open(log));
+    store.close();
+
+    // A different log under the same name invalidates the companion
+    write(log, header + "GuideStats,7.000,0.10,0.20,1,2,10.0,90.0,1\n", QIODevice::WriteOnly | QIODevice::Truncate);
+    QVERIFY(store.open(log));
+    QCOMPARE(store.guideSampleCount(), 1);
+    QCOMPARE(store.mountSampleCount(), 0);
+
+    // So does a corrupted companion
+    store.close();
+    write(AnalyzeStore::companionFilename(log), "garbage", QIODevice::WriteOnly | QIODevice::Append);
+    QVERIFY(store.open(log));
+    QCOMPARE(store.guideSampleCount(), 1);
+    QCOMPARE(store.lineCount(), 2);
+}
+
+QTEST_GUILESS_MAIN(TestAnalyzeStore)
@@ -0,0 +1,151 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QtTest>
+
+#include <QObject>
+#include <QRandomGenerator>
+#include "ekos/auxiliary/framestacker.h"
+
+#include <vector>
+
+class TestStacking : public QObject
+{
+        Q_OBJECT
+
+    public:
+        TestStacking();
+        ~TestStacking() override = default;
+
+    private slots:
+        void basicTest_data();
+        void basicTest();
+        void medianWarmupTest();
+        void kappaSigmaWarmupTest();
+};
+
+#include "teststacking.moc"
+
+using Ekos::FrameStacker;
+
+TestStacking::TestStacking() : QObject()
+{
+}
+
+void TestStacking::basicTest_data()
+{
+    QTest::addColumn<int>("method");
+    QTest::addColumn<bool>("rejectsOutliers");
+    QTest::addColumn<int>("cosmicFrame");
+
+    // The cosmic ray also hits the frames that seed the median and the kappa-sigma estimates
+    QTest::newRow("mean") << static_cast<int>(FrameStacker::Mean) << false << 15;
+    QTest::newRow("median") << static_cast<int>(FrameStacker::Median) << true << 15;
+    QTest::newRow("median, first frame") << static_cast<int>(FrameStacker::Median) << true << 0;
+    QTest::newRow("median, last frame") << static_cast<int>(FrameStacker::Median) << true << 29;
+    QTest::newRow("kappa-sigma") << static_cast<int>(FrameStacker::KappaSigma) << true << 15;
+    QTest::newRow("kappa-sigma, first frame") << static_cast<int>(FrameStacker::KappaSigma) << true << 0;
+    QTest::newRow("kappa-sigma, third frame") << static_cast<int>(FrameStacker::KappaSigma) << true << 2;
+    QTest::newRow("kappa-sigma, warm-up") << static_cast<int>(FrameStacker::KappaSigma) << true << 4;
+}
+
+void TestStacking::basicTest()
+{
+    QFETCH(int, method);
+    QFETCH(bool, rejectsOutliers);
+    QFETCH(int, cosmicFrame);
+
+    // A small frame spread over several parallel spans, with a gaussian-ish bias around 1000 ADU
+    constexpr uint32_t samples = 300000;
+    constexpr int frames = 30;
+    constexpr uint32_t cosmic = 1234;
+
+    FrameStacker stacker;
+    stacker.setMethod(static_cast<FrameStacker::Method>(method));
+
+    QRandomGenerator generator(42);
+    std::vector<uint16_t> frame(samples);
+    for (int f = 0; f < frames; f++)
+    {
+        for (auto &sample : frame)
+            sample = static_cast<uint16_t>(980 + generator.bounded(21) + generator.bounded(21));
+        // A cosmic ray hit in one of the frames
+        if (f == cosmicFrame)
+            frame[cosmic] = 60000;
+        stacker.addFrame(frame.data(), samples);
+    }
+
+    QCOMPARE(stacker.frames(), static_cast<uint32_t>(frames));
+    QVERIFY(stacker.lastFrameTime() >= 0);
+
+    std::vector<uint16_t> master(samples);
+    QVERIFY(stacker.writeMaster(master.data()));
+
+    double sum = 0;
+    for (uint32_t i = 0; i < samples; i++)
+    {
+        if (i != cosmic)
+            sum += master[i];
+    }
+    QVERIFY(std::abs(sum / (samples - 1) - 1000.0) < 2.0);
+
+    if (rejectsOutliers)
+        QVERIFY(std::abs(master[cosmic] - 1000) < 30);
+    else
+        QVERIFY(master[cosmic] > 2500);
+
+    // The stack is dropped once cleared
+    stacker.clear();
+    QCOMPARE(stacker.frames(), 0u);
+    QVERIFY(!stacker.writeMaster(master.data()));
+}
+
+void TestStacking::medianWarmupTest()
+{
+    // The median of one frame is the frame, of two frames their average, of three frames their median
+    const uint16_t frames[3][3] = {{100, 200, 300}, {110, 60000, 310}, {90, 210, 50000}};
+    const uint16_t expected[3][3] = {{100, 200, 300}, {105, 30100, 305}, {100, 210, 310}};
+
+    FrameStacker stacker;
+    stacker.setMethod(FrameStacker::Median);
+    uint16_t master[3];
+    for (int f = 0; f < 3; f++)
+    {
+        stacker.addFrame(frames[f], 3);
+        QVERIFY(stacker.writeMaster(master));
+        for (int i = 0; i < 3; i++)
+            QCOMPARE(master[i], expected[f][i]);
+    }
+}
+
+void TestStacking::kappaSigmaWarmupTest()
+{
+    // A hot first frame is left out of short stacks too, before its sample is checked
+    FrameStacker stacker;
+    stacker.setMethod(FrameStacker::KappaSigma);
+    const uint16_t frames[6][2] = {{60000, 1000}, {1002, 1003}, {998, 997}, {1001, 1000}, {999, 1002}, {1000, 998}};
+    uint16_t master[2];
+    for (int f = 0; f < 6; f++)
+    {
+        stacker.addFrame(frames[f], 2);
+        QVERIFY(stacker.writeMaster(master));
+        // With two frames, the stack is their average as for the median
+        if (f == 1)
+            QCOMPARE(master[0], static_cast<uint16_t>(30501));
+        else if (f > 1)
+            QVERIFY(std::abs(master[0] - 1000) <= 2);
+        QVERIFY(std::abs(master[1] - 1000) <= 2);
+    }
+
+    // Once checked, the suspect sample of a regular pixel is kept, that of the hot pixel is not
+    for (int f = 6; f < 10; f++)
+        stacker.addFrame(frames[f % 5 + 1], 2);
+    QVERIFY(stacker.writeMaster(master));
+    QVERIFY(std::abs(master[0] - 1000) <= 2);
+    QVERIFY(std::abs(master[1] - 1000) <= 2);
+}
+
+QTEST_GUILESS_MAIN(TestStacking)
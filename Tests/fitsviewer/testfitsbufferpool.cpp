@@ -0,0 +1,147 @@
+/*  KStars tests
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "fitsviewer/fitsbufferpool.h"
+#include "fitsviewer/fitsdata.h"
+
+#include <QtTest>
+#include <QFile>
+#include <QObject>
+
+#include <cstring>
+#include <memory>
+
+/**
+ * @brief Checks that FITSBufferPool recycles image and unpack buffers, and that consecutive frames
+ * loaded by FITSData reuse the image buffer of the previous one.
+ */
+class TestFitsBufferPool : public QObject
+{
+        Q_OBJECT
+
+    public:
+        TestFitsBufferPool() : QObject() {}
+
+    private slots:
+        void init();
+        void testImageBuffers();
+        void testEviction();
+        void testPackBuffers();
+        void testFrameReuse();
+};
+
+#include "testfitsbufferpool.moc"
+
+void TestFitsBufferPool::init()
+{
+    FITSBufferPool::Instance()->clear();
+}
+
+void TestFitsBufferPool::testImageBuffers()
+{
+    FITSBufferPool *pool = FITSBufferPool::Instance();
+    const FITSBufferPool::Counters before = pool->counters();
+
+    bool reused = true;
+    uint8_t *first = pool->acquire(1000, &reused);
+    QVERIFY(first != nullptr);
+    QVERIFY(!reused);
+    pool->release(first);
+
+    // A buffer of the same size comes back from the pool, another size does not.
+    uint8_t *second = pool->acquire(1000, &reused);
+    QVERIFY(reused);
+    QCOMPARE(second, first);
+    uint8_t *other = pool->acquire(2000, &reused);
+    QVERIFY(!reused);
+    QVERIFY(other != second);
+
+    const FITSBufferPool::Counters after = pool->counters();
+    QCOMPARE(after.allocations - before.allocations, uint64_t(2));
+    QCOMPARE(after.allocatedBytes - before.allocatedBytes, uint64_t(3000));
+    QCOMPARE(after.reuses - before.reuses, uint64_t(1));
+    QCOMPARE(after.reusedBytes - before.reusedBytes, uint64_t(1000));
+
+    pool->release(second);
+    pool->release(other);
+
+    // Buffers which do not come from the pool are deleted, not recycled.
+    pool->release(new uint8_t[3000]);
+    uint8_t *foreign = pool->acquire(3000, &reused);
+    QVERIFY(!reused);
+    pool->release(foreign);
+}
+
+void TestFitsBufferPool::testEviction()
+{
+    FITSBufferPool *pool = FITSBufferPool::Instance();
+    uint8_t *a = pool->acquire(100);
+    uint8_t *b = pool->acquire(200);
+    uint8_t *c = pool->acquire(300);
+    pool->release(a);
+    pool->release(b);
+    pool->release(c);
+
+    // Only the two most recently released buffers are kept.
+    bool reused = true;
+    pool->release(pool->acquire(100, &reused));
+    QVERIFY(!reused);
+    pool->release(pool->acquire(300, &reused));
+    QVERIFY(reused);
+}
+
+void TestFitsBufferPool::testPackBuffers()
+{
+    FITSBufferPool *pool = FITSBufferPool::Instance();
+
+    bool reused = true;
+    size_t capacity = 500;
+    uint8_t *pack = pool->acquirePackBuffer(capacity, &reused);
+    QVERIFY(pack != nullptr);
+    QVERIFY(!reused);
+    QCOMPARE(capacity, size_t(500));
+    pool->releasePackBuffer(pack, capacity);
+    QCOMPARE(pool->lastPackCapacity(), size_t(500));
+
+    // A recycled unpack buffer is grown to the requested capacity, or keeps its larger one.
+    capacity = 8000;
+    pack = pool->acquirePackBuffer(capacity, &reused);
+    QVERIFY(reused);
+    QCOMPARE(capacity, size_t(8000));
+    memset(pack, 0, capacity);
+    pool->releasePackBuffer(pack, capacity);
+
+    capacity = 1000;
+    pack = pool->acquirePackBuffer(capacity, &reused);
+    QVERIFY(reused);
+    QCOMPARE(capacity, size_t(8000));
+    pool->releasePackBuffer(pack, capacity);
+    QCOMPARE(pool->lastPackCapacity(), size_t(8000));
+}
+
+void TestFitsBufferPool::testFrameReuse()
+{
+    QFile file("m47_sim_stars.fits");
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray frame = file.readAll();
+
+    std::unique_ptr<FITSData> data(new FITSData());
+    QVERIFY(data->loadFromBuffer(frame, "fits"));
+    const FITSData::LoadCounters first = data->loadCounters();
+    QCOMPARE(first.inputBytes, size_t(frame.size()));
+    QCOMPARE(first.unpackedBytes, size_t(0));
+    QCOMPARE(first.decodedBytes, size_t(data->width() * data->height() * data->channels() *
+                                        data->getStatistics().bytesPerPixel));
+    QVERIFY(!first.imageBufferReused);
+
+    // Once the previous frame is released, the next one of the same geometry decodes into its buffer.
+    data.reset(new FITSData());
+    QVERIFY(data->loadFromBuffer(frame, "fits"));
+    QVERIFY(data->loadCounters().imageBufferReused);
+    QCOMPARE(data->loadCounters().decodedBytes, first.decodedBytes);
+}
+
+QTEST_GUILESS_MAIN(TestFitsBufferPool)
@@ -0,0 +1,263 @@
+/*  KStars tests
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "fitsviewer/fitsdata.h"
+#include "fitsviewer/fitsstatskernel.h"
+
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QRandomGenerator>
+#include <QScopeGuard>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Verifies FITSData::calculateStats() against a naive computation for every FITS data type,
+ * and reports its throughput in GB/s on one core and on all cores.
+ */
+class TestFitsStats : public QObject
+{
+        Q_OBJECT
+
+    public:
+        TestFitsStats() : QObject() {}
+
+    private slots:
+        void testCalculateStats_data();
+        void testCalculateStats();
+        void benchmarkCalculateStats_data();
+        void benchmarkCalculateStats();
+};
+
+#include "testfitsstats.moc"
+
+namespace
+{
+
+// Large enough to be split into several partitions for every data type, 16-bit included, on a
+// multi-core machine. Both dimensions are odd so that the vector loop tails and the partition
+// remainders are exercised.
+constexpr uint16_t testWidth = 2003, testHeight = 2001;
+
+// A 24 MP frame, what a typical main imager produces on every capture.
+constexpr uint16_t benchmarkWidth = 6000, benchmarkHeight = 4000;
+
+template <typename T>
+std::vector<T> makeFrame(uint32_t samples)
+{
+    QRandomGenerator generator(42);
+    std::vector<T> frame(samples);
+
+    // Sky background with a few saturated "stars", roughly what a real light frame looks like.
+    // Integer frames are scaled to the range of their type. Floating point frames sit on a large
+    // offset with little noise, where a naive sum of squares loses the variance to cancellation.
+    double background = 0, noise = 0;
+    T saturation = 0;
+    if constexpr (std::is_integral<T>::value)
+    {
+        const double range = static_cast<double>(std::numeric_limits<T>::max()) - std::numeric_limits<T>::lowest();
+        background = std::numeric_limits<T>::lowest() + 0.1 * range;
+        noise = 0.02 * range;
+        saturation = std::numeric_limits<T>::max();
+    }
+    else
+    {
+        background = std::is_same<T, float>::value ? 1e5 : 1e9;
+        noise = 10;
+        saturation = static_cast<T>(background + 1000);
+    }
+
+    for (auto &sample : frame)
+    {
+        if (generator.bounded(1000) == 0)
+            sample = saturation;
+        else
+            sample = static_cast<T>(background + generator.bounded(noise));
+    }
+    return frame;
+}
+
+template <typename T>
+void loadFrame(FITSData &data, uint32_t dataType, uint16_t width, uint16_t height, const std::vector<T> &frame)
+{
+    FITSImage::Statistic stats;
+    stats.dataType = dataType;
+    stats.bytesPerPixel = sizeof(T);
+    stats.width = width;
+    stats.height = height;
+    stats.channels = 1;
+    stats.samples_per_channel = frame.size();
+    stats.size = frame.size() * sizeof(T);
+    data.restoreStatistics(stats);
+
+    // FITSData hands the buffer back to the pool, which frees foreign buffers with delete[].
+    uint8_t *buffer = new uint8_t[stats.size];
+    memcpy(buffer, frame.data(), stats.size);
+    data.setImageBuffer(buffer);
+}
+
+template <typename T>
+void verifyStats(uint32_t dataType)
+{
+    const std::vector<T> frame = makeFrame<T>(testWidth * testHeight);
+    const uint32_t samples = frame.size();
+
+    // Reference statistics in two passes and extended precision.
+    long double min = frame[0], max = frame[0], sum = 0;
+    for (const T sample : frame)
+    {
+        min = std::min<long double>(min, sample);
+        max = std::max<long double>(max, sample);
+        sum += sample;
+    }
+    const long double mean = sum / samples;
+    long double squares = 0;
+    for (const T sample : frame)
+        squares += (sample - mean) * (sample - mean);
+    const double stddev = std::sqrt(static_cast<double>(squares / samples));
+
+    std::vector<T> sorted = frame;
+    std::nth_element(sorted.begin(), sorted.begin() + samples / 2, sorted.end());
+    const double median = sorted[samples / 2];
+
+    FITSData data;
+    loadFrame(data, dataType, testWidth, testHeight, frame);
+    data.calculateStats(true);
+
+    QCOMPARE(data.getMin(), static_cast<double>(min));
+    QCOMPARE(data.getMax(), static_cast<double>(max));
+    QVERIFY2(std::abs(data.getMean() - mean) <= 1e-9 * std::abs(mean),
+             qPrintable(QString("mean %1 expected %2").arg(data.getMean(), 0, 'g', 17).arg(static_cast<double>(mean), 0, 'g', 17)));
+    QVERIFY2(std::abs(data.getStdDev() - stddev) <= 1e-9 * stddev,
+             qPrintable(QString("stddev %1 expected %2").arg(data.getStdDev(), 0, 'g', 17).arg(stddev, 0, 'g', 17)));
+    // Wider types select their median from a subset of the samples, only histograms are exact.
+    if (FITSStatsKernel::histogramBins<T>() > 0)
+        QCOMPARE(data.getMedian(), median);
+}
+
+template <typename T>
+void benchmark(uint32_t dataType, const char *name)
+{
+    const std::vector<T> frame = makeFrame<T>(benchmarkWidth * benchmarkHeight);
+    const double gigabytes = static_cast<double>(frame.size()) * sizeof(T) / 1e9;
+
+    FITSData data;
+    loadFrame(data, dataType, benchmarkWidth, benchmarkHeight, frame);
+
+    const int maxThreads = QThreadPool::globalInstance()->maxThreadCount();
+    const auto restoreThreads = qScopeGuard([maxThreads]()
+    {
+        QThreadPool::globalInstance()->setMaxThreadCount(maxThreads);
+    });
+
+    for (int nThreads : {1, maxThreads})
+    {
+        // The partitions queue up on a single worker, which measures the throughput of one core.
+        QThreadPool::globalInstance()->setMaxThreadCount(nThreads);
+        QElapsedTimer timer;
+        timer.start();
+        constexpr int repetitions = 5;
+        for (int i = 0; i < repetitions; i++)
+            data.calculateStats(true);
+        const double seconds = timer.nsecsElapsed() / 1e9 / repetitions;
+        qInfo() << QString("%1 %2 thread(s): %3 ms/frame, %4 GB/s")
+                .arg(name, -10).arg(nThreads, 2).arg(seconds * 1000, 0, 'f', 2).arg(gigabytes / seconds, 0, 'f', 2);
+    }
+}
+
+}
+
+void TestFitsStats::testCalculateStats_data()
+{
+    QTest::addColumn<int>("TYPE");
+    QTest::newRow("TBYTE") << TBYTE;
+    QTest::newRow("TSHORT") << TSHORT;
+    QTest::newRow("TUSHORT") << TUSHORT;
+    QTest::newRow("TLONG") << TLONG;
+    QTest::newRow("TULONG") << TULONG;
+    QTest::newRow("TFLOAT") << TFLOAT;
+    QTest::newRow("TLONGLONG") << TLONGLONG;
+    QTest::newRow("TDOUBLE") << TDOUBLE;
+}
+
+void TestFitsStats::testCalculateStats()
+{
+    QFETCH(int, TYPE);
+
+    switch (TYPE)
+    {
+        case TBYTE:
+            verifyStats<uint8_t>(TYPE);
+            break;
+        case TSHORT:
+            verifyStats<int16_t>(TYPE);
+            break;
+        case TUSHORT:
+            verifyStats<uint16_t>(TYPE);
+            break;
+        case TLONG:
+            verifyStats<int32_t>(TYPE);
+            break;
+        case TULONG:
+            verifyStats<uint32_t>(TYPE);
+            break;
+        case TFLOAT:
+            verifyStats<float>(TYPE);
+            break;
+        case TLONGLONG:
+            verifyStats<int64_t>(TYPE);
+            break;
+        case TDOUBLE:
+            verifyStats<double>(TYPE);
+            break;
+    }
+}
+
+void TestFitsStats::benchmarkCalculateStats_data()
+{
+    testCalculateStats_data();
+}
+
+void TestFitsStats::benchmarkCalculateStats()
+{
+    QFETCH(int, TYPE);
+
+    switch (TYPE)
+    {
+        case TBYTE:
+            benchmark<uint8_t>(TYPE, "TBYTE");
+            break;
+        case TSHORT:
+            benchmark<int16_t>(TYPE, "TSHORT");
+            break;
+        case TUSHORT:
+            benchmark<uint16_t>(TYPE, "TUSHORT");
+            break;
+        case TLONG:
+            benchmark<int32_t>(TYPE, "TLONG");
+            break;
+        case TULONG:
+            benchmark<uint32_t>(TYPE, "TULONG");
+            break;
+        case TFLOAT:
+            benchmark<float>(TYPE, "TFLOAT");
+            break;
+        case TLONGLONG:
+            benchmark<int64_t>(TYPE, "TLONGLONG");
+            break;
+        case TDOUBLE:
+            benchmark<double>(TYPE, "TDOUBLE");
+            break;
+    }
+}
+
+QTEST_GUILESS_MAIN(TestFitsStats)
@@ -0,0 +1,137 @@
+/*  KStars tests
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "fitsviewer/fitsdata.h"
+#include "fitsviewer/stretch.h"
+
+#include <QtTest>
+#include <QObject>
+
+#include <memory>
+
+/**
+ * @brief Checks that the lookup table path of Stretch::run() renders the sample frames exactly like
+ * the per-pixel path, and benchmarks both.
+ */
+class TestStretch : public QObject
+{
+        Q_OBJECT
+
+    public:
+        TestStretch() : QObject() {}
+
+    private slots:
+        void testLookupTables_data();
+        void testLookupTables();
+
+        void benchmarkStretch_data();
+        void benchmarkStretch();
+
+    private:
+        void initFramesFixture();
+};
+
+#include "teststretch.moc"
+
+namespace
+{
+
+// Loads a sample frame, and prepares a Stretch object with automatic params and a matching output image.
+bool prepare(const QString &filename, int sampling, std::unique_ptr<FITSData> &data, std::unique_ptr<Stretch> &stretch,
+             QImage &output)
+{
+    data.reset(new FITSData());
+    QFuture<bool> worker = data->loadFromFile(filename);
+    worker.waitForFinished();
+    if (!worker.result())
+        return false;
+
+    stretch.reset(new Stretch(data->width(), data->height(), data->channels(), data->dataType()));
+    stretch->setParams(stretch->computeParams(data->getImageBuffer()));
+
+    const int w = (data->width() + sampling - 1) / sampling;
+    const int h = (data->height() + sampling - 1) / sampling;
+    output = QImage(w, h, data->channels() == 1 ? QImage::Format_Indexed8 : QImage::Format_RGB32);
+    return true;
+}
+
+}
+
+void TestStretch::initFramesFixture()
+{
+    QTest::addColumn<QString>("NAME");
+    QTest::addColumn<int>("SAMPLING");
+
+    QTest::newRow("M47-1") << "m47_sim_stars.fits" << 1;
+    QTest::newRow("M47-2") << "m47_sim_stars.fits" << 2;
+    QTest::newRow("NGC4535-1") << "ngc4535-autofocus1.fits" << 1;
+    QTest::newRow("NGC4535-3") << "ngc4535-autofocus1.fits" << 3;
+}
+
+void TestStretch::testLookupTables_data()
+{
+    initFramesFixture();
+}
+
+void TestStretch::testLookupTables()
+{
+    QFETCH(QString, NAME);
+    QFETCH(int, SAMPLING);
+
+    if(!QFile::exists(NAME))
+        QSKIP("Skipping stretch test because of missing fixture");
+
+    std::unique_ptr<FITSData> data;
+    std::unique_ptr<Stretch> stretch;
+    QImage direct, tabulated;
+    QVERIFY(prepare(NAME, SAMPLING, data, stretch, direct));
+    tabulated = direct.copy();
+
+    stretch->setUseLookupTables(false);
+    stretch->run(data->getImageBuffer(), &direct, SAMPLING);
+    stretch->setUseLookupTables(true);
+    stretch->run(data->getImageBuffer(), &tabulated, SAMPLING);
+    QCOMPARE(tabulated, direct);
+
+    // New params must invalidate the tables built for the previous ones.
+    StretchParams params = stretch->getParams();
+    params.grey_red.midtones = 0.1;
+    stretch->setParams(params);
+    stretch->run(data->getImageBuffer(), &tabulated, SAMPLING);
+    stretch->setUseLookupTables(false);
+    stretch->run(data->getImageBuffer(), &direct, SAMPLING);
+    QCOMPARE(tabulated, direct);
+}
+
+void TestStretch::benchmarkStretch_data()
+{
+    QTest::addColumn<QString>("NAME");
+    QTest::addColumn<bool>("LOOKUP_TABLES");
+
+    QTest::newRow("M47-direct") << "m47_sim_stars.fits" << false;
+    QTest::newRow("M47-lookup") << "m47_sim_stars.fits" << true;
+    QTest::newRow("NGC4535-direct") << "ngc4535-autofocus1.fits" << false;
+    QTest::newRow("NGC4535-lookup") << "ngc4535-autofocus1.fits" << true;
+}
+
+void TestStretch::benchmarkStretch()
+{
+    QFETCH(QString, NAME);
+    QFETCH(bool, LOOKUP_TABLES);
+
+    if(!QFile::exists(NAME))
+        QSKIP("Skipping stretch benchmark because of missing fixture");
+
+    std::unique_ptr<FITSData> data;
+    std::unique_ptr<Stretch> stretch;
+    QImage output;
+    QVERIFY(prepare(NAME, 1, data, stretch, output));
+    stretch->setUseLookupTables(LOOKUP_TABLES);
+
+    QBENCHMARK { stretch->run(data->getImageBuffer(), &output, 1); }
+}
+
+QTEST_GUILESS_MAIN(TestStretch)
@@ -0,0 +1,195 @@
+/*  KStars tests
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "hips/scanrender.h"
+
+#include <QtTest>
+#include <QtConcurrent>
+#include <QObject>
+
+#include <memory>
+
+/**
+ * @brief Checks that HiPS tiles rasterized in bands of rows, as HIPSRenderer does from several
+ * threads, give the same image as a single pass, and the bilinear sampling of ScanRender.
+ */
+class TestScanRender : public QObject
+{
+        Q_OBJECT
+
+    public:
+        TestScanRender() : QObject() {}
+
+    private slots:
+        void testBands_data();
+        void testBands();
+        void testSourceView();
+        void testBilinearUniform();
+        void testBilinearEdges();
+
+    private:
+        // Draws the test tiles, the texture spanning each quad
+        static void render(ScanRender &renderer, QImage &dst, QImage &src);
+        static QImage texture(int size);
+};
+
+#include "testscanrender.moc"
+
+namespace
+{
+// Quads in the order HIPSRenderer passes them: some overlap, some lie partly outside of the image
+const QVector<QVector<QPointF>> quads =
+{
+    { QPointF(10, 10), QPointF(90, 15), QPointF(85, 95), QPointF(5, 80) },
+    { QPointF(60, 40), QPointF(190, 30), QPointF(170, 150), QPointF(70, 140) },
+    { QPointF(-30, 100), QPointF(60, 90), QPointF(50, 200), QPointF(-20, 190) },
+    { QPointF(120, -20), QPointF(230, -10), QPointF(210, 70), QPointF(130, 60) },
+};
+const QPointF uv[4] = { QPointF(1, 1), QPointF(1, 0), QPointF(0, 0), QPointF(0, 1) };
+}
+
+QImage TestScanRender::texture(int size)
+{
+    QImage image(size, size, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < size; y++)
+        for (int x = 0; x < size; x++)
+            image.setPixel(x, y, qRgb(x * 255 / size, y * 255 / size, (x * 7 + y * 13) % 256));
+    return image;
+}
+
+void TestScanRender::render(ScanRender &renderer, QImage &dst, QImage &src)
+{
+    for (const auto &quad : quads)
+        renderer.renderPolygon(3, quad.constData(), &dst, &src, uv);
+}
+
+void TestScanRender::testBands_data()
+{
+    QTest::addColumn<bool>("bilinear");
+    QTest::addColumn<int>("bands");
+
+    QTest::newRow("nearest, 4 bands") << false << 4;
+    QTest::newRow("bilinear, 4 bands") << true << 4;
+    QTest::newRow("bilinear, 7 bands") << true << 7;
+}
+
+void TestScanRender::testBands()
+{
+    QFETCH(bool, bilinear);
+    QFETCH(int, bands);
+
+    QImage src = texture(64);
+
+    QImage reference(200, 160, QImage::Format_ARGB32_Premultiplied);
+    reference.fill(Qt::transparent);
+    std::unique_ptr<ScanRender> single(new ScanRender());
+    single->setBilinearInterpolationEnabled(bilinear);
+    render(*single, reference, src);
+
+    // Each band draws all the tiles in the same order, into rows no other band touches
+    QImage banded(reference.size(), reference.format());
+    banded.fill(Qt::transparent);
+    QVector<int> tops;
+    const int rows = (banded.height() + bands - 1) / bands;
+    for (int top = 0; top < banded.height(); top += rows)
+        tops << top;
+    QtConcurrent::blockingMap(tops, [&](int top)
+    {
+        std::unique_ptr<ScanRender> renderer(new ScanRender());
+        renderer->setBilinearInterpolationEnabled(bilinear);
+        renderer->setClipRows(top, top + rows);
+        render(*renderer, banded, src);
+    });
+
+    QVERIFY(reference != QImage(reference.size(), reference.format()));
+    QCOMPARE(banded, reference);
+}
+
+void TestScanRender::testSourceView()
+{
+    // HIPSManager hands out views into the cached allsky tiles, whose rows are not contiguous
+    QImage allsky = texture(256);
+    const int x = 64, y = 128, size = 64;
+    QImage view(allsky.constBits() + y * allsky.bytesPerLine() + x * 4, size, size, allsky.bytesPerLine(),
+                allsky.format());
+    QImage copy = allsky.copy(x, y, size, size);
+
+    for (bool bilinear : { false, true })
+    {
+        std::unique_ptr<ScanRender> renderer(new ScanRender());
+        renderer->setBilinearInterpolationEnabled(bilinear);
+
+        QImage fromView(200, 160, QImage::Format_ARGB32_Premultiplied);
+        fromView.fill(Qt::transparent);
+        render(*renderer, fromView, view);
+
+        QImage fromCopy(fromView.size(), fromView.format());
+        fromCopy.fill(Qt::transparent);
+        render(*renderer, fromCopy, copy);
+
+        QCOMPARE(fromView, fromCopy);
+    }
+}
+
+void TestScanRender::testBilinearUniform()
+{
+    // The fixed point weights add up to one, a flat texture comes out unchanged
+    QImage src(16, 16, QImage::Format_ARGB32_Premultiplied);
+    const QRgb color = qRgb(17, 130, 254);
+    src.fill(color);
+
+    QImage dst(200, 160, QImage::Format_ARGB32_Premultiplied);
+    dst.fill(Qt::transparent);
+    std::unique_ptr<ScanRender> renderer(new ScanRender());
+    renderer->setBilinearInterpolationEnabled(true);
+    render(*renderer, dst, src);
+
+    int drawn = 0;
+    for (int y = 0; y < dst.height(); y++)
+        for (int x = 0; x < dst.width(); x++)
+        {
+            const QRgb pixel = dst.pixel(x, y);
+            if (pixel == 0)
+                continue;
+            drawn++;
+            QCOMPARE(pixel, color);
+        }
+    QVERIFY(drawn > 1000);
+}
+
+void TestScanRender::testBilinearEdges()
+{
+    // Texels past the last column repeat it rather than wrapping to the first column of the next row
+    QImage src(16, 16, QImage::Format_ARGB32_Premultiplied);
+    src.fill(qRgb(0, 255, 0));
+    for (int y = 0; y < src.height(); y++)
+        src.setPixel(0, y, qRgb(255, 0, 0));
+
+    QImage dst(200, 160, QImage::Format_ARGB32_Premultiplied);
+    dst.fill(Qt::transparent);
+    std::unique_ptr<ScanRender> renderer(new ScanRender());
+    renderer->setBilinearInterpolationEnabled(true);
+
+    // The texture fills the image, u growing from left to right
+    const QPointF full[4] = { QPointF(0, 0), QPointF(200, 0), QPointF(200, 160), QPointF(0, 160) };
+    const QPointF fullUV[4] = { QPointF(0, 0), QPointF(1, 0), QPointF(1, 1), QPointF(0, 1) };
+    renderer->resetScanPoly(dst.width(), dst.height());
+    for (int i = 0; i < 4; i++)
+        renderer->scanLine(full[i].x(), full[i].y(), full[(i + 1) % 4].x(), full[(i + 1) % 4].y(),
+                           fullUV[i].x(), fullUV[i].y(), fullUV[(i + 1) % 4].x(), fullUV[(i + 1) % 4].y());
+    renderer->renderPolygon(&dst, &src);
+
+    // The right half is far from the red column, it must be pure green
+    for (int y = 0; y < dst.height(); y++)
+        for (int x = dst.width() / 2; x < dst.width(); x++)
+        {
+            const QRgb pixel = dst.pixel(x, y);
+            if (pixel != 0)
+                QCOMPARE(qRed(pixel), 0);
+        }
+}
+
+QTEST_GUILESS_MAIN(TestScanRender)
@@ -10,9 +10,12 @@
 #include <QtTest>
 
 #include <QObject>
+#include <QScopeGuard>
 
-// The high-level methods, selectGuideStar() and findGuideStar() are not yet tested.
-// Neither are the SEP-related EvaluateSEPStars, findTopStars, findAllSEPStars().
+#include <random>
+
+// The high-level methods, selectGuideStar() and findGuideStar() are only tested with windowed detection.
+// The SEP-related EvaluateSEPStars, findTopStars, findAllSEPStars() are not tested on their own.
 
 class TestGuideStars : public QObject
 {
@@ -28,6 +31,7 @@ class TestGuideStars : public QObject
     private slots:
         void basicTest();
         void calibrationTest();
+        void windowedDetectionTest();
 };
 
 #include "testguidestars.moc"
@@ -611,4 +615,155 @@ void TestGuideStars::calibrationTest()
     CompareFloat(cal.raPulseMillisecondsPerArcsecond() * cal.xArcsecondsPerPixel(), raPulseRate);
 }
 
+namespace
+{
+constexpr int FRAME_WIDTH = 320;
+constexpr int FRAME_HEIGHT = 240;
+
+struct SimulatedStar
+{
+    double x, y, peak, sigma;
+};
+
+// Renders the stars, moved by dx,dy, on a noisy background into a 16-bit FITS file.
+QByteArray makeFrame(const QVector<SimulatedStar> &stars, double dx, double dy, quint32 seed)
+{
+    std::mt19937 generator(seed);
+    std::normal_distribution<double> background(1000.0, 20.0);
+    QVector<double> pixels(FRAME_WIDTH * FRAME_HEIGHT);
+    for (auto &pixel : pixels)
+        pixel = background(generator);
+    for (const auto &star : stars)
+    {
+        const double x = star.x + dx, y = star.y + dy;
+        for (int row = std::max(0, int(y) - 10); row <= std::min(FRAME_HEIGHT - 1, int(y) + 10); ++row)
+            for (int col = std::max(0, int(x) - 10); col <= std::min(FRAME_WIDTH - 1, int(x) + 10); ++col)
+            {
+                const double r2 = (col - x) * (col - x) + (row - y) * (row - y);
+                pixels[row * FRAME_WIDTH + col] += star.peak * exp(-r2 / (2 * star.sigma * star.sigma));
+            }
+    }
+
+    QByteArray fits;
+    auto addCard = [&fits](const QString &keyword, const QString &value)
+    {
+        fits.append(QString("%1= %2").arg(keyword, -8).arg(value, 20).leftJustified(80, ' ').toLatin1());
+    };
+    addCard("SIMPLE", "T");
+    addCard("BITPIX", "16");
+    addCard("NAXIS", "2");
+    addCard("NAXIS1", QString::number(FRAME_WIDTH));
+    addCard("NAXIS2", QString::number(FRAME_HEIGHT));
+    addCard("BZERO", "32768");
+    addCard("BSCALE", "1");
+    fits.append(QByteArray("END").leftJustified(80, ' '));
+    fits = fits.leftJustified(2880, ' ');
+    for (const auto pixel : pixels)
+    {
+        const int value = qBound(0, qRound(pixel), 65535) - 32768;
+        fits.append(static_cast<char>((value >> 8) & 0xff));
+        fits.append(static_cast<char>(value & 0xff));
+    }
+    fits.append(QByteArray((2880 - fits.size() % 2880) % 2880, '\0'));
+    return fits;
+}
+}  // namespace
+
+// Follows a star field with windowed detection: a star leaving its window, the periodic full
+// detection, and a move of the field beyond the windows.
+void TestGuideStars::windowedDetectionTest()
+{
+    // The options are restored even if a check fails.
+    const bool windowedDetection = Options::guideWindowedDetection();
+    const uint fullDetectionInterval = Options::guideFullDetectionInterval();
+    const uint minDetections = Options::minDetectionsSEPMultistar();
+    const uint maxReferenceStars = Options::maxMultistarReferenceStars();
+    const auto restoreOptions = qScopeGuard([ = ]()
+    {
+        Options::setGuideWindowedDetection(windowedDetection);
+        Options::setGuideFullDetectionInterval(fullDetectionInterval);
+        Options::setMinDetectionsSEPMultistar(minDetections);
+        Options::setMaxMultistarReferenceStars(maxReferenceStars);
+    });
+    Options::setGuideWindowedDetection(true);
+    Options::setGuideFullDetectionInterval(4);
+    Options::setMinDetectionsSEPMultistar(5);
+    Options::setMaxMultistarReferenceStars(10);
+
+    const QVector<SimulatedStar> stars =
+    {
+        {60, 50, 3000, 1.5}, {130, 60, 6000, 1.7}, {200, 45, 2500, 1.4}, {265, 70, 8000, 1.6},
+        {80, 120, 4000, 1.8}, {160, 115, 9000, 1.5}, {240, 130, 3500, 1.7}, {55, 190, 5000, 1.6},
+        {140, 185, 7000, 1.4}, {250, 195, 4500, 1.8}
+    };
+
+    GuideStars g;
+    QSharedPointer<GuideView> guideView;
+    quint32 seed = 1;
+    // The frame buffers are kept along with their FITSData.
+    QByteArray frame;
+    QSharedPointer<FITSData> imageData;
+    auto load = [&](const QVector<SimulatedStar> &field, double dx, double dy)
+    {
+        imageData.reset();
+        frame = makeFrame(field, dx, dy, seed++);
+        imageData.reset(new FITSData());
+        return imageData->loadFromBuffer(frame, "fits");
+    };
+
+    QVERIFY(load(stars, 0, 0));
+    const QVector3D selected = g.selectGuideStar(imageData);
+    QCOMPARE(g.getNumReferences(), stars.size());
+    int guideIndex = -1;
+    for (int i = 0; i < stars.size(); ++i)
+    {
+        if (hypot(selected.x() - stars[i].x, selected.y() - stars[i].y) < 1)
+            guideIndex = i;
+    }
+    QVERIFY(guideIndex >= 0);
+    const QRect trackingBox(selected.x() - 16, selected.y() - 16, 32, 32);
+
+    auto findGuideStar = [&](double dx, double dy, bool firstFrame)
+    {
+        const GuiderUtils::Vector position = g.findGuideStar(imageData, trackingBox, guideView, firstFrame);
+        return fabs(position.x - stars[guideIndex].x - dx) < 0.25 && fabs(position.y - stars[guideIndex].y - dy) < 0.25;
+    };
+
+    // The first frame is always searched whole.
+    QVERIFY(findGuideStar(0, 0, true));
+    QCOMPARE(g.m_FramesSinceFullDetection, 0);
+
+    // Small moves are followed in the windows.
+    QVERIFY(load(stars, 2, 1));
+    QVERIFY(findGuideStar(2, 1, false));
+    QCOMPARE(g.m_FramesSinceFullDetection, 1);
+    QCOMPARE(g.getNumReferencesFound(), stars.size());
+
+    // A reference star leaves its window, the others still find the guide star.
+    QVector<SimulatedStar> leaving = stars;
+    const int leavingIndex = guideIndex == 0 ? 1 : 0;
+    leaving[leavingIndex].x = 20;
+    leaving[leavingIndex].y = 220;
+    QVERIFY(load(leaving, 3, -1));
+    QVERIFY(findGuideStar(3, -1, false));
+    QCOMPARE(g.m_FramesSinceFullDetection, 2);
+    QCOMPARE(g.getNumReferencesFound(), stars.size() - 1);
+
+    QVERIFY(load(stars, 1, 2));
+    QVERIFY(findGuideStar(1, 2, false));
+    QCOMPARE(g.m_FramesSinceFullDetection, 3);
+    QCOMPARE(g.getNumReferencesFound(), stars.size());
+
+    // Every fourth frame is searched whole.
+    QVERIFY(load(stars, 1, 2));
+    QVERIFY(findGuideStar(1, 2, false));
+    QCOMPARE(g.m_FramesSinceFullDetection, 0);
+
+    // The field moved beyond the windows, which find too few stars, and the whole frame is searched.
+    QVERIFY(load(stars, 31, 27));
+    QVERIFY(findGuideStar(31, 27, false));
+    QCOMPARE(g.m_FramesSinceFullDetection, 0);
+    QCOMPARE(g.getNumReferencesFound(), stars.size());
+}
+
 QTEST_GUILESS_MAIN(TestGuideStars)
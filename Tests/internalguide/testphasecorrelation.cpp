@@ -0,0 +1,324 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "ekos/guide/internalguide/phasecorrelation.h"
+#include "ekos/guide/internalguide/imageautoguiding.h"
+
+#include <QtTest>
+
+#include <QObject>
+
+#include <cmath>
+
+class TestPhaseCorrelation : public QObject
+{
+        Q_OBJECT
+
+    public:
+        /** @short Constructor */
+        TestPhaseCorrelation();
+
+        /** @short Destructor */
+        ~TestPhaseCorrelation() override = default;
+
+    private slots:
+        void testShift_data();
+        void testShift();
+        void testRegion();
+        void testTracking_data();
+        void testTracking();
+        void testTrackingBox();
+        void benchmarkShift_data();
+        void benchmarkShift();
+};
+
+#include "testphasecorrelation.moc"
+
+TestPhaseCorrelation::TestPhaseCorrelation() : QObject()
+{
+}
+
+namespace
+{
+struct Star
+{
+    double x, y, flux;
+};
+
+double random(double low, double high)
+{
+    return low + (high - low) * (rand() % 10000) / 10000.0;
+}
+
+// Renders stars of 1.5 pixel sigma, and optionally a nebula, moved by (dx, dy), over a noisy background
+QVector<float> render(int width, int height, const QVector<Star> &stars, bool nebula, double dx, double dy)
+{
+    QVector<float> image(width * height);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            const double X = x - dx, Y = y - dy;
+            double value = 100 + random(-5, 5);
+            if (nebula)
+            {
+                const double cx = X - width * 0.4, cy = Y - height * 0.55, sigma = width * 0.15;
+                value += 200 * std::exp(-(cx * cx + cy * cy) / (2 * sigma * sigma)) + 40 * std::sin(X * 0.11) * std::cos(Y * 0.07)
+                         + 30 * std::sin((X + Y) * 0.05);
+            }
+            for (const auto &star : stars)
+            {
+                const double sx = X - star.x, sy = Y - star.y;
+                value += star.flux * std::exp(-(sx * sx + sy * sy) / (2 * 1.5 * 1.5));
+            }
+            image[y * width + x] = value;
+        }
+    }
+    return image;
+}
+
+QVector<Star> randomStars(int count, int width, int height)
+{
+    QVector<Star> stars;
+    for (int i = 0; i < count; i++)
+        stars.append({random(0, width), random(0, height), random(300, 2300)});
+    return stars;
+}
+}
+
+void TestPhaseCorrelation::testShift_data()
+{
+    QTest::addColumn<int>("WIDTH");
+    QTest::addColumn<int>("HEIGHT");
+    QTest::addColumn<int>("STARS");
+    QTest::addColumn<bool>("NEBULA");
+    QTest::addColumn<int>("DOWNSAMPLE");
+    QTest::addColumn<double>("TOLERANCE");
+
+    QTest::newRow("single star, 64x64") << 64 << 64 << 1 << false << 1 << 0.1;
+    QTest::newRow("stars, 97x53") << 97 << 53 << 4 << false << 1 << 0.15;
+    QTest::newRow("stars, 320x240 by 2") << 320 << 240 << 25 << false << 2 << 0.25;
+    QTest::newRow("nebula, 256x192") << 256 << 192 << 0 << true << 1 << 0.8;
+    QTest::newRow("nebula, 256x192 by 2") << 256 << 192 << 0 << true << 2 << 0.8;
+}
+
+// Frames moved by known sub-pixel shifts must be measured close to them.
+void TestPhaseCorrelation::testShift()
+{
+    QFETCH(int, WIDTH);
+    QFETCH(int, HEIGHT);
+    QFETCH(int, STARS);
+    QFETCH(bool, NEBULA);
+    QFETCH(int, DOWNSAMPLE);
+    QFETCH(double, TOLERANCE);
+
+    srand(11);
+    QVector<Star> stars = randomStars(STARS, WIDTH, HEIGHT);
+    if (STARS == 1)
+        stars[0] = {WIDTH / 2.0, HEIGHT / 2.0, 1000};
+
+    PhaseCorrelation correlation;
+    correlation.setDownsample(DOWNSAMPLE);
+    const QVector<float> reference = render(WIDTH, HEIGHT, stars, NEBULA, 0, 0);
+    QVERIFY(correlation.setReference(reference.constData(), WIDTH, HEIGHT));
+
+    for (int i = 0; i < 20; i++)
+    {
+        const double dx = random(-6, 6), dy = random(-6, 6);
+        const QVector<float> frame = render(WIDTH, HEIGHT, stars, NEBULA, dx, dy);
+        double x = 0, y = 0;
+        QVERIFY(correlation.findShift(frame.constData(), WIDTH, HEIGHT, &x, &y));
+        QVERIFY2(std::hypot(x - dx, y - dy) < TOLERANCE,
+                 qPrintable(QString("Shift (%1, %2) measured as (%3, %4)").arg(dx).arg(dy).arg(x).arg(y)));
+    }
+}
+
+// The reference is taken from a region of the frame, which frames must keep covering.
+void TestPhaseCorrelation::testRegion()
+{
+    constexpr int width = 200, height = 150;
+    srand(5);
+    const QVector<Star> stars = { {120, 60, 1500}, {135, 80, 700}, {20, 20, 2000} };
+    const QVector<float> reference = render(width, height, stars, false, 0, 0);
+
+    PhaseCorrelation correlation;
+    double x = 0, y = 0;
+    QVERIFY(!correlation.findShift(reference.constData(), width, height, &x, &y));
+    QVERIFY(!correlation.setReference(reference.constData(), width, height, QRect(100, 50, 6, 40)));
+    QVERIFY(!correlation.hasReference());
+
+    QVERIFY(correlation.setReference(reference.constData(), width, height, QRect(100, 40, 50, 60)));
+    QCOMPARE(correlation.region(), QRect(100, 40, 50, 60));
+
+    // The star out of the region does not move with the others.
+    QVector<Star> moved = stars;
+    moved[0] = {121.5, 58, 1500};
+    moved[1] = {136.5, 78, 700};
+    const QVector<float> frame = render(width, height, moved, false, 0, 0);
+    QVERIFY(correlation.findShift(frame.constData(), width, height, &x, &y));
+    QVERIFY(std::abs(x - 1.5) < 0.1);
+    QVERIFY(std::abs(y + 2) < 0.1);
+
+    // Frames too small for the region cannot be correlated.
+    QVERIFY(!correlation.findShift(frame.constData(), 120, 90, &x, &y));
+
+    correlation.clearReference();
+    QVERIFY(!correlation.findShift(frame.constData(), width, height, &x, &y));
+}
+
+void TestPhaseCorrelation::testTracking_data()
+{
+    QTest::addColumn<int>("WIDTH");
+    QTest::addColumn<int>("HEIGHT");
+    QTest::addColumn<int>("STARS");
+    QTest::addColumn<bool>("NEBULA");
+    QTest::addColumn<int>("BOX");
+    QTest::addColumn<int>("DOWNSAMPLE");
+    QTest::addColumn<double>("STEP");
+    QTest::addColumn<double>("TOLERANCE");
+
+    QTest::newRow("star, box 32, 1.5 px steps") << 160 << 120 << 0 << false << 32 << 1 << 1.5 << 0.1;
+    QTest::newRow("star, box 32, 5 px steps") << 160 << 120 << 0 << false << 32 << 1 << 5.0 << 0.1;
+    QTest::newRow("stars, box 32, 3 px steps") << 160 << 120 << 6 << false << 32 << 1 << 3.0 << 0.1;
+    QTest::newRow("stars, box 64 by 2, 5 px steps") << 160 << 120 << 12 << false << 64 << 2 << 5.0 << 0.2;
+    QTest::newRow("nebula, full frame, 3 px steps") << 256 << 192 << 0 << true << 0 << 1 << 3.0 << 0.8;
+}
+
+// Calibration moves the guide star by up to CalibrationMaxMove, 15 pixels, along each axis and
+// back, with the tracking box following it. The positions found must follow the star.
+void TestPhaseCorrelation::testTracking()
+{
+    QFETCH(int, WIDTH);
+    QFETCH(int, HEIGHT);
+    QFETCH(int, STARS);
+    QFETCH(bool, NEBULA);
+    QFETCH(int, BOX);
+    QFETCH(int, DOWNSAMPLE);
+    QFETCH(double, STEP);
+    QFETCH(double, TOLERANCE);
+
+    srand(7);
+    QVector<Star> stars = randomStars(STARS, WIDTH, HEIGHT);
+    const double starX = 70.3, starY = 55.6;
+    if (!NEBULA)
+        stars.prepend({starX, starY, 1500});
+
+    // The tracking box is centered on the last position found, as the guide module does
+    auto box = [&](double x, double y)
+    {
+        return BOX == 0 ? QRect() : QRect(x - BOX / 2.0, y - BOX / 2.0, BOX, BOX);
+    };
+
+    PhaseCorrelation correlation;
+    correlation.setDownsample(DOWNSAMPLE);
+    QVector<float> frame = render(WIDTH, HEIGHT, stars, NEBULA, 0, 0);
+    double x = 0, y = 0;
+    QVERIFY(correlation.track(frame.constData(), WIDTH, HEIGHT, box(starX, starY), &x, &y));
+    const double originX = x, originY = y;
+
+    double dx = 0, dy = 0;
+    for (const double angle : {0.5, 0.5 + M_PI / 2})
+    {
+        for (const int direction : {1, -1})
+        {
+            for (int i = 0; i < std::ceil(15 / STEP); i++)
+            {
+                dx += direction * STEP * std::cos(angle);
+                dy += direction * STEP * std::sin(angle);
+                const QRect region = box(x, y);
+                frame = render(WIDTH, HEIGHT, stars, NEBULA, dx, dy);
+                QVERIFY(correlation.track(frame.constData(), WIDTH, HEIGHT, region, &x, &y));
+                QVERIFY2(std::hypot(x - originX - dx, y - originY - dy) < TOLERANCE,
+                         qPrintable(QString("Moved by (%1, %2), found at (%3, %4)").arg(dx).arg(dy).arg(x - originX).arg(y - originY)));
+            }
+        }
+    }
+}
+
+// The tracking box may change size, or leave the frame.
+void TestPhaseCorrelation::testTrackingBox()
+{
+    constexpr int width = 160, height = 120;
+    srand(7);
+    QVector<Star> stars = randomStars(6, width, height);
+    stars.prepend({70.3, 55.6, 1500});
+
+    PhaseCorrelation correlation;
+    QVector<float> frame = render(width, height, stars, false, 0, 0);
+    double x = 0, y = 0;
+    QRect region(54, 39, 32, 32);
+    QVERIFY(correlation.track(frame.constData(), width, height, region, &x, &y));
+    QCOMPARE(x, 70.0);
+    QCOMPARE(y, 55.0);
+
+    frame = render(width, height, stars, false, 4, -3);
+    QVERIFY(correlation.track(frame.constData(), width, height, region, &x, &y));
+    QVERIFY(std::hypot(x - 74, y - 52) < 0.1);
+
+    // A larger box takes a new reference, positions carry on from the last one
+    region = QRect(x - 24, y - 24, 48, 48);
+    QVERIFY(correlation.track(frame.constData(), width, height, region, &x, &y));
+    QVERIFY(std::hypot(x - 74, y - 52) < 0.1);
+    QCOMPARE(correlation.region(), region);
+
+    frame = render(width, height, stars, false, 9, 2);
+    QVERIFY(correlation.track(frame.constData(), width, height, region, &x, &y));
+    QVERIFY(std::hypot(x - 79, y - 57) < 0.1);
+
+    // A box out of the frame cannot be read, the reference is kept for the next frames
+    QVERIFY(!correlation.track(frame.constData(), width, height, region.translated(width, 0), &x, &y));
+    QVERIFY(correlation.track(frame.constData(), width, height, region, &x, &y));
+    QVERIFY(std::hypot(x - 79, y - 57) < 0.1);
+}
+
+void TestPhaseCorrelation::benchmarkShift_data()
+{
+    QTest::addColumn<bool>("CORRELATION");
+    QTest::addColumn<int>("SIZE");
+
+    for (const int size : {64, 128, 256})
+    {
+        QTest::newRow(qPrintable(QString("ImageAutoGuiding1 %1x%1").arg(size))) << false << size;
+        QTest::newRow(qPrintable(QString("PhaseCorrelation %1x%1").arg(size))) << true << size;
+    }
+}
+
+// Times the measure of the shift of a star field, from frame to frame, by the phase correlation
+// keeping its plans and reference spectrum and by the routine transforming both frames each time.
+void TestPhaseCorrelation::benchmarkShift()
+{
+    QFETCH(bool, CORRELATION);
+    QFETCH(int, SIZE);
+
+    srand(3);
+    const QVector<Star> stars = randomStars(SIZE * SIZE / 400, SIZE, SIZE);
+    QVector<float> reference = render(SIZE, SIZE, stars, false, 0, 0);
+    QVector<float> frame = render(SIZE, SIZE, stars, false, 2.3, -1.6);
+
+    if (CORRELATION)
+    {
+        PhaseCorrelation correlation;
+        QVERIFY(correlation.setReference(reference.constData(), SIZE, SIZE));
+        double x = 0, y = 0;
+        QVERIFY(correlation.findShift(frame.constData(), SIZE, SIZE, &x, &y));
+        QVERIFY(std::abs(x - 2.3) < 0.1 && std::abs(y + 1.6) < 0.1);
+
+        QBENCHMARK
+        {
+            correlation.findShift(frame.constData(), SIZE, SIZE, &x, &y);
+        }
+    }
+    else
+    {
+        float x = 0, y = 0;
+        QBENCHMARK
+        {
+            ImageAutoGuiding::ImageAutoGuiding1(reference.data(), frame.data(), SIZE, &x, &y);
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(TestPhaseCorrelation)
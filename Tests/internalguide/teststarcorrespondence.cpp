@@ -24,6 +24,9 @@ class TestStarCorrespondence : public QObject
 
     private slots:
         void basicTest();
+        void benchmarkFind_data();
+        void benchmarkFind();
+        void gridEdgesTest();
 };
 
 #include "teststarcorrespondence.moc"
@@ -238,4 +241,75 @@ void TestStarCorrespondence::basicTest()
     runNoCorrespondenceTest();
 }
 
+void TestStarCorrespondence::benchmarkFind_data()
+{
+    QTest::addColumn<int>("NUM_STARS");
+    QTest::addColumn<int>("NUM_REFERENCES");
+
+    QTest::newRow("10 stars") << 10 << 10;
+    QTest::newRow("100 stars") << 100 << 50;
+    QTest::newRow("1000 stars") << 1000 << 300;
+}
+
+// Times the correspondence of frames of random stars with many references, from frame to frame.
+void TestStarCorrespondence::benchmarkFind()
+{
+    QFETCH(int, NUM_STARS);
+    QFETCH(int, NUM_REFERENCES);
+    constexpr double maxDistanceToStar = 5.0;
+    constexpr int width = 4000, height = 3000;
+
+    // Stars are spread over a grid of 100x120 pixel cells, at least 40 pixels apart.
+    srand(7);
+    QList<Edge> stars;
+    for (int i = 0; i < NUM_STARS; ++i)
+        stars.append(makeEdge((i % 40) * 100 + 20 + rand() % 60, (i / 40) * 120 + 20 + rand() % 80));
+    StarCorrespondence c(stars.mid(0, NUM_REFERENCES), 0);
+    c.setImageSize(width, height);
+
+    // The detected stars moved a little, and some of the references were not detected.
+    QList<Edge> detected;
+    QVector<int> expected;
+    for (int i = NUM_STARS - 1; i >= 0; --i)
+    {
+        if (i > 0 && i % 7 == 0)
+            continue;
+        const double noise = ((rand() % 200) - 100) / 200.0;
+        detected.append(makeEdge(stars[i].x + 3.5 + noise, stars[i].y - 2.0 - noise));
+        expected.append(i < NUM_REFERENCES ? i : -1);
+    }
+
+    QVector<int> output;
+    Edge gStar = c.find(detected, maxDistanceToStar, &output, false);
+    QCOMPARE(gStar.x, detected.last().x);
+    QCOMPARE(gStar.y, detected.last().y);
+    QCOMPARE(output, expected);
+
+    QBENCHMARK
+    {
+        c.find(detected, maxDistanceToStar, &output, false);
+    }
+}
+
+// The stars at the extremes of the field must fall in the grid, whatever the rounding of their coordinates.
+void TestStarCorrespondence::gridEdgesTest()
+{
+    srand(11);
+    for (int trial = 0; trial < 200; ++trial)
+    {
+        QList<Edge> stars;
+        const int numStars = 5 + rand() % 40;
+        for (int i = 0; i < numStars; ++i)
+            stars.append(makeEdge(rand() % 100000 / 37.0f, rand() % 100000 / 41.0f));
+        StarCorrespondence c(stars, 0);
+        c.setImageSize(2800, 2500);
+
+        QVector<int> output, expected;
+        for (int i = 0; i < numStars; ++i)
+            expected.append(i);
+        c.find(stars, 0.5, &output, false);
+        QCOMPARE(output, expected);
+    }
+}
+
 QTEST_GUILESS_MAIN(TestStarCorrespondence)
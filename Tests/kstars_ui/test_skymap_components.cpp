@@ -0,0 +1,114 @@
+/*  KStars UI tests
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "test_skymap_components.h"
+
+#include "kstars_ui_tests.h"
+#include "test_kstars_startup.h"
+
+#include "Options.h"
+#include "kstars.h"
+#include "kstarsdata.h"
+#include "skymap.h"
+#include "skycomponents/constellationboundarylines.h"
+#include "skycomponents/skymapcomposite.h"
+
+#include <QRandomGenerator>
+#include <QtTest>
+
+TestSkyMapComponents::TestSkyMapComponents(QObject *parent): QObject(parent)
+{
+}
+
+void TestSkyMapComponents::initTestCase()
+{
+    KTELL_BEGIN();
+}
+
+void TestSkyMapComponents::cleanupTestCase()
+{
+    KTELL_END();
+}
+
+void TestSkyMapComponents::testConstellationIds()
+{
+    ConstellationBoundaryLines * const boundaries = KStarsData::Instance()->skyComposite()->constellationBoundary();
+    QVERIFY(boundaries != nullptr);
+
+    KTELL("Look up random points and the named stars one by one, then all at once");
+    QVector<SkyPoint> points;
+    QRandomGenerator generator(42);
+    for (int i = 0; i < 50000; i++)
+        points.append(SkyPoint(dms(generator.bounded(360.0)), dms(generator.bounded(180.0) - 90.0)));
+    // Boundaries crossing 0h and the poles are handled separately
+    for (double dec = -90.0; dec <= 90.0; dec += 0.5)
+    {
+        points.append(SkyPoint(dms(0.0), dms(dec)));
+        points.append(SkyPoint(dms(359.999), dms(dec)));
+    }
+    for (SkyObject *star : KStarsData::Instance()->skyComposite()->stars())
+        points.append(SkyPoint(star->ra(), star->dec()));
+
+    QVector<const SkyPoint *> batch;
+    for (const SkyPoint &point : points)
+        batch.append(&point);
+    const QVector<int> ids = boundaries->constellationIds(batch);
+    QCOMPARE(ids.size(), points.size());
+
+    for (int i = 0; i < points.size(); i++)
+    {
+        QVERIFY2(ids[i] == boundaries->constellationId(&points[i]),
+                 qPrintable(QString("Lookups differ at RA %1 Dec %2").arg(points[i].ra().toHMSString(),
+                            points[i].dec().toDMSString())));
+        QVERIFY(ids[i] >= 0);
+    }
+
+    KTELL("Check a few well-known points");
+    const bool localNames = Options::useLocalConstellNames();
+    Options::setUseLocalConstellNames(false);
+    SkyPoint betelgeuse(5.919529, 7.407064), polaris(2.530301, 89.264109), acrux(12.443311, -63.099092);
+    QCOMPARE(boundaries->constellationName(&betelgeuse), QString("Orion"));
+    QCOMPARE(boundaries->constellationName(&polaris), QString("Ursa Minor"));
+    QCOMPARE(boundaries->constellationName(&acrux), QString("Crux"));
+    Options::setUseLocalConstellNames(localNames);
+}
+
+void TestSkyMapComponents::testFocusObject_data()
+{
+    QTest::addColumn<bool>("comet");
+
+    QTest::newRow("asteroid") << false;
+    QTest::newRow("comet") << true;
+}
+
+void TestSkyMapComponents::testFocusObject()
+{
+    QFETCH(bool, comet);
+
+    KTELL("Look for the saved focus object once the background loading is done");
+    SkyMapComposite * const composite = KStarsData::Instance()->skyComposite();
+    composite->waitForLoading();
+    QVERIFY(!composite->isLoading());
+
+    const QList<SkyObject *> &objects = comet ? composite->comets() : composite->asteroids();
+    QVERIFY(!objects.isEmpty());
+    SkyObject * const object = objects.first();
+
+    // Objects below the horizon would be confirmed from a dialog
+    const bool showGround = Options::showGround();
+    const QString focusObject = Options::focusObject();
+    Options::setShowGround(false);
+
+    KTELL(QString("Restore the focus on %1").arg(object->name()));
+    Options::setFocusObject(object->name());
+    KStars::Instance()->applyConfig(true);
+    QTRY_VERIFY_WITH_TIMEOUT(KStars::Instance()->map()->focusObject() == object, 5000);
+
+    Options::setFocusObject(focusObject);
+    Options::setShowGround(showGround);
+}
+
+QTEST_KSTARS_MAIN(TestSkyMapComponents)
@@ -0,0 +1,33 @@
+/*  KStars UI tests
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef TEST_SKYMAP_COMPONENTS_H
+#define TEST_SKYMAP_COMPONENTS_H
+
+#include "config-kstars.h"
+#include <QObject>
+
+/**
+ * @class TestSkyMapComponents
+ * @short Checks the sky map components once KStars is running, with the data it ships.
+ */
+class TestSkyMapComponents: public QObject
+{
+    Q_OBJECT
+public:
+    explicit TestSkyMapComponents(QObject* parent = nullptr);
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testConstellationIds();
+
+    void testFocusObject_data();
+    void testFocusObject();
+};
+
+#endif // TEST_SKYMAP_COMPONENTS_H
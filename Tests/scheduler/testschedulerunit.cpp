@@ -11,6 +11,9 @@
 
 #include "ekos/scheduler/scheduler.h"
 #include "ekos/scheduler/schedulerjob.h"
+#include "ekos/scheduler/greedyscheduler.h"
+#include "ekos/scheduler/schedulerephemeris.h"
+#include "ksnumbers.h"
 #include "indi/indiproperty.h"
 #include "ekos/capture/sequencejob.h"
 #include "ekos/capture/placeholderpath.h"
@@ -44,6 +47,8 @@ class TestSchedulerUnit : public QObject
         void estimateJobTimeTest();
         void calculateJobScoreTest();
         void evaluateJobsTest();
+        void ephemerisTest();
+        void simulationTest();
 
     private:
         void runSetupJob(SchedulerJob &job,
@@ -734,4 +739,98 @@ void TestSchedulerUnit::evaluateJobsTest()
     sortedJobs.clear();
 }
 
+// Test SchedulerEphemeris against the exact computation of the target position.
+void TestSchedulerUnit::ephemerisTest()
+{
+    SkyPoint target;
+    target.setRA0(midnightRA);
+    target.setDec0(testDEC);
+
+    // Sample the day around midNight at instants between the minutes of the timeline
+    for (int seconds = -12 * 3600; seconds <= 12 * 3600; seconds += 37 * 60 + 13)
+    {
+        const KStarsDateTime ut = siliconValley.LTtoUT(midNight.addSecs(seconds));
+
+        SkyObject o;
+        o.setRA0(target.ra0());
+        o.setDec0(target.dec0());
+        KSNumbers numbers(ut.djd());
+        o.updateCoordsNow(&numbers);
+        CachingDms const LST = siliconValley.GSTtoLST(ut.gst());
+        o.EquatorialToHorizontal(&LST, siliconValley.lat());
+
+        const Ekos::SchedulerEphemeris::Sample sample =
+            Ekos::SchedulerEphemeris::Instance()->sample(target, &siliconValley, ut.djd());
+
+        QVERIFY(compareFloat(sample.altitude, o.alt().Degrees(), .01));
+
+        double hourAngle = LST.Hours() - o.ra().Hours();
+        if (hourAngle < 0)
+            hourAngle += 24.0;
+        const double hourAngleError = std::fabs(sample.hourAngle - hourAngle);
+        QVERIFY(hourAngleError < .001 || hourAngleError > 24 - .001);
+
+        // Azimuth is not defined at the zenith
+        if (o.alt().Degrees() < 85)
+        {
+            const double azimuthError = std::fabs(sample.azimuth - o.az().Degrees());
+            QVERIFY(azimuthError < .01 || azimuthError > 360 - .01);
+        }
+    }
+
+    // Moving the observatory drops the timelines
+    GeoLocation elsewhere(dms(2, 20), dms(48, 51), "Paris", "", "France", 1);
+    const KStarsDateTime ut = siliconValley.LTtoUT(midNight);
+    const double here = Ekos::SchedulerEphemeris::Instance()->sample(target, &siliconValley, ut.djd()).altitude;
+    const double there = Ekos::SchedulerEphemeris::Instance()->sample(target, &elsewhere, ut.djd()).altitude;
+    QVERIFY(!compareFloat(here, there, 1));
+    QVERIFY(compareFloat(here, Ekos::SchedulerEphemeris::Instance()->sample(target, &siliconValley, ut.djd()).altitude));
+}
+
+// Test that the greedy scheduler plan, simulated on a worker thread, doesn't override
+// the state of a job that is started while the simulation is in flight.
+void TestSchedulerUnit::simulationTest()
+{
+    auto now = midNight;
+    Scheduler::setLocalTime(&now);
+    const QMap<QString, uint16_t> capturedFrames;
+
+    SchedulerJob job1(nullptr), job2(nullptr);
+    runSetupJob(job1, &siliconValley, &midNight, "Job1", 10,
+                midnightRA, testDEC, 0.0,
+                QUrl(QString("file:%1").arg(seqFile9Filters)), QUrl(""),
+                SchedulerJob::START_ASAP, QDateTime(), 0,
+                SchedulerJob::FINISH_SEQUENCE, QDateTime(), 1,
+                30.0);
+    runSetupJob(job2, &siliconValley, &midNight, "Job2", 10,
+                midnightRA, testDEC, 0.0,
+                QUrl(QString("file:%1").arg(seqFile9Filters)), QUrl(""),
+                SchedulerJob::START_ASAP, QDateTime(), 0,
+                SchedulerJob::FINISH_SEQUENCE, QDateTime(), 1,
+                30.0);
+    QList<SchedulerJob *> jobs = {&job1, &job2};
+
+    // Without interference, the plan runs the first job now, and the second one after it.
+    Ekos::GreedyScheduler scheduler;
+    scheduler.scheduleJobs(jobs, now, capturedFrames, nullptr);
+    QVERIFY(scheduler.getScheduledJob() == &job1);
+    QVERIFY(scheduler.getSchedule().size() >= 2);
+    QVERIFY(job1.getState() == SchedulerJob::JOB_SCHEDULED);
+    QVERIFY(job2.getState() == SchedulerJob::JOB_SCHEDULED);
+    QVERIFY(job2.getStartupTime() > now);
+
+    // The scheduler starts the selected job before the plan is applied.
+    scheduler.scheduleJobs(jobs, now, capturedFrames, nullptr);
+    QVERIFY(scheduler.getScheduledJob() == &job1);
+    const QDateTime startup = job1.getStartupTime();
+    job1.setState(SchedulerJob::JOB_BUSY);
+    scheduler.waitForSimulation();
+
+    // The running job is left alone, the others still get the plan.
+    QVERIFY(job1.getState() == SchedulerJob::JOB_BUSY);
+    QVERIFY(job1.getStartupTime() == startup);
+    QVERIFY(job2.getState() == SchedulerJob::JOB_SCHEDULED);
+    QVERIFY(job2.getStartupTime() > now);
+}
+
 QTEST_GUILESS_MAIN(TestSchedulerUnit)
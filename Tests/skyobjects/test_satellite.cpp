@@ -0,0 +1,336 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "test_satellite.h"
+
+#include "auxiliary/dms.h"
+#include "geolocation.h"
+#include "skyobjects/satellitegroup.h"
+#include "skyobjects/satellitepasspredictor.h"
+#include "time/kstarsdatetime.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace
+{
+// Low earth orbit, geostationary, Molniya and very low perigee orbits, covering the near earth
+// and both deep space resonance paths of SGP4
+const char *TLES[][3] =
+{
+    {
+        "ISS (ZARYA)",
+        "1 25544U 98067A   22016.52213176  .00005735  00000-0  11129-3 0  9990",
+        "2 25544  51.6454 339.6960 0006814  31.4165  74.6522 15.49627619321650"
+    },
+    {
+        "GOES 16",
+        "1 41866U 16071A   22016.56418059 -.00000259  00000-0  00000+0 0  9990",
+        "2 41866   0.0362 281.2424 0000776 187.4117 190.6178  1.00271386 19040"
+    },
+    {
+        "MOLNIYA 1-93",
+        "1 28163U 04005A   22016.20856474  .00000149  00000-0  00000+0 0  9990",
+        "2 28163  64.2728 192.0413 6744484 283.3137  11.6588  2.00615834131110"
+    },
+    {
+        "LOW PERIGEE",
+        "1 43890U 18104C   22016.37125000  .00041237  12345-5  25419-3 0  9990",
+        "2 43890  97.4431  86.1512 0012500 145.2217 215.7391 16.30412118178020"
+    }
+};
+
+// Roughly the size of the CelesTrak active satellites catalog
+constexpr int CATALOG_SIZE = 4096;
+}
+
+TestSatellite::TestSatellite() : QObject()
+{
+}
+
+TestSatellite::~TestSatellite()
+{
+}
+
+void TestSatellite::initTestCase()
+{
+    for (const auto &tle : TLES)
+        m_Satellites.append(new Satellite(tle[0], tle[1], tle[2]));
+    m_Geo = new GeoLocation(dms(-122.42), dms(37.77));
+}
+
+void TestSatellite::cleanupTestCase()
+{
+    qDeleteAll(m_Satellites);
+    m_Satellites.clear();
+    delete m_Geo;
+}
+
+QVector<Satellite *> TestSatellite::satellites(int count) const
+{
+    QVector<Satellite *> copies;
+    for (int i = 0; i < count; i++)
+        copies.append(m_Satellites[i % m_Satellites.size()]->clone());
+    return copies;
+}
+
+Satellite::Observer TestSatellite::observer(long double jd) const
+{
+    return Satellite::observer(jd, m_Geo, m_Geo->GSTtoLST(KStarsDateTime(jd).gst()), -20.0);
+}
+
+void TestSatellite::testBatchMatchesPerObject()
+{
+    QVector<Satellite *> batch = satellites(CATALOG_SIZE / 8);
+    QVector<Satellite *> single = satellites(CATALOG_SIZE / 8);
+    const long double start = KStarsDateTime(QDate(2022, 1, 17), QTime(0, 0)).djd();
+
+    // Deep space satellites integrate their resonances from their previous position, going back
+    // and forth in time checks that this state is kept apart for each satellite.
+    for (const double hours : { 0.0, 6.5, 1.25, 48.0, 12.0, 72.75, -3.0 })
+    {
+        const Satellite::Observer now = observer(start + hours / 24.0);
+        const QVector<Satellite::Position> positions = SatelliteGroup::propagate(batch, now);
+        QCOMPARE(positions.size(), batch.size());
+
+        int visible = 0;
+        for (int i = 0; i < single.size(); i++)
+        {
+            const Satellite::Position expected = single[i]->propagate(now);
+            const Satellite::Position &position = positions[i];
+            const QString where = QString("%1 after %2 h").arg(single[i]->name()).arg(hours);
+
+            QVERIFY2(position.rc == expected.rc, qPrintable(where));
+            if (expected.rc != 0)
+                continue;
+
+            // Both paths run the same computation, positions must be bit for bit identical
+            QVERIFY2(position.az == expected.az && position.alt == expected.alt, qPrintable(where));
+            QVERIFY2(position.velocity == expected.velocity, qPrintable(where));
+            QVERIFY2(position.altitude == expected.altitude && position.range == expected.range, qPrintable(where));
+            QVERIFY2(position.eclipsed == expected.eclipsed && position.visible == expected.visible, qPrintable(where));
+
+            single[i]->setPosition(expected, now);
+            batch[i]->setPosition(position, now);
+            QVERIFY2(batch[i]->ra().Degrees() == single[i]->ra().Degrees(), qPrintable(where));
+            QVERIFY2(batch[i]->dec().Degrees() == single[i]->dec().Degrees(), qPrintable(where));
+            if (position.visible)
+                visible++;
+        }
+        qDebug() << "After" << hours << "h:" << visible << "of" << batch.size() << "satellites visible";
+    }
+
+    qDeleteAll(batch);
+    qDeleteAll(single);
+}
+
+void TestSatellite::testMatchesUpdatePos_data()
+{
+    QTest::addColumn<int>("SATELLITE");
+    QTest::addColumn<double>("HOURS");
+    QTest::addColumn<double>("AZ");
+    QTest::addColumn<double>("ALT");
+    QTest::addColumn<double>("RANGE");
+    QTest::addColumn<double>("ALTITUDE");
+    QTest::addColumn<double>("VELOCITY");
+    QTest::addColumn<bool>("ECLIPSED");
+    QTest::addColumn<bool>("VISIBLE");
+
+    // Positions computed by Satellite::updatePos() before propagation was split from the update of
+    // the satellites, for the test location and the Sun 20 degrees below the horizon.
+    // The altitude is the one updatePos() computed, from a slightly off distance of the observer.
+    struct
+    {
+        int satellite;
+        double hours, az, alt, range, altitude, velocity;
+        bool eclipsed, visible;
+    } const positions[] =
+    {
+        { 0, 0.00, 236.686265, -71.416907, 12525.7856, 331.8555, 7.646887, false, false },
+        { 0, 1.25, 49.227343, -66.413316, 12154.4358, 325.5316, 7.656207, true, false },
+        { 0, 12.00, 232.755195, -12.869217, 4163.9382, 303.4613, 7.659401, true, false },
+        { 0, 48.00, 234.014624, -72.997826, 12629.7016, 367.1302, 7.646476, false, false },
+        { 1, 0.00, 82.141309, -18.191595, 43716.2251, 37903.4397, 3.074947, false, false },
+        { 1, 1.25, 82.141800, -18.195475, 43716.6055, 33113.2746, 3.074950, false, false },
+        { 1, 12.00, 82.170929, -18.216369, 43725.4847, 37695.5633, 3.074476, false, false },
+        { 1, 48.00, 82.149595, -18.194607, 43716.6080, 37102.0697, 3.074946, false, false },
+        { 2, 0.00, 323.101157, 62.046293, 36892.1210, 35761.7725, 1.922224, false, true },
+        { 2, 1.25, 299.759194, 61.191347, 32140.9932, 32341.9916, 2.460618, false, true },
+        { 2, 12.00, 14.290005, -3.862982, 42491.6391, 36669.3202, 1.933369, false, false },
+        { 2, 48.00, 320.912881, 62.240993, 36474.2990, 35514.8360, 1.968627, false, true },
+        { 3, 0.00, 0.014545, -20.343444, 4944.3473, 201.2531, 7.798858, true, false },
+        { 3, 1.25, 69.447460, -25.211167, 5869.0573, -159.5026, 7.791724, true, false },
+        { 3, 12.00, 59.041995, -36.968591, 7973.5994, 415.2469, 7.806126, false, false },
+        { 3, 48.00, 111.532331, -56.527158, 10854.7473, 366.6735, 7.782502, true, false },
+    };
+
+    for (const auto &p : positions)
+        QTest::addRow("%s after %.2f h", TLES[p.satellite][0], p.hours) << p.satellite << p.hours << p.az << p.alt << p.range
+                << p.altitude << p.velocity << p.eclipsed << p.visible;
+}
+
+void TestSatellite::testMatchesUpdatePos()
+{
+    QFETCH(int, SATELLITE);
+    QFETCH(double, HOURS);
+    QFETCH(double, AZ);
+    QFETCH(double, ALT);
+    QFETCH(double, RANGE);
+    QFETCH(double, ALTITUDE);
+    QFETCH(double, VELOCITY);
+    QFETCH(bool, ECLIPSED);
+    QFETCH(bool, VISIBLE);
+
+    // Deep space satellites integrate their resonances from the epoch of their TLE, as updatePos() did
+    QVector<Satellite *> batch { m_Satellites[SATELLITE]->clone() };
+    std::unique_ptr<Satellite> single(m_Satellites[SATELLITE]->clone());
+    const Satellite::Observer now = observer(KStarsDateTime(QDate(2022, 1, 17), QTime(0, 0)).djd() + HOURS / 24.0);
+
+    const Satellite::Position expected = single->propagate(now);
+    const QVector<Satellite::Position> positions = SatelliteGroup::propagate(batch, now);
+
+    for (const Satellite::Position &position : { expected, positions.first() })
+    {
+        QCOMPARE(position.rc, 0);
+        // References are rounded to 1e-6 degree and km/s, and 1e-4 km
+        QVERIFY(std::abs(position.az - AZ) < 1e-5);
+        QVERIFY(std::abs(position.alt - ALT) < 1e-5);
+        QVERIFY(std::abs(position.range - RANGE) < 1e-3);
+        QVERIFY(std::abs(position.altitude - ALTITUDE) < 1e-3);
+        QVERIFY(std::abs(position.velocity - VELOCITY) < 1e-5);
+        QCOMPARE(position.eclipsed, ECLIPSED);
+        QCOMPARE(position.visible, VISIBLE);
+    }
+
+    qDeleteAll(batch);
+}
+
+void TestSatellite::testPassPrediction()
+{
+    std::unique_ptr<Satellite> iss(m_Satellites[0]->clone());
+    const long double start = KStarsDateTime(QDate(2022, 1, 17), QTime(0, 0)).djd();
+    const long double end = start + 2;
+    const long double second = 1.0L / 86400;
+
+    const QVector<SatellitePassPredictor::Pass> passes = SatellitePassPredictor::predict(iss.get(), m_Geo, start, end, 60, 0.0);
+    QVERIFY(!passes.isEmpty());
+
+    for (const auto &pass : passes)
+    {
+        const QString when = pass.culmination.toString(Qt::ISODate);
+        QVERIFY2(pass.rise.djd() < pass.culmination.djd() && pass.culmination.djd() < pass.set.djd(), qPrintable(when));
+        // The ISS stays up for a few minutes
+        QVERIFY2(pass.set.djd() - pass.rise.djd() < 15 * 60 * second, qPrintable(when));
+
+        // Rise and set are found within two seconds
+        QVERIFY2(iss->propagate(observer(pass.rise.djd())).alt >= 0, qPrintable(when));
+        QVERIFY2(iss->propagate(observer(pass.rise.djd() - 2 * second)).alt < 0, qPrintable(when));
+        QVERIFY2(iss->propagate(observer(pass.set.djd())).alt >= 0, qPrintable(when));
+        QVERIFY2(iss->propagate(observer(pass.set.djd() + 2 * second)).alt < 0, qPrintable(when));
+    }
+
+    // Step through the two days every 10 seconds, every pass reaching a degree must have been predicted
+    int found = 0;
+    double highest = -90;
+    long double culmination = 0;
+    for (long double jd = start; jd <= end; jd += 10 * second)
+    {
+        const double altitude = iss->propagate(observer(jd)).alt;
+        if (altitude >= 0)
+        {
+            if (altitude > highest)
+            {
+                highest = altitude;
+                culmination = jd;
+            }
+            continue;
+        }
+        if (highest >= 1 && culmination > start + 15 * 60 * second)
+        {
+            auto pass = std::find_if(passes.cbegin(), passes.cend(), [&](const SatellitePassPredictor::Pass & pass)
+            {
+                return pass.rise.djd() <= culmination && culmination <= pass.set.djd();
+            });
+            QVERIFY2(pass != passes.cend(), qPrintable(KStarsDateTime(culmination).toString(Qt::ISODate)));
+            QVERIFY(std::abs(pass->culmination.djd() - culmination) < 10 * second);
+            QVERIFY(pass->maxAltitude >= highest - 0.01);
+            found++;
+        }
+        highest = -90;
+    }
+    qDebug() << passes.size() << "passes predicted," << found << "found stepping every 10 seconds";
+    QVERIFY(found > 0);
+}
+
+void TestSatellite::testPassCache()
+{
+    QList<Satellite *> satellites;
+    for (Satellite *satellite : m_Satellites)
+        satellites.append(satellite);
+
+    const KStarsDateTime start(QDate(2022, 1, 17), QTime(0, 0));
+    SatellitePassPredictor predictor;
+    QSignalSpy predicted(&predictor, &SatellitePassPredictor::passesPredicted);
+
+    QVERIFY(predictor.predict(satellites, m_Geo, start, 24));
+    predictor.waitForPrediction();
+    QCOMPARE(predicted.count(), 1);
+    QVERIFY(!predictor.passes(start).isEmpty());
+
+    // Still covered, then too close to the end of the prediction
+    QVERIFY(!predictor.predict(satellites, m_Geo, start.addSecs(6 * 3600), 24));
+    QVERIFY(predictor.predict(satellites, m_Geo, start.addSecs(18 * 3600), 24));
+    predictor.waitForPrediction();
+
+    // Another location, and other satellites
+    GeoLocation elsewhere(dms(2.35), dms(48.86));
+    QVERIFY(predictor.predict(satellites, &elsewhere, start.addSecs(18 * 3600), 24));
+    predictor.cancel();
+    QVERIFY(predictor.predict(satellites.mid(1), m_Geo, start.addSecs(18 * 3600), 24));
+    predictor.waitForPrediction();
+    QCOMPARE(predicted.count(), 3);
+
+    for (const auto &pass : predictor.passes(start))
+        QVERIFY(pass.satellite != m_Satellites[0]->name());
+}
+
+void TestSatellite::benchmarkPropagate_data()
+{
+    QTest::addColumn<bool>("BATCH");
+
+    QTest::newRow("propagate") << false;
+    QTest::newRow("SatelliteGroup::propagate") << true;
+}
+
+void TestSatellite::benchmarkPropagate()
+{
+    QFETCH(bool, BATCH);
+
+    QVector<Satellite *> catalog = satellites(CATALOG_SIZE);
+    const Satellite::Observer now = observer(KStarsDateTime(QDate(2022, 1, 17), QTime(21, 30)).djd());
+
+    if (BATCH)
+    {
+        QBENCHMARK
+        {
+            const QVector<Satellite::Position> positions = SatelliteGroup::propagate(catalog, now);
+            for (int i = 0; i < catalog.size(); i++)
+                catalog[i]->setPosition(positions[i], now);
+        }
+    }
+    else
+    {
+        QBENCHMARK
+        {
+            for (Satellite *satellite : catalog)
+                satellite->setPosition(satellite->propagate(now), now);
+        }
+    }
+
+    qDeleteAll(catalog);
+}
+
+QTEST_GUILESS_MAIN(TestSatellite)
@@ -0,0 +1,46 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QtTest/QtTest>
+
+#include "skyobjects/satellite.h"
+
+class GeoLocation;
+
+/**
+ * @class TestSatellite
+ * @short Checks the batched propagation of satellites against the propagation of each satellite.
+ */
+class TestSatellite : public QObject
+{
+        Q_OBJECT
+
+    public:
+        TestSatellite();
+        ~TestSatellite() override;
+
+    private slots:
+        void initTestCase();
+        void cleanupTestCase();
+
+        void testBatchMatchesPerObject();
+        void testMatchesUpdatePos_data();
+        void testMatchesUpdatePos();
+        void testPassPrediction();
+        void testPassCache();
+        void benchmarkPropagate_data();
+        void benchmarkPropagate();
+
+    private:
+        // Copies of the test satellites, @p count in total
+        QVector<Satellite *> satellites(int count) const;
+        Satellite::Observer observer(long double jd) const;
+
+        QVector<Satellite *> m_Satellites;
+        GeoLocation *m_Geo { nullptr };
+};
@@ -0,0 +1,93 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "test_skylabeler.h"
+
+#include "skycomponents/skylabeler.h"
+
+namespace
+{
+// Size of the sky map the virtual screen is set up for
+constexpr int WIDTH  = 800;
+constexpr int HEIGHT = 600;
+}
+
+TestSkyLabeler::TestSkyLabeler() : QObject()
+{
+}
+
+TestSkyLabeler::~TestSkyLabeler()
+{
+}
+
+void TestSkyLabeler::init()
+{
+    m_Labeler = SkyLabeler::Instance();
+    m_Labeler->resetScreen(WIDTH, HEIGHT);
+    QVERIFY(m_Labeler->m_maxY >= 2);
+}
+
+bool TestSkyLabeler::markStrips(qreal left, qreal right, int first, int last)
+{
+    // Rows are strips as high as the font, aim at their middle
+    const qreal yScale = m_Labeler->m_yScale;
+    return m_Labeler->markRegion(left, right, (first + 0.5) * yScale, (last + 0.5) * yScale);
+}
+
+void TestSkyLabeler::testFillRatio()
+{
+    const float strips = m_Labeler->m_maxY + 1;
+    QCOMPARE(m_Labeler->fillRatio(), 0.0f);
+
+    // A label on the screen covers its columns in each of its strips
+    QVERIFY(markStrips(100, 199, 1, 2));
+    QCOMPARE(m_Labeler->fillRatio(), 100.0f * 200 / (strips * WIDTH));
+
+    // Labels in the margins are not counted
+    QVERIFY(markStrips(-600, -400, 0, 0));
+    QVERIFY(markStrips(WIDTH + 400, WIDTH + 600, 0, 0));
+    QCOMPARE(m_Labeler->fillRatio(), 100.0f * 200 / (strips * WIDTH));
+
+    // A label running over both edges only counts the columns of the screen
+    QVERIFY(markStrips(-100, WIDTH + 100, 3, 3));
+    QCOMPARE(m_Labeler->fillRatio(), 100.0f * (200 + WIDTH) / (strips * WIDTH));
+
+    // The whole virtual screen fills the screen exactly
+    m_Labeler->resetScreen(WIDTH, HEIGHT);
+    QVERIFY(markStrips(-2000, WIDTH + 2000, 0, m_Labeler->m_maxY));
+    QCOMPARE(m_Labeler->fillRatio(), 100.0f);
+    QCOMPARE(m_Labeler->marks(), (m_Labeler->m_maxY + 1) * WIDTH);
+}
+
+void TestSkyLabeler::testEdgeCollisions()
+{
+    // Labels running over the left edge collide with labels in the margin, and on the screen
+    QVERIFY(markStrips(-50, 40, 1, 1));
+    QVERIFY(!markStrips(-80, -20, 1, 1));
+    QVERIFY(!markStrips(30, 100, 1, 1));
+
+    // Same over the right edge
+    QVERIFY(markStrips(WIDTH - 40, WIDTH + 50, 1, 1));
+    QVERIFY(!markStrips(WIDTH + 20, WIDTH + 80, 1, 1));
+    QVERIFY(!markStrips(WIDTH - 100, WIDTH - 30, 1, 1));
+
+    // Labels in the margins only collide with the labels they overlap
+    QVERIFY(markStrips(-1000, -900, 1, 1));
+    QVERIFY(markStrips(-800, -700, 1, 1));
+    QVERIFY(markStrips(WIDTH + 700, WIDTH + 800, 1, 1));
+    QVERIFY(!markStrips(WIDTH + 750, WIDTH + 850, 1, 1));
+
+    // Other strips are free, the top and bottom ones included
+    QVERIFY(markStrips(-50, 40, 0, 0));
+    QVERIFY(markStrips(WIDTH - 40, WIDTH + 50, m_Labeler->m_maxY, m_Labeler->m_maxY));
+    // Regions below the screen are kept in the bottom strip
+    QVERIFY(!m_Labeler->markRegion(WIDTH - 20, WIDTH, HEIGHT + 100, HEIGHT + 50));
+
+    QCOMPARE(m_Labeler->hits(), 7);
+    QCOMPARE(m_Labeler->misses(), 6);
+}
+
+QTEST_MAIN(TestSkyLabeler)
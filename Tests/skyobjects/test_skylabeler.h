@@ -0,0 +1,36 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QtTest/QtTest>
+
+class SkyLabeler;
+
+/**
+ * @class TestSkyLabeler
+ * @short Checks the virtual screen of the SkyLabeler, on the screen and in its margins.
+ */
+class TestSkyLabeler : public QObject
+{
+        Q_OBJECT
+
+    public:
+        TestSkyLabeler();
+        ~TestSkyLabeler() override;
+
+    private slots:
+        void init();
+
+        void testFillRatio();
+        void testEdgeCollisions();
+
+    private:
+        // Marks the region covering strips first to last, both included
+        bool markStrips(qreal left, qreal right, int first, int last);
+
+        SkyLabeler *m_Labeler { nullptr };
+};
@@ -11,6 +11,9 @@
 #include "auxiliary/dms.h"
 #include "Options.h"
 #include <libnova/libnova.h>
+
+#include <Eigen/Geometry>
+
 TestSkyPoint::TestSkyPoint() : QObject()
 {
     useRelativistic = Options::useRelativistic();
@@ -614,4 +617,109 @@ void TestSkyPoint::testUpdateCoords()
 
 }
 
+namespace
+{
+// Points spread over the sky, up to a degree from the poles
+QVector<SkyPoint> skyGrid(int raStep, int decStep)
+{
+    QVector<SkyPoint> points;
+    for (int dec = -89; dec <= 89; dec += decStep)
+        for (int ra = 0; ra < 360; ra += raStep)
+            points.append(SkyPoint(dms(ra + 0.5 * dec).reduce(), dms(dec)));
+    return points;
+}
+
+QVector<SkyPoint *> pointers(QVector<SkyPoint> &points)
+{
+    QVector<SkyPoint *> result;
+    for (auto &point : points)
+        result.append(&point);
+    return result;
+}
+
+// Angle between the current coordinates of two points, in milliarcseconds
+double separation(const SkyPoint &p1, const SkyPoint &p2)
+{
+    double sinRa1, cosRa1, sinDec1, cosDec1, sinRa2, cosRa2, sinDec2, cosDec2;
+    p1.ra().SinCos(sinRa1, cosRa1);
+    p1.dec().SinCos(sinDec1, cosDec1);
+    p2.ra().SinCos(sinRa2, cosRa2);
+    p2.dec().SinCos(sinDec2, cosDec2);
+    const Eigen::Vector3d v1(cosDec1 * cosRa1, cosDec1 * sinRa1, sinDec1), v2(cosDec2 * cosRa2, cosDec2 * sinRa2, sinDec2);
+    return std::atan2(v1.cross(v2).norm(), v1.dot(v2)) / dms::DegToRad * 3600.0 * 1000.0;
+}
+}
+
+void TestSkyPoint::testUpdateCoordsBatch_data()
+{
+    QTest::addColumn<QString>("DATE");
+
+    QTest::newRow("1998") << "1998-01-25T19:12";
+    QTest::newRow("2021") << "2021-12-16T14:38";
+    QTest::newRow("2050") << "2050-06-01T00:00";
+}
+
+void TestSkyPoint::testUpdateCoordsBatch()
+{
+    QFETCH(QString, DATE);
+
+    Options::setUseRelativistic(false);
+    KSNumbers num(KStarsDateTime::fromString(DATE).djd());
+
+    QVector<SkyPoint> reference = skyGrid(15, 4);
+    for (auto &point : reference)
+        point.updateCoordsNow(&num);
+
+    QVector<SkyPoint> batch = skyGrid(15, 4);
+    SkyPoint::updateCoordsBatch(pointers(batch).constData(), batch.size(), &num, true);
+
+    // The step by step corrections of updateCoords() are first order in RA and Dec, their second order
+    // terms grow with tan(Dec). The batch agrees to a milliarcsecond near the equator.
+    double worstEquator = 0;
+    for (int i = 0; i < batch.size(); i++)
+    {
+        const double tanDec    = std::tan(reference[i].dec0().radians());
+        const double tolerance = 1.0 + tanDec * tanDec;
+        const double error     = separation(batch[i], reference[i]);
+        QVERIFY2(error < tolerance, qPrintable(QString("RA0 %1 Dec0 %2 error %3 mas").arg(reference[i].ra0().Degrees())
+                 .arg(reference[i].dec0().Degrees()).arg(error)));
+        if (std::abs(reference[i].dec0().Degrees()) <= 20.0)
+            worstEquator = std::max(worstEquator, error);
+    }
+    qDebug() << "Worst batch error within 20 degrees of the equator:" << worstEquator << "mas";
+    QVERIFY(worstEquator < 1.0);
+}
+
+void TestSkyPoint::benchmarkUpdateCoords_data()
+{
+    QTest::addColumn<bool>("BATCH");
+
+    QTest::newRow("updateCoords") << false;
+    QTest::newRow("updateCoordsBatch") << true;
+}
+
+void TestSkyPoint::benchmarkUpdateCoords()
+{
+    QFETCH(bool, BATCH);
+
+    Options::setUseRelativistic(false);
+    KSNumbers num(KStarsDateTime::fromString("2021-12-16T14:38").djd());
+
+    QVector<SkyPoint> points = skyGrid(1, 1);
+    QVector<SkyPoint *> batch = pointers(points);
+
+    if (BATCH)
+    {
+        QBENCHMARK { SkyPoint::updateCoordsBatch(batch.constData(), batch.size(), &num, true); }
+    }
+    else
+    {
+        QBENCHMARK
+        {
+            for (auto &point : points)
+                point.updateCoordsNow(&num);
+        }
+    }
+}
+
 QTEST_GUILESS_MAIN(TestSkyPoint)
@@ -63,6 +63,12 @@ class TestSkyPoint : public QObject
 
         void testUpdateCoords();
 
+        void testUpdateCoordsBatch_data();
+        void testUpdateCoordsBatch();
+
+        void benchmarkUpdateCoords_data();
+        void benchmarkUpdateCoords();
+
     private:
         bool useRelativistic {false};
 };
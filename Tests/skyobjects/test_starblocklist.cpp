@@ -0,0 +1,121 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "test_starblocklist.h"
+
+#include "skycomponents/deepstarcomponent.h"
+#include "skycomponents/starblock.h"
+#include "skycomponents/starblocklist.h"
+
+#include <QAtomicInt>
+#include <QMutexLocker>
+#include <QtConcurrent>
+
+namespace
+{
+// Trixels of the catalog used by the test, many more than the blocks the StarBlockFactory caches
+constexpr Trixel TRIXELS = 128;
+}
+
+TestStarBlockList::TestStarBlockList() : QObject()
+{
+}
+
+TestStarBlockList::~TestStarBlockList()
+{
+}
+
+void TestStarBlockList::initTestCase()
+{
+    // The catalog is looked up in the application data, give it a test copy
+    QStandardPaths::setTestModeEnabled(true);
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    QVERIFY(QDir().mkpath(dir));
+    const QString path = QDir(dir).filePath("unnamedstars.dat");
+    QFile::remove(path);
+    QVERIFY(QFile::copy("unnamedstars.dat", path));
+
+    // Loaded dynamically, as deep star catalogs are
+    m_Component.reset(new DeepStarComponent(nullptr, "unnamedstars.dat", 0, false));
+    QVERIFY(m_Component->fileOpen());
+    QVERIFY(m_Component->getStarReader()->getMappedData() != nullptr);
+}
+
+void TestStarBlockList::cleanupTestCase()
+{
+    m_Lists.clear();
+    m_Component.reset();
+}
+
+QVector<float> TestStarBlockList::magnitudes(StarBlockList *list)
+{
+    QVector<float> mags;
+    for (int i = 0; i < list->getBlockCount(); ++i)
+    {
+        std::shared_ptr<StarBlock> block = list->block(i);
+        if (block->parent != list)
+            return QVector<float>();
+        for (int j = 0; j < block->getStarCount(); ++j)
+            mags << block->mag(j);
+    }
+    if (mags.size() != list->getStarCount())
+        return QVector<float>();
+    return mags;
+}
+
+void TestStarBlockList::testConcurrentLoading()
+{
+    // Reference magnitudes, each trixel filled and read right away
+    QVector<QVector<float>> expected;
+    for (Trixel trixel = 0; trixel < TRIXELS; ++trixel)
+    {
+        std::shared_ptr<StarBlockList> list(new StarBlockList(trixel, m_Component.get()));
+        m_Lists << list;
+
+        QMutexLocker locker(list->mutex());
+        list->fillToMag(30);
+        expected << magnitudes(list.get());
+        QCOMPARE(expected.last().size(), static_cast<int>(m_Component->getStarReader()->getRecordCount(trixel)));
+    }
+
+    // Several threads fill the same trixels in different orders and to different magnitudes, recycling
+    // each other's blocks. Whatever is left in a list must be the first stars of its trixel.
+    QAtomicInt failures;
+    QVector<int> workers { 0, 1, 2, 3, 4, 5, 6, 7 };
+    QtConcurrent::blockingMap(workers, [&](int worker)
+    {
+        for (int round = 0; round < 20; ++round)
+        {
+            const float maglim = (round + worker) % 3 == 0 ? 30 : 4 + round % 5;
+            for (Trixel i = 0; i < TRIXELS; ++i)
+            {
+                const Trixel trixel = (worker % 2 ? TRIXELS - 1 - i : i) * 13 % TRIXELS;
+                StarBlockList *list = m_Lists.at(trixel).get();
+
+                QMutexLocker locker(list->mutex());
+                list->fillToMag(maglim);
+                const QVector<float> mags = magnitudes(list);
+                if (mags.isEmpty() && list->getStarCount() > 0)
+                    failures.ref();
+                else if (mags != expected.at(trixel).mid(0, mags.size()))
+                    failures.ref();
+                else if (!list->isFilledToMag(maglim))
+                    failures.ref();
+            }
+        }
+    });
+    QCOMPARE(failures.loadAcquire(), 0);
+
+    for (Trixel trixel = 0; trixel < TRIXELS; ++trixel)
+    {
+        StarBlockList *list = m_Lists.at(trixel).get();
+        QMutexLocker locker(list->mutex());
+        list->fillToMag(30);
+        QCOMPARE(magnitudes(list), expected.at(trixel));
+    }
+}
+
+QTEST_GUILESS_MAIN(TestStarBlockList)
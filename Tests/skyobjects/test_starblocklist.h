@@ -0,0 +1,41 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QtTest/QtTest>
+
+#include <memory>
+
+class DeepStarComponent;
+class StarBlockList;
+
+/**
+ * @class TestStarBlockList
+ * @short Checks that star block lists filled from several threads hold the same stars as filled one by one.
+ */
+class TestStarBlockList : public QObject
+{
+        Q_OBJECT
+
+    public:
+        TestStarBlockList();
+        ~TestStarBlockList() override;
+
+    private slots:
+        void initTestCase();
+        void cleanupTestCase();
+
+        void testConcurrentLoading();
+
+    private:
+        // The magnitudes of the stars of the list, in order, or an empty list if the blocks are inconsistent
+        static QVector<float> magnitudes(StarBlockList *list);
+
+        std::unique_ptr<DeepStarComponent> m_Component;
+        // Blocks in the StarBlockFactory cache point to their lists, which must outlive the test
+        QVector<std::shared_ptr<StarBlockList>> m_Lists;
+};
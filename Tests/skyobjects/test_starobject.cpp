@@ -9,6 +9,9 @@
 
 #include "skyobjects/skypoint.h"
 #include "skyobjects/starobject.h"
+#include "skyobjects/deepstardata.h"
+#include "skycomponents/deepstarcomponent.h"
+#include "skycomponents/starblock.h"
 #include "ksnumbers.h"
 #include "time/kstarsdatetime.h"
 #include "auxiliary/dms.h"
@@ -292,6 +295,183 @@ void TestStarObject::testUpdateCoords()
 
 }
 
+void TestStarObject::testCompactStarBlock()
+{
+    /*
+     * The compact layout of StarBlock computes the apparent and
+     * horizontal coordinates of a whole block at once. Check it
+     * against StarObject::updateCoords() followed by
+     * EquatorialToHorizontal()
+     */
+
+    Options::setUseRelativistic(false);
+
+    // RA in hours * 1e6, Dec in degrees * 1e5, proper motions in mas/yr * 100, magnitudes * 1000
+    QList<DeepStarData> records;
+    records << DeepStarData { 5500000, 2000000, 0, 0, 6500, 6000 }                 // No proper motion
+            << DeepStarData { 2530000, 8926000, 4448, -1185, 7600, 7000 }          // Near the north pole
+            << DeepStarData { 17963000, 469000, -30000, 30000, 10200, 8000 }       // High proper motion
+            << DeepStarData { 21146000, -8895000, 2667, 561, 9100, 9000 }          // Near the south pole
+            << DeepStarData { 19209000, 6766000, 9574, 9192, 30000, 10000 };       // Near the pole of the ecliptic, no B
+
+    const CachingDms lat(45.0), lst1(150.0), lst2(290.0);
+
+    for (const auto &dt : { KStarsDateTime::fromString("1998-01-25T19:12"), KStarsDateTime::fromString("2021-12-16T14:38") })
+    {
+        KSNumbers num(dt.djd());
+
+        StarBlock block(10, StarBlock::COMPACT_LAYOUT);
+        for (const auto &record : records)
+            QVERIFY(block.addStar(record) == nullptr);
+        QCOMPARE(block.getStarCount(), records.size());
+
+        // The first frame moves the stars to the date, the second one only changes the sidereal time
+        for (const CachingDms *lst : { &lst1, &lst2 })
+        {
+            const StarBlock::Frame frame(&num, lst, &lat, lst == &lst1 ? 1 : 2, 1);
+            block.updateCoords(frame, 20.0);
+
+            for (int i = 0; i < records.size(); ++i)
+            {
+                StarObject reference;
+                reference.init(&records.at(i));
+                reference.updateCoords(&num);
+                reference.EquatorialToHorizontal(lst, &lat);
+
+                SkyPoint buffer;
+                const SkyPoint *position = block.position(i, buffer);
+                const QString msg = QString("%1 star %2 LST %3").arg(dt.toString(Qt::ISODate)).arg(i).arg(lst->Degrees());
+                compare(msg, position->ra().Degrees(), position->dec().Degrees(), reference.ra().Degrees(),
+                        reference.dec().Degrees());
+                compare(msg + " alt", position->alt().Degrees(), reference.alt().Degrees(), 0.0001);
+                compare(msg + " az", std::remainder(position->az().Degrees() - reference.az().Degrees(), 360.0), 0.0, 0.0002);
+                QCOMPARE(block.mag(i), reference.mag());
+                QCOMPARE(block.spchar(i), reference.spchar());
+            }
+        }
+
+        // Creating the StarObjects must not move the stars
+        for (int i = 0; i < records.size(); ++i)
+        {
+            SkyPoint buffer;
+            const SkyPoint *position = block.position(i, buffer);
+            const StarObject *star   = block.star(i);
+            compare(QString("Created star %1").arg(i), star->ra().Degrees(), star->dec().Degrees(), position->ra().Degrees(),
+                    position->dec().Degrees(), 1e-9);
+            compare(QString("Created star %1 alt").arg(i), star->alt().Degrees(), position->alt().Degrees(), 1e-9);
+            QCOMPARE(star->mag(), block.mag(i));
+        }
+    }
+
+    // Only the star asked for gets a StarObject, which a recycled block initializes again in place
+    StarBlock block(10, StarBlock::COMPACT_LAYOUT);
+    for (const auto &record : records)
+        block.addStar(record);
+    const StarObject *created = block.star(2);
+    block.reset();
+    for (int i = 0; i < records.size(); ++i)
+        QCOMPARE(block.addStar(records.at(i)) != nullptr, i == 2);
+    QCOMPARE(block.star(2), created);
+    QCOMPARE(created->mag(), block.mag(2));
+}
+
+void TestStarObject::testAddStars()
+{
+    /*
+     * StarBlockList::fillToMag() hands spans of catalog records to
+     * StarBlock::addStars(), which must stop right after the first
+     * star fainter than the limit, or when the block is full.
+     */
+
+    // Magnitudes 6.0, 6.5, ... 9.5
+    QVector<DeepStarData> records;
+    for (int i = 0; i < 8; ++i)
+        records << DeepStarData { 1000000 * i, 1000000 * i, 0, 0, static_cast<qint16>(7000 + 500 * i),
+                                  static_cast<qint16>(6000 + 500 * i) };
+
+    for (const auto layout : { StarBlock::OBJECT_LAYOUT, StarBlock::COMPACT_LAYOUT })
+    {
+        {
+            StarBlock block(10, layout);
+            QCOMPARE(block.addStars(records.constData(), records.size(), 20.0), records.size());
+            QCOMPARE(block.getStarCount(), records.size());
+            QCOMPARE(block.getFreeCount(), 2);
+            QCOMPARE(block.getBrightMag(), 6.0f);
+            QCOMPARE(block.getFaintMag(), 9.5f);
+        }
+        {
+            // The star crossing the limit is kept, as fillToMag() did record by record
+            StarBlock block(10, layout);
+            QCOMPARE(block.addStars(records.constData(), records.size(), 7.2), 4);
+            QCOMPARE(block.getFaintMag(), 7.5f);
+            QVERIFY(!block.isFull());
+        }
+        {
+            // A full block stops the span, the next block goes on from there
+            StarBlock first(3, layout), second(3, layout);
+            const int consumed = first.addStars(records.constData(), records.size(), 20.0);
+            QCOMPARE(consumed, 3);
+            QVERIFY(first.isFull());
+            QCOMPARE(first.getFaintMag(), 7.0f);
+            QCOMPARE(second.addStars(records.constData() + consumed, records.size() - consumed, 20.0), 3);
+            QCOMPARE(second.getBrightMag(), 7.5f);
+            for (int i = 0; i < 3; ++i)
+            {
+                QCOMPARE(first.mag(i), 6.0f + 0.5f * i);
+                QCOMPARE(second.mag(i), 7.5f + 0.5f * i);
+                QCOMPARE(second.star(i)->ra0().Hours(), records[consumed + i].RA / 1e6);
+            }
+            QCOMPARE(first.addStars(records.constData(), records.size(), 20.0), 0);
+        }
+    }
+}
+
+void TestStarObject::testMappedRecords()
+{
+    /*
+     * Compact blocks filled from a catalog mapped in memory read the
+     * records back from the mapping to create StarObjects, instead
+     * of keeping copies of them.
+     */
+
+    QVector<DeepStarData> records;
+    records << DeepStarData { 5500000, 2000000, 0, 0, 6500, 6000 }
+            << DeepStarData { 2530000, 8926000, 4448, -1185, 7600, 7000 }
+            << DeepStarData { 17963000, 469000, -30000, 30000, 10200, 8000 };
+
+    for (const bool swapped : { false, true })
+    {
+        // The mapped catalog, in the byte order of the file
+        QVector<DeepStarData> mapped = records;
+        if (swapped)
+            DeepStarComponent::byteSwap(mapped.data(), mapped.size());
+        const uchar *source = reinterpret_cast<const uchar *>(mapped.data());
+
+        StarBlock block(10, StarBlock::COMPACT_LAYOUT);
+        QCOMPARE(block.addStars(records.constData(), 2, 20.0, source, swapped), 2);
+        QCOMPARE(block.addStars(records.constData() + 2, 1, 20.0, source + 2 * sizeof(DeepStarData), swapped), 1);
+
+        // Only the mapping knows about this change
+        DeepStarData changed = records.at(1);
+        changed.dRA          = 1234;
+        if (swapped)
+            DeepStarComponent::byteSwap(&changed);
+        mapped[1] = changed;
+
+        for (int i = 0; i < records.size(); ++i)
+        {
+            StarObject reference;
+            reference.init(&records.at(i));
+            const StarObject *star = block.star(i);
+            QCOMPARE(star->ra0().Degrees(), reference.ra0().Degrees());
+            QCOMPARE(star->dec0().Degrees(), reference.dec0().Degrees());
+            QCOMPARE(star->mag(), reference.mag());
+            QCOMPARE(star->getBVIndex(), reference.getBVIndex());
+            QCOMPARE(star->pmRA(), i == 1 ? 12.34 : reference.pmRA());
+        }
+    }
+}
+
 #ifdef HAVE_LIBERFA
 void TestStarObject::compareProperMotionAgainstErfa_data()
 {
@@ -36,6 +36,9 @@ class TestStarObject : public QObject
     private slots:
         void testUpdateCoordsStepByStep();
         void testUpdateCoords();
+        void testCompactStarBlock();
+        void testAddStars();
+        void testMappedRecords();
 #ifdef HAVE_LIBERFA
         void compareProperMotionAgainstErfa_data();
         void compareProperMotionAgainstErfa();
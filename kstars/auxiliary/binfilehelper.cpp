@@ -29,7 +29,7 @@ BinFileHelper::~BinFileHelper()
 void BinFileHelper::init()
 {
     if (fileHandle)
-        fclose(fileHandle);
+        closeFile();
 
     fileHandle      = nullptr;
     indexUpdated    = false;
@@ -73,6 +73,7 @@ FILE *BinFileHelper::openFile(const QString &fileName)
 {
     QString FilePath = KSPaths::locate(QStandardPaths::AppLocalDataLocation, fileName);
     init();
+    filePath             = FilePath;
     QByteArray b         = FilePath.toLatin1();
     const char *filepath = b.data();
 
@@ -86,6 +87,27 @@ FILE *BinFileHelper::openFile(const QString &fileName)
     return fileHandle;
 }
 
+const uchar *BinFileHelper::mapFile()
+{
+    if (!fileHandle)
+        return nullptr;
+    if (mappedData)
+        return mappedData;
+
+    mappedFile.setFileName(filePath);
+    if (!mappedFile.open(QIODevice::ReadOnly))
+        return nullptr;
+
+    mappedSize = mappedFile.size();
+    mappedData = mappedFile.map(0, mappedSize);
+    if (!mappedData)
+    {
+        mappedFile.close();
+        mappedSize = 0;
+    }
+    return mappedData;
+}
+
 enum BinFileHelper::Errors BinFileHelper::__readHeader()
 {
     qint16 endian_id, i;
@@ -275,6 +297,13 @@ bool BinFileHelper::readHeader()
 
 void BinFileHelper::closeFile()
 {
+    if (mappedData)
+    {
+        mappedFile.unmap(mappedData);
+        mappedFile.close();
+        mappedData = nullptr;
+        mappedSize = 0;
+    }
     fclose(fileHandle);
     fileHandle = nullptr;
 }
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <QFile>
 #include <QString>
 #include <QVector>
 
@@ -58,6 +59,15 @@ class BinFileHelper
 
     FILE *openFile(const QString &fileName);
 
+    /**
+     * @short  Map the whole open file in memory
+     *
+     * Records can then be read straight from memory instead of seeking and reading the file handle
+     * for each of them. The file handle stays open and valid.
+     * @return Pointer to the first byte of the file, nullptr if the file could not be mapped.
+     */
+    const uchar *mapFile();
+
     /**
      * @short  Read the header and index table from the file and fill up the QVector s with the entries
      * @return True if successful, false if an error occurred, sets the error.
@@ -108,6 +118,17 @@ class BinFileHelper
      */
     inline FILE *getFileHandle() const { return fileHandle; }
 
+    /**
+     * @short  Get the memory mapping of the currently open file
+     * @return Pointer to the first byte of the file if mapFile() succeeded, nullptr otherwise
+     */
+    inline const uchar *getMappedData() const { return mappedData; }
+
+    /**
+     * @return Size in bytes of the memory mapping, zero if the file is not mapped
+     */
+    inline qint64 getMappedSize() const { return mappedSize; }
+
     /**
      * @short  Returns the offset in the file corresponding to the given index ID
      * @param  id  ID of the index entry whose offset is required
@@ -229,6 +250,12 @@ class BinFileHelper
 
     /// Handle to the file.
     FILE *fileHandle { nullptr};
+    /// Full path of the open file
+    QString filePath;
+    /// File used for the memory mapping, and the mapping itself
+    QFile mappedFile;
+    uchar *mappedData { nullptr };
+    qint64 mappedSize { 0 };
     /// Stores offsets corresponding to each index table entry
     QVector<unsigned long> indexOffset;
     /// Stores number of records under each index table entry
@@ -0,0 +1,61 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "decimatedgraph.h"
+
+DecimatedGraph::DecimatedGraph(QCPAxis *keyAxis, QCPAxis *valueAxis) : QCPGraph(keyAxis, valueAxis)
+{
+}
+
+void DecimatedGraph::sync()
+{
+    const int count = mDataContainer->size();
+    const int synced = m_Pyramid.size();
+
+    // Samples were removed, or inserted before the end
+    if (count < synced || (synced > 0 && (mDataContainer->constBegin() + (synced - 1))->key != m_LastKey))
+        m_Pyramid.clear();
+
+    for (auto it = mDataContainer->constBegin() + m_Pyramid.size(); it != mDataContainer->constEnd(); ++it)
+        m_Pyramid.append(it->value);
+
+    if (count > 0)
+        m_LastKey = (mDataContainer->constEnd() - 1)->key;
+}
+
+void DecimatedGraph::draw(QCPPainter *painter)
+{
+    sync();
+    m_PlottedPoints = 0;
+    QCPGraph::draw(painter);
+}
+
+void DecimatedGraph::getOptimizedLineData(QVector<QCPGraphData> *lineData,
+        const QCPGraphDataContainer::const_iterator &begin,
+        const QCPGraphDataContainer::const_iterator &end) const
+{
+    // Logarithmic axes and unsynced data are left to the adaptive sampling of QCPGraph
+    QCPAxis *keyAxis = mKeyAxis.data();
+    if (!lineData || !keyAxis || begin == end || !mAdaptiveSampling || keyAxis->scaleType() != QCPAxis::stLinear
+            || m_Pyramid.size() != mDataContainer->size())
+    {
+        QCPGraph::getOptimizedLineData(lineData, begin, end);
+        if (lineData)
+            m_PlottedPoints += lineData->size();
+        return;
+    }
+
+    const double pixels = qAbs(keyAxis->coordToPixel(begin->key) - keyAxis->coordToPixel((end - 1)->key));
+    const auto first = mDataContainer->constBegin();
+
+    QVector<int> indices;
+    m_Pyramid.decimate(begin - first, end - first, static_cast<int>(pixels) + 1, &indices);
+
+    lineData->reserve(lineData->size() + indices.size());
+    for (const int index : indices)
+        lineData->append(*(first + index));
+    m_PlottedPoints += indices.size();
+}
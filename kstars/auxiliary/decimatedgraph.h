@@ -0,0 +1,50 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "minmaxpyramid.h"
+#include "qcustomplot.h"
+
+/**
+ * @class DecimatedGraph
+ * @short QCPGraph plotting long series through a min/max pyramid.
+ *
+ * The data of the graph is left untouched, so that it can still be read and edited through the
+ * QCPGraph interface. The pyramid follows the data: samples appended since the last replot are
+ * added to it before drawing, and it is rebuilt when the data changed otherwise. Lines are then
+ * drawn through the extremes of a few blocks per pixel of the visible range, rather than through
+ * all of its samples.
+ *
+ * The graph registers itself with the plot of its axes, as QCustomPlot::addGraph() does.
+ */
+class DecimatedGraph : public QCPGraph
+{
+        Q_OBJECT
+
+    public:
+        DecimatedGraph(QCPAxis *keyAxis, QCPAxis *valueAxis);
+
+        /** @return number of points the lines were drawn through at the last replot. */
+        int plottedPoints() const
+        {
+            return m_PlottedPoints;
+        }
+
+    protected:
+        void draw(QCPPainter *painter) override;
+        void getOptimizedLineData(QVector<QCPGraphData> *lineData, const QCPGraphDataContainer::const_iterator &begin,
+                                  const QCPGraphDataContainer::const_iterator &end) const override;
+
+    private:
+        // Brings the pyramid up to date with the data
+        void sync();
+
+        MinMaxPyramid m_Pyramid;
+        // Key of the last sample in the pyramid, to detect data that was not appended
+        double m_LastKey { 0 };
+        mutable int m_PlottedPoints { 0 };
+};
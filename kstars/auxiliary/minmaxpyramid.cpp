@@ -0,0 +1,101 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "minmaxpyramid.h"
+
+#include <algorithm>
+#include <cmath>
+
+void MinMaxPyramid::append(double value)
+{
+    const int index = m_Size++;
+    for (int level = 0; level < LEVELS; level++)
+    {
+        QVector<Block> &blocks = m_Levels[level];
+        const int block = index >> (2 * (level + 1));
+        if (block == blocks.size())
+            blocks.append(Block());
+
+        Block &b = blocks[block];
+        if (std::isnan(value))
+        {
+            if (b.nanIndex == NONE)
+                b.nanIndex = index;
+            continue;
+        }
+        if (b.minIndex == NONE || value < b.minValue)
+        {
+            b.minValue = value;
+            b.minIndex = index;
+        }
+        if (b.maxIndex == NONE || value > b.maxValue)
+        {
+            b.maxValue = value;
+            b.maxIndex = index;
+        }
+    }
+}
+
+void MinMaxPyramid::clear()
+{
+    m_Size = 0;
+    for (auto &blocks : m_Levels)
+        blocks.clear();
+}
+
+void MinMaxPyramid::emitBlock(const Block &block, QVector<int> *indices)
+{
+    int samples[3] = { block.minIndex, block.maxIndex, block.nanIndex };
+    std::sort(samples, samples + 3);
+    for (int i = 0; i < 3; i++)
+    {
+        if (samples[i] != NONE && (i == 0 || samples[i] != samples[i - 1]))
+            indices->append(samples[i]);
+    }
+}
+
+void MinMaxPyramid::decimate(int first, int last, int buckets, QVector<int> *indices) const
+{
+    first = std::max(first, 0);
+    last = std::min(last, m_Size);
+    const int count = last - first;
+    if (count <= 0)
+        return;
+
+    // Few enough samples to plot them all
+    if (count <= 2 * std::max(buckets, 1))
+    {
+        for (int i = first; i < last; i++)
+            indices->append(i);
+        return;
+    }
+
+    // Coarsest level whose blocks are no larger than a pixel
+    const int samplesPerBucket = count / buckets;
+    int top = 0;
+    while (top < LEVELS && (4 << (2 * top)) <= samplesPerBucket)
+        top++;
+
+    // Blocks are aligned on their size, the ends of the range are covered by finer blocks
+    int i = first;
+    while (i < last)
+    {
+        int level = top;
+        while (level > 0 && ((i & ((1 << (2 * level)) - 1)) != 0 || i + (1 << (2 * level)) > last))
+            level--;
+
+        if (level == 0)
+        {
+            indices->append(i);
+            i++;
+        }
+        else
+        {
+            emitBlock(m_Levels[level - 1][i >> (2 * level)], indices);
+            i += 1 << (2 * level);
+        }
+    }
+}
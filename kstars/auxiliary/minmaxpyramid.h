@@ -0,0 +1,67 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QVector>
+
+/**
+ * @class MinMaxPyramid
+ * @short Multi-resolution summary of a series of samples, to plot long series at a given width.
+ *
+ * Level l of the pyramid splits the series in blocks of 4^l samples, and keeps the index of the
+ * lowest and highest sample of each block, along with the index of its first NaN sample since
+ * plots break their lines on NaN. Plotting a range of samples then only needs a few blocks per
+ * pixel, whatever the number of samples in the range: a line drawn through the extremes of each
+ * block looks the same as a line drawn through all the samples.
+ *
+ * Samples are appended one at a time, updating one block per level.
+ */
+class MinMaxPyramid
+{
+    public:
+        MinMaxPyramid() = default;
+
+        /** @short Appends a sample, its index is size() - 1 once appended. */
+        void append(double value);
+
+        void clear();
+
+        /** @return the number of samples appended since the pyramid was last cleared. */
+        int size() const
+        {
+            return m_Size;
+        }
+
+        /**
+         * @brief decimate List the samples to plot from a range so that it looks the same as if all its samples were plotted.
+         * @param first first sample of the range.
+         * @param last end of the range, excluded.
+         * @param buckets number of pixels the range is plotted over.
+         * @param indices receives the indices of the samples to plot, in increasing order.
+         */
+        void decimate(int first, int last, int buckets, QVector<int> *indices) const;
+
+    private:
+        static constexpr int LEVELS = 12;
+        static constexpr int NONE = -1;
+
+        struct Block
+        {
+            double minValue { 0 };
+            double maxValue { 0 };
+            int minIndex { NONE };
+            int maxIndex { NONE };
+            int nanIndex { NONE };
+        };
+
+        // Appends the samples of a block to indices, in order
+        static void emitBlock(const Block &block, QVector<int> *indices);
+
+        int m_Size { 0 };
+        // Level l + 1 of the pyramid, level 0 being the samples themselves
+        QVector<Block> m_Levels[LEVELS];
+};
@@ -0,0 +1,169 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "observabilityengine.h"
+
+#include "geolocation.h"
+#include "skyobjects/skyobject.h"
+
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+// Objects evaluated by each parallel task
+constexpr int BATCH_SIZE = 256;
+
+// Middle of the grid, the epoch J2000 positions are brought to
+long double middleJD(const KStarsDateTime &start, const KStarsDateTime &end)
+{
+    return end.djd() > start.djd() ? (start.djd() + end.djd()) / 2 : start.djd();
+}
+}
+
+ObservabilityEngine::ObservabilityEngine(const GeoLocation *geo, const KStarsDateTime &start, const KStarsDateTime &end,
+        int stepSeconds)
+    : m_Start(start), m_StepSeconds(qMax(1, stepSeconds)), m_Numbers(middleJD(start, end))
+{
+    geo->lat()->SinCos(m_SinLat, m_CosLat);
+
+    for (KStarsDateTime t = start; t < end; t = t.addSecs(m_StepSeconds))
+    {
+        double sinLST, cosLST;
+        geo->GSTtoLST(t.gst()).SinCos(sinLST, cosLST);
+        m_SinLST.append(sinLST);
+        m_CosLST.append(cosLST);
+    }
+}
+
+ObservabilityEngine::ObservabilityEngine(const GeoLocation *geo, const KStarsDateTime &ut)
+    : ObservabilityEngine(geo, ut, ut.addSecs(1), 1)
+{
+}
+
+ObservabilityEngine::Position ObservabilityEngine::position(const SkyObject &object)
+{
+    // Moving objects have no meaningful catalog coordinates
+    if (object.isSolarSystem() || object.type() == SkyObject::SATELLITE)
+        return { object.ra().Degrees(), object.dec().Degrees(), false };
+
+    return { object.ra0().Degrees(), object.dec0().Degrees(), true };
+}
+
+KStarsDateTime ObservabilityEngine::time(int sample) const
+{
+    return m_Start.addSecs(static_cast<double>(sample) * m_StepSeconds);
+}
+
+void ObservabilityEngine::direction(const Position &position, double &sinDec, double &cosDec, double &sinRA,
+                                    double &cosRA) const
+{
+    const double ra = position.ra * dms::DegToRad, dec = position.dec * dms::DegToRad;
+    if (!position.j2000)
+    {
+        sinDec = std::sin(dec);
+        cosDec = std::cos(dec);
+        sinRA  = std::sin(ra);
+        cosRA  = std::cos(ra);
+        return;
+    }
+
+    const Eigen::Vector3d v = m_Numbers.apparentDirection(
+                                  Eigen::Vector3d(std::cos(dec) * std::cos(ra), std::cos(dec) * std::sin(ra), std::sin(dec)));
+    sinDec = v.z();
+    cosDec = std::hypot(v.x(), v.y());
+    sinRA  = cosDec > 0 ? v.y() / cosDec : 0;
+    cosRA  = cosDec > 0 ? v.x() / cosDec : 1;
+}
+
+ObservabilityEngine::Visibility ObservabilityEngine::evaluate(const Position &position,
+        const Constraints &constraints) const
+{
+    Visibility result;
+    const int count = sampleCount();
+    if (count == 0)
+        return result;
+
+    double sinDec, cosDec, sinRA, cosRA;
+    direction(position, sinDec, cosDec, sinRA, cosRA);
+
+    // sin(alt) = sin(lat) sin(dec) + cos(lat) cos(dec) cos(LST - RA), with cos(LST - RA) expanded
+    // so that the loop over the grid is made of multiply-adds only
+    const double a = m_SinLat * sinDec;
+    const double b = m_CosLat * cosDec * cosRA;
+    const double c = m_CosLat * cosDec * sinRA;
+
+    const double sinMin = std::sin(qBound(-90.0, constraints.minAltitude, 90.0) * dms::DegToRad);
+    const double sinMax = std::sin(qBound(-90.0, constraints.maxAltitude, 90.0) * dms::DegToRad);
+
+    const double *sinLST = m_SinLST.constData();
+    const double *cosLST = m_CosLST.constData();
+
+    // Altitudes first, in a loop the compiler vectorizes, then the runs meeting the constraints
+    thread_local std::vector<double> sinAltitudes;
+    sinAltitudes.resize(count);
+    double *sinAlt = sinAltitudes.data();
+    for (int i = 0; i < count; i++)
+        sinAlt[i] = a + b * cosLST[i] + c * sinLST[i];
+
+    int first = -1;
+    for (int i = 0; i < count; i++)
+    {
+        if (sinAlt[i] >= sinMin && sinAlt[i] <= sinMax)
+        {
+            result.samples++;
+            if (first < 0)
+                first = i;
+        }
+        else if (first >= 0)
+        {
+            result.windows.append({ first, i - 1 });
+            first = -1;
+        }
+    }
+    if (first >= 0)
+        result.windows.append({ first, count - 1 });
+
+    const double maxSinAlt = *std::max_element(sinAlt, sinAlt + count);
+    result.maxAltitude = std::asin(qBound(-1.0, maxSinAlt, 1.0)) / dms::DegToRad;
+
+    // Azimuth at the start of the grid, from the north towards the east
+    const double sinHA = sinLST[0] * cosRA - cosLST[0] * sinRA;
+    const double cosHA = cosLST[0] * cosRA + sinLST[0] * sinRA;
+    result.startAltitude = std::asin(qBound(-1.0, sinAlt[0], 1.0)) / dms::DegToRad;
+    double azimuth = std::atan2(-cosDec * sinHA, sinDec * m_CosLat - cosDec * m_SinLat * cosHA) / dms::DegToRad;
+    result.startAzimuth = azimuth < 0 ? azimuth + 360.0 : azimuth;
+
+    return result;
+}
+
+QVector<ObservabilityEngine::Visibility> ObservabilityEngine::evaluate(const QVector<Position> &positions,
+        const Constraints &constraints) const
+{
+    QVector<Visibility> results(positions.size());
+    Visibility *output = results.data();
+
+    QVector<int> batches;
+    for (int first = 0; first < positions.size(); first += BATCH_SIZE)
+        batches.append(first);
+
+    auto evaluateBatch = [&](const int &first)
+    {
+        const int last = std::min(first + BATCH_SIZE, static_cast<int>(positions.size()));
+        for (int i = first; i < last; i++)
+            output[i] = evaluate(positions[i], constraints);
+    };
+
+    if (batches.size() > 1)
+        QtConcurrent::blockingMap(batches, evaluateBatch);
+    else if (!batches.isEmpty())
+        evaluateBatch(batches.first());
+
+    return results;
+}
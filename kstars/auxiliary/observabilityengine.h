@@ -0,0 +1,116 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "ksnumbers.h"
+#include "kstarsdatetime.h"
+
+#include <QVector>
+
+class GeoLocation;
+class SkyObject;
+
+/**
+ * @class ObservabilityEngine
+ * @short Altitude and azimuth of many objects over a grid of instants.
+ *
+ * The local sidereal time of every instant of the grid, and the rotation from J2000 to the
+ * coordinates of date, are computed once when the engine is built. Evaluating an object then
+ * boils down to a few multiply-adds per instant, with no trigonometry. Lists of objects are split
+ * in batches evaluated in parallel.
+ *
+ * The grid is meant to span a night or so: J2000 positions are brought to the epoch of the middle
+ * of the grid only.
+ */
+class ObservabilityEngine
+{
+    public:
+        /** @short Equatorial position of an object, in degrees. */
+        struct Position
+        {
+            double ra { 0 };
+            double dec { 0 };
+            /** J2000 catalog coordinates if true, apparent coordinates of date otherwise */
+            bool j2000 { true };
+        };
+
+        /** @short Altitude range an object has to be in to be observable, in degrees. */
+        struct Constraints
+        {
+            double minAltitude { -90 };
+            double maxAltitude { 90 };
+        };
+
+        /** @short Run of consecutive instants of the grid meeting the constraints. */
+        struct Window
+        {
+            int first { 0 };
+            int last { 0 };
+        };
+
+        /** @short How an object fares over the grid. */
+        struct Visibility
+        {
+            /** Number of instants meeting the constraints */
+            int samples { 0 };
+            QVector<Window> windows;
+            /** Altitude and azimuth at the first instant of the grid, in degrees */
+            double startAltitude { 0 };
+            double startAzimuth { 0 };
+            /** Highest altitude over the grid, in degrees */
+            double maxAltitude { -90 };
+        };
+
+        /**
+         * @short Builds a grid from @p start, by steps of @p stepSeconds, up to but excluding @p end.
+         * @param geo the observing location.
+         * @param start first instant, UT.
+         * @param end end of the grid, UT.
+         * @param stepSeconds interval between two instants.
+         */
+        ObservabilityEngine(const GeoLocation *geo, const KStarsDateTime &start, const KStarsDateTime &end,
+                            int stepSeconds);
+
+        /** @short Builds a grid of the single instant @p ut. */
+        ObservabilityEngine(const GeoLocation *geo, const KStarsDateTime &ut);
+
+        /** @return the position of @p object to evaluate: catalog coordinates, or coordinates of date for moving objects. */
+        static Position position(const SkyObject &object);
+
+        /** @return the number of instants of the grid. */
+        int sampleCount() const
+        {
+            return m_SinLST.size();
+        }
+
+        /** @return the instant @p sample of the grid, UT. */
+        KStarsDateTime time(int sample) const;
+
+        /** @return the interval between two instants of the grid, in seconds. */
+        int stepSeconds() const
+        {
+            return m_StepSeconds;
+        }
+
+        /** @short Evaluates one object. */
+        Visibility evaluate(const Position &position, const Constraints &constraints = Constraints()) const;
+
+        /** @short Evaluates a list of objects, in parallel. The results are in the order of @p positions. */
+        QVector<Visibility> evaluate(const QVector<Position> &positions, const Constraints &constraints = Constraints()) const;
+
+    private:
+        // Brings the position to the epoch of the grid, as direction cosines
+        void direction(const Position &position, double &sinDec, double &cosDec, double &sinRA, double &cosRA) const;
+
+        KStarsDateTime m_Start;
+        int m_StepSeconds { 1 };
+        KSNumbers m_Numbers;
+        double m_SinLat { 0 };
+        double m_CosLat { 1 };
+        QVector<double> m_SinLST;
+        QVector<double> m_CosLST;
+};
@@ -0,0 +1,156 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "startuptaskgraph.h"
+
+#include <QFutureWatcher>
+#include <QtConcurrent>
+
+#include <kstars_debug.h>
+
+#include <algorithm>
+
+StartupTaskGraph::StartupTaskGraph(QObject *parent) : QObject(parent)
+{
+    m_Clock.start();
+}
+
+StartupTaskGraph::~StartupTaskGraph()
+{
+    for (const auto &task : m_Tasks)
+    {
+        if (task->started && !task->finished)
+            task->future.waitForFinished();
+    }
+}
+
+int StartupTaskGraph::addTask(const QString &name, Step work, Step finish, const QVector<int> &dependencies)
+{
+    auto task = std::make_shared<Task>();
+    task->name = name;
+    task->work = std::move(work);
+    task->finish = std::move(finish);
+    task->dependencies = dependencies;
+    m_Tasks.append(task);
+    m_Pending++;
+
+    launchReady();
+    return m_Tasks.size() - 1;
+}
+
+int StartupTaskGraph::measure(const QString &name, const Step &step)
+{
+    QElapsedTimer timer;
+    timer.start();
+    step();
+
+    auto task = std::make_shared<Task>();
+    task->name = name;
+    task->started = task->finished = true;
+    m_Tasks.append(task);
+
+    qCInfo(KSTARS) << QString("Startup: %1 loaded in %2 ms on the main thread").arg(name).arg(timer.elapsed());
+    return m_Tasks.size() - 1;
+}
+
+void StartupTaskGraph::start()
+{
+    m_Started = true;
+    for (int i = 0; i < m_Tasks.size(); i++)
+    {
+        const auto &t = m_Tasks.at(i);
+        if (t->started && !t->finished && t->future.isFinished())
+            finish(i);
+    }
+}
+
+void StartupTaskGraph::wait(int task)
+{
+    const std::shared_ptr<Task> t = m_Tasks.at(task);
+    if (t->finished)
+        return;
+
+    for (const int dependency : t->dependencies)
+        wait(dependency);
+
+    if (!t->started)
+        launch(task);
+    t->future.waitForFinished();
+    finish(task);
+}
+
+void StartupTaskGraph::waitForAll()
+{
+    for (int i = 0; i < m_Tasks.size(); i++)
+        wait(i);
+}
+
+bool StartupTaskGraph::isFinished(int task) const
+{
+    return m_Tasks.at(task)->finished;
+}
+
+void StartupTaskGraph::launch(int task)
+{
+    std::shared_ptr<Task> t = m_Tasks.at(task);
+    t->started = true;
+    t->future = QtConcurrent::run([t]()
+    {
+        QElapsedTimer timer;
+        timer.start();
+        t->work();
+        t->workTime = timer.elapsed();
+    });
+
+    auto watcher = new QFutureWatcher<void>(this);
+    connect(watcher, &QFutureWatcher<void>::finished, this, [this, watcher, task]()
+    {
+        watcher->deleteLater();
+        if (m_Started)
+            finish(task);
+    });
+    watcher->setFuture(t->future);
+}
+
+void StartupTaskGraph::launchReady()
+{
+    for (int i = 0; i < m_Tasks.size(); i++)
+    {
+        const auto &t = m_Tasks.at(i);
+        if (t->started)
+            continue;
+
+        const bool ready = std::all_of(t->dependencies.cbegin(), t->dependencies.cend(), [this](int dependency)
+        {
+            return m_Tasks.at(dependency)->finished;
+        });
+        if (ready)
+            launch(i);
+    }
+}
+
+void StartupTaskGraph::finish(int task)
+{
+    const std::shared_ptr<Task> t = m_Tasks.at(task);
+    // The watcher of a task the main thread waited for reports it again from the event loop
+    if (t->finished)
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    if (t->finish)
+        t->finish();
+    t->finished = true;
+    m_Pending--;
+
+    qCInfo(KSTARS) << QString("Startup: %1 loaded in %2 ms on a worker thread and %3 ms on the main thread, ready after %4 ms")
+                   .arg(t->name).arg(t->workTime).arg(timer.elapsed()).arg(m_Clock.elapsed());
+
+    emit taskFinished(t->name);
+    launchReady();
+    if (m_Pending == 0)
+        emit allFinished();
+}
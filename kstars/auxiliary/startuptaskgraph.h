@@ -0,0 +1,105 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+#include <functional>
+#include <memory>
+
+/**
+ * @class StartupTaskGraph
+ * @short Loads independent data sets concurrently while KStars starts.
+ *
+ * A task reads its data on a worker thread, then hands it over to the objects using it on the
+ * thread of the graph, where Qt objects and shared indexes such as the SkyMesh are safe to
+ * touch. A task starts as soon as the tasks and steps it depends on have completed.
+ *
+ * Hand-overs run from the event loop once the graph is started, so that tasks can be added
+ * before the objects they hand their data over to exist, or right away when waiting for their
+ * task: startup waits for the tasks the sky map cannot be shown without, the others complete in
+ * the background. Steps run on the thread of the graph are timed along with the tasks, the time
+ * spent on each is logged as it completes.
+ */
+class StartupTaskGraph : public QObject
+{
+        Q_OBJECT
+
+    public:
+        using Step = std::function<void()>;
+
+        explicit StartupTaskGraph(QObject *parent = nullptr);
+
+        /** @short Waits for the tasks running on worker threads, the others are dropped. */
+        ~StartupTaskGraph() override;
+
+        /**
+         * @brief addTask Add a task to the graph.
+         * @param name name of the task, as logged.
+         * @param work step run on a worker thread, it must not touch objects used by other threads.
+         * @param finish step run on the thread of the graph once work is done, may be empty.
+         * @param dependencies tasks and steps which must have completed before work starts.
+         * @return identifier of the task.
+         */
+        int addTask(const QString &name, Step work, Step finish = Step(), const QVector<int> &dependencies = QVector<int>());
+
+        /**
+         * @short Runs a step on the calling thread and logs its time along with the tasks.
+         * @return identifier of the step, for tasks to depend on it.
+         */
+        int measure(const QString &name, const Step &step);
+
+        /** @short Starts handing over the data of the tasks whose work is done, from the event loop. */
+        void start();
+
+        /** @short Blocks until @p task has completed, handing over the data of its dependencies and its own. */
+        void wait(int task);
+
+        void waitForAll();
+
+        bool isFinished(int task) const;
+
+        /** @return true once all the tasks have completed. */
+        bool isFinished() const
+        {
+            return m_Pending == 0;
+        }
+
+    signals:
+        void taskFinished(const QString &name);
+        void allFinished();
+
+    private:
+        struct Task
+        {
+            QString name;
+            Step work;
+            Step finish;
+            QVector<int> dependencies;
+            QFuture<void> future;
+            bool started { false };
+            bool finished { false };
+            // Written by the worker thread before its future finishes
+            qint64 workTime { -1 };
+        };
+
+        void launch(int task);
+        // Launches the tasks waiting for no dependency
+        void launchReady();
+        // Hands the data of a task over once its work is done
+        void finish(int task);
+
+        // Tasks are shared with the worker threads, which keep them while the list grows
+        QVector<std::shared_ptr<Task>> m_Tasks;
+        QElapsedTimer m_Clock;
+        bool m_Started { false };
+        int m_Pending { 0 };
+};
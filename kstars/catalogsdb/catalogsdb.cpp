@@ -4,6 +4,7 @@
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
+#include <atomic>
 #include <limits>
 #include <cmath>
 #include <QSqlDriver>
@@ -12,6 +13,7 @@
 #include <qsqldatabase.h>
 #include "cachingdms.h"
 #include "catalogsdb.h"
+#include "mastersnapshot.h"
 #include "kspaths.h"
 #include "skymesh.h"
 #include "Options.h"
@@ -21,12 +23,18 @@
 using namespace CatalogsDB;
 QSet<QString> DBManager::m_db_paths{};
 
+/**
+ * Guards `DBManager::m_db_paths`, managers are also created on worker
+ * threads.
+ */
+static QMutex db_paths_mutex;
+
 /**
  * Get an increasing index for new connections.
  */
 int get_connection_index()
 {
-    static int connection_index = 0;
+    static std::atomic<int> connection_index{ 0 };
     return connection_index++;
 }
 
@@ -80,7 +88,10 @@ std::pair<bool, QString> migrate_db(const int version, QSqlDatabase &db,
 DBManager::DBManager(const QString &filename)
     : m_db{ QSqlDatabase::addDatabase(
           "QSQLITE", QString("cat_%1_%2").arg(filename).arg(get_connection_index())) },
-      m_db_file{ *m_db_paths.insert(filename) }
+      m_db_file{ [&]() -> const QString & {
+          QMutexLocker _{ &db_paths_mutex };
+          return *m_db_paths.insert(filename);
+      }() }
 
 {
     m_db.setDatabaseName(m_db_file);
@@ -353,9 +364,25 @@ bool DBManager::compile_master_catalog()
     success &= query.exec(SqlStatements::create_master_mag_index);
     success &= query.exec(SqlStatements::create_master_type_index);
     success &= query.exec(SqlStatements::create_master_name_index);
+
+    // The snapshot is rebuilt on demand, the master catalog may be
+    // recompiled many times in a row while catalogs are edited
+    QFile::remove(MasterSnapshot::path_for(m_db_file));
     return success;
 };
 
+std::pair<bool, QString> DBManager::compile_master_snapshot()
+{
+    QSqlQuery query{ m_db };
+    query.setForwardOnly(true);
+    auto _ = gsl::finally([&]() { query.finish(); });
+
+    if (!query.exec(SqlStatements::dso_snapshot))
+        return { false, query.lastError().text() };
+
+    return MasterSnapshot::write(query, m_db_file, m_htmesh_level);
+}
+
 const Catalog read_catalog(const QSqlQuery &query)
 {
     return { query.value("id").toInt(),
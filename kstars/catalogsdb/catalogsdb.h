@@ -503,10 +503,24 @@ class DBManager
      * the master table. **Caution** you may want to call
      * `update_catalog_views` beforhand.
      *
+     * The snapshot of the previous master catalog is removed, \sa
+     * compile_master_snapshot.
+     *
      * @return true in case of success, false in case of an error
      */
     bool compile_master_catalog();
 
+    /**
+     * Writes the memory mapped snapshot of the master catalog used to
+     * draw the sky map, \sa MasterSnapshot. This reads the whole master
+     * catalog and is only done when the snapshot is missing or out of
+     * date.
+     *
+     * \returns wether the operation was successful and if not, an
+     * error message
+     */
+    std::pair<bool, QString> compile_master_snapshot();
+
     /**
      * Updates the all_catalog_view so that it includes all known
      * catalogs.
@@ -0,0 +1,296 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "mastersnapshot.h"
+
+#include <QSaveFile>
+#include <QSqlError>
+#include <QSqlQuery>
+
+#include <algorithm>
+#include <cstring>
+
+#include "nan.h"
+
+using namespace CatalogsDB;
+
+namespace
+{
+constexpr char snapshot_magic[8] = { 'K', 'S', 'D', 'S', 'O', 'S', 'N', 'P' };
+constexpr quint32 snapshot_version = 1;
+constexpr quint32 snapshot_endianness = 0x01020304;
+
+/** Number of trixels of an htmesh of \p level */
+int trixel_count(const int level)
+{
+    return 8 << (2 * level);
+}
+
+/** Appends \p bytes prefixed with their size to \p strings and returns their offset */
+quint32 append_string(QByteArray &strings, const QByteArray &bytes)
+{
+    const quint32 offset = strings.size();
+    const quint32 size   = bytes.size();
+    strings.append(reinterpret_cast<const char *>(&size), sizeof(size));
+    strings.append(bytes);
+    return offset;
+}
+} // namespace
+
+struct MasterSnapshot::Header
+{
+    char magic[8];
+    quint32 version;
+    quint32 endianness;
+    qint32 htmesh_level;
+    qint32 trixel_count;
+    quint64 object_count;
+    quint64 strings_size;
+};
+
+struct MasterSnapshot::TrixelEntry
+{
+    /** Index of the first record of the trixel */
+    quint32 first;
+    quint32 known_mag_count;
+    quint32 null_mag_count;
+};
+
+struct MasterSnapshot::Record
+{
+    double ra;
+    double dec;
+    double position_angle;
+    float mag;
+    float major_axis;
+    float minor_axis;
+    float flux;
+    qint32 type;
+    qint32 catalog_id;
+    /** Offsets into the string table */
+    quint32 oid;
+    quint32 name;
+    quint32 long_name;
+    quint32 catalog_identifier;
+};
+
+std::pair<bool, QString> MasterSnapshot::write(QSqlQuery &query, const QString &db_file,
+                                               const int htmesh_level)
+{
+    static_assert(sizeof(Record) == 64, "Snapshot records must not be padded");
+
+    QSaveFile file{ path_for(db_file) };
+    if (!file.open(QIODevice::WriteOnly))
+        return { false, file.errorString() };
+
+    Header header{};
+    std::memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+    header.version      = snapshot_version;
+    header.endianness   = snapshot_endianness;
+    header.htmesh_level = htmesh_level;
+    header.trixel_count = trixel_count(htmesh_level);
+
+    std::vector<TrixelEntry> trixels(header.trixel_count, TrixelEntry{ 0, 0, 0 });
+    QByteArray strings;
+
+    // The header and the trixel table are rewritten once the records are known
+    const qint64 records_offset =
+        sizeof(Header) + sizeof(TrixelEntry) * static_cast<qint64>(trixels.size());
+    if (!file.seek(records_offset))
+        return { false, file.errorString() };
+
+    int last_trixel = -1;
+    while (query.next())
+    {
+        const int trixel = query.value(13).toInt();
+        if (trixel < 0 || trixel >= header.trixel_count || trixel < last_trixel)
+            return { false, QString("Unexpected trixel %1 in the master catalog.").arg(trixel) };
+
+        auto &entry = trixels[trixel];
+        if (trixel != last_trixel)
+            entry.first = static_cast<quint32>(header.object_count);
+        last_trixel = trixel;
+
+        Record record{};
+        record.ra             = query.value(2).toDouble();
+        record.dec            = query.value(3).toDouble();
+        record.position_angle = query.value(10).toDouble();
+        record.mag            = query.isNull(4) ? NaN::f : query.value(4).toFloat();
+        record.major_axis     = query.value(8).toFloat();
+        record.minor_axis     = query.value(9).toFloat();
+        record.flux           = query.value(11).toFloat();
+        record.type           = query.value(1).toInt();
+        record.catalog_id     = query.value(12).toInt();
+        record.oid            = append_string(strings, query.value(0).toByteArray());
+        record.name           = append_string(strings, query.value(5).toString().toUtf8());
+        record.long_name = append_string(strings, query.value(6).toString().toUtf8());
+        record.catalog_identifier =
+            append_string(strings, query.value(7).toString().toUtf8());
+
+        if (query.isNull(4))
+            entry.null_mag_count++;
+        else if (entry.null_mag_count > 0)
+            return { false, "The master catalog is not ordered by magnitude." };
+        else
+            entry.known_mag_count++;
+
+        if (file.write(reinterpret_cast<const char *>(&record), sizeof(record)) !=
+            sizeof(record))
+            return { false, file.errorString() };
+
+        header.object_count++;
+    }
+
+    if (query.lastError().isValid())
+        return { false, query.lastError().text() };
+
+    header.strings_size = strings.size();
+    if (file.write(strings) != strings.size() || !file.seek(0) ||
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header)) !=
+            sizeof(header) ||
+        file.write(reinterpret_cast<const char *>(trixels.data()),
+                   sizeof(TrixelEntry) * trixels.size()) !=
+            static_cast<qint64>(sizeof(TrixelEntry) * trixels.size()))
+        return { false, file.errorString() };
+
+    if (!file.commit())
+        return { false, file.errorString() };
+
+    return { true, "" };
+}
+
+bool MasterSnapshot::open(const QString &db_file, const int htmesh_level,
+                          const int object_count)
+{
+    close();
+
+    m_file.setFileName(path_for(db_file));
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 size = m_file.size();
+    if (size < static_cast<qint64>(sizeof(Header)))
+    {
+        m_file.close();
+        return false;
+    }
+
+    const uchar *data = m_file.map(0, size);
+    if (data == nullptr)
+    {
+        m_file.close();
+        return false;
+    }
+
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+
+    const qint64 expected_size =
+        sizeof(Header) + sizeof(TrixelEntry) * static_cast<qint64>(header.trixel_count) +
+        sizeof(Record) * header.object_count + header.strings_size;
+
+    if (std::memcmp(header.magic, snapshot_magic, sizeof(header.magic)) != 0 ||
+        header.version != snapshot_version || header.endianness != snapshot_endianness ||
+        header.htmesh_level != htmesh_level ||
+        header.trixel_count != trixel_count(htmesh_level) ||
+        header.object_count != static_cast<quint64>(object_count) ||
+        expected_size != size)
+    {
+        m_file.unmap(const_cast<uchar *>(data));
+        m_file.close();
+        return false;
+    }
+
+    m_data         = data;
+    m_db_file      = &db_file;
+    m_trixel_count = header.trixel_count;
+    m_trixels      = reinterpret_cast<const TrixelEntry *>(data + sizeof(Header));
+    m_records      = reinterpret_cast<const Record *>(m_trixels + m_trixel_count);
+    m_strings      = reinterpret_cast<const char *>(m_records + header.object_count);
+    m_strings_size = header.strings_size;
+
+    return true;
+}
+
+void MasterSnapshot::close()
+{
+    if (m_data)
+        m_file.unmap(const_cast<uchar *>(m_data));
+
+    m_file.close();
+    m_data         = nullptr;
+    m_db_file      = nullptr;
+    m_trixels      = nullptr;
+    m_trixel_count = 0;
+    m_records      = nullptr;
+    m_strings      = nullptr;
+    m_strings_size = 0;
+}
+
+size_t MasterSnapshot::read_known_mag(const int trixel, const float maglim,
+                                      std::vector<CatalogObject> &objects) const
+{
+    if (!is_open() || trixel < 0 || trixel >= m_trixel_count)
+        return 0;
+
+    const auto &entry   = m_trixels[trixel];
+    const Record *begin = m_records + entry.first;
+    const Record *end   = begin + entry.known_mag_count;
+    const Record *last  = std::lower_bound(
+        begin, end, maglim,
+        [](const Record &record, const float mag) { return record.mag < mag; });
+
+    const size_t first = objects.size();
+    if (begin + first >= last)
+        return 0;
+
+    objects.reserve(last - begin);
+    for (const Record *record = begin + first; record != last; ++record)
+        objects.push_back(read_record(*record));
+
+    return objects.size() - first;
+}
+
+size_t MasterSnapshot::read_null_mag(const int trixel,
+                                     std::vector<CatalogObject> &objects) const
+{
+    if (!is_open() || trixel < 0 || trixel >= m_trixel_count)
+        return 0;
+
+    const auto &entry   = m_trixels[trixel];
+    const Record *begin = m_records + entry.first + entry.known_mag_count;
+    const Record *end   = begin + entry.null_mag_count;
+
+    objects.reserve(objects.size() + entry.null_mag_count);
+    for (const Record *record = begin; record != end; ++record)
+        objects.push_back(read_record(*record));
+
+    return entry.null_mag_count;
+}
+
+CatalogObject MasterSnapshot::read_record(const Record &record) const
+{
+    const auto string = [&](const quint32 offset) {
+        quint32 size;
+        std::memcpy(&size, m_strings + offset, sizeof(size));
+        return QByteArray::fromRawData(m_strings + offset + sizeof(size), size);
+    };
+
+    return { QByteArray(string(record.oid)),
+             static_cast<SkyObject::TYPE>(record.type),
+             dms(record.ra),
+             dms(record.dec),
+             record.mag,
+             QString::fromUtf8(string(record.name)),
+             QString::fromUtf8(string(record.long_name)),
+             QString::fromUtf8(string(record.catalog_identifier)),
+             record.catalog_id,
+             record.major_axis,
+             record.minor_axis,
+             record.position_angle,
+             record.flux,
+             *m_db_file };
+}
@@ -0,0 +1,120 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <QtGlobal>
+
+#include <utility>
+#include <vector>
+
+#include "catalogobject.h"
+
+class QSqlQuery;
+
+namespace CatalogsDB
+{
+/**
+ * A read only, memory mapped copy of the master catalog laid out for
+ * the sky map.
+ *
+ * The objects are grouped by trixel. Within a trixel, the objects of
+ * known magnitude come first, sorted by magnitude (brightest first),
+ * followed by the objects of unknown magnitude. Every object is a
+ * fixed size record pointing into a string table, so that the objects
+ * of a trixel down to some magnitude can be found by a binary search
+ * and turned into `CatalogObject`s without touching the database.
+ *
+ * The snapshot lives next to the database (\sa
+ * `MasterSnapshot::path_for`) and is written by
+ * `DBManager::compile_master_snapshot`. It records the htmesh level
+ * and the number of objects of the master catalog it was made from,
+ * `open` refuses snapshots that don't match.
+ *
+ * The records are stored in the byte order of the machine that wrote
+ * them. A snapshot from another machine is simply rejected and
+ * recompiled.
+ */
+class MasterSnapshot
+{
+  public:
+    MasterSnapshot() = default;
+    ~MasterSnapshot() { close(); }
+
+    MasterSnapshot(const MasterSnapshot &) = delete;
+    MasterSnapshot &operator=(const MasterSnapshot &) = delete;
+
+    /** \returns the path of the snapshot of the database \p db_file */
+    static QString path_for(const QString &db_file) { return db_file + ".snapshot"; }
+
+    /**
+     * Writes the snapshot of the database \p db_file from the rows of the
+     * executed \p query.
+     *
+     * The query must select the `SqlStatements::dso_query_fields`
+     * followed by the trixel, ordered as described in the class
+     * documentation. The file is replaced atomically.
+     *
+     * \returns wether the operation was successful and if not, an error
+     * message
+     */
+    static std::pair<bool, QString> write(QSqlQuery &query, const QString &db_file,
+                                          const int htmesh_level);
+
+    /**
+     * Maps the snapshot of the database \p db_file. The snapshot has to
+     * match the \p htmesh_level and \p object_count of the master
+     * catalog.
+     *
+     * The objects read from the snapshot refer to \p db_file, which
+     * has to outlive them, like `DBManager::db_file_name`.
+     *
+     * \returns true if the snapshot could be mapped and is up to date
+     */
+    bool open(const QString &db_file, const int htmesh_level, const int object_count);
+
+    /** Unmaps the snapshot */
+    void close();
+
+    /** \returns wether a snapshot is mapped */
+    bool is_open() const { return m_data != nullptr; }
+
+    /**
+     * Appends the objects of known magnitude in \p trixel brighter than
+     * \p maglim to \p objects, skipping the first `objects.size()` ones
+     * which are assumed to have been read by an earlier call.
+     *
+     * \returns the number of objects appended
+     */
+    size_t read_known_mag(const int trixel, const float maglim,
+                          std::vector<CatalogObject> &objects) const;
+
+    /**
+     * Appends all the objects of unknown magnitude in \p trixel to \p objects.
+     *
+     * \returns the number of objects appended
+     */
+    size_t read_null_mag(const int trixel, std::vector<CatalogObject> &objects) const;
+
+  private:
+    struct Header;
+    struct TrixelEntry;
+    struct Record;
+
+    CatalogObject read_record(const Record &record) const;
+
+    QFile m_file;
+    const uchar *m_data{ nullptr };
+    const QString *m_db_file{ nullptr };
+    const TrixelEntry *m_trixels{ nullptr };
+    int m_trixel_count{ 0 };
+    const Record *m_records{ nullptr };
+    const char *m_strings{ nullptr };
+    quint64 m_strings_size{ 0 };
+};
+} // namespace CatalogsDB
@@ -335,6 +335,11 @@ const QString _dso_by_trixel_no_nulls = "SELECT %1 FROM master WHERE trixel = "
                                         " BY magnitude DESC";
 const QString dso_by_trixel_no_nulls = QString(_dso_by_trixel_no_nulls).arg(object_fields);
 
+// The order is assumed by MasterSnapshot::write
+const QString _dso_snapshot = "SELECT %1, trixel FROM master ORDER BY trixel ASC, "
+                              "magnitude IS NULL ASC, magnitude ASC, major_axis DESC";
+const QString dso_snapshot = QString(_dso_snapshot).arg(object_fields);
+
 const QString _dso_by_oid = "SELECT %1 FROM master WHERE oid = :id LIMIT 1";
 
 const QString dso_by_oid = QString(_dso_by_oid).arg(object_fields);
@@ -12,6 +12,9 @@
 #include <QtGlobal>
 #include <QColor>
 
+#include <algorithm>
+
+#include "auxiliary/decimatedgraph.h"
 #include "auxiliary/kspaths.h"
 #include "dms.h"
 #include "ekos/manager.h"
@@ -20,6 +23,7 @@
 #include "ksmessagebox.h"
 #include "kstars.h"
 #include "Options.h"
+#include "analyzestore.h"
 
 #include <ekos_analyze_debug.h>
 #include <KHelpClient>
@@ -246,8 +250,9 @@ QString findFilename(const QString &filename, const QString &alternateDirectory)
     return "";
 }
 
-// This is an exhaustive search for now.
-// This is reasonable as the number of sessions should be limited.
+// Sessions sorted by start time, along with the latest end of the sessions up to each one,
+// so that finding the sessions containing a time is a binary search followed by a walk back
+// over the sessions that may still be running at that time.
 template <class T>
 class IntervalFinder
 {
@@ -256,24 +261,42 @@ class IntervalFinder
         ~IntervalFinder() {}
         void add(T value)
         {
-            intervals.append(value);
+            auto position = std::upper_bound(intervals.begin(), intervals.end(), value.start,
+                                             [](double start, const T & interval)
+            {
+                return start < interval.start;
+            });
+            const int index = position - intervals.begin();
+            intervals.insert(index, value);
+
+            // Sessions are mostly added in time order, this only updates the last entry then
+            maxEnd.resize(intervals.size());
+            for (int i = index; i < intervals.size(); i++)
+                maxEnd[i] = i > 0 ? std::max(maxEnd[i - 1], intervals[i].end) : intervals[i].end;
         }
         void clear()
         {
             intervals.clear();
+            maxEnd.clear();
         }
         QList<T> find(double t)
         {
             QList<T> result;
-            for (const auto &i : intervals)
+            auto position = std::upper_bound(intervals.begin(), intervals.end(), t,
+                                             [](double time, const T & interval)
+            {
+                return time < interval.start;
+            });
+            for (int i = position - intervals.begin() - 1; i >= 0 && maxEnd[i] >= t; i--)
             {
-                if (t >= i.start && t <= i.end)
-                    result.push_back(i);
+                if (t <= intervals[i].end)
+                    result.push_front(intervals[i]);
             }
             return result;
         }
     private:
-        QList<T> intervals;
+        QVector<T> intervals;
+        QVector<double> maxEnd;
 };
 
 IntervalFinder<Ekos::Analyze::CaptureSession> captureSessions;
@@ -675,19 +698,34 @@ void Analyze::addMountCoords(double ra, double dec, double az,
 double Analyze::readDataFromFile(const QString &filename)
 {
     double lastTime = 10;
-    QFile inputFile(filename);
-    if (inputFile.open(QIODevice::ReadOnly))
+
+    // Guide and mount samples come pre-parsed from the binary companion of the log,
+    // the other lines are parsed as text.
+    AnalyzeStore store;
+    if (!store.open(filename))
+        return lastTime;
+
+    AnalyzeStore::Callbacks callbacks;
+    callbacks.guideStats = [&](double time, double raError, double decError, int raPulse, int decPulse,
+                               double snr, double skyBg, int numStars)
     {
-        QTextStream in(&inputFile);
-        while (!in.atEnd())
-        {
-            QString line = in.readLine();
-            double time = processInputLine(line);
-            if (time > lastTime)
-                lastTime = time;
-        }
-        inputFile.close();
-    }
+        processGuideStats(time, raError, decError, raPulse, decPulse, snr, skyBg, numStars, true);
+        lastTime = std::max(lastTime, time);
+    };
+    callbacks.mountCoords = [&](double time, double ra, double dec, double az, double alt, int pierSide, double ha)
+    {
+        processMountCoords(time, ra, dec, az, alt, pierSide, ha, true);
+        lastTime = std::max(lastTime, time);
+    };
+    callbacks.line = [&](const QString & line)
+    {
+        lastTime = std::max(lastTime, processInputLine(line));
+    };
+    store.replay(callbacks);
+
+    qCDebug(KSTARS_EKOS_ANALYZE) << "Read" << filename << ":" << store.guideSampleCount() << "guide samples,"
+                                 << store.mountSampleCount() << "mount samples," << store.lineCount() << "other lines,"
+                                 << (store.isMapped() ? "from its companion" : "companion kept in memory");
     return lastTime;
 }
 
@@ -1436,6 +1474,17 @@ void Analyze::replot(bool adjustSlider)
     statsPlot->replot();
     graphicsPlot->replot();
     updateStatsValues();
+
+    int plottedPoints = 0;
+    for (int i = 0; i < statsPlot->graphCount(); ++i)
+    {
+        auto graph = qobject_cast<DecimatedGraph *>(statsPlot->graph(i));
+        if (graph != nullptr && graph->visible())
+            plottedPoints += graph->plottedPoints();
+    }
+    qCDebug(KSTARS_EKOS_ANALYZE) << QString("Replot: stats %1ms (%2ms average) over %3 points, timeline %4ms")
+                                 .arg(statsPlot->replotTime(), 0, 'f', 1).arg(statsPlot->replotTime(true), 0, 'f', 1)
+                                 .arg(plottedPoints).arg(timelinePlot->replotTime(), 0, 'f', 1);
 }
 
 namespace
@@ -1658,7 +1707,12 @@ int Analyze::initGraph(QCustomPlot *plot, QCPAxis *yAxis, QCPGraph::LineStyle li
                        const QColor &color, const QString &name)
 {
     int num = plot->graphCount();
-    plot->addGraph(plot->xAxis, yAxis);
+    // The stats plot gets a guide and a mount sample per second over whole nights,
+    // it is drawn through a min/max pyramid of each graph.
+    if (plot == statsPlot)
+        new DecimatedGraph(plot->xAxis, yAxis);
+    else
+        plot->addGraph(plot->xAxis, yAxis);
     plot->graph(num)->setLineStyle(lineStyle);
     plot->graph(num)->setPen(QPen(color));
     plot->graph(num)->setName(name);
@@ -0,0 +1,441 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "analyzestore.h"
+
+#include <QCryptographicHash>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Ekos
+{
+
+namespace
+{
+constexpr char store_magic[8] = { 'K', 'S', 'A', 'N', 'A', 'I', 'D', 'X' };
+constexpr char chunk_magic[4] = { 'C', 'H', 'N', 'K' };
+constexpr quint32 store_version = 1;
+constexpr quint32 store_endianness = 0x01020304;
+
+// The beginning of the log identifies it, a companion is rebuilt if it changed
+constexpr qint64 PREFIX_SIZE = 4096;
+
+// Same bounds as Analyze::processInputLine(), samples outside of them are left to it to reject
+constexpr double MAX_LOG_TIME = 3600 * 24 * 10;
+
+template <typename T>
+void appendColumn(QByteArray &out, const QVector<T> &column)
+{
+    out.append(reinterpret_cast<const char *>(column.constData()), column.size() * static_cast<int>(sizeof(T)));
+}
+
+bool parseTime(const QByteArray &field, double &time)
+{
+    bool ok;
+    time = field.toDouble(&ok);
+    return ok && time >= 0 && time <= MAX_LOG_TIME;
+}
+
+// GuideStats,time,raError,decError,raPulse,decPulse,snr,skyBg,numStars
+bool parseGuideStats(const QList<QByteArray> &fields, double values[5], qint32 pulses[3])
+{
+    if (fields.size() != 9 || !parseTime(fields[1], values[0]))
+        return false;
+
+    bool ok[8];
+    values[1] = fields[2].toDouble(&ok[0]);
+    values[2] = fields[3].toDouble(&ok[1]);
+    pulses[0] = fields[4].toInt(&ok[2]);
+    pulses[1] = fields[5].toInt(&ok[3]);
+    values[3] = fields[6].toDouble(&ok[4]);
+    values[4] = fields[7].toDouble(&ok[5]);
+    pulses[2] = fields[8].toInt(&ok[6]);
+    return std::all_of(ok, ok + 7, [](bool b)
+    {
+        return b;
+    });
+}
+
+// MountCoords,time,ra,dec,az,alt,pierSide[,ha]
+bool parseMountCoords(const QList<QByteArray> &fields, double values[6], qint32 &pierSide)
+{
+    if ((fields.size() != 7 && fields.size() != 8) || !parseTime(fields[1], values[0]))
+        return false;
+
+    bool ok[6] = { true, true, true, true, true, true };
+    values[1] = fields[2].toDouble(&ok[0]);
+    values[2] = fields[3].toDouble(&ok[1]);
+    values[3] = fields[4].toDouble(&ok[2]);
+    values[4] = fields[5].toDouble(&ok[3]);
+    pierSide = fields[6].toInt(&ok[4]);
+    values[5] = fields.size() > 7 ? fields[7].toDouble(&ok[5]) : 0;
+    return std::all_of(ok, ok + 6, [](bool b)
+    {
+        return b;
+    });
+}
+}
+
+struct AnalyzeStore::Header
+{
+    char magic[8];
+    quint32 version;
+    quint32 endianness;
+    quint64 prefixSize;
+    char prefixHash[16];
+};
+
+// Followed by the guide and mount double columns, the guide and mount integer columns,
+// the line entries and the line strings, padded to 8 bytes.
+struct AnalyzeStore::ChunkHeader
+{
+    char magic[4];
+    quint32 guideCount;
+    quint32 mountCount;
+    quint32 lineCount;
+    quint64 stringBytes;
+    /** Offset in the log of the end of the lines of the chunk */
+    quint64 textEnd;
+};
+
+struct AnalyzeStore::LineEntry
+{
+    quint32 offset;
+    quint32 size;
+    /** Number of guide and mount samples of the chunk preceding the line */
+    quint32 guideIndex;
+    quint32 mountIndex;
+};
+
+AnalyzeStore::~AnalyzeStore()
+{
+    close();
+}
+
+void AnalyzeStore::close()
+{
+    if (m_Data)
+        m_File.unmap(const_cast<uchar *>(m_Data));
+    m_File.close();
+    m_Data = nullptr;
+    m_Size = 0;
+    m_Memory.clear();
+    m_Tail.clear();
+    m_Chunks.clear();
+}
+
+bool AnalyzeStore::map(const QString &filename)
+{
+    m_File.setFileName(filename);
+    if (!m_File.open(QIODevice::ReadOnly))
+        return false;
+
+    m_Size = m_File.size();
+    m_Data = m_Size >= static_cast<qint64>(sizeof(Header)) ? m_File.map(0, m_Size) : nullptr;
+    if (m_Data == nullptr)
+    {
+        m_File.close();
+        m_Size = 0;
+        return false;
+    }
+    return true;
+}
+
+QByteArray AnalyzeStore::header(const QByteArray &prefixHash, quint64 prefixSize)
+{
+    static_assert(sizeof(Header) % 8 == 0 && sizeof(ChunkHeader) % 8 == 0, "Store headers must keep columns aligned");
+
+    Header header {};
+    std::memcpy(header.magic, store_magic, sizeof(header.magic));
+    header.version = store_version;
+    header.endianness = store_endianness;
+    header.prefixSize = prefixSize;
+    std::memcpy(header.prefixHash, prefixHash.constData(), std::min<size_t>(prefixHash.size(), sizeof(header.prefixHash)));
+    return QByteArray(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+bool AnalyzeStore::open(const QString &logFilename)
+{
+    close();
+
+    QFile log(logFilename);
+    if (!log.open(QIODevice::ReadOnly))
+        return false;
+
+    const QString companion = companionFilename(logFilename);
+    auto prefixHash = [&](quint64 size)
+    {
+        log.seek(0);
+        return QCryptographicHash::hash(log.read(size), QCryptographicHash::Md5);
+    };
+
+    // Part of the log already in the companion, if it still matches the log
+    qint64 covered = -1;
+    if (map(companion))
+    {
+        Header header;
+        std::memcpy(&header, m_Data, sizeof(header));
+        QVector<Chunk> chunks;
+        if (std::memcmp(header.magic, store_magic, sizeof(header.magic)) == 0 && header.version == store_version &&
+                header.endianness == store_endianness && header.prefixSize <= static_cast<quint64>(log.size()) &&
+                prefixHash(header.prefixSize) == QByteArray(header.prefixHash, sizeof(header.prefixHash)))
+            covered = readChunks(reinterpret_cast<const char *>(m_Data) + sizeof(Header), m_Size - sizeof(Header), chunks);
+
+        if (covered > log.size())
+            covered = -1;
+    }
+
+    // Parse the complete lines the companion misses, the final line may still be written to
+    log.seek(std::max<qint64>(covered, 0));
+    QByteArray text = log.readAll();
+    const int end = text.lastIndexOf('\n') + 1;
+    if (end < text.size())
+        m_Tail = buildChunk(text.mid(end), 0);
+    text.truncate(end);
+
+    QByteArray content;
+    if (covered < 0)
+    {
+        const qint64 prefixSize = std::min<qint64>(PREFIX_SIZE, text.size());
+        content = header(prefixHash(prefixSize), prefixSize) + buildChunk(text, text.size());
+
+        if (m_Data)
+            m_File.unmap(const_cast<uchar *>(m_Data));
+        m_File.close();
+        m_Data = nullptr;
+
+        QSaveFile file(companion);
+        if (!text.isEmpty() && file.open(QIODevice::WriteOnly) && file.write(content) == content.size() && file.commit())
+            map(companion);
+    }
+    else if (!text.isEmpty())
+    {
+        const QByteArray chunk = buildChunk(text, covered + text.size());
+        content = QByteArray(reinterpret_cast<const char *>(m_Data), m_Size) + chunk;
+
+        m_File.unmap(const_cast<uchar *>(m_Data));
+        m_File.close();
+        m_Data = nullptr;
+
+        QFile file(companion);
+        if (file.open(QIODevice::WriteOnly | QIODevice::Append) && file.write(chunk) == chunk.size())
+        {
+            file.close();
+            map(companion);
+        }
+    }
+
+    // The companion couldn't be written, or what was read back differs from what was written
+    if (m_Data && !content.isEmpty() && (m_Size != content.size() || std::memcmp(m_Data, content.constData(), m_Size) != 0))
+    {
+        m_File.unmap(const_cast<uchar *>(m_Data));
+        m_File.close();
+        m_Data = nullptr;
+    }
+    if (m_Data == nullptr)
+    {
+        m_Memory = content;
+        m_Size = content.size();
+    }
+
+    const char *data = m_Data ? reinterpret_cast<const char *>(m_Data) : m_Memory.constData();
+    if (m_Size > static_cast<qint64>(sizeof(Header)))
+        readChunks(data + sizeof(Header), m_Size - sizeof(Header), m_Chunks);
+    if (!m_Tail.isEmpty())
+        readChunks(m_Tail.constData(), m_Tail.size(), m_Chunks);
+
+    return true;
+}
+
+QByteArray AnalyzeStore::buildChunk(const QByteArray &text, quint64 textEnd)
+{
+    QVector<double> guide[5], mount[6];
+    QVector<qint32> guidePulses[3], pierSide;
+    QVector<LineEntry> lines;
+    QByteArray strings;
+
+    int start = 0;
+    while (start < text.size())
+    {
+        int end = text.indexOf('\n', start);
+        if (end < 0)
+            end = text.size();
+        int length = end - start;
+        if (length > 0 && text.at(end - 1) == '\r')
+            length--;
+        const QByteArray line = QByteArray::fromRawData(text.constData() + start, length);
+        start = end + 1;
+        if (line.isEmpty())
+            continue;
+
+        if (line.startsWith("GuideStats,"))
+        {
+            double values[5];
+            qint32 pulses[3];
+            if (parseGuideStats(line.split(','), values, pulses))
+            {
+                for (int i = 0; i < 5; i++)
+                    guide[i].append(values[i]);
+                for (int i = 0; i < 3; i++)
+                    guidePulses[i].append(pulses[i]);
+                continue;
+            }
+        }
+        else if (line.startsWith("MountCoords,"))
+        {
+            double values[6];
+            qint32 side;
+            if (parseMountCoords(line.split(','), values, side))
+            {
+                for (int i = 0; i < 6; i++)
+                    mount[i].append(values[i]);
+                pierSide.append(side);
+                continue;
+            }
+        }
+
+        lines.append({ static_cast<quint32>(strings.size()), static_cast<quint32>(line.size()),
+                       static_cast<quint32>(guide[0].size()), static_cast<quint32>(mount[0].size()) });
+        strings.append(line);
+    }
+
+    ChunkHeader header {};
+    std::memcpy(header.magic, chunk_magic, sizeof(header.magic));
+    header.guideCount = guide[0].size();
+    header.mountCount = mount[0].size();
+    header.lineCount = lines.size();
+    header.stringBytes = strings.size();
+    header.textEnd = textEnd;
+
+    QByteArray chunk(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const auto &column : guide)
+        appendColumn(chunk, column);
+    for (const auto &column : mount)
+        appendColumn(chunk, column);
+    for (const auto &column : guidePulses)
+        appendColumn(chunk, column);
+    appendColumn(chunk, pierSide);
+    appendColumn(chunk, lines);
+    chunk.append(strings);
+    chunk.append((8 - chunk.size() % 8) % 8, '\0');
+    return chunk;
+}
+
+qint64 AnalyzeStore::readChunks(const char *data, qint64 size, QVector<Chunk> &chunks)
+{
+    qint64 covered = 0;
+    qint64 position = 0;
+    while (position < size)
+    {
+        if (size - position < static_cast<qint64>(sizeof(ChunkHeader)))
+            return -1;
+
+        const auto header = reinterpret_cast<const ChunkHeader *>(data + position);
+        if (std::memcmp(header->magic, chunk_magic, sizeof(header->magic)) != 0 ||
+                header->stringBytes > static_cast<quint64>(size))
+            return -1;
+
+        const qint64 g = header->guideCount, m = header->mountCount;
+        qint64 chunkSize = sizeof(ChunkHeader) + 8 * (5 * g + 6 * m) + 4 * (3 * g + m)
+                           + static_cast<qint64>(sizeof(LineEntry)) * header->lineCount + header->stringBytes;
+        chunkSize += (8 - chunkSize % 8) % 8;
+        if (chunkSize > size - position || (header->textEnd > 0 && static_cast<qint64>(header->textEnd) < covered))
+            return -1;
+
+        Chunk chunk;
+        chunk.header = header;
+        const char *column = data + position + sizeof(ChunkHeader);
+        for (auto &values : chunk.guide)
+        {
+            values = reinterpret_cast<const double *>(column);
+            column += 8 * g;
+        }
+        for (auto &values : chunk.mount)
+        {
+            values = reinterpret_cast<const double *>(column);
+            column += 8 * m;
+        }
+        for (auto &values : chunk.guidePulses)
+        {
+            values = reinterpret_cast<const qint32 *>(column);
+            column += 4 * g;
+        }
+        chunk.pierSide = reinterpret_cast<const qint32 *>(column);
+        column += 4 * m;
+        chunk.lines = reinterpret_cast<const LineEntry *>(column);
+        chunk.strings = column + sizeof(LineEntry) * header->lineCount;
+
+        for (quint32 i = 0; i < header->lineCount; i++)
+        {
+            const LineEntry &line = chunk.lines[i];
+            if (static_cast<quint64>(line.offset) + line.size > header->stringBytes || line.guideIndex > g || line.mountIndex > m)
+                return -1;
+        }
+
+        chunks.append(chunk);
+        covered = std::max<qint64>(covered, header->textEnd);
+        position += chunkSize;
+    }
+    return covered;
+}
+
+void AnalyzeStore::replay(const Callbacks &callbacks) const
+{
+    for (const auto &chunk : m_Chunks)
+    {
+        quint32 g = 0, m = 0;
+        auto guideUpTo = [&](quint32 end)
+        {
+            for (; g < end; g++)
+                callbacks.guideStats(chunk.guide[0][g], chunk.guide[1][g], chunk.guide[2][g], chunk.guidePulses[0][g],
+                                     chunk.guidePulses[1][g], chunk.guide[3][g], chunk.guide[4][g], chunk.guidePulses[2][g]);
+        };
+        auto mountUpTo = [&](quint32 end)
+        {
+            for (; m < end; m++)
+                callbacks.mountCoords(chunk.mount[0][m], chunk.mount[1][m], chunk.mount[2][m], chunk.mount[3][m],
+                                      chunk.mount[4][m], chunk.pierSide[m], chunk.mount[5][m]);
+        };
+
+        for (quint32 i = 0; i < chunk.header->lineCount; i++)
+        {
+            const LineEntry &line = chunk.lines[i];
+            guideUpTo(line.guideIndex);
+            mountUpTo(line.mountIndex);
+            callbacks.line(QString::fromUtf8(chunk.strings + line.offset, line.size));
+        }
+        guideUpTo(chunk.header->guideCount);
+        mountUpTo(chunk.header->mountCount);
+    }
+}
+
+int AnalyzeStore::guideSampleCount() const
+{
+    int count = 0;
+    for (const auto &chunk : m_Chunks)
+        count += chunk.header->guideCount;
+    return count;
+}
+
+int AnalyzeStore::mountSampleCount() const
+{
+    int count = 0;
+    for (const auto &chunk : m_Chunks)
+        count += chunk.header->mountCount;
+    return count;
+}
+
+int AnalyzeStore::lineCount() const
+{
+    int count = 0;
+    for (const auto &chunk : m_Chunks)
+        count += chunk.header->lineCount;
+    return count;
+}
+
+}
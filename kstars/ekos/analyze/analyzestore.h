@@ -0,0 +1,112 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+#include <functional>
+
+namespace Ekos
+{
+
+/**
+ * @class AnalyzeStore
+ * @short Binary companion of an .analyze log, so that long logs are not parsed again each time they are loaded.
+ *
+ * The companion sits next to the log, with an .idx suffix. It is a sequence of chunks, each covering the lines
+ * of the log up to some offset. Guide and mount samples, which make up most of a log, are kept in columns of
+ * binary values. All the other lines are kept as text, along with the number of samples preceding them, so
+ * that the log can be replayed in its original order.
+ *
+ * The companion is memory mapped. When the log grew since the companion was written, e.g. because it is the log
+ * of the current session, the new lines are parsed and appended as a new chunk. When the beginning of the log
+ * changed, or the companion can't be read, it is rebuilt. If it can't be written, it is kept in memory.
+ */
+class AnalyzeStore
+{
+    public:
+        /** @short Receivers of the replayed log, in the order of the log. */
+        struct Callbacks
+        {
+            std::function<void(double time, double raError, double decError, int raPulse, int decPulse,
+                               double snr, double skyBg, int numStars)> guideStats;
+            std::function<void(double time, double ra, double dec, double az, double alt, int pierSide,
+                               double ha)> mountCoords;
+            /** Any other line of the log, to be parsed as text */
+            std::function<void(const QString &line)> line;
+        };
+
+        AnalyzeStore() = default;
+        ~AnalyzeStore();
+
+        /**
+         * @brief open Load the companion of an .analyze log, creating or extending it as needed.
+         * @param logFilename path to the .analyze log.
+         * @return False if the log can't be read.
+         */
+        bool open(const QString &logFilename);
+        void close();
+
+        /** @brief replay Send the content of the log to the callbacks, in the order of the log. */
+        void replay(const Callbacks &callbacks) const;
+
+        int guideSampleCount() const;
+        int mountSampleCount() const;
+        int lineCount() const;
+
+        /** @return true if the companion was read from disk, or written to it. */
+        bool isMapped() const
+        {
+            return m_Data != nullptr;
+        }
+
+        static QString companionFilename(const QString &logFilename)
+        {
+            return logFilename + ".idx";
+        }
+
+    private:
+        struct Header;
+        struct ChunkHeader;
+        struct LineEntry;
+
+        // Pointers to the columns of a chunk, either in the mapped companion or in memory
+        struct Chunk
+        {
+            const ChunkHeader *header { nullptr };
+            // Time, RA error, DEC error, SNR and sky background of the guide samples
+            const double *guide[5] {};
+            // RA pulse, DEC pulse and number of stars of the guide samples
+            const qint32 *guidePulses[3] {};
+            // Time, RA, DEC, azimuth, altitude and hour angle of the mount samples
+            const double *mount[6] {};
+            const qint32 *pierSide { nullptr };
+            const LineEntry *lines { nullptr };
+            const char *strings { nullptr };
+        };
+
+        // Parses lines of the log into a chunk ending at textEnd in the log
+        static QByteArray buildChunk(const QByteArray &text, quint64 textEnd);
+        // Splits a companion into chunks, returns the part of the log they cover or -1 if it is corrupted
+        static qint64 readChunks(const char *data, qint64 size, QVector<Chunk> &chunks);
+        static QByteArray header(const QByteArray &prefixHash, quint64 prefixSize);
+        bool map(const QString &filename);
+
+        QFile m_File;
+        const uchar *m_Data { nullptr };
+        qint64 m_Size { 0 };
+        // Companion content when it could not be written to disk
+        QByteArray m_Memory;
+        // Chunk of the final line of the log, when not terminated yet, never written to the companion
+        QByteArray m_Tail;
+        QVector<Chunk> m_Chunks;
+};
+
+}
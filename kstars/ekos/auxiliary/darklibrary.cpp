@@ -19,6 +19,8 @@
 #include "fitsviewer/fitsdata.h"
 #include "fitsviewer/fitsview.h"
 
+#include "ekos_debug.h"
+
 #include <QDesktopServices>
 #include <QSqlRecord>
 #include <QSqlTableModel>
@@ -521,13 +523,10 @@ void DarkLibrary::processNewBLOB(IBLOB *bp)
         return;
     }
 
-    uint32_t totalElements = m_CurrentDarkFrame->channels() * m_CurrentDarkFrame->samplesPerChannel();
-    if (totalElements != m_DarkMasterBuffer.size())
-        m_DarkMasterBuffer.assign(totalElements, 0);
-
     aggregate(m_CurrentDarkFrame);
     darkProgress->setValue(darkProgress->value() + 1);
-    m_StatusLabel->setText(i18n("Received %1/%2 images.", darkProgress->value(), darkProgress->maximum()));
+    m_StatusLabel->setText(i18n("Received %1/%2 images (stacked at %3 Mpx/s).", darkProgress->value(), darkProgress->maximum(),
+                                QString::number(m_DarkStacker.throughput(), 'f', 0)));
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////
@@ -1201,6 +1200,7 @@ void DarkLibrary::generateDarkJobs()
 void DarkLibrary::execute()
 {
     m_DarkImagesCounter = 0;
+    m_DarkStacker.setMethod(static_cast<FrameStacker::Method>(combinAlgorithmCombo->currentIndex()));
     darkProgress->setValue(0);
     darkProgress->setTextVisible(true);
     connect(m_CaptureModule, &Capture::newImage, this, &DarkLibrary::processNewImage, Qt::UniqueConnection);
@@ -1296,8 +1296,9 @@ template <typename T>
 void DarkLibrary::aggregateInternal(const QSharedPointer<FITSData> &data)
 {
     T const *darkBuffer  = reinterpret_cast<T const*>(data->getImageBuffer());
-    for (uint32_t i = 0; i < m_DarkMasterBuffer.size(); i++)
-        m_DarkMasterBuffer[i] += darkBuffer[i];
+    m_DarkStacker.addFrame(darkBuffer, data->channels() * data->samplesPerChannel());
+    qCDebug(KSTARS_EKOS) << "Dark frame" << m_DarkStacker.frames() << "stacked in" << m_DarkStacker.lastFrameTime() << "ms,"
+                         << m_DarkStacker.throughput() << "Mpx/s";
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////
@@ -1344,8 +1345,8 @@ void DarkLibrary::generateMasterFrame(const QSharedPointer<FITSData> &data, cons
     }
 
     emit newImage(data);
-    // Reset Master Buffer
-    m_DarkMasterBuffer.assign(m_DarkMasterBuffer.size(), 0);
+    // Reset the stack for the next master frame
+    m_DarkStacker.clear();
 
 }
 
@@ -1356,10 +1357,11 @@ template <typename T>  void DarkLibrary::generateMasterFrameInternal(const QShar
         const QJsonObject &metadata)
 {
     T *writableBuffer = reinterpret_cast<T *>(data->getWritableImageBuffer());
-    const uint32_t count = metadata["count"].toInt();
-    // Average the values
-    for (uint32_t i = 0; i < m_DarkMasterBuffer.size(); i++)
-        writableBuffer[i] = m_DarkMasterBuffer[i] / count;
+    if (!m_DarkStacker.writeMaster(writableBuffer))
+    {
+        m_FileLabel->setText(i18n("Failed to generate master frame: no dark frames received."));
+        return;
+    }
 
     QString ts = QDateTime::currentDateTime().toString("yyyy-MM-ddThh-mm-ss");
     QString path = QDir(KSPaths::writableLocation(QStandardPaths::AppLocalDataLocation)).filePath("darks/darkframe_" + ts +
@@ -10,6 +10,7 @@
 #include "indi/indidustcap.h"
 #include "darkview.h"
 #include "defectmap.h"
+#include "framestacker.h"
 #include "ekos/ekos.h"
 
 #include <QDialog>
@@ -33,8 +34,8 @@ class SequenceJob;
  *
  * Dark Frames:
  *
- * The user can generate dark frames from an average combination of the camera dark frames. By default, 5 dark frames
- * are captured to merged into a single master frame. Frame duration, binning, and temperature are all configurable.
+ * The user can generate dark frames from an average, median or kappa-sigma combination of the camera dark frames. By default,
+ * 5 dark frames are captured to merged into a single master frame. Frames are stacked by /class FrameStacker as they arrive. Frame duration, binning, and temperature are all configurable.
  * If the user select "Dark" in any of the Ekos module, Dark Library can be queried if a suitable dark frame exists given
  * the current camera settings (binning, temperature..etc). If a suitable frame exists, it is loaded up and send to /class DarkProcessor
  * class along with the light frame to perform subtraction or defect map corrections.
@@ -189,7 +190,7 @@ class DarkLibrary : public QDialog, public Ui::DarkLibrary
 
         /**
          * @brief aggregate Aggregate the data as per the selected algorithm. Each time a new dark frame is received, this function
-         * adds the frame data to the dark buffer.
+         * folds the frame data into the frame stacker.
          * @param data Dark frame data.
          */
         template <typename T> void aggregateInternal(const QSharedPointer<FITSData> &data);
@@ -285,7 +286,7 @@ class DarkLibrary : public QDialog, public Ui::DarkLibrary
         QSqlTableModel *darkFramesModel = nullptr;
         QSortFilterProxyModel *sortFilter = nullptr;
 
-        std::vector<uint32_t> m_DarkMasterBuffer;
+        FrameStacker m_DarkStacker;
         uint32_t m_DarkImagesCounter {0};
         bool m_RememberFITSViewer {true};
         bool m_RememberSummaryView {true};
@@ -7,14 +7,55 @@
 #include "darkprocessor.h"
 #include "darklibrary.h"
 #include "ekos/auxiliary/opticaltrainsettings.h"
+#include "fitsviewer/fitsstatskernel.h"
 
+#include <QtConcurrent>
+#include <QThread>
+
+#include <algorithm>
 #include <array>
+#include <vector>
 
 #include "ekos_debug.h"
 
 namespace Ekos
 {
 
+namespace
+{
+// Rows corrected at once by a task, then gathered into the statistics while they are still in cache
+constexpr uint32_t TILE_ROWS = 16;
+// Bad pixels filtered by each parallel task
+constexpr uint32_t DEFECTS_PER_TASK = 4096;
+
+// Subtract a row of dark pixels from a row of light pixels, clamping at zero, in a loop the compiler vectorizes
+template <typename T>
+void subtractRow(T *light, T const *dark, uint32_t count)
+{
+    for (uint32_t x = 0; x < count; x++)
+        light[x] = (light[x] > dark[x]) ? static_cast<T>(light[x] - dark[x]) : static_cast<T>(0);
+}
+
+// Run function(first, count) over chunks of size items, in parallel
+template <typename F>
+void forEachChunk(uint32_t size, uint32_t chunkSize, F function)
+{
+    QVector<uint32_t> chunks;
+    for (uint32_t first = 0; first < size; first += chunkSize)
+        chunks.append(first);
+
+    auto run = [&](const uint32_t &first)
+    {
+        function(first, std::min(chunkSize, size - first));
+    };
+
+    if (chunks.size() > 1)
+        QtConcurrent::blockingMap(chunks, run);
+    else if (!chunks.isEmpty())
+        run(chunks.first());
+}
+}
+
 DarkProcessor::DarkProcessor(QObject *parent) : QObject(parent)
 {
     connect(&m_Watcher, &QFutureWatcher<bool>::finished, this, [this]()
@@ -76,44 +117,50 @@ template <typename T>
 void DarkProcessor::normalizeDefectsInternal(const QSharedPointer<DefectMap> &defectMap,
         const QSharedPointer<FITSData> &lightData, uint16_t offsetX, uint16_t offsetY)
 {
-
     T *lightBuffer = reinterpret_cast<T *>(lightData->getWritableImageBuffer());
-    const uint32_t width = lightData->width();
+    const int64_t width = lightData->width();
+    const int64_t height = lightData->height();
+    const std::vector<uint32_t> &index = defectMap->badPixelIndex();
 
     // Account for offset X and Y
     // e.g. if we send a subframed light frame 100x100 pixels wide
     // but the source defect map covers 1000x1000 pixels array, then we need to only compensate
-    // for the 100x100 region.
-    for (BadPixelSet::const_iterator onePixel = defectMap->hotThreshold();
-            onePixel != defectMap->hotPixels().cend(); ++onePixel)
+    // for the 100x100 region. Pixels on the border of the light frame lack neighbours and are left alone.
+    auto locate = [&](uint32_t packed, int64_t &x, int64_t &y)
     {
-        const uint16_t x = (*onePixel).x;
-        const uint16_t y = (*onePixel).y;
-
-        if (x <= offsetX || y <= offsetY)
-            continue;
-
-        uint32_t offset = (x - offsetX) + (y - offsetY) * width;
-
-        lightBuffer[offset] = median3x3Filter(x - offsetX, y - offsetY, width, lightBuffer);
-    }
-
-    for (BadPixelSet::const_iterator onePixel = defectMap->coldPixels().cbegin();
-            onePixel != defectMap->coldThreshold(); ++onePixel)
+        x = static_cast<int64_t>(packed & 0xFFFF) - offsetX;
+        y = static_cast<int64_t>(packed >> 16) - offsetY;
+        return x >= 1 && y >= 1 && x < width - 1 && y < height - 1;
+    };
+
+    // Filter all the bad pixels first, from the uncorrected frame, so that the bands below
+    // can be corrected in parallel without reading pixels another band is writing.
+    std::vector<T> replacements(index.size());
+    forEachChunk(index.size(), DEFECTS_PER_TASK, [&](uint32_t first, uint32_t count)
     {
-        const uint16_t x = (*onePixel).x;
-        const uint16_t y = (*onePixel).y;
-
-        if (x <= offsetX || y <= offsetY)
-            continue;
-
-        uint32_t offset = (x - offsetX) + (y - offsetY) * width;
-
-        lightBuffer[offset] = median3x3Filter(x - offsetX, y - offsetY, width, lightBuffer);
-    }
+        int64_t x, y;
+        for (uint32_t i = first; i < first + count; i++)
+        {
+            if (locate(index[i], x, y))
+                replacements[i] = median3x3Filter<T>(x, y, width, lightBuffer);
+        }
+    });
 
-    lightData->calculateStats(true);
+    // The index is sorted in memory order, the bad pixels of a band of rows are contiguous in it
+    transformWithStats<T>(lightData, [&](int channel, uint32_t firstRow, uint32_t rows)
+    {
+        if (channel != 0)
+            return;
 
+        const auto begin = std::lower_bound(index.cbegin(), index.cend(), static_cast<uint64_t>(firstRow + offsetY) << 16);
+        const auto end = std::lower_bound(begin, index.cend(), static_cast<uint64_t>(firstRow + rows + offsetY) << 16);
+        int64_t x, y;
+        for (auto onePixel = begin; onePixel != end; ++onePixel)
+        {
+            if (locate(*onePixel, x, y))
+                lightBuffer[x + y * width] = replacements[onePixel - index.cbegin()];
+        }
+    });
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////
@@ -199,23 +246,104 @@ void DarkProcessor::subtractInternal(const QSharedPointer<FITSData> &darkData, c
                                      uint16_t offsetX, uint16_t offsetY)
 {
     const uint32_t width = lightData->width();
-    const uint32_t height = lightData->height();
+    const uint32_t lightSamples = lightData->samplesPerChannel();
     T *lightBuffer = reinterpret_cast<T *>(lightData->getWritableImageBuffer());
 
     const uint32_t darkStride = darkData->width();
+    const uint32_t darkSamples = darkData->samplesPerChannel();
     const uint32_t darkoffset = offsetX + offsetY * darkStride;
     T const *darkBuffer  = reinterpret_cast<T const*>(darkData->getImageBuffer()) + darkoffset;
+    const int channels = std::min(lightData->channels(), darkData->channels());
 
-    for (uint32_t y = 0; y < height; y++)
+    transformWithStats<T>(lightData, [&](int channel, uint32_t firstRow, uint32_t rows)
     {
-        for (uint32_t x = 0; x < width; x++)
-            lightBuffer[x] = (lightBuffer[x] > darkBuffer[x]) ? (lightBuffer[x] - darkBuffer[x]) : 0;
+        if (channel >= channels)
+            return;
+
+        T *light = lightBuffer + channel * lightSamples + firstRow * width;
+        T const *dark = darkBuffer + channel * darkSamples + firstRow * darkStride;
+        for (uint32_t y = 0; y < rows; y++)
+        {
+            subtractRow(light, dark, width);
+            light += width;
+            dark += darkStride;
+        }
+    });
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///////////////////////////////////////////////////////////////////////////////////////
+template <typename T, typename Transform>
+void DarkProcessor::transformWithStats(const QSharedPointer<FITSData> &lightData, Transform transform)
+{
+    T const *buffer = reinterpret_cast<T const *>(lightData->getImageBuffer());
+    const uint32_t width = lightData->width();
+    const uint32_t height = lightData->height();
+    const uint32_t samples = lightData->samplesPerChannel();
+    constexpr uint32_t bins = FITSStatsKernel::histogramBins<T>();
+    constexpr int32_t offset = FITSStatsKernel::histogramOffset<T>();
+
+    // One band per core, but large enough to amortize the dispatch and, for 8/16 bit data,
+    // the merge of the per-band histograms.
+    const uint32_t minBandSize = bins > 0 ? 16 * bins : 65536;
+    const uint32_t nBands = qBound<uint32_t>(1, samples / minBandSize, QThread::idealThreadCount());
+    const uint32_t bandRows = (height + nBands - 1) / nBands;
+
+    for (int n = 0; n < lightData->channels(); n++)
+    {
+        T const * const channel = buffer + n * samples;
+        std::vector<std::vector<uint32_t>> histograms(bins > 0 ? nBands : 0);
+        std::vector<FITSStatsKernel::Partial> partials(nBands);
+
+        forEachChunk(nBands, 1, [&](uint32_t band, uint32_t)
+        {
+            const uint32_t last = std::min(height, (band + 1) * bandRows);
+            if constexpr (bins > 0)
+                histograms[band].assign(bins, 0);
+
+            for (uint32_t row = band * bandRows; row < last; row += TILE_ROWS)
+            {
+                const uint32_t rows = std::min(TILE_ROWS, last - row);
+                transform(n, row, rows);
+
+                T const * const tile = channel + row * width;
+                if constexpr (bins > 0)
+                    partials[band].merge(FITSStatsKernel::accumulate(tile, rows * width, histograms[band].data()));
+                else
+                    partials[band].merge(FITSStatsKernel::accumulate(tile, rows * width));
+            }
+        });
+
+        FITSStatsKernel::Partial total;
+        double median = 0;
+        if constexpr (bins > 0)
+        {
+            for (uint32_t i = 1; i < nBands; i++)
+            {
+                for (uint32_t bin = 0; bin < bins; bin++)
+                    histograms[0][bin] += histograms[i][bin];
+            }
+
+            total = FITSStatsKernel::fromHistogram(histograms[0].data(), bins, offset);
+            median = FITSStatsKernel::histogramMedian(histograms[0].data(), bins, offset, total.count);
+        }
+        else
+        {
+            for (const auto &partial : partials)
+                total.merge(partial);
+            median = FITSStatsKernel::sampledMedian(channel, samples);
+        }
 
-        lightBuffer += width;
-        darkBuffer += darkStride;
+        if (total.count > 0)
+            lightData->setMinMax(total.min, total.max, n);
+        lightData->setMean(total.mean(), n);
+        lightData->setStdDev(total.stddev(), n);
+        lightData->setMedian(median, n);
     }
 
-    lightData->calculateStats(true);
+    // FIXME That's not really SNR, same as FITSData::calculateStats()
+    lightData->setSNR(lightData->getMean(0) / lightData->getStdDev(0));
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////
@@ -30,6 +30,9 @@ namespace Ekos
  * pixels are treated with a 3x3 median filter. If no defect map is found, it searches for suitable dark frames and if any is found then
  * a simple subtraction is applied.
  *
+ * Both corrections walk the light frame once, in bands of rows processed in parallel, and gather the statistics of each
+ * band while it is still in cache, so that the frame is not read again to refresh its statistics.
+ *
  * @author Jasem Mutlaq
  * @version 1.0
  */
@@ -97,6 +100,15 @@ class DarkProcessor : public QObject
         template <typename T>
         T median3x3Filter(uint16_t x, uint16_t y, uint32_t width, T *buffer);
 
+        /**
+        * @brief transformWithStats Apply a correction to the light frame in bands of rows, in parallel, and refresh the
+        * statistics of the frame from the corrected bands.
+        * @param lightData Light frame data. The light frame data is modified in this process.
+        * @param transform Called as transform(channel, firstRow, rowCount) to correct rows of a channel in place.
+        */
+        template <typename T, typename Transform>
+        void transformWithStats(const QSharedPointer<FITSData> &lightData, Transform transform);
+
     signals:
         void darkFrameCompleted(bool);
         void newLog(const QString &message);
@@ -7,6 +7,8 @@
 #include "defectmap.h"
 #include <QJsonDocument>
 
+#include <algorithm>
+
 //////////////////////////////////////////////////////////////////////////////
 ///
 //////////////////////////////////////////////////////////////////////////////
@@ -26,7 +28,8 @@ QJsonObject BadPixel::json() const
 //////////////////////////////////////////////////////////////////////////////
 DefectMap::DefectMap() : QObject()
 {
-
+    m_HotPixelsThreshold = m_HotPixels.cend();
+    m_ColdPixelsThreshold = m_ColdPixels.cbegin();
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -58,6 +61,8 @@ bool DefectMap::load(const QString &filename)
 
     m_HotPixels.clear();
     m_ColdPixels.clear();
+    m_HotPixelsThreshold = m_HotPixels.cend();
+    m_ColdPixelsThreshold = m_ColdPixels.cbegin();
 
     for (const auto &onePixel : qAsConst(hot))
     {
@@ -264,15 +269,34 @@ void DefectMap::filterPixels()
     else
         m_ColdPixelsCount = std::distance(m_ColdPixels.cbegin(), m_ColdPixelsThreshold);
 
+    buildBadPixelIndex();
     emit pixelsUpdated(m_HotPixelsCount, m_ColdPixelsCount);
 }
 
+//////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////
+void DefectMap::buildBadPixelIndex()
+{
+    m_BadPixelIndex.clear();
+    m_BadPixelIndex.reserve((m_HotEnabled ? m_HotPixelsCount : 0) + (m_ColdEnabled ? m_ColdPixelsCount : 0));
+
+    for (auto onePixel = hotThreshold(); onePixel != m_HotPixels.cend(); ++onePixel)
+        m_BadPixelIndex.push_back(static_cast<uint32_t>(onePixel->y) << 16 | onePixel->x);
+    for (auto onePixel = m_ColdPixels.cbegin(); onePixel != coldThreshold(); ++onePixel)
+        m_BadPixelIndex.push_back(static_cast<uint32_t>(onePixel->y) << 16 | onePixel->x);
+
+    std::sort(m_BadPixelIndex.begin(), m_BadPixelIndex.end());
+    m_BadPixelIndex.erase(std::unique(m_BadPixelIndex.begin(), m_BadPixelIndex.end()), m_BadPixelIndex.end());
+}
+
 //////////////////////////////////////////////////////////////////////////////
 ///
 //////////////////////////////////////////////////////////////////////////////
 void DefectMap::setHotEnabled(bool enabled)
 {
     m_HotEnabled = enabled;
+    buildBadPixelIndex();
     emit pixelsUpdated(m_HotEnabled ? m_HotPixelsCount : 0, m_ColdPixelsCount);
 }
 
@@ -282,5 +306,6 @@ void DefectMap::setHotEnabled(bool enabled)
 void DefectMap::setColdEnabled(bool enabled)
 {
     m_ColdEnabled = enabled;
+    buildBadPixelIndex();
     emit pixelsUpdated(m_HotPixelsCount, m_ColdEnabled ? m_ColdPixelsCount : 0);
 }
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <set>
+#include <vector>
 #include <QJsonObject>
 #include <QJsonArray>
 
@@ -90,6 +91,15 @@ class DefectMap : public QObject
             return m_ColdPixelsCount;
         }
 
+        /**
+         * @brief badPixelIndex Positions of the enabled hot and cold pixels, packed as (y << 16) | x and sorted in
+         * ascending order, that is in the order they are laid out in the image buffer.
+         */
+        const std::vector<uint32_t> &badPixelIndex() const
+        {
+            return m_BadPixelIndex;
+        }
+
         void filterPixels();
     signals:
         //        void hotPixelsUpdated(const BadPixelSet::const_iterator &start, const BadPixelSet::const_iterator &end);
@@ -102,9 +112,11 @@ class DefectMap : public QObject
         double calculateSigma(uint8_t aggressiveness);
         template <typename T>
         void initBadPixelsInternal(double hotPixelThreshold, double coldPixelThreshold);
+        void buildBadPixelIndex();
 
         BadPixelSet m_ColdPixels, m_HotPixels;
         BadPixelSet::const_iterator m_ColdPixelsThreshold, m_HotPixelsThreshold;
+        std::vector<uint32_t> m_BadPixelIndex;
         uint8_t m_HotPixelsAggressiveness {75}, m_ColdPixelsAggressiveness {75};
         uint32_t m_HotPixelsCount {0}, m_ColdPixelsCount {0};
         double m_HotSigma {0}, m_ColdSigma {0};
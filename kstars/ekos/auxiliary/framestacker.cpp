@@ -0,0 +1,341 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "framestacker.h"
+
+#include <QElapsedTimer>
+#include <QVector>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+namespace Ekos
+{
+
+namespace
+{
+// Samples folded by each parallel task
+constexpr uint32_t SPAN_SIZE = 1 << 16;
+
+// Scale of the median step relative to the mean absolute deviation. For a gaussian pixel, the
+// ideal step is 1.25 sigma, and the mean absolute deviation is 0.8 sigma.
+constexpr float MEDIAN_GAIN = 1.5f;
+
+// Residuals are clipped to this many mean absolute deviations before updating the deviation, so
+// that an outlier neither inflates the step of the median nor drags it away.
+constexpr float MEDIAN_CLIP = 3.0f;
+
+// Whether a sample delta away from the mean of n accepted samples lies within kappa standard deviations,
+// as 0 or 1. Integer samples are quantized, a deviation of floor is allowed for pixels that never changed.
+inline float withinKappa(float delta, float n, float m2, float kappa2, float floor)
+{
+    // delta^2 <= kappa^2 * variance, with variance = m2 / (n - 1)
+    return static_cast<float>(delta * delta * (n - 1) <= kappa2 * (m2 + floor * (n - 1)));
+}
+
+// Folds value, with a weight of 0 or 1, into the running average and sum of squared deviations of n samples
+inline void foldSample(float value, float weight, float &mean, float &m2, float &n)
+{
+    const float delta = value - mean;
+    const float total = n + weight;
+    mean += weight * delta / total;
+    m2 += weight * delta * (value - mean);
+    n = total;
+}
+
+// Runs function(first, count) over spans of samples, in parallel
+template <typename F>
+void forEachSpan(uint32_t samples, F function)
+{
+    QVector<uint32_t> spans;
+    for (uint32_t first = 0; first < samples; first += SPAN_SIZE)
+        spans.append(first);
+
+    auto run = [&](const uint32_t &first)
+    {
+        function(first, std::min(SPAN_SIZE, samples - first));
+    };
+
+    if (spans.size() > 1)
+        QtConcurrent::blockingMap(spans, run);
+    else if (!spans.isEmpty())
+        run(spans.first());
+}
+}
+
+void FrameStacker::setMethod(Method method, float kappa)
+{
+    m_Method = method;
+    m_Kappa = kappa;
+    clear();
+}
+
+void FrameStacker::clear()
+{
+    m_Frames = 0;
+    m_Samples = 0;
+    m_LastFrameTime = 0;
+    std::vector<float>().swap(m_Mean);
+    std::vector<float>().swap(m_M2);
+    std::vector<float>().swap(m_Extra);
+    std::vector<float>().swap(m_Suspect);
+}
+
+double FrameStacker::throughput() const
+{
+    return m_LastFrameTime > 0 ? m_Samples / (m_LastFrameTime * 1000.0) : 0;
+}
+
+void FrameStacker::resize(uint32_t samples)
+{
+    clear();
+    m_Samples = samples;
+
+    // Only what the method needs, the first frame initializes every estimate
+    if (m_Method != Median)
+        m_Mean.resize(samples);
+    if (m_Method != Mean)
+    {
+        m_M2.resize(samples);
+        m_Extra.resize(samples);
+    }
+    if (m_Method == KappaSigma)
+        m_Suspect.resize(samples);
+}
+
+template <typename T>
+void FrameStacker::addFrame(const T *buffer, uint32_t samples)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    if (samples != m_Samples || m_Frames == 0)
+        resize(samples);
+
+    m_Frames++;
+    forEachSpan(samples, [&](uint32_t first, uint32_t count)
+    {
+        accumulate(buffer, first, count);
+    });
+
+    // The suspect samples were checked
+    if (m_Method == KappaSigma && m_Frames == KAPPA_SIGMA_RECHECK)
+        std::vector<float>().swap(m_Suspect);
+
+    m_LastFrameTime = timer.nsecsElapsed() / 1e6;
+}
+
+template <typename T>
+void FrameStacker::accumulate(const T *buffer, uint32_t first, uint32_t count)
+{
+    const T *x = buffer + first;
+    const float inverse = 1.0f / m_Frames;
+
+    switch (m_Method)
+    {
+        case Mean:
+        {
+            float *mean = m_Mean.data() + first;
+            for (uint32_t i = 0; i < count; i++)
+                mean[i] += (static_cast<float>(x[i]) - mean[i]) * inverse;
+        }
+        break;
+
+        case Median:
+        {
+            float *median = m_Extra.data() + first;
+            float *deviation = m_M2.data() + first;
+
+            // The first two frames are kept as they are, the third one seeds the estimate with the
+            // median of the three, and the deviation with the smaller gap around it.
+            if (m_Frames == 1)
+            {
+                for (uint32_t i = 0; i < count; i++)
+                    median[i] = static_cast<float>(x[i]);
+                break;
+            }
+            if (m_Frames == 2)
+            {
+                for (uint32_t i = 0; i < count; i++)
+                    deviation[i] = static_cast<float>(x[i]);
+                break;
+            }
+            if (m_Frames == 3)
+            {
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    const float a = median[i], b = deviation[i], c = static_cast<float>(x[i]);
+                    const float low = std::min(std::min(a, b), c);
+                    const float high = std::max(std::max(a, b), c);
+                    const float middle = a + b + c - low - high;
+                    median[i] = middle;
+                    deviation[i] = std::min(middle - low, high - middle);
+                }
+                break;
+            }
+
+            // Nudge the estimate towards the sample, by a step shrinking as frames are added.
+            // Integer samples are quantized, allow a deviation of one unit for pixels that never changed.
+            const float gain = MEDIAN_GAIN * inverse;
+            const float floor = std::is_integral<T>::value ? 1.0f : 0.0f;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                const float value = static_cast<float>(x[i]);
+                const float residual = std::min(std::fabs(value - median[i]), MEDIAN_CLIP * (deviation[i] + floor));
+                deviation[i] += (residual - deviation[i]) * inverse;
+                const float sign = static_cast<float>(value > median[i]) - static_cast<float>(value < median[i]);
+                median[i] += gain * deviation[i] * sign;
+            }
+        }
+        break;
+
+        case KappaSigma:
+        {
+            float *mean = m_Mean.data() + first;
+            float *m2 = m_M2.data() + first;
+            float *accepted = m_Extra.data() + first;
+            float *suspect = m_Suspect.empty() ? nullptr : m_Suspect.data() + first;
+
+            // As for the median, the first two frames are kept as they are. The third one seeds the estimates
+            // with the two samples closest to the median of the three, the farthest one is set aside until
+            // enough samples were accepted to trust their deviation, so that an outlier in the first frames
+            // neither shifts the mean nor loosens the rejection.
+            if (m_Frames == 1)
+            {
+                for (uint32_t i = 0; i < count; i++)
+                    mean[i] = static_cast<float>(x[i]);
+                break;
+            }
+            if (m_Frames == 2)
+            {
+                for (uint32_t i = 0; i < count; i++)
+                    m2[i] = static_cast<float>(x[i]);
+                break;
+            }
+            if (m_Frames == 3)
+            {
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    const float a = mean[i], b = m2[i], c = static_cast<float>(x[i]);
+                    const float low = std::min(std::min(a, b), c);
+                    const float high = std::max(std::max(a, b), c);
+                    const float middle = a + b + c - low - high;
+                    const bool highest = high - middle > middle - low;
+                    const float nearest = highest ? low : high;
+                    suspect[i] = highest ? high : low;
+                    mean[i] = 0.5f * (middle + nearest);
+                    m2[i] = 0.5f * (middle - nearest) * (middle - nearest);
+                    accepted[i] = 2;
+                }
+                break;
+            }
+
+            // Integer samples are quantized, allow a deviation of one unit for pixels that never changed
+            const float floor = std::is_integral<T>::value ? 1.0f : 0.0f;
+            const float kappa2 = m_Kappa * m_Kappa;
+            // Until it is checked, the suspect sample counts in the deviation the samples are checked against,
+            // which would otherwise collapse when the two seeds are close. An outlier set aside only loosens
+            // the rejection of these few frames.
+            if (m_Frames < KAPPA_SIGMA_RECHECK)
+            {
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    const float value = static_cast<float>(x[i]);
+                    const float n = accepted[i];
+                    const float aside = suspect[i] - mean[i];
+                    const float spread = m2[i] + aside * aside * n / (n + 1);
+                    const float delta = value - mean[i] - aside / (n + 1);
+                    foldSample(value, withinKappa(delta, n + 1, spread, kappa2, floor), mean[i], m2[i], accepted[i]);
+                }
+                break;
+            }
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                const float value = static_cast<float>(x[i]);
+                foldSample(value, withinKappa(value - mean[i], accepted[i], m2[i], kappa2, floor), mean[i], m2[i], accepted[i]);
+            }
+
+            // The deviation is now trusted, the suspect sample is kept unless it is an outlier
+            if (m_Frames == KAPPA_SIGMA_RECHECK)
+            {
+                for (uint32_t i = 0; i < count; i++)
+                    foldSample(suspect[i], withinKappa(suspect[i] - mean[i], accepted[i], m2[i], kappa2, floor), mean[i], m2[i],
+                               accepted[i]);
+            }
+        }
+        break;
+    }
+}
+
+template <typename T>
+bool FrameStacker::writeMaster(T *buffer) const
+{
+    if (m_Frames == 0)
+        return false;
+
+    const float *estimate = (m_Method == Median) ? m_Extra.data() : m_Mean.data();
+    // With two frames, the median is the average of the first frame and of the second one, kept aside.
+    // Kappa-sigma keeps them the same way.
+    const bool pair = (m_Method != Mean && m_Frames == 2);
+    const float *other = pair ? m_M2.data() : estimate;
+    const float weight = pair ? 0.5f : 1.0f;
+    // Until it is checked, the suspect sample of kappa-sigma is kept if it lies within kappa deviations
+    const bool suspect = (m_Method == KappaSigma && m_Frames >= 3 && m_Frames < KAPPA_SIGMA_RECHECK);
+    const float floor = std::is_integral<T>::value ? 1.0f : 0.0f;
+    const float kappa2 = m_Kappa * m_Kappa;
+    auto combined = [&](uint32_t i)
+    {
+        const float value = weight * estimate[i] + (1.0f - weight) * other[i];
+        if (!suspect)
+            return value;
+        const float n = m_Extra[i];
+        const float delta = m_Suspect[i] - value;
+        const float keep = withinKappa(delta, n, m_M2[i], kappa2, floor);
+        return value + keep * delta / (n + keep);
+    };
+    forEachSpan(m_Samples, [&](uint32_t first, uint32_t count)
+    {
+        T *destination = buffer + first;
+        if constexpr (std::is_integral<T>::value)
+        {
+            const double low = std::numeric_limits<T>::lowest();
+            const double high = std::numeric_limits<T>::max();
+            for (uint32_t i = 0; i < count; i++)
+                destination[i] = static_cast<T>(std::min(std::max(std::floor(combined(first + i) + 0.5), low), high));
+        }
+        else
+        {
+            for (uint32_t i = 0; i < count; i++)
+                destination[i] = static_cast<T>(combined(first + i));
+        }
+    });
+
+    return true;
+}
+
+template void FrameStacker::addFrame(const uint8_t *, uint32_t);
+template void FrameStacker::addFrame(const int16_t *, uint32_t);
+template void FrameStacker::addFrame(const uint16_t *, uint32_t);
+template void FrameStacker::addFrame(const int32_t *, uint32_t);
+template void FrameStacker::addFrame(const uint32_t *, uint32_t);
+template void FrameStacker::addFrame(const float *, uint32_t);
+template void FrameStacker::addFrame(const int64_t *, uint32_t);
+template void FrameStacker::addFrame(const double *, uint32_t);
+
+template bool FrameStacker::writeMaster(uint8_t *) const;
+template bool FrameStacker::writeMaster(int16_t *) const;
+template bool FrameStacker::writeMaster(uint16_t *) const;
+template bool FrameStacker::writeMaster(int32_t *) const;
+template bool FrameStacker::writeMaster(uint32_t *) const;
+template bool FrameStacker::writeMaster(float *) const;
+template bool FrameStacker::writeMaster(int64_t *) const;
+template bool FrameStacker::writeMaster(double *) const;
+
+}
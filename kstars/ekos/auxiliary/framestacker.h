@@ -0,0 +1,142 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Ekos
+{
+
+/**
+ * @class FrameStacker
+ * @short Combines calibration frames into a master frame as they are received.
+ *
+ * Frames are never retained: each one is folded into per-pixel running estimates, and the master
+ * frame is produced from those estimates once the last frame was added. Frames are processed in
+ * parallel spans of pixels, with branch-free loops the compiler vectorizes.
+ *
+ * Three combination methods are supported:
+ * - Mean: running average, one float per pixel.
+ * - Median: stochastic approximation of the median, seeded with the median of the first three
+ *   frames, then nudged towards each new sample by a step shrinking with the number of frames and
+ *   scaled by the running mean absolute deviation of the pixel. Residuals are clipped to a few
+ *   deviations, so outliers neither drag the estimate nor inflate the step. Two floats per pixel.
+ * - KappaSigma: running average of the samples lying within kappa standard deviations of the
+ *   running average of the samples accepted so far. The estimates are seeded with the two samples of
+ *   the first three frames closest to their median, and the third one is set aside until the eighth
+ *   frame, where it is kept unless it is an outlier. Until then, it counts in the deviation the new samples
+ *   are checked against. Three floats per pixel, and a fourth one until the eighth frame.
+ */
+class FrameStacker
+{
+    public:
+        typedef enum
+        {
+            Mean,
+            Median,
+            KappaSigma
+        } Method;
+
+        FrameStacker() = default;
+
+        /**
+         * @brief setMethod Select how frames are combined, and drop all the frames added so far.
+         * @param method combination method.
+         * @param kappa rejection threshold of KappaSigma, in standard deviations.
+         */
+        void setMethod(Method method, float kappa = 3.0f);
+
+        Method method() const
+        {
+            return m_Method;
+        }
+
+        /**
+         * @brief clear Drop all the frames added so far and release the per-pixel estimates.
+         */
+        void clear();
+
+        /**
+         * @brief addFrame Fold a frame into the running estimates. All frames must have the same number
+         * of samples, a frame of a different size restarts the stack.
+         * @param buffer frame samples, all channels.
+         * @param samples number of samples in buffer.
+         */
+        template <typename T> void addFrame(const T *buffer, uint32_t samples);
+
+        /**
+         * @brief writeMaster Write the master frame. Integer samples are rounded and clamped to the range of T.
+         * @param buffer destination, it must hold samples() elements.
+         * @return False if no frame was added.
+         */
+        template <typename T> bool writeMaster(T *buffer) const;
+
+        /** @return number of frames added since the stack was last cleared. */
+        uint32_t frames() const
+        {
+            return m_Frames;
+        }
+
+        /** @return number of samples of each frame. */
+        uint32_t samples() const
+        {
+            return m_Samples;
+        }
+
+        /** @return time taken to fold the last frame, in milliseconds. */
+        double lastFrameTime() const
+        {
+            return m_LastFrameTime;
+        }
+
+        /** @return throughput of the last frame, in millions of samples per second. */
+        double throughput() const;
+
+    private:
+        // Frame where KappaSigma checks the sample set aside from the first three frames
+        static constexpr uint32_t KAPPA_SIGMA_RECHECK = 8;
+
+        void resize(uint32_t samples);
+        template <typename T> void accumulate(const T *buffer, uint32_t first, uint32_t count);
+
+        Method m_Method { Mean };
+        float m_Kappa { 3.0f };
+        uint32_t m_Frames { 0 };
+        uint32_t m_Samples { 0 };
+        double m_LastFrameTime { 0 };
+
+        // Running average of the accepted samples
+        std::vector<float> m_Mean;
+        // Sum of squared deviations of the accepted samples for KappaSigma,
+        // mean absolute deviation (or the second frame, until the third one) for Median
+        std::vector<float> m_M2;
+        // Median estimate for Median, number of accepted samples for KappaSigma
+        std::vector<float> m_Extra;
+        // Sample of the first three frames farthest from their median, until KappaSigma checks it
+        std::vector<float> m_Suspect;
+};
+
+extern template void FrameStacker::addFrame(const uint8_t *, uint32_t);
+extern template void FrameStacker::addFrame(const int16_t *, uint32_t);
+extern template void FrameStacker::addFrame(const uint16_t *, uint32_t);
+extern template void FrameStacker::addFrame(const int32_t *, uint32_t);
+extern template void FrameStacker::addFrame(const uint32_t *, uint32_t);
+extern template void FrameStacker::addFrame(const float *, uint32_t);
+extern template void FrameStacker::addFrame(const int64_t *, uint32_t);
+extern template void FrameStacker::addFrame(const double *, uint32_t);
+
+extern template bool FrameStacker::writeMaster(uint8_t *) const;
+extern template bool FrameStacker::writeMaster(int16_t *) const;
+extern template bool FrameStacker::writeMaster(uint16_t *) const;
+extern template bool FrameStacker::writeMaster(int32_t *) const;
+extern template bool FrameStacker::writeMaster(uint32_t *) const;
+extern template bool FrameStacker::writeMaster(float *) const;
+extern template bool FrameStacker::writeMaster(int64_t *) const;
+extern template bool FrameStacker::writeMaster(double *) const;
+
+}
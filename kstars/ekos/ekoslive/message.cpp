@@ -13,6 +13,7 @@
 #include "indi/drivermanager.h"
 #include "indi/indilistener.h"
 #include "auxiliary/ksmessagebox.h"
+#include "auxiliary/observabilityengine.h"
 #include "ekos/auxiliary/filtermanager.h"
 #include "ekos/auxiliary/opticaltrainmanager.h"
 #include "ekos/auxiliary/profilesettings.h"
@@ -1699,11 +1700,42 @@ void Message::processAstronomyCommands(const QString &command, const QJsonObject
 
         QMutableVectorIterator<QPair<QString, const SkyObject *>> objectIterator(allObjects);
 
+        // Maximum Magnitude
+        if (!isDSO)
+        {
+            objectIterator.toFront();
+            while (objectIterator.hasNext())
+            {
+                auto magnitude = objectIterator.next().second->mag();
+                // Only filter for objects that have valid magnitude, otherwise, they're automatically included.
+                if (magnitude != NaN::f && magnitude > objectMaxMagnitude)
+                    objectIterator.remove();
+            }
+        }
+
+        // Direction and altitude are evaluated hourly until dawn, for all the objects at once.
+        QVector<ObservabilityEngine::Position> positions;
+        if (isDSO)
+        {
+            positions.reserve(static_cast<int>(dsoObjects.size()));
+            for (const auto &oneObject : dsoObjects)
+                positions.append(ObservabilityEngine::position(oneObject));
+        }
+        else
+        {
+            positions.reserve(allObjects.size());
+            for (const auto &oneObject : allObjects)
+                positions.append(ObservabilityEngine::position(*oneObject.second));
+        }
+
+        const ObservabilityEngine engine(geo, geo->LTtoUT(start), geo->LTtoUT(end), 3600);
+        const auto visibilities = engine.evaluate(positions, {objectMinAlt, 90});
+
         // Filter direction, if specified.
+        QPair<int, int> minAZ, maxAZ;
         if (objectDirection != All)
         {
             QPair<int, int> Quardent1(270, 360), Quardent2(0, 90), Quardent3(90, 180), Quardent4(180, 270);
-            QPair<int, int> minAZ, maxAZ;
             switch (objectDirection)
             {
                 case North:
@@ -1725,60 +1757,27 @@ void Message::processAstronomyCommands(const QString &command, const QJsonObject
                 default:
                     break;
             }
-
-            if (isDSO)
-            {
-                CatalogsDB::CatalogObjectList::iterator dsoIterator = dsoObjects.begin();
-                while (dsoIterator != dsoObjects.end())
-                {
-                    // If there a more efficient way to do this?
-                    const double az = (*dsoIterator).recomputeHorizontalCoords(start, geo).az().Degrees();
-                    if (! ((minAZ.first <= az && az <= minAZ.second) || (maxAZ.first <= az && az <= maxAZ.second)))
-                        dsoIterator = dsoObjects.erase(dsoIterator);
-                    else
-                        ++dsoIterator;
-                }
-            }
-            else
-            {
-                while (objectIterator.hasNext())
-                {
-                    const auto az = objectIterator.next().second->recomputeHorizontalCoords(start, geo).az().Degrees();
-                    if (! ((minAZ.first <= az && az <= minAZ.second) || (maxAZ.first <= az && az <= maxAZ.second)))
-                        objectIterator.remove();
-                }
-            }
         }
 
-        // Maximum Magnitude
-        if (!isDSO)
+        // Objects must be in the requested direction now, and above the altitude long enough before dawn.
+        auto isObservable = [&](const ObservabilityEngine::Visibility & visibility)
         {
-            objectIterator.toFront();
-            while (objectIterator.hasNext())
+            if (objectDirection != All)
             {
-                auto magnitude = objectIterator.next().second->mag();
-                // Only filter for objects that have valid magnitude, otherwise, they're automatically included.
-                if (magnitude != NaN::f && magnitude > objectMaxMagnitude)
-                    objectIterator.remove();
+                const double az = visibility.startAzimuth;
+                if (! ((minAZ.first <= az && az <= minAZ.second) || (maxAZ.first <= az && az <= maxAZ.second)))
+                    return false;
             }
-        }
+            return visibility.samples * engine.stepSeconds() >= objectMinDuration;
+        };
 
-        // Altitude
+        int index = 0;
         if (isDSO)
         {
             CatalogsDB::CatalogObjectList::iterator dsoIterator = dsoObjects.begin();
             while (dsoIterator != dsoObjects.end())
             {
-                double duration = 0;
-                for (KStarsDateTime t = start; t < end; t = t.addSecs(3600.0))
-                {
-                    dms LST = geo->GSTtoLST(t.gst());
-                    (*dsoIterator).EquatorialToHorizontal(&LST, geo->lat());
-                    if ((*dsoIterator).alt().Degrees() >= objectMinAlt)
-                        duration += 3600;
-                }
-
-                if (duration < objectMinDuration)
+                if (!isObservable(visibilities[index++]))
                     dsoIterator = dsoObjects.erase(dsoIterator);
                 else
                     ++dsoIterator;
@@ -1789,18 +1788,8 @@ void Message::processAstronomyCommands(const QString &command, const QJsonObject
             objectIterator.toFront();
             while (objectIterator.hasNext())
             {
-                auto oneObject = objectIterator.next().second;
-                double duration = 0;
-
-                for (KStarsDateTime t = start; t < end; t = t.addSecs(3600.0))
-                {
-                    auto LST = geo->GSTtoLST(t.gst());
-                    const_cast<SkyObject *>(oneObject)->EquatorialToHorizontal(&LST, geo->lat());
-                    if (oneObject->alt().Degrees() >= objectMinAlt)
-                        duration += 3600;
-                }
-
-                if (duration < objectMinDuration)
+                objectIterator.next();
+                if (!isObservable(visibilities[index++]))
                     objectIterator.remove();
             }
         }
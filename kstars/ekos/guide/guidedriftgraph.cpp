@@ -6,6 +6,7 @@
 */
 
 #include "guidedriftgraph.h"
+#include "auxiliary/decimatedgraph.h"
 #include "klocalizedstring.h"
 #include "ksnotification.h"
 #include "kstarsdata.h"
@@ -85,14 +86,17 @@ GuideDriftGraph::GuideDriftGraph(QWidget *parent)
     legend->setFillOrder(QCPLegend::foColumnsFirst);
     axisRect()->insetLayout()->setInsetAlignment(0, Qt::AlignLeft | Qt::AlignBottom);
 
+    // The curves get a sample per guide frame over whole nights, they are drawn
+    // through a min/max pyramid. The highlighted points are plain graphs.
+
     // RA Curve
-    addGraph(xAxis, yAxis);
+    new DecimatedGraph(xAxis, yAxis);
     graph(GuideGraph::G_RA)->setPen(QPen(KStarsData::Instance()->colorScheme()->colorNamed("RAGuideError")));
     graph(GuideGraph::G_RA)->setName("RA");
     graph(GuideGraph::G_RA)->setLineStyle(QCPGraph::lsLine);
 
     // DE Curve
-    addGraph(xAxis, yAxis);
+    new DecimatedGraph(xAxis, yAxis);
     graph(GuideGraph::G_DEC)->setPen(QPen(KStarsData::Instance()->colorScheme()->colorNamed("DEGuideError")));
     graph(GuideGraph::G_DEC)->setName("DE");
     graph(GuideGraph::G_DEC)->setLineStyle(QCPGraph::lsLine);
@@ -112,7 +116,7 @@ GuideDriftGraph::GuideDriftGraph(QWidget *parent)
             QPen(KStarsData::Instance()->colorScheme()->colorNamed("DEGuideError"), 2), QBrush(), 10));
 
     // RA Pulse
-    addGraph(xAxis, yAxis2);
+    new DecimatedGraph(xAxis, yAxis2);
     QColor raPulseColor(KStarsData::Instance()->colorScheme()->colorNamed("RAGuideError"));
     raPulseColor.setAlpha(75);
     graph(GuideGraph::G_RA_PULSE)->setPen(QPen(raPulseColor));
@@ -121,7 +125,7 @@ GuideDriftGraph::GuideDriftGraph(QWidget *parent)
     graph(GuideGraph::G_RA_PULSE)->setLineStyle(QCPGraph::lsStepLeft);
 
     // DEC Pulse
-    addGraph(xAxis, yAxis2);
+    new DecimatedGraph(xAxis, yAxis2);
     QColor dePulseColor(KStarsData::Instance()->colorScheme()->colorNamed("DEGuideError"));
     dePulseColor.setAlpha(75);
     graph(GuideGraph::G_DEC_PULSE)->setPen(QPen(dePulseColor));
@@ -130,25 +134,25 @@ GuideDriftGraph::GuideDriftGraph(QWidget *parent)
     graph(GuideGraph::G_DEC_PULSE)->setLineStyle(QCPGraph::lsStepLeft);
 
     // SNR
-    addGraph(xAxis, snrAxis);
+    new DecimatedGraph(xAxis, snrAxis);
     graph(GuideGraph::G_SNR)->setPen(QPen(Qt::yellow));
     graph(GuideGraph::G_SNR)->setName("SNR");
     graph(GuideGraph::G_SNR)->setLineStyle(QCPGraph::lsLine);
 
     // RA RMS
-    addGraph(xAxis, yAxis);
+    new DecimatedGraph(xAxis, yAxis);
     graph(GuideGraph::G_RA_RMS)->setPen(QPen(Qt::red));
     graph(GuideGraph::G_RA_RMS)->setName("RA RMS");
     graph(GuideGraph::G_RA_RMS)->setLineStyle(QCPGraph::lsLine);
 
     // DEC RMS
-    addGraph(xAxis, yAxis);
+    new DecimatedGraph(xAxis, yAxis);
     graph(GuideGraph::G_DEC_RMS)->setPen(QPen(Qt::red));
     graph(GuideGraph::G_DEC_RMS)->setName("DEC RMS");
     graph(GuideGraph::G_DEC_RMS)->setLineStyle(QCPGraph::lsLine);
 
     // Total RMS
-    addGraph(xAxis, yAxis);
+    new DecimatedGraph(xAxis, yAxis);
     graph(GuideGraph::G_RMS)->setPen(QPen(Qt::red));
     graph(GuideGraph::G_RMS)->setName("RMS");
     graph(GuideGraph::G_RMS)->setLineStyle(QCPGraph::lsLine);
@@ -568,13 +572,9 @@ void GuideDriftGraph::setSNR(double snr)
     graph(GuideGraph::G_SNR)->addData(key, snr);
 
     // Sets the SNR axis to have the maximum be 95% of the way up from the middle to the top.
-    QCPGraphData snrMax = *std::min_element(graph(GuideGraph::G_SNR)->data()->begin(),
-                                            graph(GuideGraph::G_SNR)->data()->end(),
-                                            [](QCPGraphData const & s1, QCPGraphData const & s2)
-    {
-        return s1.value > s2.value;
-    });
-    snrAxis->setRange(-1.05 * snrMax.value, 1.05 * snrMax.value);
+    if (graph(GuideGraph::G_SNR)->dataCount() == 1 || snr > snrMax)
+        snrMax = snr;
+    snrAxis->setRange(-1.05 * snrMax, 1.05 * snrMax);
 }
 
 void GuideDriftGraph::updateCorrectionsScaleVisibility()
@@ -68,6 +68,8 @@ private:
 
     // Axis for the SNR part of the driftGraph. Qt owns this pointer's memory.
     QCPAxis *snrAxis;
+    // Highest SNR plotted since the graph was last cleared.
+    double snrMax {0};
 
     // Guide timer
     QTime guideTimer;
@@ -17,6 +17,7 @@
 #include "ekos/auxiliary/stellarsolverprofileeditor.h"
 #include "guidealgorithms.h"
 
+#include <QElapsedTimer>
 #include <QVector3D>
 #include <cmath>
 #include <set>
@@ -34,6 +35,8 @@ GuiderUtils::Vector cgmath::findLocalStarPosition(QSharedPointer<FITSData> &imag
         position = guideStars.findGuideStar(imageData, trackingBox, guideView, firstFrame);
 
     }
+    else if (algorithm == PHASE_CORRELATION)
+        position = findCorrelatedPosition(imageData, guideView->getTrackingBox(), firstFrame);
     else
         position = GuideAlgorithms::findLocalStarPosition(
                        imageData, algorithm, video_width, video_height,
@@ -44,6 +47,27 @@ GuiderUtils::Vector cgmath::findLocalStarPosition(QSharedPointer<FITSData> &imag
     return position;
 }
 
+GuiderUtils::Vector cgmath::findCorrelatedPosition(QSharedPointer<FITSData> &imageData, const QRect &trackingBox,
+        bool firstFrame)
+{
+    phaseCorrelation.setDownsample(Options::guideCorrelationDownsample());
+
+    if (firstFrame)
+        phaseCorrelation.clearReference();
+
+    // The whole frame is correlated when the target is extended, or there is no star to box.
+    // Otherwise the reference follows the tracking box, which follows the positions found.
+    const QRect region = Options::guideCorrelationFullFrame() ? QRect() : trackingBox;
+    double x = 0, y = 0;
+    if (!phaseCorrelation.track(imageData, region, &x, &y))
+    {
+        qCDebug(KSTARS_EKOS_GUIDE) << "Phase correlation: region" << region << "is too small or out of the frame.";
+        return GuiderUtils::Vector(-1, -1, -1);
+    }
+
+    return GuiderUtils::Vector(x, y, 0);
+}
+
 
 cgmath::cgmath() : QObject()
 {
@@ -170,9 +194,11 @@ bool cgmath::reset()
 
 void cgmath::setAlgorithmIndex(int algorithmIndex)
 {
-    if (algorithmIndex < 0 || algorithmIndex > SEP_MULTISTAR)
+    if (algorithmIndex < 0 || algorithmIndex > PHASE_CORRELATION)
         return;
 
+    if (algorithmIndex != algorithm)
+        phaseCorrelation.clearReference();
     algorithm = algorithmIndex;
 }
 
@@ -213,6 +239,12 @@ void cgmath::start()
 void cgmath::abort()
 {
     guideStars.reset();
+    phaseCorrelation.clearReference();
+}
+
+void cgmath::clearCorrelationReference()
+{
+    phaseCorrelation.clearReference();
 }
 
 void cgmath::suspend(bool mode)
@@ -457,8 +489,12 @@ void cgmath::performProcessing(Ekos::GuideState state, QSharedPointer<FITSData>
 
     GuiderUtils::Vector starPositionArcSec, targetPositionArcSec;
 
-    // find guiding star location in the image
+    // find guiding star location in the image, timing it for the guide log
+    QElapsedTimer detectionTimer;
+    detectionTimer.start();
     starPosition = findLocalStarPosition(imageData, guideView, false);
+    if (logger != nullptr && state == Ekos::GUIDE_GUIDING)
+        logger->detectionTimeInfo(detectionTimer.nsecsElapsed() / 1e6);
 
     // If no star found, mark as lost star.
     if (starPosition.x == -1 || std::isnan(starPosition.x))
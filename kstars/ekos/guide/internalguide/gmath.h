@@ -24,6 +24,7 @@
 #include "starcorrespondence.h"
 #include "fitsviewer/fitssepdetector.h"
 #include "guidestars.h"
+#include "phasecorrelation.h"
 #include "calibration.h"
 
 #include "gpg.h"
@@ -38,6 +39,7 @@ class Edge;
 #define AUTO_THRESHOLD     3
 #define NO_THRESHOLD       4
 #define SEP_MULTISTAR      5
+#define PHASE_CORRELATION  6
 
 #define GUIDE_RA    0
 #define GUIDE_DEC   1
@@ -113,6 +115,8 @@ class cgmath : public QObject
         bool reset();
         // Currently only relevant to SEP MultiStar.
         void abort();
+        // The phase correlation takes a new reference on the next frame.
+        void clearCorrelationReference();
         void suspend(bool mode);
         bool isSuspended() const;
 
@@ -165,6 +169,9 @@ class cgmath : public QObject
         // Templated functions
         template <typename T>
         GuiderUtils::Vector findLocalStarPosition(void) const;
+        // Follows the image content by phase correlation with a reference frame, see PhaseCorrelation
+        GuiderUtils::Vector findCorrelatedPosition(QSharedPointer<FITSData> &imageData, const QRect &trackingBox,
+                bool firstFrame);
 
         void updateCircularBuffers(void);
         GuiderUtils::Vector point2arcsec(const GuiderUtils::Vector &p) const;
@@ -217,6 +224,8 @@ class cgmath : public QObject
 
         GuideStars guideStars;
 
+        PhaseCorrelation phaseCorrelation;
+
         std::unique_ptr<GPG> gpg;
         Calibration calibration;
         bool configureInParams(Ekos::GuideState state);
@@ -22,6 +22,7 @@
 #define AUTO_THRESHOLD     3
 #define NO_THRESHOLD       4
 #define SEP_MULTISTAR      5
+#define PHASE_CORRELATION  6
 
 // smart threshold algorithm param
 // width of outer frame for background calculation
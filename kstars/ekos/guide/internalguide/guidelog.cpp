@@ -319,3 +319,11 @@ void GuideLog::settleCompletedInfo()
 {
     appendToLog("INFO: SETTLING STATE CHANGE, Settling complete\n");
 }
+
+// Kept out of the frame lines, whose columns are those of PHD2.
+void GuideLog::detectionTimeInfo(double milliseconds)
+{
+    appendToLog(QString("INFO: Frame %1 star detection time = %2 ms\n")
+                .arg(guideIndex)
+                .arg(QString::number(milliseconds, 'f', 3)));
+}
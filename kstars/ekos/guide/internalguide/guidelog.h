@@ -87,6 +87,8 @@ class GuideLog
         void resumeInfo();
         void settleStartedInfo();
         void settleCompletedInfo();
+        // Time spent finding the guide star in the next frame.
+        void detectionTimeInfo(double milliseconds);
 
         // Deal with suspend, resume, dither, ...
     private:
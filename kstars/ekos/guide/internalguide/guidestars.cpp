@@ -25,6 +25,12 @@
 // It will instead back-off to a reticle-based algorithm.
 #define MIN_STAR_CORRESPONDENCE_SIZE 5
 
+// Windowed detection looks for each reference star this many pixels around its expected position,
+// enough for the star to move by the max association distance and still be measured whole.
+constexpr int WINDOW_RADIUS = 24;
+// Windows cut by the edges of the frame below this size are not searched.
+constexpr int MIN_WINDOW_SIZE = 8;
+
 // We limit the HFR for guide stars. When searching for the guide star, we relax this by the
 // margin below (e.g. if a guide star was selected that was near the max guide-star hfr, the later
 // the hfr increased a little, we still want to be able to find it.
@@ -87,6 +93,10 @@ GuideStars::GuideStars()
 {
 }
 
+GuideStars::~GuideStars()
+{
+}
+
 // It's possible that we don't map all the stars, if there are too many.
 int GuideStars::getStarMap(int index)
 {
@@ -233,6 +243,7 @@ QVector3D GuideStars::selectGuideStar(const QList<Edge> &stars,
     }
     setupStarCorrespondence(guideStarNeighbors, maxScoreIndex);
     QVector3D newStarCenter(stars[maxScoreIndex].x, stars[maxScoreIndex].y, 0);
+    m_LastGuideStar = GuiderUtils::Vector(newStarCenter.x(), newStarCenter.y(), 0);
     qCDebug(KSTARS_EKOS_GUIDE) << "new star center: " << maxScoreIndex << " x: "
                                << stars[maxScoreIndex].x << " y: " << stars[maxScoreIndex].y;
     return newStarCenter;
@@ -314,10 +325,19 @@ GuiderUtils::Vector GuideStars::findGuideStar(const QSharedPointer<FITSData> &im
     const double maxHFR = Options::guideMaxHFR() + HFR_MARGIN;
     if (starCorrespondence.size() > 0)
     {
-
-        findTopStars(imageData, STARS_TO_SEARCH, &detectedStars, maxHFR);
+        // Between full detections, stars may only be detected around the reference stars.
+        const bool windowed = Options::guideWindowedDetection() && !firstFrame &&
+                              m_FramesSinceFullDetection + 1 < static_cast<int>(Options::guideFullDetectionInterval()) &&
+                              findWindowedStars(imageData, &detectedStars, maxHFR);
+        if (windowed)
+            m_FramesSinceFullDetection++;
+        else
+            findTopStars(imageData, STARS_TO_SEARCH, &detectedStars, maxHFR);
         if (detectedStars.empty())
+        {
+            m_LastGuideStar = GuiderUtils::Vector(-1);
             return GuiderUtils::Vector(-1, -1, -1);
+        }
 
         // Allow it to guide even if the main guide star isn't detected (as long as enough reference stars are).
         starCorrespondence.setAllowMissingGuideStar(allowMissingGuideStar);
@@ -333,22 +353,41 @@ GuiderUtils::Vector GuideStars::findGuideStar(const QSharedPointer<FITSData> &im
 
         Edge foundStar = starCorrespondence.find(detectedStars, maxStarAssociationDistance, &starMap, true, minFraction);
 
-        // Is there a correspondence to the guide star
-        // Should we also weight distance to the tracking box?
-        for (int i = 0; i < detectedStars.size(); ++i)
+        // Returns the index of the detected star that matched the guide star, -1 if none did.
+        auto guideStarIndex = [&]()
         {
-            if (getStarMap(i) == starCorrespondence.guideStar())
+            for (int i = 0; i < detectedStars.size(); ++i)
             {
-                auto &star = detectedStars[i];
-                double SNR = skyBackground.SNR(star.sum, star.numPixels);
-                guideStarSNR = SNR;
-                guideStarMass = star.sum;
-                unreliableDectionCounter = 0;
-                qCDebug(KSTARS_EKOS_GUIDE) << "StarCorrespondence found " << i << "at" << star.x << star.y << "SNR" << SNR;
-                if (guideView != nullptr)
-                    plotStars(guideView, trackingBox);
-                return GuiderUtils::Vector(star.x, star.y, 0);
+                if (getStarMap(i) == starCorrespondence.guideStar())
+                    return i;
             }
+            return -1;
+        };
+
+        // The windows may have missed the guide star, e.g. after a large move of the mount.
+        int index = guideStarIndex();
+        if (windowed && index < 0 && (foundStar.x < 0 || foundStar.y < 0))
+        {
+            qCDebug(KSTARS_EKOS_GUIDE) << "Multistar: the guide star was lost in the windows, detecting stars in the whole frame";
+            findTopStars(imageData, STARS_TO_SEARCH, &detectedStars, maxHFR);
+            foundStar = starCorrespondence.find(detectedStars, maxStarAssociationDistance, &starMap, true, minFraction);
+            index = guideStarIndex();
+        }
+
+        // Is there a correspondence to the guide star
+        // Should we also weight distance to the tracking box?
+        if (index >= 0)
+        {
+            auto &star = detectedStars[index];
+            double SNR = skyBackground.SNR(star.sum, star.numPixels);
+            guideStarSNR = SNR;
+            guideStarMass = star.sum;
+            unreliableDectionCounter = 0;
+            m_LastGuideStar = GuiderUtils::Vector(star.x, star.y, 0);
+            qCDebug(KSTARS_EKOS_GUIDE) << "StarCorrespondence found " << index << "at" << star.x << star.y << "SNR" << SNR;
+            if (guideView != nullptr)
+                plotStars(guideView, trackingBox);
+            return GuiderUtils::Vector(star.x, star.y, 0);
         }
         // None of the stars matched the guide star, but it's possible star correspondence
         // invented a guide star position.
@@ -357,6 +396,7 @@ GuiderUtils::Vector GuideStars::findGuideStar(const QSharedPointer<FITSData> &im
             guideStarSNR = skyBackground.SNR(foundStar.sum, foundStar.numPixels);
             guideStarMass = foundStar.sum;
             unreliableDectionCounter = 0;  // debating this
+            m_LastGuideStar = GuiderUtils::Vector(foundStar.x, foundStar.y, 0);
             qCDebug(KSTARS_EKOS_GUIDE) << "StarCorrespondence invented at" << foundStar.x << foundStar.y << "SNR" << guideStarSNR;
             if (guideView != nullptr)
                 plotStars(guideView, trackingBox);
@@ -364,6 +404,9 @@ GuiderUtils::Vector GuideStars::findGuideStar(const QSharedPointer<FITSData> &im
         }
     }
 
+    // Without a guide star position, the next frame is searched whole.
+    m_LastGuideStar = GuiderUtils::Vector(-1);
+
     qCDebug(KSTARS_EKOS_GUIDE) << "StarCorrespondence not used. It failed to find the guide star.";
 
     if (++unreliableDectionCounter > MAX_CONSECUTIVE_UNRELIABLE)
@@ -503,6 +546,7 @@ void GuideStars::findTopStars(const QSharedPointer<FITSData> &imageData, int num
 
     QElapsedTimer timer;
     timer.restart();
+    m_FramesSinceFullDetection = 0;
     QList<Edge*> sepStars;
     int count = findAllSEPStars(imageData, &sepStars, num * 2);
     if (count == 0)
@@ -511,6 +555,16 @@ void GuideStars::findTopStars(const QSharedPointer<FITSData> &imageData, int num
     if (sepStars.empty())
         return;
 
+    selectTopStars(sepStars, num, stars, maxHFR, roi, outputScores, minDistances);
+    qCDebug(KSTARS_EKOS_GUIDE)
+            << QString("Multistar: findTopStars returning: %1 stars, %2s")
+            .arg(stars->size()).arg(timer.elapsed() / 1000.0, 4, 'f', 2);
+}
+
+void GuideStars::selectTopStars(const QList<Edge *> &sepStars, int num, QList<Edge> *stars,
+                                const double maxHFR, const QRect *roi,
+                                QList<double> *outputScores, QList<double> *minDistances)
+{
     QVector<double> scores;
     evaluateSEPStars(sepStars, &scores, roi, maxHFR);
     // Sort the sepStars by score, higher score to lower score.
@@ -535,9 +589,96 @@ void GuideStars::findTopStars(const QSharedPointer<FITSData> &imageData, int num
                 minDistances->append(findMinDistance(starIndex, sepStars));
         }
     }
+}
+
+// Detects stars in windows around the positions where the reference stars are expected, given
+// where the guide star was in the previous frame. The sky background of the last full detection
+// is kept for the scores and SNRs. Returns false when the windows found too few stars to be trusted.
+bool GuideStars::findWindowedStars(const QSharedPointer<FITSData> &imageData, QList<Edge> *stars, const double maxHFR)
+{
+    stars->clear();
+    if (m_LastGuideStar.x < 0 || m_LastGuideStar.y < 0)
+        return false;
+
+    QElapsedTimer timer;
+    timer.restart();
+
+    // Windows that overlap are merged, so that no star is detected twice.
+    const QRect frame(0, 0, imageData->width(), imageData->height());
+    QVector<QRect> windows;
+    for (int i = 0; i < starCorrespondence.size(); ++i)
+    {
+        const QVector2D offset = starCorrespondence.offset(i);
+        QRect window(static_cast<int>(m_LastGuideStar.x + offset.x()) - WINDOW_RADIUS,
+                     static_cast<int>(m_LastGuideStar.y + offset.y()) - WINDOW_RADIUS,
+                     2 * WINDOW_RADIUS + 1, 2 * WINDOW_RADIUS + 1);
+        window &= frame;
+        if (window.width() < MIN_WINDOW_SIZE || window.height() < MIN_WINDOW_SIZE)
+            continue;
+        for (int j = 0; j < windows.size();)
+        {
+            if (windows[j].intersects(window))
+            {
+                window |= windows[j];
+                windows.remove(j);
+                j = 0;
+            }
+            else
+                ++j;
+        }
+        windows.append(window);
+    }
+    if (windows.empty())
+        return false;
+
+    if (m_WindowSolver == nullptr)
+    {
+        m_WindowSolver.reset(new StellarSolver());
+        m_WindowSolver->setLogLevel(SSolver::LOG_NONE);
+        m_WindowSolver->setSSLogLevel(SSolver::LOG_OFF);
+    }
+    // The windows are too small to be worth partitioning.
+    SSolver::Parameters params = FITSSEPDetector::getParameters(Ekos::GuideProfiles, Options::guideOptionsProfile());
+    params.partition = false;
+    m_WindowSolver->setParameters(params);
+    m_WindowSolver->loadNewImageBuffer(imageData->getStatistics(), imageData->getImageBuffer());
+
+    QVector<Edge> windowStars;
+    for (const auto &window : windows)
+    {
+        m_WindowSolver->extract(true, window);
+        for (const auto &star : m_WindowSolver->getStarList())
+        {
+            Edge edge;
+            edge.x = star.x;
+            edge.y = star.y;
+            edge.val = star.peak;
+            edge.sum = star.flux;
+            edge.HFR = star.HFR;
+            edge.width = star.a;
+            edge.numPixels = star.numPixels;
+            edge.ellipticity = star.a > 0 ? 1 - star.b / star.a : 0;
+            windowStars.append(edge);
+        }
+    }
+    m_NumStarsDetected = windowStars.size();
+
+    // Too many reference stars were lost for star correspondence to succeed.
+    if (windowStars.size() < std::max(MIN_STAR_CORRESPONDENCE_SIZE, starCorrespondence.size() / 2))
+    {
+        qCDebug(KSTARS_EKOS_GUIDE) << "Multistar: only" << windowStars.size() << "stars found in" << windows.size()
+                                   << "windows, detecting stars in the whole frame";
+        return false;
+    }
+
+    QList<Edge *> sepStars;
+    for (auto &star : windowStars)
+        sepStars.append(&star);
+    selectTopStars(sepStars, STARS_TO_SEARCH, stars, maxHFR, nullptr, nullptr, nullptr);
     qCDebug(KSTARS_EKOS_GUIDE)
-            << QString("Multistar: findTopStars returning: %1 stars, %2s")
-            .arg(stars->size()).arg(timer.elapsed() / 1000.0, 4, 'f', 2);
+            << QString("Multistar: findWindowedStars returning: %1 stars from %2 windows, %3s")
+            .arg(stars->size()).arg(windows.size()).arg(timer.elapsed() / 1000.0, 4, 'f', 2);
+    return !stars->empty();
 }
 
 // Scores star detection relative to each other. Uses the star's SNR as the main measure.
@@ -17,6 +17,10 @@
 #include "../guideview.h"
 #include "calibration.h"
 
+#include <memory>
+
+class StellarSolver;
+
 namespace SSolver
 {
 class Parameters;
@@ -42,13 +46,18 @@ class Parameters;
  * Returns the star movement in RA and DEC. The reticle can be input indicating
  * that the desired position for the original guide star and reference stars has
  * shifted (e.g. dithering).
+ *
+ * With windowed detection enabled, findGuideStar() only detects stars in small windows
+ * around the positions where the reference stars are expected, given the guide star position
+ * in the previous frame. Stars are detected in the whole frame every few frames, and whenever
+ * the windows lose too many reference stars or the guide star.
  */
 
 class GuideStars
 {
     public:
         GuideStars();
-        ~GuideStars() {}
+        ~GuideStars();
 
         // Select a guide star, given the image.
         // Performs a SEP processing to detect stars, then finds the
@@ -103,6 +112,7 @@ class GuideStars
         void reset()
         {
             starCorrespondence.reset();
+            m_LastGuideStar = GuiderUtils::Vector(-1);
         }
 
     private:
@@ -123,8 +133,15 @@ class GuideStars
                           const QRect *roi = nullptr,
                           QList<double> *outputScores = nullptr,
                           QList<double> *minDistances = nullptr);
+        // Copies the top num of sepStars according to the evaluateSEPStars criteria.
+        void selectTopStars(const QList<Edge *> &sepStars, int num, QList<Edge> *stars,
+                            const double maxHFR, const QRect *roi,
+                            QList<double> *outputScores, QList<double> *minDistances);
         // The interface to the SEP star detection algoritms.
         int findAllSEPStars(const QSharedPointer<FITSData> &imageData, QList<Edge*> *sepStars, int num);
+        // Detects stars only in windows around the expected positions of the reference stars.
+        // Returns false if the stars need to be detected in the whole frame instead.
+        bool findWindowedStars(const QSharedPointer<FITSData> &imageData, QList<Edge> *stars, const double maxHFR);
 
         // Convert from input image coordinates to output RA and DEC coordinates.
         GuiderUtils::Vector point2arcsec(const GuiderUtils::Vector &p) const;
@@ -187,5 +204,12 @@ class GuideStars
 
         int m_NumStarsDetected { 0 };
 
+        // Windowed detection reuses its solver from frame to frame, and counts the frames
+        // since stars were last detected in the whole frame.
+        std::unique_ptr<StellarSolver> m_WindowSolver;
+        int m_FramesSinceFullDetection { 0 };
+        // Position of the guide star in the previous frame, invalid if it was not found.
+        GuiderUtils::Vector m_LastGuideStar { -1 };
+
         friend class TestGuideStars;
 };
@@ -548,6 +548,7 @@ bool InternalGuider::calibrate()
         calibrationProcess.reset(
             new CalibrationProcess(calibrationStartX, calibrationStartY,
                                    !Options::twoAxisEnabled()));
+        pmath->clearCorrelationReference();
         state = GUIDE_CALIBRATING;
         emit newStatus(GUIDE_CALIBRATING);
     }
@@ -605,7 +606,7 @@ void InternalGuider::iterateCalibration()
         QString info = "";
         if (pmath->usingSEPMultiStar())
         {
-            auto gs = pmath->getGuideStars();
+            const auto &gs = pmath->getGuideStars();
             info = QString("%1 stars, %2/%3 refs")
                    .arg(gs.getNumStarsDetected())
                    .arg(gs.getNumReferencesFound())
@@ -660,6 +661,7 @@ void InternalGuider::iterateCalibration()
                               i18n("Guiding calibration completed successfully"), KSNotification::Guide);
         emit DESwapChanged(pmath->getCalibration().declinationSwapEnabled());
         pmath->setTargetPosition(calibrationStartX, calibrationStartY);
+        pmath->clearCorrelationReference();
         reset();
     }
 }
@@ -749,6 +751,8 @@ void InternalGuider::setSquareAlgorithm(int index)
 {
     if (index == SEP_MULTISTAR && !pmath->usingSEPMultiStar())
         m_isFirstFrame = true;
+    if (index == PHASE_CORRELATION && pmath->getAlgorithmIndex() != PHASE_CORRELATION)
+        m_isFirstFrame = true;
     pmath->setAlgorithmIndex(index);
 }
 
@@ -838,7 +842,7 @@ bool InternalGuider::processGuiding()
         if (pmath->usingSEPMultiStar())
         {
             QString info = "";
-            auto gs = pmath->getGuideStars();
+            const auto &gs = pmath->getGuideStars();
             info = QString("%1 stars, %2/%3 refs")
                    .arg(gs.getNumStarsDetected())
                    .arg(gs.getNumReferencesFound())
@@ -0,0 +1,534 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "phasecorrelation.h"
+
+#include "fitsviewer/fitsdata.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// Smallest width or height of the transformed region, after downsampling
+constexpr int MIN_SIZE = 8;
+// Largest downsampling factor
+constexpr int MAX_DOWNSAMPLE = 16;
+// Damping of the cross-power spectrum relative to its mean magnitude, and its smallest value for blank frames
+constexpr float DAMPING = 16.0f;
+constexpr float MIN_POWER = 1e-20f;
+
+// Largest size up to n made of factors 2, 3 and 5 only
+int smoothSize(int n)
+{
+    for (; n > 1; n--)
+    {
+        int m = n;
+        for (const int p : {2, 3, 5})
+        {
+            while (m % p == 0)
+                m /= p;
+        }
+        if (m == 1)
+            return n;
+    }
+    return n;
+}
+
+// Symmetric Hann window, which keeps the edges of the region from correlating
+void hannWindow(QVector<float> &window, int size)
+{
+    window.resize(size);
+    for (int i = 0; i < size; i++)
+        window[i] = 0.5f - 0.5f * std::cos(2 * M_PI * (i + 0.5) / size);
+}
+
+// Complex product without the checks for infinities std::complex does
+inline std::complex<float> multiply(const std::complex<float> &a, const std::complex<float> &b)
+{
+    return std::complex<float>(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+}
+
+inline float magnitude(const std::complex<float> &a)
+{
+    return std::sqrt(a.real() * a.real() + a.imag() * a.imag());
+}
+
+// Offset of the top of a parabola through three values around a peak, in [-0.5, 0.5]
+double peakOffset(float before, float peak, float after)
+{
+    const double curvature = before - 2.0 * peak + after;
+    if (curvature >= 0)
+        return 0;
+    return std::max(-0.5, std::min(0.5, 0.5 * (before - after) / curvature));
+}
+}
+
+void PhaseCorrelation::setDownsample(int factor)
+{
+    factor = std::max(1, std::min(MAX_DOWNSAMPLE, factor));
+    if (factor == m_Downsample)
+        return;
+
+    m_Downsample = factor;
+    clearReference();
+}
+
+bool PhaseCorrelation::setReference(const QSharedPointer<FITSData> &imageData, const QRect &region)
+{
+    clearReference();
+    if (imageData.isNull())
+        return false;
+
+    const int width = imageData->width(), height = imageData->height();
+    return dispatch(imageData, [&](auto image)
+    {
+        return takeReference(image, width, height, region);
+    });
+}
+
+bool PhaseCorrelation::setReference(const float *image, int width, int height, const QRect &region)
+{
+    clearReference();
+    return takeReference(image, width, height, region);
+}
+
+template <typename T>
+bool PhaseCorrelation::takeReference(const T *image, int width, int height, const QRect &region)
+{
+    m_HasReference = setRegion(width, height, region) && load(image, width, height, 0, 0, 0, 0);
+    if (!m_HasReference)
+        return false;
+
+    std::copy(m_Spectrum.cbegin(), m_Spectrum.cend(), m_Reference.begin());
+    m_TrackedRegion = region;
+    m_OriginX = m_Region.x() + m_Region.width() / 2.0;
+    m_OriginY = m_Region.y() + m_Region.height() / 2.0;
+    return true;
+}
+
+void PhaseCorrelation::clearReference()
+{
+    m_HasReference = false;
+    m_Region = QRect();
+    m_TrackedRegion = QRect();
+}
+
+bool PhaseCorrelation::track(const QSharedPointer<FITSData> &imageData, const QRect &region, double *x, double *y)
+{
+    if (imageData.isNull())
+        return false;
+
+    const int width = imageData->width(), height = imageData->height();
+    return dispatch(imageData, [&](auto image)
+    {
+        return follow(image, width, height, region, x, y);
+    });
+}
+
+bool PhaseCorrelation::track(const float *image, int width, int height, const QRect &region, double *x, double *y)
+{
+    return follow(image, width, height, region, x, y);
+}
+
+template <typename T>
+bool PhaseCorrelation::follow(const T *image, int width, int height, const QRect &region, double *x, double *y)
+{
+    if (!m_HasReference)
+    {
+        if (!takeReference(image, width, height, region))
+            return false;
+        *x = m_OriginX;
+        *y = m_OriginY;
+        return true;
+    }
+
+    // The frame is read around the center of the region, the reference staying where it was taken
+    int offsetX = 0, offsetY = 0;
+    if (!region.isNull() && !m_TrackedRegion.isNull())
+    {
+        offsetX = std::lround(region.x() - m_TrackedRegion.x() + (region.width() - m_TrackedRegion.width()) / 2.0);
+        offsetY = std::lround(region.y() - m_TrackedRegion.y() + (region.height() - m_TrackedRegion.height()) / 2.0);
+    }
+
+    double dx = 0, dy = 0;
+    if (!measure(image, width, height, offsetX, offsetY, &dx, &dy))
+        return false;
+    *x = m_OriginX + dx;
+    *y = m_OriginY + dy;
+
+    if (region.size() != m_TrackedRegion.size())
+    {
+        if (takeReference(image, width, height, region))
+        {
+            m_OriginX = *x;
+            m_OriginY = *y;
+        }
+        else
+            clearReference();
+    }
+    return true;
+}
+
+bool PhaseCorrelation::findShift(const QSharedPointer<FITSData> &imageData, double *dx, double *dy)
+{
+    if (!m_HasReference || imageData.isNull())
+        return false;
+
+    const int width = imageData->width(), height = imageData->height();
+    return dispatch(imageData, [&](auto image)
+    {
+        return measure(image, width, height, 0, 0, dx, dy);
+    });
+}
+
+bool PhaseCorrelation::findShift(const float *image, int width, int height, double *dx, double *dy)
+{
+    return m_HasReference && measure(image, width, height, 0, 0, dx, dy);
+}
+
+template <typename T>
+bool PhaseCorrelation::measure(const T *image, int width, int height, int offsetX, int offsetY, double *dx,
+                               double *dy)
+{
+    if (!load(image, width, height, offsetX, offsetY, 0, 0) || !correlate(dx, dy))
+        return false;
+
+    // The window weighs both images alike, which pulls the shift of smooth content towards zero.
+    // The frame is weighed again by the window moved along with its content, and correlated again.
+    const int columns = std::lround(*dx / m_Downsample), rows = std::lround(*dy / m_Downsample);
+    double x, y;
+    if ((columns != 0 || rows != 0) && load(image, width, height, offsetX, offsetY, columns, rows) && correlate(&x, &y))
+    {
+        *dx = x;
+        *dy = y;
+    }
+    *dx += offsetX;
+    *dy += offsetY;
+    return true;
+}
+
+bool PhaseCorrelation::correlate(double *dx, double *dy)
+{
+    // Transforming the conjugate of the cross-power spectrum forward gives the same real
+    // correlation surface as transforming it back.
+    Complex *spectrum = m_Spectrum.data();
+    const Complex *reference = m_Reference.constData();
+    const int size = m_Spectrum.size();
+    double total = 0;
+    for (int i = 0; i < size; i++)
+    {
+        spectrum[i] = multiply(std::conj(spectrum[i]), reference[i]);
+        total += magnitude(spectrum[i]);
+    }
+
+    // Frequencies where the images share much more power than on average are whitened, which
+    // sharpens the peak. The others, where noise dominates, keep weights growing with their power,
+    // which keeps the peak stable on smooth nebulae.
+    const float damping = std::max(static_cast<float>(DAMPING * total / size), MIN_POWER);
+    for (int i = 0; i < size; i++)
+        spectrum[i] /= magnitude(spectrum[i]) + damping;
+    backward();
+
+    const float *surface = m_Image.constData();
+    const int peak = std::max_element(m_Image.cbegin(), m_Image.cend()) - m_Image.cbegin();
+    if (!(surface[peak] > 0))
+        return false;
+
+    const int x = peak % m_Width, y = peak / m_Width;
+    auto value = [&](int column, int row)
+    {
+        return surface[((row + m_Height) % m_Height) * m_Width + (column + m_Width) % m_Width];
+    };
+    const double peakX = x + peakOffset(value(x - 1, y), value(x, y), value(x + 1, y));
+    const double peakY = y + peakOffset(value(x, y - 1), value(x, y), value(x, y + 1));
+
+    // The surface wraps around, peaks past the middle are negative shifts
+    *dx = (peakX > m_Width / 2 ? peakX - m_Width : peakX) * m_Downsample;
+    *dy = (peakY > m_Height / 2 ? peakY - m_Height : peakY) * m_Downsample;
+    return true;
+}
+
+bool PhaseCorrelation::setRegion(int width, int height, const QRect &region)
+{
+    const QRect frame(0, 0, width, height);
+    const QRect area = region.isNull() ? frame : region.intersected(frame);
+    const int columns = smoothSize(area.width() / m_Downsample);
+    const int rows = smoothSize(area.height() / m_Downsample);
+    if (columns < MIN_SIZE || rows < MIN_SIZE)
+        return false;
+
+    m_Region = area;
+    // The transformed part is centered in the region
+    m_X = area.x() + (area.width() - columns * m_Downsample) / 2;
+    m_Y = area.y() + (area.height() - rows * m_Downsample) / 2;
+
+    if (columns != m_Width || rows != m_Height)
+    {
+        m_Width = columns;
+        m_Height = rows;
+        makePlan(m_RowPlan, m_Width);
+        makePlan(m_ColumnPlan, m_Height);
+        hannWindow(m_RowWindow, m_Width);
+        hannWindow(m_ColumnWindow, m_Height);
+        m_Image.resize(m_Width * m_Height);
+        m_Reference.resize((m_Width / 2 + 1) * m_Height);
+        m_Spectrum.resize((m_Width / 2 + 1) * m_Height);
+        m_Line.resize(std::max(m_Width, m_Height));
+        m_TransformedLine.resize(std::max(m_Width, m_Height));
+    }
+    return true;
+}
+
+template <typename T>
+bool PhaseCorrelation::load(const T *image, int width, int height, int offsetX, int offsetY, int windowColumn,
+                            int windowRow)
+{
+    const int left = m_X + offsetX, top = m_Y + offsetY;
+    if (left < 0 || top < 0 || left + m_Width * m_Downsample > width || top + m_Height * m_Downsample > height)
+        return false;
+    if (std::abs(windowColumn) >= m_Width / 2 || std::abs(windowRow) >= m_Height / 2)
+        return false;
+
+    float *values = m_Image.data();
+    double sum = 0;
+    for (int row = 0; row < m_Height; row++)
+    {
+        for (int column = 0; column < m_Width; column++)
+        {
+            const T *block = image + static_cast<size_t>(top + row * m_Downsample) * width + left + column * m_Downsample;
+            float value = 0;
+            for (int j = 0; j < m_Downsample; j++, block += width)
+            {
+                for (int i = 0; i < m_Downsample; i++)
+                    value += block[i];
+            }
+            values[row * m_Width + column] = value;
+            sum += value;
+        }
+    }
+
+    // The mean is removed so that the window does not correlate with itself
+    const float mean = sum / (m_Width * m_Height);
+    for (int row = 0; row < m_Height; row++)
+    {
+        const int windowY = row - windowRow;
+        const float weight = windowY >= 0 && windowY < m_Height ? m_ColumnWindow[windowY] : 0;
+        for (int column = 0; column < m_Width; column++)
+        {
+            const int windowX = column - windowColumn;
+            float &value = values[row * m_Width + column];
+            value = windowX >= 0 && windowX < m_Width ? (value - mean) * m_RowWindow[windowX] * weight : 0;
+        }
+    }
+
+    forward();
+    return true;
+}
+
+template <typename Function>
+bool PhaseCorrelation::dispatch(const QSharedPointer<FITSData> &imageData, Function function)
+{
+    const uint8_t *buffer = imageData->getImageBuffer();
+    if (buffer == nullptr)
+        return false;
+
+    // Color frames are correlated on their first channel
+    switch (imageData->dataType())
+    {
+        case TBYTE:
+            return function(reinterpret_cast<const uint8_t *>(buffer));
+        case TSHORT:
+            return function(reinterpret_cast<const int16_t *>(buffer));
+        case TUSHORT:
+            return function(reinterpret_cast<const uint16_t *>(buffer));
+        case TLONG:
+            return function(reinterpret_cast<const int32_t *>(buffer));
+        case TULONG:
+            return function(reinterpret_cast<const uint32_t *>(buffer));
+        case TFLOAT:
+            return function(reinterpret_cast<const float *>(buffer));
+        case TLONGLONG:
+            return function(reinterpret_cast<const int64_t *>(buffer));
+        case TDOUBLE:
+            return function(reinterpret_cast<const double *>(buffer));
+        default:
+            return false;
+    }
+}
+
+void PhaseCorrelation::forward()
+{
+    const int columns = m_Width / 2 + 1;
+    const float *image = m_Image.constData();
+    Complex *line = m_Line.data();
+    const Complex *transformed = m_TransformedLine.constData();
+
+    // Two real rows are transformed at once, as the real and imaginary parts of a complex row.
+    // Their spectra are then told apart by their symmetries.
+    for (int row = 0; row < m_Height; row += 2)
+    {
+        const float *first = image + row * m_Width;
+        const float *second = row + 1 < m_Height ? first + m_Width : nullptr;
+        for (int x = 0; x < m_Width; x++)
+            line[x] = Complex(first[x], second ? second[x] : 0);
+        transform(m_RowPlan, line, 1, m_TransformedLine.data());
+
+        Complex *spectrum = m_Spectrum.data() + row * columns;
+        for (int k = 0; k < columns; k++)
+        {
+            const Complex direct = transformed[k], mirrored = std::conj(transformed[(m_Width - k) % m_Width]);
+            spectrum[k] = (direct + mirrored) * 0.5f;
+            if (second)
+                spectrum[columns + k] = multiply(direct - mirrored, Complex(0, -0.5f));
+        }
+    }
+
+    transformColumns();
+}
+
+void PhaseCorrelation::backward()
+{
+    transformColumns();
+
+    const int columns = m_Width / 2 + 1;
+    const Complex *spectrum = m_Spectrum.constData();
+    Complex *line = m_Line.data();
+    const Complex *transformed = m_TransformedLine.constData();
+
+    // The rows of the spectrum are symmetric, their transforms are real, two of them are
+    // transformed at once as the real and imaginary parts of a complex row.
+    for (int row = 0; row < m_Height; row += 2)
+    {
+        const Complex *first = spectrum + row * columns;
+        const Complex *second = row + 1 < m_Height ? first + columns : nullptr;
+        for (int k = 0; k < m_Width; k++)
+        {
+            const Complex a = k < columns ? first[k] : std::conj(first[m_Width - k]);
+            const Complex b = second == nullptr ? Complex(0, 0) : k < columns ? second[k] : std::conj(second[m_Width - k]);
+            line[k] = Complex(a.real() - b.imag(), a.imag() + b.real());
+        }
+        transform(m_RowPlan, line, 1, m_TransformedLine.data());
+
+        float *surface = m_Image.data() + row * m_Width;
+        for (int x = 0; x < m_Width; x++)
+        {
+            surface[x] = transformed[x].real();
+            if (second)
+                surface[m_Width + x] = transformed[x].imag();
+        }
+    }
+}
+
+void PhaseCorrelation::transformColumns()
+{
+    const int columns = m_Width / 2 + 1;
+    Complex *spectrum = m_Spectrum.data();
+    const Complex *transformed = m_TransformedLine.constData();
+
+    for (int column = 0; column < columns; column++)
+    {
+        transform(m_ColumnPlan, spectrum + column, columns, m_TransformedLine.data());
+        for (int row = 0; row < m_Height; row++)
+            spectrum[row * columns + column] = transformed[row];
+    }
+}
+
+void PhaseCorrelation::makePlan(Plan &plan, int size)
+{
+    plan.size = size;
+
+    plan.twiddles.resize(size);
+    for (int i = 0; i < size; i++)
+        plan.twiddles[i] = std::polar(1.0f, static_cast<float>(-2 * M_PI * i / size));
+
+    plan.factors.clear();
+    int radix = 4, left = size, largest = 1;
+    while (left > 1)
+    {
+        while (left % radix != 0)
+            radix = radix == 4 ? 2 : radix == 2 ? 3 : radix + 2;
+        left /= radix;
+        plan.factors << radix << left;
+        largest = std::max(largest, radix);
+    }
+    if (plan.factors.isEmpty())
+        plan.factors << 1 << 1;
+
+    plan.scratch.resize(largest);
+}
+
+void PhaseCorrelation::transform(Plan &plan, const Complex *in, int inStride, Complex *out)
+{
+    stage(plan, out, in, inStride, plan.factors.constData(), 1);
+}
+
+// Decimation in time: the transform of length radix x length is made of radix transforms of
+// length, one for each residue of the input index modulo radix, combined by butterflies.
+void PhaseCorrelation::stage(Plan &plan, Complex *out, const Complex *in, int inStride, const int *factors,
+                             int stride)
+{
+    const int radix = factors[0], length = factors[1];
+    const Complex *twiddles = plan.twiddles.constData();
+
+    if (length == 1)
+    {
+        for (int i = 0; i < radix; i++, in += stride * inStride)
+            out[i] = *in;
+    }
+    else
+    {
+        for (int i = 0; i < radix; i++, in += stride * inStride)
+            stage(plan, out + i * length, in, inStride, factors + 2, stride * radix);
+    }
+
+    if (radix == 4)
+    {
+        for (int k = 0; k < length; k++)
+        {
+            const Complex a = multiply(out[k + length], twiddles[k * stride]);
+            const Complex b = multiply(out[k + 2 * length], twiddles[2 * k * stride]);
+            const Complex c = multiply(out[k + 3 * length], twiddles[3 * k * stride]);
+            const Complex sum = out[k] + b, difference = out[k] - b;
+            const Complex outer = a + c, inner = a - c;
+            out[k] = sum + outer;
+            out[k + 2 * length] = sum - outer;
+            out[k + length] = Complex(difference.real() + inner.imag(), difference.imag() - inner.real());
+            out[k + 3 * length] = Complex(difference.real() - inner.imag(), difference.imag() + inner.real());
+        }
+    }
+    else if (radix == 2)
+    {
+        for (int k = 0; k < length; k++)
+        {
+            const Complex t = multiply(out[k + length], twiddles[k * stride]);
+            out[k + length] = out[k] - t;
+            out[k] += t;
+        }
+    }
+    else if (radix > 2)
+    {
+        Complex *scratch = plan.scratch.data();
+        for (int u = 0; u < length; u++)
+        {
+            for (int q = 0; q < radix; q++)
+                scratch[q] = out[u + q * length];
+
+            for (int q = 0, k = u; q < radix; q++, k += length)
+            {
+                Complex value = scratch[0];
+                for (int r = 1, twiddle = 0; r < radix; r++)
+                {
+                    twiddle += stride * k;
+                    if (twiddle >= plan.size)
+                        twiddle -= plan.size;
+                    value += multiply(scratch[r], twiddles[twiddle]);
+                }
+                out[k] = value;
+            }
+        }
+    }
+}
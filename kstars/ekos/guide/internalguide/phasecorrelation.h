@@ -0,0 +1,153 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QRect>
+#include <QSharedPointer>
+#include <QVector>
+
+#include <complex>
+
+class FITSData;
+
+/*
+ * Measures how far an image moved from a reference image by phase correlation, without detecting
+ * any star. It suits guiding on nebulae, planets or the Moon, where star detection fails.
+ *
+ * The reference is taken from a region of a frame, optionally averaged down by blocks of pixels,
+ * and weighted by a Hann window. Later frames are read from the same region, or from where the
+ * tracking box moved it, see track(). The cross-power spectrum of the frame and the reference,
+ * whitened where it is strong, is transformed back to a correlation surface peaking at the shift. The peak is refined to sub-pixel precision by a
+ * parabola through its neighbours along each axis. When the frame moved by a pixel or more, it is
+ * correlated again with the window moved along, as the window otherwise biases the shift.
+ *
+ * Regions need not be square nor powers of two: they are trimmed to the nearest smaller sizes
+ * made of factors 2, 3 and 5, which the mixed-radix FFT handles efficiently. The FFT plans,
+ * windows and spectra are kept from frame to frame, so measuring a shift does not allocate
+ * as long as the region is kept.
+ */
+class PhaseCorrelation
+{
+    public:
+        PhaseCorrelation() = default;
+
+        /** @short Pixels are averaged by blocks of factor x factor before correlating, 1 to disable. */
+        void setDownsample(int factor);
+        int downsample() const
+        {
+            return m_Downsample;
+        }
+
+        /**
+         * @short Takes the reference from @p region of @p imageData, the whole frame if @p region is null.
+         * @return false if the region is too small to correlate.
+         */
+        bool setReference(const QSharedPointer<FITSData> &imageData, const QRect &region = QRect());
+        bool setReference(const float *image, int width, int height, const QRect &region = QRect());
+
+        /**
+         * @short Measures the shift of @p imageData from the reference, in pixels of the frame.
+         * The content at (x, y) in the reference is found at (x + dx, y + dy) in @p imageData.
+         * @return false if there is no reference or the frame no longer covers its region.
+         */
+        bool findShift(const QSharedPointer<FITSData> &imageData, double *dx, double *dy);
+        bool findShift(const float *image, int width, int height, double *dx, double *dy);
+
+        /**
+         * @short Finds the position of the content of the reference in @p imageData, read from @p region,
+         * the whole frame if @p region is null. Without a reference, the frame becomes the reference and
+         * the position found is the center of @p region. The region may move from frame to frame, as the
+         * tracking box does when it follows the positions found, so that the content can move further
+         * than half the region from the reference. When the size of the region changes, the frame becomes
+         * the new reference once measured, and later positions carry on from the one found in it.
+         * @return false if @p region is too small or out of the frame.
+         */
+        bool track(const QSharedPointer<FITSData> &imageData, const QRect &region, double *x, double *y);
+        bool track(const float *image, int width, int height, const QRect &region, double *x, double *y);
+
+        bool hasReference() const
+        {
+            return m_HasReference;
+        }
+        void clearReference();
+
+        /** @return the region of the frame the reference was taken from. */
+        const QRect &region() const
+        {
+            return m_Region;
+        }
+
+    private:
+        using Complex = std::complex<float>;
+
+        // Mixed radix FFT of one length
+        struct Plan
+        {
+            int size { 0 };
+            // Radix of each stage followed by the length left to transform after it
+            QVector<int> factors;
+            QVector<Complex> twiddles;
+            QVector<Complex> scratch;
+        };
+
+        static void makePlan(Plan &plan, int size);
+        // Transforms plan.size values read every inStride values of in into out, which must not overlap in
+        static void transform(Plan &plan, const Complex *in, int inStride, Complex *out);
+        static void stage(Plan &plan, Complex *out, const Complex *in, int inStride, const int *factors, int stride);
+
+        // Calls function with the pixels of the first channel of imageData
+        template <typename Function>
+        static bool dispatch(const QSharedPointer<FITSData> &imageData, Function function);
+        // Reads the region of a frame, moved by offsetX, offsetY pixels, into m_Image, weighed by the
+        // window moved by windowColumn, windowRow, then transforms it into m_Spectrum
+        template <typename T>
+        bool load(const T *image, int width, int height, int offsetX, int offsetY, int windowColumn, int windowRow);
+        // Measures the shift of a frame read from the region moved by offsetX, offsetY pixels
+        template <typename T>
+        bool measure(const T *image, int width, int height, int offsetX, int offsetY, double *dx, double *dy);
+        // Takes the reference from the region of a frame, the position of its center being the origin
+        template <typename T>
+        bool takeReference(const T *image, int width, int height, const QRect &region);
+        template <typename T>
+        bool follow(const T *image, int width, int height, const QRect &region, double *x, double *y);
+        // Transforms m_Image into m_Spectrum, and back
+        void forward();
+        void backward();
+        void transformColumns();
+        // Correlates the frame in m_Spectrum with the reference
+        bool correlate(double *dx, double *dy);
+
+        // Prepares the plans, windows and buffers for the region
+        bool setRegion(int width, int height, const QRect &region);
+
+        int m_Downsample { 1 };
+
+        // Region of the frame the reference was taken from, and the part of it being transformed
+        QRect m_Region;
+        // Region requested for the reference, and the position in the frame its content is followed from
+        QRect m_TrackedRegion;
+        double m_OriginX { 0 };
+        double m_OriginY { 0 };
+        int m_X { 0 };
+        int m_Y { 0 };
+        int m_Width { 0 };
+        int m_Height { 0 };
+
+        Plan m_RowPlan;
+        Plan m_ColumnPlan;
+        QVector<float> m_RowWindow;
+        QVector<float> m_ColumnWindow;
+
+        // Spectra of real images are symmetric, only their first m_Width / 2 + 1 columns are kept
+        bool m_HasReference { false };
+        QVector<Complex> m_Reference;
+        QVector<Complex> m_Spectrum;
+        // The windowed frame, then the correlation surface
+        QVector<float> m_Image;
+        QVector<Complex> m_Line;
+        QVector<Complex> m_TransformedLine;
+};
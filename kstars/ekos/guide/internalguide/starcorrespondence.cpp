@@ -9,84 +9,98 @@
 #include <math.h>
 #include "ekos_guide_debug.h"
 
-// Finds the star in sortedStars that's closest to x,y and within maxDistance pixels.
-// Returns the index of the closest star in  sortedStars, or -1 if none satisfies the criteria.
-// sortedStars must be sorted by x, from lower x to higher x.
+#include <algorithm>
+
+// Sorts the stars into the cells of a grid covering them. Cells are at least maxDistance wide,
+// so the stars within maxDistance of any position lie in the 3x3 cells around it. They are
+// made wider when the stars are sparse, so that there are about as many cells as stars.
+void StarCorrespondence::indexStars(const QList<Edge> &stars, double maxDistance)
+{
+    const int numStars = stars.size();
+    // In double, as in cellOf(), so that the extreme stars fall in the last column and row.
+    double minX = 0, minY = 0, maxX = 0, maxY = 0;
+    for (int i = 0; i < numStars; ++i)
+    {
+        const auto &star = stars[i];
+        minX = (i == 0) ? star.x : std::min<double>(minX, star.x);
+        minY = (i == 0) ? star.y : std::min<double>(minY, star.y);
+        maxX = (i == 0) ? star.x : std::max<double>(maxX, star.x);
+        maxY = (i == 0) ? star.y : std::max<double>(maxY, star.y);
+    }
+
+    gridX = minX;
+    gridY = minY;
+    const double width = maxX - minX, height = maxY - minY;
+    gridCellSize = std::max({maxDistance, sqrt(width * height / std::max(numStars, 1)),
+                             width / std::max(numStars, 1), height / std::max(numStars, 1), 1e-3});
+    gridColumns = static_cast<int>(width / gridCellSize) + 1;
+    gridRows = static_cast<int>(height / gridCellSize) + 1;
+
+    // Counting sort of the stars by cell.
+    gridCellStart.fill(0, gridColumns * gridRows + 1);
+    gridStars.resize(numStars);
+    // Clamped, rounding must never put a star outside of the grid.
+    auto cellOf = [this](const Edge & star)
+    {
+        const int column = std::min(std::max(static_cast<int>((star.x - gridX) / gridCellSize), 0), gridColumns - 1);
+        const int row = std::min(std::max(static_cast<int>((star.y - gridY) / gridCellSize), 0), gridRows - 1);
+        return row * gridColumns + column;
+    };
+    for (const auto &star : stars)
+        gridCellStart[cellOf(star) + 1]++;
+    for (int c = 0; c < gridColumns * gridRows; ++c)
+        gridCellStart[c + 1] += gridCellStart[c];
+    // Fill each cell from its end, which leaves the start of cell c in gridCellStart[c + 1].
+    for (int i = numStars - 1; i >= 0; --i)
+        gridStars[--gridCellStart[cellOf(stars[i]) + 1]] = i;
+    for (int c = 0; c < gridColumns * gridRows; ++c)
+        gridCellStart[c] = gridCellStart[c + 1];
+    gridCellStart[gridColumns * gridRows] = numStars;
+}
+
+// Finds the star in stars that's closest to x,y and within maxDistance pixels.
+// Returns the index of the closest star in stars, or -1 if none satisfies the criteria.
+// Of stars at the same distance, the one with the lowest index is returned.
 // Fills distance to the pixel distance to the closest star.
-int StarCorrespondence::findClosestStar(double x, double y, const QList<Edge> sortedStars,
+int StarCorrespondence::findClosestStar(double x, double y, const QList<Edge> &stars,
                                         double maxDistance, double *distance) const
 {
     if (x < -maxDistance || y < -maxDistance ||
-            x > imageWidth + maxDistance || y > imageWidth + maxDistance)
+            x > imageWidth + maxDistance || y > imageHeight + maxDistance)
         return -1;
 
-    const int size = sortedStars.size();
-    int startPoint = 0;
-
-    // Efficiency improvement to quickly find the start point.
-    // Increments by size/10 to find a better start point.
-    const int coarseIncrement = size / 10;
-    if (coarseIncrement > 1)
-    {
-        for (int i = 0; i < size; i += coarseIncrement)
-        {
-            if (sortedStars[i].x < x - maxDistance)
-                startPoint = i;
-            else
-                break;
-        }
-    }
+    // The cells which may hold stars within maxDistance of x,y.
+    const double column = std::floor((x - gridX) / gridCellSize);
+    const double row = std::floor((y - gridY) / gridCellSize);
+    const int firstColumn = std::max(0.0, column - 1), lastColumn = std::min(gridColumns - 1.0, column + 1);
+    const int firstRow = std::max(0.0, row - 1), lastRow = std::min(gridRows - 1.0, row + 1);
 
-    // Iterate through the stars starting with the star with lowest x where x >= x - maxDistance
-    // through the star with greatest x where x <= x + maxDistance.  Find the closest star to x,y.
     int bestIndex = -1;
     double bestSquaredDistance = maxDistance * maxDistance;
-    for (int i = startPoint; i < size; ++i)
+    for (int r = firstRow; r <= lastRow; ++r)
     {
-        auto &star = sortedStars[i];
-        if (star.x < x - maxDistance) continue;
-        if (star.x > x + maxDistance) break;
-        const double xDiff = star.x - x;
-        const double yDiff = star.y - y;
-        const double squaredDistance = xDiff * xDiff + yDiff * yDiff;
-        if (squaredDistance <= bestSquaredDistance)
+        for (int c = firstColumn; c <= lastColumn; ++c)
         {
-            bestIndex = i;
-            bestSquaredDistance = squaredDistance;
+            const int cell = r * gridColumns + c;
+            for (int k = gridCellStart[cell]; k < gridCellStart[cell + 1]; ++k)
+            {
+                const int i = gridStars[k];
+                const double xDiff = stars[i].x - x;
+                const double yDiff = stars[i].y - y;
+                const double squaredDistance = xDiff * xDiff + yDiff * yDiff;
+                if (squaredDistance < bestSquaredDistance ||
+                        (squaredDistance == bestSquaredDistance && (bestIndex < 0 || i < bestIndex)))
+                {
+                    bestIndex = i;
+                    bestSquaredDistance = squaredDistance;
+                }
+            }
         }
     }
     if (distance != nullptr) *distance = sqrt(bestSquaredDistance);
     return bestIndex;
 }
 
-namespace
-{
-// Sorts stars by their x values, places the sorted stars into sortedStars.
-// sortedToOriginal is a map whose index is the index of a star in sortedStars and whose
-// value is the index of a star in stars.
-// Therefore, sortedToOrigial[a] = b, means that sortedStars[a] corresponds to stars[b].
-void sortByX(const QList<Edge> &stars, QList<Edge> *sortedStars, QVector<int> *sortedToOriginal)
-{
-    sortedStars->clear();
-    sortedToOriginal->clear();
-
-    // Sort the stars by their x-positions, lower to higher.
-    QVector<std::pair<int, float>> rx;
-    for (int i = 0; i < stars.size(); ++i)
-        rx.push_back(std::pair<int, float>(i, stars[i].x));
-    std::sort(rx.begin(), rx.end(), [](const std::pair<int, float> &a, const std::pair<int, double> &b)
-    {
-        return a.second < b.second;
-    });
-    for (int i = 0; i < stars.size(); ++i)
-    {
-        sortedStars->append(stars[ rx[i].first ]);
-        sortedToOriginal->push_back(rx[i].first);
-    }
-}
-
-}  // namespace
-
 StarCorrespondence::StarCorrespondence(const QList<Edge> &stars, int guideStar)
 {
     initialize(stars, guideStar);
@@ -135,7 +149,7 @@ void StarCorrespondence::reset()
 
 int StarCorrespondence::findInternal(const QList<Edge> &stars, double maxDistance, QVector<int> *starMap,
                                      int guideStarIndex, const QVector<Offsets> &offsets,
-                                     int *numFound, int *numNotFound, double minFraction) const
+                                     int *numFound, int *numNotFound, double minFraction)
 {
     // This is the cost of not finding one of the reference stars.
     constexpr double missingRefStarCost = 100;
@@ -143,7 +157,7 @@ int StarCorrespondence::findInternal(const QList<Edge> &stars, double maxDistanc
     constexpr double distanceWeight = 1.0;
 
     // Initialize all stars to not-corresponding to any reference star.
-    *starMap = QVector<int>(stars.size(), -1);
+    starMap->fill(-1, stars.size());
 
     // We won't accept a solution worse than bestCost.
     // In the default case, we need to find about half the reference stars.
@@ -161,13 +175,16 @@ int StarCorrespondence::findInternal(const QList<Edge> &stars, double maxDistanc
     // Score the assignment, pick the best, and then assign the rest.
     const int numStars = stars.size();
     int bestStarIndex = -1, bestNumFound = 0, bestNumNotFound = 0;
+    // The mapping of each candidate is reset through the stars it set, rather than refilled.
+    candidateMap.fill(-1, numStars);
+    candidateStars.reserve(offsets.size());
     for (int starIndex = 0; starIndex < numStars; ++starIndex)
     {
         const float starX = stars[starIndex].x;
         const float starY = stars[starIndex].y;
 
         double cost = 0.0;
-        QVector<int> mapping(stars.size(), -1);
+        candidateStars.clear();
         int numFound = 0, numNotFound = 0;
         for (int offsetIndex = 0; offsetIndex < offsets.size(); ++offsetIndex)
         {
@@ -178,7 +195,6 @@ int StarCorrespondence::findInternal(const QList<Edge> &stars, double maxDistanc
             if (cost > bestCost) break;
 
             // Look for an input star at the offset position.
-            // Note the index value returned is the sorted index, which is converted back later.
             const auto &offset = offsets[offsetIndex];
             double distance;
             const int closestIndex = findClosestStar(starX + offset.x, starY + offset.y,
@@ -194,7 +210,8 @@ int StarCorrespondence::findInternal(const QList<Edge> &stars, double maxDistanc
 
             // If starIndex is the star that corresponds to guideStarIndex, then
             // stars[index] corresponds to references[offsetIndex]
-            mapping[closestIndex] = offsetIndex;
+            candidateMap[closestIndex] = offsetIndex;
+            candidateStars.push_back(closestIndex);
             cost += distance * distanceWeight;
         }
         if (cost < bestCost)
@@ -204,11 +221,13 @@ int StarCorrespondence::findInternal(const QList<Edge> &stars, double maxDistanc
             bestNumFound = numFound;
             bestNumNotFound = numNotFound;
 
-            *starMap = QVector<int>(stars.size(), -1);
-            for (int i = 0; i < mapping.size(); ++i)
-                (*starMap)[i] = mapping[i];
+            starMap->fill(-1);
+            for (const int i : candidateStars)
+                (*starMap)[i] = candidateMap[i];
             (*starMap)[starIndex] = guideStarIndex;
         }
+        for (const int i : candidateStars)
+            candidateMap[i] = -1;
     }
     *numFound = bestNumFound;
     *numNotFound = bestNumNotFound;
@@ -240,7 +259,7 @@ void StarCorrespondence::makeOffsets(const QVector<Offsets> &offsets, QVector<Of
 
 // We create an imaginary star from the ones we did find.
 Edge StarCorrespondence::inventStarPosition(const QList<Edge> &stars, const QVector<int> &starMap,
-        QVector<Offsets> offsets, Offsets offset) const
+        const QVector<Offsets> &offsets, Offsets offset) const
 {
     Edge inventedStar;
     inventedStar.invalidate();
@@ -305,43 +324,25 @@ Edge StarCorrespondence::inventStarPosition(const QList<Edge> &stars, const QVec
     return inventedStar;
 }
 
-namespace
-{
-// This utility converts the starMap to refer to indexes in the original star QVector
-// instead of the sorted-by-x version.
-void unmapStarMap(const QVector<int> &sortedStarMap, const QVector<int> &sortedToOriginal, QVector<int> *starMap)
-{
-    for (int i = 0; i < sortedStarMap.size(); ++i)
-        (*starMap)[sortedToOriginal[i]] = sortedStarMap[i];
-}
-}
-
 Edge StarCorrespondence::find(const QList<Edge> &stars, double maxDistance,
                               QVector<int> *starMap, bool adapt, double minFraction)
 {
     m_NumReferencesFound = 0;
-    *starMap = QVector<int>(stars.size(), -1);
+    starMap->fill(-1, stars.size());
     Edge foundStar;
     foundStar.invalidate();
     if (!initialized)  return foundStar;
     int numFound, numNotFound;
 
-    // findClosestStar needs an input with stars sorted by their x.
+    // findClosestStar needs the stars indexed in a grid.
     // Do this outside of the loops.
-    QList<Edge> sortedStars;
-    QVector<int> sortedToOriginal;
-    sortByX(stars, &sortedStars, &sortedToOriginal);
+    indexStars(stars, maxDistance);
 
-    QVector<int> sortedStarMap;
-    int bestStarIndex = findInternal(sortedStars, maxDistance, &sortedStarMap, guideStarIndex,
+    int bestStarIndex = findInternal(stars, maxDistance, starMap, guideStarIndex,
                                      guideStarOffsets, &numFound, &numNotFound, minFraction);
 
     if (bestStarIndex > -1)
     {
-        // Convert back to the unsorted index value.
-        bestStarIndex = sortedToOriginal[bestStarIndex];
-        unmapStarMap(sortedStarMap, sortedToOriginal, starMap);
-
         foundStar = stars[bestStarIndex];
         qCDebug(KSTARS_EKOS_GUIDE)
                 << " StarCorrespondence found guideStar at " << bestStarIndex << "found/not"
@@ -364,15 +365,13 @@ Edge StarCorrespondence::find(const QList<Edge> &stars, double maxDistance,
         {
             if (gStarIndex == guideStarIndex)
                 continue;
-            QVector<Offsets> gStarOffsets;
-            makeOffsets(guideStarOffsets, &gStarOffsets, gStarIndex);
-            QVector<int> newStarMap;
-            int detectedStarIndex = findInternal(sortedStars, maxDistance, &newStarMap,
-                                                 gStarIndex, gStarOffsets,
+            makeOffsets(guideStarOffsets, &substituteOffsets, gStarIndex);
+            int detectedStarIndex = findInternal(stars, maxDistance, &substituteMap,
+                                                 gStarIndex, substituteOffsets,
                                                  &numFound, &numNotFound, minFraction);
             if (detectedStarIndex >= 0 && numFound > bestNumFound)
             {
-                Edge invented = inventStarPosition(sortedStars, newStarMap, gStarOffsets,
+                Edge invented = inventStarPosition(stars, substituteMap, substituteOffsets,
                                                    guideStarOffsets[gStarIndex]);
                 if (invented.x < 0 || invented.y < 0)
                     continue;
@@ -380,7 +379,7 @@ Edge StarCorrespondence::find(const QList<Edge> &stars, double maxDistance,
                 bestInvented = invented;
                 bestNumFound = numFound;
                 bestNumNotFound = numNotFound;
-                sortedStarMap = newStarMap;
+                std::swap(bestSubstituteMap, substituteMap);
 
                 if (numNotFound <= 1)
                     // We can't do better than this.
@@ -389,8 +388,7 @@ Edge StarCorrespondence::find(const QList<Edge> &stars, double maxDistance,
         }
         if (bestNumFound > 0)
         {
-            // Convert back to the unsorted index value.
-            unmapStarMap(sortedStarMap, sortedToOriginal, starMap);
+            std::copy(bestSubstituteMap.cbegin(), bestSubstituteMap.cend(), starMap->begin());
             qCDebug(KSTARS_EKOS_GUIDE)
                     << "StarCorrespondence found guideStar (invented) at "
                     << bestInvented.x << bestInvented.y << "found/not" << bestNumFound << bestNumNotFound;
@@ -22,6 +22,11 @@
  * of the new stars to the references. Some reference stars may not be in the new star group, and
  * there may be new stars that don't appear in the references. However, the guide star must appear
  * in both sets for this to be successful.
+ *
+ * The input stars are indexed once per frame in a grid whose cells are at least maxDistance wide,
+ * so looking up the star closest to a reference position only visits the 3x3 cells around it.
+ * The grid and the other working buffers are kept from frame to frame, so matching does not
+ * allocate once their sizes have settled.
  */
 
 class StarCorrespondence
@@ -111,9 +116,10 @@ class StarCorrespondence
         void adaptOffsets(const QList<Edge> &stars, const QVector<int> &starMap);
 
         // Utility used by find. Useful for iterating when the guide star is missing.
+        // The stars must have been indexed by indexStars().
         int findInternal(const QList<Edge> &stars, double maxDistance, QVector<int> *starMap,
                          int guideStarIndex, const QVector<Offsets> &offsets,
-                         int *numFound, int *numNotFound, double minFraction) const;
+                         int *numFound, int *numNotFound, double minFraction);
 
         // Used to when guide star is missing. Creates offsets as if other stars were the guide star.
         void makeOffsets(const QVector<Offsets> &offsets, QVector<Offsets> *targetOffsets, int targetStar) const;
@@ -125,11 +131,14 @@ class StarCorrespondence
         // StarMap is the map made for that substitude by findInternal().
         // Offset is the offset from the original guide star to that substitute guide star.
         Edge inventStarPosition(const QList<Edge> &stars, const QVector<int> &starMap,
-                                QVector<Offsets> offsets, Offsets offset) const;
+                                const QVector<Offsets> &offsets, Offsets offset) const;
 
-        // Finds the star closest to x,y. Returns the index in sortedStars.
-        // sortedStars should be sorted in x, which allows for a speedup in search.
-        int findClosestStar(double x, double y, const QList<Edge> sortedStars,
+        // Builds the grid over stars used by findClosestStar().
+        void indexStars(const QList<Edge> &stars, double maxDistance);
+
+        // Finds the star closest to x,y. Returns the index in stars.
+        // stars must have been indexed by indexStars() with the same maxDistance.
+        int findClosestStar(double x, double y, const QList<Edge> &stars,
                             double maxDistance, double *distance) const;
 
         // The offsets of the reference stars relative to the guide star.
@@ -159,5 +168,24 @@ class StarCorrespondence
 
         // A copy of the original reference offsets used so that the values don't move too far.
         QVector<Offsets> originalGuideStarOffsets;
+
+        // The grid over the input stars of the frame being matched.
+        double gridX { 0 };
+        double gridY { 0 };
+        double gridCellSize { 1 };
+        int gridColumns { 0 };
+        int gridRows { 0 };
+        // The stars in cell c are gridStars[gridCellStart[c]] up to gridStars[gridCellStart[c + 1] - 1].
+        QVector<int> gridCellStart;
+        QVector<int> gridStars;
+
+        // The mapping of the candidate guide star being scored by findInternal(), and the stars it maps.
+        QVector<int> candidateMap;
+        QVector<int> candidateStars;
+
+        // The offsets and mapping of substitute guide stars, used when the guide star is missing.
+        QVector<Offsets> substituteOffsets;
+        QVector<int> substituteMap;
+        QVector<int> bestSubstituteMap;
 };
 
@@ -13,6 +13,8 @@
 #include "ekos/ekos.h"
 #include "ui_scheduler.h"
 
+#include <QtConcurrent>
+
 // Can make the scheduling a bit faster by sampling every other minute instead of every minute.
 constexpr int SCHEDULE_RESOLUTION_MINUTES = 2;
 
@@ -21,6 +23,12 @@ namespace Ekos
 
 GreedyScheduler::GreedyScheduler()
 {
+    connect(&simulationWatcher, &QFutureWatcher<SimulationResult>::finished, this, &GreedyScheduler::applySimulation);
+}
+
+GreedyScheduler::~GreedyScheduler()
+{
+    cancelSimulation();
 }
 
 void GreedyScheduler::setParams(bool restartImmediately, bool restartQueue,
@@ -39,32 +47,27 @@ QList<SchedulerJob *> GreedyScheduler::scheduleJobs(const QList<SchedulerJob *>
         const QMap<QString, uint16_t> &capturedFramesCount,
         Scheduler *scheduler)
 {
+    // A previous plan is of no use anymore, and its simulation must not update the jobs behind our back.
+    cancelSimulation();
+
     for (auto job : jobs)
         job->clearCache();
 
     SchedulerJob::enableGraphicsUpdates(false);
     QDateTime when;
-    QElapsedTimer timer;
-    timer.start();
+    simulationTimer.start();
+    simulationStart = now;
+    simulationScheduler = scheduler;
     scheduledJob = nullptr;
     schedule.clear();
 
     QList<SchedulerJob *> sortedJobs =
         prepareJobsForEvaluation(jobs, now, capturedFramesCount, scheduler);
 
+    // The plan is logged once simulated, see applySimulation().
     scheduledJob = selectNextJob(sortedJobs, now, nullptr, true, &when, nullptr, nullptr, &capturedFramesCount);
-    auto schedule = getSchedule();
-    if (!schedule.empty())
-    {
-        // Print in reverse order ?! The log window at the bottom of the screen
-        // prints "upside down" -- most recent on top -- and I believe that view
-        // is more important than the log file (where we can invert when debugging).
-        for (int i = schedule.size() - 1; i >= 0; i--)
-            scheduler->appendLogText(GreedyScheduler::jobScheduleString(schedule[i]));
-        scheduler->appendLogText(QString("Greedy Scheduler plan for the next 48 hours starting %1 (%2)s:")
-                                 .arg(now.toString()).arg(timer.elapsed() / 1000.0));
-    }
-    else scheduler->appendLogText(QString("Greedy Scheduler: empty plan (%1s)").arg(timer.elapsed() / 1000.0));
+    if (scheduledJob == nullptr && scheduler != nullptr)
+        scheduler->appendLogText(QString("Greedy Scheduler: empty plan (%1s)").arg(simulationTimer.elapsed() / 1000.0));
     if (scheduledJob != nullptr)
     {
         qCDebug(KSTARS_EKOS_SCHEDULER)
@@ -74,6 +77,8 @@ QList<SchedulerJob *> GreedyScheduler::scheduleJobs(const QList<SchedulerJob *>
         scheduledJob->setStartupTime(when);
         foreach (auto job, sortedJobs)
             job->updateJobCells();
+        // The simulation was started before the selected job was marked, this is the state it must find.
+        recordSimulationStates();
     }
     // The graphics would get updated many times during scheduling, which can
     // cause significant cpu usage. No need for that, so we turn off updates
@@ -200,9 +205,7 @@ QList<SchedulerJob *> GreedyScheduler::prepareJobsForEvaluation(
     qCInfo(KSTARS_EKOS_SCHEDULER) << "Option to sort jobs based on priority and altitude is" << Options::sortSchedulerJobs();
     if (Options::sortSchedulerJobs())
     {
-        using namespace std::placeholders;
-        std::stable_sort(sortedJobs.begin(), sortedJobs.end(),
-                         std::bind(SchedulerJob::decreasingAltitudeOrder, _1, _2, now));
+        SchedulerJob::sortByDecreasingAltitude(sortedJobs.begin(), sortedJobs.end(), now);
         std::stable_sort(sortedJobs.begin(), sortedJobs.end(), SchedulerJob::increasingPriorityOrder);
     }
     return sortedJobs;
@@ -284,6 +287,9 @@ SchedulerJob *GreedyScheduler::selectNextJob(const QList<SchedulerJob *> &jobs,
     SchedulerJob *nextJob = nullptr;
     QString interruptStr;
 
+    // Find the first time each job can meet all its constraints, both loops below pick from these.
+    const QHash<SchedulerJob *, QDateTime> startTimes = findStartTimes(jobs, now, currentJob);
+
     for (int i = 0; i < jobs.size(); ++i)
     {
         SchedulerJob *job = jobs[i];
@@ -292,15 +298,7 @@ SchedulerJob *GreedyScheduler::selectNextJob(const QList<SchedulerJob *> &jobs,
         if (!allowJob(job, rescheduleAbortsImmediate, rescheduleAbortsQueue, rescheduleErrors))
             continue;
 
-        // If the job state is abort or error, might have to delay the first possible start time.
-        QDateTime startSearchingtAt = firstPossibleStart(
-                                          job, now, rescheduleAbortsQueue, abortDelaySeconds, rescheduleErrors, errorDelaySeconds);
-
-        // Find the first time this job can meet all its constraints.
-        // I found that passing in an "until" 4th argument actually hurt performance, as it reduces
-        // the effectiveness of the cache that getNextPossibleStartTime uses.
-        const QDateTime startTime = job->getNextPossibleStartTime(startSearchingtAt, SCHEDULE_RESOLUTION_MINUTES,
-                                    evaluatingCurrentJob);
+        const QDateTime startTime = startTimes.value(job);
         if (startTime.isValid())
         {
             if (nextJob == nullptr)
@@ -364,14 +362,9 @@ SchedulerJob *GreedyScheduler::selectNextJob(const QList<SchedulerJob *> &jobs,
             {
                 if (!allowJob(atJob, rescheduleAbortsImmediate, rescheduleAbortsQueue, rescheduleErrors))
                     continue;
-                // If the job state is abort or error, might have to delay the first possible start time.
-                QDateTime startSearchingtAt = firstPossibleStart(
-                                                  atJob, now, rescheduleAbortsQueue, abortDelaySeconds, rescheduleErrors,
-                                                  errorDelaySeconds);
                 // atTime above is the user-specified start time. atJobStartTime is the time it can
                 // actually start, given all the constraints (altitude, twilight, etc).
-                const QDateTime atJobStartTime = atJob->getNextPossibleStartTime(startSearchingtAt, SCHEDULE_RESOLUTION_MINUTES, currentJob
-                                                 && (atJob == currentJob));
+                const QDateTime atJobStartTime = startTimes.value(atJob);
                 if (atJobStartTime.isValid())
                 {
                     // This difference between the user-specified start time, and the time it can really start.
@@ -417,32 +410,116 @@ SchedulerJob *GreedyScheduler::selectNextJob(const QList<SchedulerJob *> &jobs,
 
     constexpr int twoDays = 48 * 3600;
     if (fullSchedule && nextJob != nullptr)
-        simulate(jobs, now, now.addSecs(twoDays), capturedFramesCount);
+        startSimulation(jobs, now, now.addSecs(twoDays), capturedFramesCount);
 
     return nextJob;
 }
 
-void GreedyScheduler::simulate(const QList<SchedulerJob *> &jobs, const QDateTime &time, const QDateTime &endTime,
-                               const QMap<QString, uint16_t> *capturedFramesCount)
+QHash<SchedulerJob *, QDateTime> GreedyScheduler::findStartTimes(const QList<SchedulerJob *> &jobs, const QDateTime &now,
+        SchedulerJob *currentJob)
 {
+    struct Candidate
+    {
+        SchedulerJob *job;
+        QDateTime startTime;
+    };
+    QVector<Candidate> candidates;
+    for (auto job : jobs)
+        if (allowJob(job, rescheduleAbortsImmediate, rescheduleAbortsQueue, rescheduleErrors))
+            candidates.append({job, QDateTime()});
+    if (candidates.isEmpty())
+        return QHash<SchedulerJob *, QDateTime>();
+
+    // The searches look up to a day ahead, and the Moon is only positioned from the main thread:
+    // prepare the ephemeris so that all the jobs see the same Moon, whichever thread searches them.
+    candidates.first().job->prepareEphemeris(now, 48);
+
+    // Each job only touches its own cache, and the timelines of the targets are shared safely.
+    QtConcurrent::blockingMap(candidates, [&](Candidate & candidate)
+    {
+        // If the job state is abort or error, might have to delay the first possible start time.
+        const QDateTime startSearchingAt = firstPossibleStart(
+                                               candidate.job, now, rescheduleAbortsQueue, abortDelaySeconds,
+                                               rescheduleErrors, errorDelaySeconds);
+        // I found that passing in an "until" 4th argument actually hurt performance, as it reduces
+        // the effectiveness of the cache that getNextPossibleStartTime uses.
+        candidate.startTime = candidate.job->getNextPossibleStartTime(startSearchingAt, SCHEDULE_RESOLUTION_MINUTES,
+                              currentJob && (candidate.job == currentJob));
+    });
+
+    QHash<SchedulerJob *, QDateTime> startTimes;
+    for (const auto &candidate : candidates)
+        startTimes.insert(candidate.job, candidate.startTime);
+    return startTimes;
+}
+
+void GreedyScheduler::cancelSimulation()
+{
+    if (simulatedJobs.isEmpty())
+        return;
+
+    simulationCanceled = true;
+    simulationWatcher.waitForFinished();
+    // The notification of a finished simulation may still be waiting for the event loop, drop it.
+    simulationWatcher.setFuture(QFuture<SimulationResult>());
+    qDeleteAll(simulatedJobs);
+    simulatedJobs.clear();
+    simulationJobs.clear();
+    simulationStates.clear();
+    simulationCanceled = false;
+}
+
+void GreedyScheduler::waitForSimulation()
+{
+    if (simulatedJobs.isEmpty())
+        return;
+    simulationWatcher.waitForFinished();
+    applySimulation();
+}
+
+void GreedyScheduler::startSimulation(const QList<SchedulerJob *> &jobs, const QDateTime &time, const QDateTime &endTime,
+                                      const QMap<QString, uint16_t> *capturedFramesCount)
+{
+    cancelSimulation();
     schedule.clear();
 
-    // Make a deep copy of jobs
+    // Make a deep copy of jobs, the simulation works on these while the jobs stay in the hands of the user.
     QList<SchedulerJob *> copiedJobs;
-    QList<SchedulerJob *> scheduledJobs;
-
     foreach (SchedulerJob *job, jobs)
     {
         SchedulerJob *newJob = new SchedulerJob();
         // Make sure the copied class pointers aren't affected!
         *newJob = *job;
-        // Don't want to affect the UI
-        newJob->setStatusCell(nullptr);
-        newJob->setStartupCell(nullptr);
+        // Don't want to affect the UI, the copies are used from another thread
+        newJob->detachFromUI();
         copiedJobs.append(newJob);
         job->setGreedyCompletionTime(QDateTime());
     }
 
+    // The Moon can only be positioned from here, prepare the nights the simulation will look at.
+    if (!jobs.isEmpty())
+        jobs.first()->prepareEphemeris(time, time.secsTo(endTime) / 3600 + 24);
+
+    QMap<QString, uint16_t> capturedFramesCopy;
+    if (capturedFramesCount != nullptr)
+        capturedFramesCopy = *capturedFramesCount;
+
+    simulatedJobs = copiedJobs;
+    simulationJobs = jobs;
+    recordSimulationStates();
+    simulationWatcher.setFuture(QtConcurrent::run([this, jobs, copiedJobs, time, endTime, capturedFramesCopy]()
+    {
+        return simulate(jobs, copiedJobs, time, endTime, capturedFramesCopy);
+    }));
+}
+
+GreedyScheduler::SimulationResult GreedyScheduler::simulate(const QList<SchedulerJob *> &jobs,
+        const QList<SchedulerJob *> &copiedJobs, const QDateTime &time, const QDateTime &endTime,
+        const QMap<QString, uint16_t> &capturedFramesCount)
+{
+    SimulationResult result;
+    result.jobs.resize(copiedJobs.size());
+
     // The number of jobs we have that can be scheduled,
     // and the number of them where a simulated start has been scheduled.
     int numStartupCandidates = 0, numStartups = 0;
@@ -456,11 +533,8 @@ void GreedyScheduler::simulate(const QList<SchedulerJob *> &jobs, const QDateTim
             numStartupCandidates++;
     }
 
-    QMap<QString, uint16_t> capturedFramesCopy;
-    if (capturedFramesCount != nullptr)
-        capturedFramesCopy = *capturedFramesCount;
     QList<SchedulerJob *>simJobs =
-        prepareJobsForEvaluation(copiedJobs, time, capturedFramesCopy, nullptr, false);
+        prepareJobsForEvaluation(copiedJobs, time, capturedFramesCount, nullptr, false);
 
     QDateTime simTime = time;
     int iterations = 0;
@@ -468,7 +542,7 @@ void GreedyScheduler::simulate(const QList<SchedulerJob *> &jobs, const QDateTim
     for(int i = 0; i < simJobs.size(); ++i)
         workDone[simJobs[i]] = 0.0;
 
-    while (true)
+    while (!simulationCanceled)
     {
         QDateTime jobStartTime;
         QDateTime jobInterruptTime;
@@ -522,7 +596,7 @@ void GreedyScheduler::simulate(const QList<SchedulerJob *> &jobs, const QDateTim
             selectedJob->setGreedyCompletionTime(jobStopTime);
             selectedJob->setStopReason(stopReason);
             selectedJob->setState(SchedulerJob::JOB_SCHEDULED);
-            scheduledJobs.append(selectedJob);
+            result.jobs[copiedJobs.indexOf(selectedJob)].scheduled = true;
         }
 
         // Compute if the simulated job should be considered complete because of work done.
@@ -530,7 +604,7 @@ void GreedyScheduler::simulate(const QList<SchedulerJob *> &jobs, const QDateTim
                 workDone[selectedJob] >= selectedJob->getEstimatedTime())
             selectedJob->setState(SchedulerJob::JOB_COMPLETE);
 
-        schedule.append(JobSchedule(jobs[copiedJobs.indexOf(selectedJob)], jobStartTime, jobStopTime, stopReason));
+        result.schedule.append(JobSchedule(jobs[copiedJobs.indexOf(selectedJob)], jobStartTime, jobStopTime, stopReason));
         simTime = jobStopTime.addSecs(60);
 
         // End the simulation if we've crossed endTime, or no further jobs could be started,
@@ -540,25 +614,80 @@ void GreedyScheduler::simulate(const QList<SchedulerJob *> &jobs, const QDateTim
         if (++iterations > 20) break;
     }
 
+    for (int i = 0; i < copiedJobs.size(); ++i)
+    {
+        result.jobs[i].startupTime = copiedJobs[i]->getStartupTime();
+        result.jobs[i].greedyCompletionTime = copiedJobs[i]->getGreedyCompletionTime();
+        result.jobs[i].stopReason = copiedJobs[i]->getStopReason();
+    }
+    return result;
+}
+
+void GreedyScheduler::applySimulation()
+{
+    // Nothing left to apply if the simulation was canceled or already applied by waitForSimulation()
+    if (simulatedJobs.isEmpty() || !simulationWatcher.future().isFinished())
+        return;
+
+    const SimulationResult result = simulationWatcher.future().result();
+    const QList<SchedulerJob *> jobs = simulationJobs;
+    schedule = result.schedule;
+
     // This simulation has been run using a deep-copy of the jobs list, so as not to interfere with
     // some of their stored data. However, we do wish to update several fields of the "real" scheduleJobs.
-    // Note that the original jobs list and "copiedJobs" should be in the same order..
+    // Note that the original jobs list and the results should be in the same order.
+    // The scheduler may have started, aborted or completed jobs in the meantime, those are not ours to update.
+    QList<SchedulerJob *> untouchedJobs;
     for (int i = 0; i < jobs.size(); ++i)
     {
-        if (scheduledJobs.indexOf(copiedJobs[i]) >= 0)
+        if (jobs[i]->getState() != simulationStates[i].first || jobs[i]->getStateTime() != simulationStates[i].second)
+            continue;
+        untouchedJobs.append(jobs[i]);
+        if (result.jobs[i].scheduled)
         {
             jobs[i]->setState(SchedulerJob::JOB_SCHEDULED);
-            jobs[i]->setStartupTime(copiedJobs[i]->getStartupTime());
+            jobs[i]->setStartupTime(result.jobs[i].startupTime);
             // Can't set the standard completionTime as it affects getEstimatedTime()
-            jobs[i]->setGreedyCompletionTime(copiedJobs[i]->getGreedyCompletionTime());
-            jobs[i]->setStopReason(copiedJobs[i]->getStopReason());
+            jobs[i]->setGreedyCompletionTime(result.jobs[i].greedyCompletionTime);
+            jobs[i]->setStopReason(result.jobs[i].stopReason);
         }
     }
     // This should go after above loop. unsetEvaluation calls setState() which clears
     // certain fields from the state for IDLE states.
-    unsetEvaluation(jobs);
+    unsetEvaluation(untouchedJobs);
 
-    return;
+    qDeleteAll(simulatedJobs);
+    simulatedJobs.clear();
+    simulationJobs.clear();
+    simulationStates.clear();
+    simulationWatcher.setFuture(QFuture<SimulationResult>());
+
+    if (!simulationScheduler.isNull())
+    {
+        if (!schedule.empty())
+        {
+            // Print in reverse order ?! The log window at the bottom of the screen
+            // prints "upside down" -- most recent on top -- and I believe that view
+            // is more important than the log file (where we can invert when debugging).
+            for (int i = schedule.size() - 1; i >= 0; i--)
+                simulationScheduler->appendLogText(GreedyScheduler::jobScheduleString(schedule[i]));
+            simulationScheduler->appendLogText(QString("Greedy Scheduler plan for the next 48 hours starting %1 (%2)s:")
+                                               .arg(simulationStart.toString()).arg(simulationTimer.elapsed() / 1000.0));
+        }
+        else simulationScheduler->appendLogText(QString("Greedy Scheduler: empty plan (%1s)").arg(
+                    simulationTimer.elapsed() / 1000.0));
+    }
+
+    for (auto job : jobs)
+        job->updateJobCells();
+    emit scheduleUpdated();
+}
+
+void GreedyScheduler::recordSimulationStates()
+{
+    simulationStates.clear();
+    for (auto job : simulationJobs)
+        simulationStates.append(qMakePair(job->getState(), job->getStateTime()));
 }
 
 void GreedyScheduler::unsetEvaluation(const QList<SchedulerJob *> &jobs)
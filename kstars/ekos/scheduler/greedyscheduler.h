@@ -9,10 +9,16 @@
 #include <QList>
 #include <QMap>
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QPointer>
 #include <QString>
 #include <QVector>
 #include "schedulerjob.h"
 
+#include <atomic>
+
 namespace Ekos
 {
 
@@ -38,6 +44,7 @@ class GreedyScheduler : public QObject
         };
 
         GreedyScheduler();
+        ~GreedyScheduler() override;
         /**
           * @brief setParams Sets parameters, usually stored as KStars Options to the scheduler.
           * @param restartImmediately Aborted jobs should attempt to be restarted right after they were suspended.
@@ -56,6 +63,8 @@ class GreedyScheduler : public QObject
           * @param capturedFramesCount A structure, computed by the scheduler, which keeps track of previous job progress.
           * @param scheduler A pointer to the scheduler object, useful for notifying the user. Can be nullptr.
           * @return returns a possibly sorted list of the same jobs input, but with state and start/end time changes.
+          * @note The job to run next is selected right away. The plan for the next 48 hours is simulated on a worker
+          * thread, scheduleUpdated() is emitted once the jobs have been updated with it.
           */
         QList<SchedulerJob *> scheduleJobs(const QList<SchedulerJob *> &jobs,
                                            const QDateTime &now,
@@ -81,17 +90,29 @@ class GreedyScheduler : public QObject
         }
         /**
           * @brief getSchedule Returns the QList<JobSchedule> computed by scheduleJobs().
+          * Waits for the simulation in progress, if any.
           * @return returns the previously computed schedule.
           */
         const QList<JobSchedule> &getSchedule()
         {
+            waitForSimulation();
             return schedule;
         }
+        /**
+          * @brief cancelSimulation Stops the simulation in progress, if any, and drops its results.
+          * Must be called before the jobs given to scheduleJobs() are edited, moved or deleted.
+          */
+        void cancelSimulation();
+        /**
+          * @brief waitForSimulation Waits for the simulation in progress, if any, and updates the jobs with its results.
+          */
+        void waitForSimulation();
         /**
           * @brief setRescheduleAbortsImmediate sets the rescheduleAbortsImmediate parameter.
           */
         void setRescheduleAbortsImmediate(bool value)
         {
+            cancelSimulation();
             rescheduleAbortsImmediate = value;
         }
         /**
@@ -99,6 +120,7 @@ class GreedyScheduler : public QObject
           */
         void setRescheduleAbortsQueue(bool value)
         {
+            cancelSimulation();
             rescheduleAbortsQueue = value;
         }
         /**
@@ -106,6 +128,7 @@ class GreedyScheduler : public QObject
           */
         void setRescheduleErrors(bool value)
         {
+            cancelSimulation();
             rescheduleErrors = value;
         }
         /**
@@ -113,6 +136,7 @@ class GreedyScheduler : public QObject
           */
         void setAbortDelaySeconds(int value)
         {
+            cancelSimulation();
             abortDelaySeconds = value;
         }
         /**
@@ -120,6 +144,7 @@ class GreedyScheduler : public QObject
           */
         void setErrorDelaySeconds(int value)
         {
+            cancelSimulation();
             errorDelaySeconds = value;
         }
 
@@ -128,7 +153,28 @@ class GreedyScheduler : public QObject
         static void printSchedule(const QList<JobSchedule> &schedule);
         static QString jobScheduleString(const JobSchedule &jobSchedule);
 
+    signals:
+        /**
+          * @brief scheduleUpdated Emitted once the simulated plan has been applied to the jobs.
+          */
+        void scheduleUpdated();
+
     private:
+        // What the simulation found for one of the simulated jobs.
+        struct SimulatedJob
+        {
+            bool scheduled { false };
+            QDateTime startupTime;
+            QDateTime greedyCompletionTime;
+            QString stopReason;
+        };
+
+        // Outcome of simulate(), the jobs in the order of the simulated list.
+        struct SimulationResult
+        {
+            QList<JobSchedule> schedule;
+            QVector<SimulatedJob> jobs;
+        };
 
         // Changes the states of the jons on the list, deciding which ones
         // can be scheduled by scheduleJobs().
@@ -153,11 +199,29 @@ class GreedyScheduler : public QObject
                                     QString *interruptReason = nullptr,
                                     const QMap<QString, uint16_t> *capturedFramesCount = nullptr);
 
-        // Simulate the running of the scheduler from time to endTime.
-        // Used to find which jobs will be run in the future.
-        void simulate(const QList<SchedulerJob *> &jobs, const QDateTime &time,
-                      const QDateTime &endTime = QDateTime(),
-                      const QMap<QString, uint16_t> *capturedFramesCount = nullptr);
+        // Computes the next possible start time of each job selectNextJob() may consider.
+        // The searches are independent of each other and run in parallel.
+        QHash<SchedulerJob *, QDateTime> findStartTimes(const QList<SchedulerJob *> &jobs, const QDateTime &now,
+                SchedulerJob *currentJob);
+
+        // Copies the jobs, and simulates them on a worker thread.
+        void startSimulation(const QList<SchedulerJob *> &jobs, const QDateTime &time,
+                             const QDateTime &endTime = QDateTime(),
+                             const QMap<QString, uint16_t> *capturedFramesCount = nullptr);
+
+        // Simulate the running of the scheduler from time to endTime, on copiedJobs.
+        // Used to find which jobs will be run in the future. The schedule refers to jobs, which
+        // are in the same order as copiedJobs but are not touched.
+        SimulationResult simulate(const QList<SchedulerJob *> &jobs, const QList<SchedulerJob *> &copiedJobs,
+                                  const QDateTime &time, const QDateTime &endTime,
+                                  const QMap<QString, uint16_t> &capturedFramesCount);
+
+        // Updates the jobs and the schedule with the results of the finished simulation.
+        // Jobs whose state changed while the simulation ran, e.g. the job the scheduler started, are left as they are.
+        void applySimulation();
+
+        // Remembers the state of the simulated jobs, applySimulation() only updates the jobs still in that state.
+        void recordSimulationStates();
 
         // Error/Abort restart parameters.
         // Defaults don't matter much, will be set by UI.
@@ -171,6 +235,16 @@ class GreedyScheduler : public QObject
         // by getScheduledJob() and getSchedule().
         SchedulerJob *scheduledJob { nullptr };
         QList<JobSchedule> schedule;
+
+        // The simulation in progress, the copies it works on, the jobs it was started for and where to report its plan.
+        QFutureWatcher<SimulationResult> simulationWatcher;
+        std::atomic<bool> simulationCanceled { false };
+        QList<SchedulerJob *> simulatedJobs;
+        QList<SchedulerJob *> simulationJobs;
+        QList<QPair<SchedulerJob::JOBStatus, QDateTime>> simulationStates;
+        QPointer<Scheduler> simulationScheduler;
+        QDateTime simulationStart;
+        QElapsedTimer simulationTimer;
 };
 
 }  // namespace Ekos
@@ -435,6 +435,12 @@ void Scheduler::setupScheduler(const QString &ekosPathStr, const QString &ekosIn
     completionTimeEdit->setDateTime(currentDateTime);
 
     m_GreedyScheduler = new GreedyScheduler();
+    // The plan is simulated in the background, publish it when it is known
+    m_GreedyScheduler->setParent(this);
+    connect(m_GreedyScheduler, &GreedyScheduler::scheduleUpdated, this, [this]()
+    {
+        emit jobsUpdated(getJSONJobs());
+    });
 
     // Set up DBus interfaces
     new SchedulerAdaptor(this);
@@ -1209,6 +1215,8 @@ void Scheduler::saveJob()
         return;
     }
 
+    m_GreedyScheduler->cancelSimulation();
+
     if (nameEdit->text().isEmpty())
     {
         appendLogText(i18n("Warning: Target name is required."));
@@ -1690,6 +1698,8 @@ void Scheduler::moveJobUp()
     if (Options::sortSchedulerJobs())
         return;
 
+    m_GreedyScheduler->cancelSimulation();
+
     int const rowCount = queueTable->rowCount();
     int const currentRow = queueTable->currentRow();
     int const destinationRow = currentRow - 1;
@@ -1728,6 +1738,8 @@ void Scheduler::moveJobDown()
     if (Options::sortSchedulerJobs())
         return;
 
+    m_GreedyScheduler->cancelSimulation();
+
     int const rowCount = queueTable->rowCount();
     int const currentRow = queueTable->currentRow();
     int const destinationRow = currentRow + 1;
@@ -1816,6 +1828,9 @@ void Scheduler::removeJob()
     if (currentRow < 0)
         return;
 
+    /* The plan being simulated refers to the job */
+    m_GreedyScheduler->cancelSimulation();
+
     /* Grab the job currently selected */
     SchedulerJob * const job = jobs.at(currentRow);
     qCDebug(KSTARS_EKOS_SCHEDULER) << QString("Job '%1' at row #%2 is being deleted.").arg(job->getName()).arg(currentRow + 1);
@@ -2356,9 +2371,7 @@ QList<SchedulerJob *> Scheduler::prepareJobsForEvaluation( QList<SchedulerJob *>
     qCInfo(KSTARS_EKOS_SCHEDULER) << "Option to sort jobs based on priority and altitude is" << Options::sortSchedulerJobs();
     if (Options::sortSchedulerJobs())
     {
-        using namespace std::placeholders;
-        std::stable_sort(sortedJobs.begin(), sortedJobs.end(),
-                         std::bind(SchedulerJob::decreasingAltitudeOrder, _1, _2, getLocalTime()));
+        SchedulerJob::sortByDecreasingAltitude(sortedJobs.begin(), sortedJobs.end(), getLocalTime());
         std::stable_sort(sortedJobs.begin(), sortedJobs.end(), SchedulerJob::increasingPriorityOrder);
     }
     return sortedJobs;
@@ -4424,6 +4437,7 @@ void Scheduler::removeAllJobs()
     while (queueTable->rowCount() > 0)
         queueTable->removeRow(0);
 
+    m_GreedyScheduler->cancelSimulation();
     qDeleteAll(jobs);
     jobs.clear();
 }
@@ -6866,10 +6880,8 @@ void Scheduler::sortJobsPerAltitude()
     // Don't reset scheduler jobs startup times before sorting - we need the first job startup time
 
     // Sort by startup time, using the first job time as reference for altitude calculations
-    using namespace std::placeholders;
     QList<SchedulerJob*> sortedJobs = jobs;
-    std::stable_sort(sortedJobs.begin() + 1, sortedJobs.end(),
-                     std::bind(SchedulerJob::decreasingAltitudeOrder, _1, _2, jobs.first()->getStartupTime()));
+    SchedulerJob::sortByDecreasingAltitude(sortedJobs.begin() + 1, sortedJobs.end(), jobs.first()->getStartupTime());
 
     // If order changed, reset and re-evaluate
     if (reorderJobs(sortedJobs))
@@ -7014,6 +7026,7 @@ void Scheduler::startMosaicTool()
             if (KMessageBox::questionYesNo(nullptr,
                                            i18n("Do you want to keep the existing jobs in the mosaic schedule?")) == KMessageBox::No)
             {
+                m_GreedyScheduler->cancelSimulation();
                 qDeleteAll(jobs);
                 jobs.clear();
                 while (queueTable->rowCount() > 0)
@@ -0,0 +1,280 @@
+/*  Ekos Scheduler target ephemeris cache
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "schedulerephemeris.h"
+
+#include "geolocation.h"
+#include "ksmoon.h"
+#include "ksnumbers.h"
+#include "kstarsdatetime.h"
+#include "skypoint.h"
+
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <cmath>
+
+namespace Ekos
+{
+
+namespace
+{
+// The apparent place of a target drifts slowly, it is computed every hour and interpolated
+constexpr int TARGET_STEP_MINUTES = 60;
+// The Moon moves about half a degree per hour, its parallax changes with the sidereal time
+constexpr int MOON_STEP_MINUTES = 10;
+
+// Give up on the oldest timelines past this many, that is a few dozen jobs over a few nights
+constexpr int MAX_TIMELINES = 1000;
+constexpr int MAX_WINDOWS = 16;
+
+// Interpolates between a and b, which are angles modulo period
+double interpolateAngle(double a, double b, double fraction, double period)
+{
+    double delta = b - a;
+    if (delta > period / 2)
+        delta -= period;
+    else if (delta < -period / 2)
+        delta += period;
+
+    double result = a + fraction * delta;
+    if (result >= period)
+        result -= period;
+    else if (result < 0)
+        result += period;
+    return result;
+}
+
+// Reduces hours to [0,24[, meridian being at 0
+double reduceHours(double hours)
+{
+    hours = std::fmod(hours, 24.0);
+    return hours < 0 ? hours + 24.0 : hours;
+}
+}
+
+uint qHash(const SchedulerEphemeris::TimelineKey &key, uint seed)
+{
+    return ::qHash(key.window, seed) ^ ::qHash(key.ra0, seed) ^ ::qHash(key.dec0, seed);
+}
+
+struct SchedulerEphemeris::Window
+{
+    // Julian day of the first sample, UT
+    long double start { 0 };
+    // Local sidereal time of each sample, hours
+    QVector<double> lst;
+    // Apparent topocentric place of the Moon at each sample, empty if no Moon was given
+    QVector<double> moonRA;
+    QVector<double> moonDec;
+    QVector<float> moonAltitude;
+    QVector<float> moonIllumination;
+};
+
+struct SchedulerEphemeris::Timeline
+{
+    QVector<float> altitude;
+    QVector<float> azimuth;
+    QVector<float> hourAngle;
+    // Empty if no Moon was given
+    QVector<float> moonSeparation;
+};
+
+SchedulerEphemeris *SchedulerEphemeris::Instance()
+{
+    static SchedulerEphemeris instance;
+    return &instance;
+}
+
+void SchedulerEphemeris::clear()
+{
+    QMutexLocker locker(&m_Mutex);
+    m_Windows.clear();
+    m_Timelines.clear();
+}
+
+void SchedulerEphemeris::prepare(const GeoLocation *geo, long double fromJD, long double toJD, KSMoon *moon)
+{
+    const double longitude = geo->lng()->Degrees();
+
+    QMutexLocker locker(&m_Mutex);
+    checkLocation(geo);
+    for (qint64 index = std::floor(fromJD + longitude / 360.0); index <= std::floor(toJD + longitude / 360.0); index++)
+        window(index, geo, moon);
+}
+
+SchedulerEphemeris::Sample SchedulerEphemeris::sample(const SkyPoint &target, const GeoLocation *geo, long double jd,
+        KSMoon *moon)
+{
+    // Windows start at local mean noon, julian days start at noon UT
+    const double longitude = geo->lng()->Degrees();
+    const qint64 index = static_cast<qint64>(std::floor(jd + longitude / 360.0));
+    const TimelineKey key { index, target.ra0().Degrees(), target.dec0().Degrees() };
+
+    std::shared_ptr<const Window> w;
+    std::shared_ptr<const Timeline> t;
+    {
+        QMutexLocker locker(&m_Mutex);
+        checkLocation(geo);
+        w = window(index, geo, moon);
+        t = m_Timelines.value(key);
+    }
+
+    // Timelines are computed outside of the lock, other threads keep sampling meanwhile
+    if (t == nullptr || t->moonSeparation.isEmpty() != w->moonRA.isEmpty())
+    {
+        t = computeTimeline(target, w.get(), geo);
+
+        QMutexLocker locker(&m_Mutex);
+        if (m_Windows.value(index) == w)
+        {
+            if (m_Timelines.size() >= MAX_TIMELINES)
+                m_Timelines.clear();
+            m_Timelines.insert(key, t);
+        }
+    }
+
+    const double minutes = static_cast<double>((jd - w->start) * 1440.0L);
+    const int i = qBound(0, static_cast<int>(std::floor(minutes)), SAMPLES - 2);
+    const double fraction = qBound(0.0, minutes - i, 1.0);
+
+    Sample result;
+    result.altitude = t->altitude[i] + fraction * (t->altitude[i + 1] - t->altitude[i]);
+    result.azimuth = interpolateAngle(t->azimuth[i], t->azimuth[i + 1], fraction, 360.0);
+    result.hourAngle = interpolateAngle(t->hourAngle[i], t->hourAngle[i + 1], fraction, 24.0);
+
+    if (moon != nullptr && !t->moonSeparation.isEmpty())
+    {
+        result.moonSeparation = t->moonSeparation[i] + fraction * (t->moonSeparation[i + 1] - t->moonSeparation[i]);
+        result.moonAltitude = w->moonAltitude[i] + fraction * (w->moonAltitude[i + 1] - w->moonAltitude[i]);
+        result.moonIllumination = w->moonIllumination[i] + fraction * (w->moonIllumination[i + 1] - w->moonIllumination[i]);
+    }
+
+    return result;
+}
+
+void SchedulerEphemeris::checkLocation(const GeoLocation *geo)
+{
+    if (geo->lat()->Degrees() != m_Latitude || geo->lng()->Degrees() != m_Longitude)
+    {
+        m_Windows.clear();
+        m_Timelines.clear();
+        m_Latitude = geo->lat()->Degrees();
+        m_Longitude = geo->lng()->Degrees();
+    }
+}
+
+std::shared_ptr<const SchedulerEphemeris::Window> SchedulerEphemeris::window(qint64 index, const GeoLocation *geo,
+        KSMoon *moon)
+{
+    // The Moon is shared with the sky map, it is only positioned from the thread that draws it
+    if (QCoreApplication::instance() != nullptr && QThread::currentThread() != QCoreApplication::instance()->thread())
+        moon = nullptr;
+
+    auto found = m_Windows.constFind(index);
+    if (found != m_Windows.constEnd() && (moon == nullptr || !found.value()->moonRA.isEmpty()))
+        return found.value();
+
+    if (m_Windows.size() >= MAX_WINDOWS)
+    {
+        m_Windows.clear();
+        m_Timelines.clear();
+    }
+
+    auto w = std::make_shared<Window>();
+    w->start = index - geo->lng()->Degrees() / 360.0L;
+
+    w->lst.resize(SAMPLES);
+    for (int i = 0; i < SAMPLES; i++)
+        w->lst[i] = geo->GSTtoLST(KStarsDateTime(w->start + i / 1440.0L).gst()).Hours();
+
+    if (moon != nullptr)
+    {
+        // Place the Moon at coarser steps, then fill the minutes in between
+        const int nodes = (SAMPLES - 1) / MOON_STEP_MINUTES + 1;
+        QVector<double> ra(nodes), dec(nodes), altitude(nodes), illumination(nodes);
+        for (int n = 0; n < nodes; n++)
+        {
+            const long double jd = w->start + n * MOON_STEP_MINUTES / 1440.0L;
+            KSNumbers numbers(jd);
+            CachingDms const LST(w->lst[n * MOON_STEP_MINUTES] * 15.0);
+            moon->updateCoords(&numbers, true, geo->lat(), &LST, true);
+            ra[n] = moon->ra().Degrees();
+            dec[n] = moon->dec().Degrees();
+            altitude[n] = moon->alt().Degrees();
+            illumination[n] = moon->illum() * 100.0;
+        }
+
+        w->moonRA.resize(SAMPLES);
+        w->moonDec.resize(SAMPLES);
+        w->moonAltitude.resize(SAMPLES);
+        w->moonIllumination.resize(SAMPLES);
+        for (int i = 0; i < SAMPLES; i++)
+        {
+            const int n = qMin(i / MOON_STEP_MINUTES, nodes - 2);
+            const double fraction = (i - n * MOON_STEP_MINUTES) / double(MOON_STEP_MINUTES);
+            w->moonRA[i] = interpolateAngle(ra[n], ra[n + 1], fraction, 360.0);
+            w->moonDec[i] = dec[n] + fraction * (dec[n + 1] - dec[n]);
+            w->moonAltitude[i] = altitude[n] + fraction * (altitude[n + 1] - altitude[n]);
+            w->moonIllumination[i] = illumination[n] + fraction * (illumination[n + 1] - illumination[n]);
+        }
+    }
+
+    m_Windows.insert(index, w);
+    return w;
+}
+
+std::shared_ptr<const SchedulerEphemeris::Timeline> SchedulerEphemeris::computeTimeline(const SkyPoint &target,
+        const Window *w, const GeoLocation *geo)
+{
+    // Apparent place of the target every hour
+    const int nodes = (SAMPLES - 1) / TARGET_STEP_MINUTES + 1;
+    QVector<double> ra(nodes), dec(nodes);
+    SkyPoint point;
+    point.setRA0(target.ra0());
+    point.setDec0(target.dec0());
+    for (int n = 0; n < nodes; n++)
+    {
+        KSNumbers numbers(w->start + n * TARGET_STEP_MINUTES / 1440.0L);
+        point.updateCoordsNow(&numbers);
+        ra[n] = point.ra().Degrees();
+        dec[n] = point.dec().Degrees();
+    }
+
+    auto t = std::make_shared<Timeline>();
+    t->altitude.resize(SAMPLES);
+    t->azimuth.resize(SAMPLES);
+    t->hourAngle.resize(SAMPLES);
+    if (!w->moonRA.isEmpty())
+        t->moonSeparation.resize(SAMPLES);
+
+    SkyPoint moonPoint;
+    for (int i = 0; i < SAMPLES; i++)
+    {
+        const int n = qMin(i / TARGET_STEP_MINUTES, nodes - 2);
+        const double fraction = (i - n * TARGET_STEP_MINUTES) / double(TARGET_STEP_MINUTES);
+        point.setRA(interpolateAngle(ra[n], ra[n + 1], fraction, 360.0) / 15.0);
+        point.setDec(dec[n] + fraction * (dec[n + 1] - dec[n]));
+
+        CachingDms const LST(w->lst[i] * 15.0);
+        point.EquatorialToHorizontal(&LST, geo->lat());
+        t->altitude[i] = point.alt().Degrees();
+        t->azimuth[i] = point.az().Degrees();
+        t->hourAngle[i] = reduceHours(w->lst[i] - point.ra().Hours());
+
+        if (!t->moonSeparation.isEmpty())
+        {
+            moonPoint.setRA(w->moonRA[i] / 15.0);
+            moonPoint.setDec(w->moonDec[i]);
+            t->moonSeparation[i] = moonPoint.angularDistanceTo(&point).Degrees();
+        }
+    }
+
+    return t;
+}
+
+}
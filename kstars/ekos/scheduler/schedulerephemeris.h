@@ -0,0 +1,117 @@
+/*  Ekos Scheduler target ephemeris cache
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+
+#include <memory>
+
+class GeoLocation;
+class KSMoon;
+class SkyPoint;
+
+namespace Ekos
+{
+
+/**
+ * @class SchedulerEphemeris
+ * @brief Altitude, azimuth and moon separation timelines of the scheduler targets.
+ *
+ * The scheduler evaluates the constraints of every job minute by minute over the next 24 hours,
+ * many times per scheduling pass. Instead of applying precession, nutation and aberration and
+ * converting to horizontal coordinates at each of these minutes, the targets are sampled once per
+ * observing window (24 hours starting at local mean noon) at a one minute resolution, and the
+ * samples are interpolated in between.
+ *
+ * The timelines only depend on the catalog coordinates of the target and on the geographic
+ * location. Altitude, twilight and moon constraints are applied by SchedulerJob on the samples,
+ * changing them does not invalidate anything. The cache is dropped when the location changes.
+ *
+ * The cache is shared by all the jobs and may be used from several threads.
+ */
+class SchedulerEphemeris
+{
+    public:
+        /** @brief Position of a target at some instant, interpolated from the timeline. */
+        struct Sample
+        {
+            /// Apparent altitude and azimuth, in degrees
+            double altitude { 0 };
+            double azimuth { 0 };
+            /// Local sidereal time minus apparent right ascension, reduced to [0,24[ hours
+            double hourAngle { 0 };
+            /// Angular distance to the Moon, altitude of the Moon in degrees and its illumination in percent.
+            /// Not set if no Moon was given.
+            double moonSeparation { 180 };
+            double moonAltitude { -90 };
+            double moonIllumination { 0 };
+        };
+
+        static SchedulerEphemeris *Instance();
+
+        /**
+         * @brief sample Locate a target at a given instant.
+         * @param target target, only its catalog coordinates are used.
+         * @param geo geographic location of the observatory.
+         * @param jd julian day of the instant, UT.
+         * @param moon the Moon, moon fields of the result are left to their defaults if nullptr.
+         */
+        Sample sample(const SkyPoint &target, const GeoLocation *geo, long double jd, KSMoon *moon = nullptr);
+
+        /**
+         * @brief prepare Compute the windows covering an interval ahead of time.
+         * The Moon is shared with the sky map and only positioned from the main thread. Samples taken from
+         * other threads in windows that were not prepared with the Moon leave the moon fields to their defaults.
+         * @param geo geographic location of the observatory.
+         * @param fromJD first julian day of the interval, UT.
+         * @param toJD last julian day of the interval, UT.
+         * @param moon the Moon, or nullptr.
+         */
+        void prepare(const GeoLocation *geo, long double fromJD, long double toJD, KSMoon *moon);
+
+        /** @brief clear Drop all the timelines. */
+        void clear();
+
+    private:
+        SchedulerEphemeris() = default;
+
+        // One sample per minute of the window, plus the first minute of the next one
+        static constexpr int SAMPLES = 24 * 60 + 1;
+
+        struct Window;
+        struct Timeline;
+
+        struct TimelineKey
+        {
+            qint64 window;
+            double ra0;
+            double dec0;
+
+            bool operator==(const TimelineKey &other) const
+            {
+                return window == other.window && ra0 == other.ra0 && dec0 == other.dec0;
+            }
+        };
+        friend uint qHash(const TimelineKey &key, uint seed);
+
+        // Drops everything if the observatory moved, the mutex must be locked
+        void checkLocation(const GeoLocation *geo);
+        // Finds or computes a window, the mutex must be locked
+        std::shared_ptr<const Window> window(qint64 index, const GeoLocation *geo, KSMoon *moon);
+        static std::shared_ptr<const Timeline> computeTimeline(const SkyPoint &target, const Window *w,
+                const GeoLocation *geo);
+
+        QMutex m_Mutex;
+        double m_Latitude { 0 };
+        double m_Longitude { 0 };
+        QHash<qint64, std::shared_ptr<const Window>> m_Windows;
+        QHash<TimelineKey, std::shared_ptr<const Timeline>> m_Timelines;
+};
+
+}
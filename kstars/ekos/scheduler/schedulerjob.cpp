@@ -13,11 +13,14 @@
 #include "Options.h"
 #include "scheduler.h"
 #include "ksalmanac.h"
+#include "schedulerephemeris.h"
 
 #include <knotification.h>
 
 #include <QTableWidgetItem>
 
+#include <mutex>
+
 #include <ekos_scheduler_debug.h>
 
 #define BAD_SCORE -1000
@@ -25,6 +28,32 @@
 
 bool SchedulerJob::m_UpdateGraphics = true;
 
+namespace
+{
+// Sort with the setting target first, then by decreasing altitude, see SchedulerJob::decreasingAltitudeOrder()
+bool decreasingAltitude(double altA, bool A_is_setting, double altB, bool B_is_setting)
+{
+    if (A_is_setting && !B_is_setting)
+        return true;
+    else if (!A_is_setting && B_is_setting)
+        return false;
+
+    // If both targets rise or set, sort by decreasing altitude, considering a setting target is prioritary
+    return (A_is_setting && B_is_setting) ? altA < altB : altB < altA;
+}
+
+// Whether the target passed the meridian, hours are reduced to [0,24[, meridian being at 0
+bool passedMeridian(const CachingDms &LST, const SkyPoint &target)
+{
+    double offset = LST.Hours() - target.ra().Hours();
+    if (24.0 <= offset)
+        offset -= 24.0;
+    else if (offset < 0.0)
+        offset += 24.0;
+    return 0.0 <= offset && offset < 12.0;
+}
+}
+
 GeoLocation *SchedulerJob::storedGeo = nullptr;
 KStarsDateTime *SchedulerJob::storedLocalTime = nullptr;
 ArtificialHorizon *SchedulerJob::storedHorizon = nullptr;
@@ -912,14 +941,38 @@ bool SchedulerJob::decreasingAltitudeOrder(SchedulerJob const *job1, SchedulerJo
                         findAltitude(job2->getTargetCoords(), when, &B_is_setting) :
                         job2->altitudeAtStartup;
 
-    // Sort with the setting target first
-    if (A_is_setting && !B_is_setting)
-        return true;
-    else if (!A_is_setting && B_is_setting)
-        return false;
+    return decreasingAltitude(altA, A_is_setting, altB, B_is_setting);
+}
 
-    // If both targets rise or set, sort by decreasing altitude, considering a setting target is prioritary
-    return (A_is_setting && B_is_setting) ? altA < altB : altB < altA;
+void SchedulerJob::sortByDecreasingAltitude(QList<SchedulerJob *>::iterator begin, QList<SchedulerJob *>::iterator end,
+        QDateTime const &when)
+{
+    QHash<SchedulerJob const *, int> indexes;
+    QList<SkyPoint> targets;
+    for (auto job = begin; job != end; ++job)
+    {
+        indexes.insert(*job, targets.size());
+        targets.append((*job)->getTargetCoords());
+    }
+
+    QVector<bool> settings(targets.size());
+    QVector<double> altitudes(targets.size());
+    if (when.isValid())
+        altitudes = findAltitudes(targets, when, &settings);
+    else
+    {
+        for (auto job = begin; job != end; ++job)
+        {
+            altitudes[indexes[*job]] = (*job)->altitudeAtStartup;
+            settings[indexes[*job]]  = (*job)->isSettingAtStartup;
+        }
+    }
+
+    std::stable_sort(begin, end, [&](SchedulerJob const * job1, SchedulerJob const * job2)
+    {
+        const int a = indexes[job1], b = indexes[job2];
+        return decreasingAltitude(altitudes[a], settings[a], altitudes[b], settings[b]);
+    });
 }
 
 bool SchedulerJob::increasingStartupTimeOrder(SchedulerJob const *job1, SchedulerJob const *job2)
@@ -945,28 +998,15 @@ bool SchedulerJob::satisfiesAltitudeConstraint(double azimuth, double altitude,
 
 int16_t SchedulerJob::getAltitudeScore(QDateTime const &when, double *altPtr) const
 {
-    // FIXME: block calculating target coordinates at a particular time is duplicated in several places
-
     // Retrieve the argument date/time, or fall back to current time - don't use QDateTime's timezone!
     KStarsDateTime ltWhen(when.isValid() ?
                           Qt::UTC == when.timeSpec() ? getGeo()->UTtoLT(KStarsDateTime(when)) : when :
                           getLocalTime());
 
-    // Create a sky object with the target catalog coordinates
-    SkyPoint const target = getTargetCoords();
-    SkyObject o;
-    o.setRA0(target.ra0());
-    o.setDec0(target.dec0());
-
-    // Update RA/DEC of the target for the current fraction of the day
-    KSNumbers numbers(ltWhen.djd());
-    o.updateCoordsNow(&numbers);
-
-    // Compute local sidereal time for the current fraction of the day, calculate altitude
-    CachingDms const LST = getGeo()->GSTtoLST(getGeo()->LTtoUT(ltWhen).gst());
-    o.EquatorialToHorizontal(&LST, getGeo()->lat());
-    double const altitude = o.alt().Degrees();
-    double const azimuth = o.az().Degrees();
+    // Locate the target at the argument time
+    Ekos::SchedulerEphemeris::Sample const ephemeris = getEphemeris(ltWhen);
+    double const altitude = ephemeris.altitude;
+    double const azimuth = ephemeris.azimuth;
     if (altPtr != nullptr)
         *altPtr = altitude;
 
@@ -988,19 +1028,11 @@ int16_t SchedulerJob::getAltitudeScore(QDateTime const &when, double *altPtr) co
             score = BAD_SCORE;
         // Else if setting and under altitude cutoff, job would end soon after starting, bad score
         // FIXME: half bad score when under altitude cutoff risk getting positive again
-        else
+        else if (ephemeris.hourAngle < 12.0)
         {
-            double offset = LST.Hours() - o.ra().Hours();
-            if (24.0 <= offset)
-                offset -= 24.0;
-            else if (offset < 0.0)
-                offset += 24.0;
-            if (0.0 <= offset && offset < 12.0)
-            {
-                bool const settingAltitudeOK = satisfiesAltitudeConstraint(azimuth, altitude - SETTING_ALTITUDE_CUTOFF);
-                if (!settingAltitudeOK)
-                    score = BAD_SCORE / 2;
-            }
+            bool const settingAltitudeOK = satisfiesAltitudeConstraint(azimuth, altitude - SETTING_ALTITUDE_CUTOFF);
+            if (!settingAltitudeOK)
+                score = BAD_SCORE / 2;
         }
     }
     // If not constrained but below minimum hard altitude, set score to 10% of altitude value
@@ -1026,42 +1058,30 @@ int16_t SchedulerJob::getMoonSeparationScore(QDateTime const &when) const
 {
     if (moon == nullptr) return 100;
 
-    // FIXME: block calculating target coordinates at a particular time is duplicated in several places
-
     // Retrieve the argument date/time, or fall back to current time - don't use QDateTime's timezone!
     KStarsDateTime ltWhen(when.isValid() ?
                           Qt::UTC == when.timeSpec() ? getGeo()->UTtoLT(KStarsDateTime(when)) : when :
                           getLocalTime());
 
-    // Create a sky object with the target catalog coordinates
-    SkyPoint const target = getTargetCoords();
-    SkyObject o;
-    o.setRA0(target.ra0());
-    o.setDec0(target.dec0());
-
-    // Update RA/DEC of the target for the current fraction of the day
-    KSNumbers numbers(ltWhen.djd());
-    o.updateCoordsNow(&numbers);
+    return getMoonSeparationScore(getEphemeris(ltWhen));
+}
 
-    // Update moon
-    //ut = getGeo()->LTtoUT(ltWhen);
-    //KSNumbers ksnum(ut.djd()); // BUG: possibly LT.djd() != UT.djd() because of translation
-    //LST = getGeo()->GSTtoLST(ut.gst());
-    CachingDms LST = getGeo()->GSTtoLST(getGeo()->LTtoUT(ltWhen).gst());
-    moon->updateCoords(&numbers, true, getGeo()->lat(), &LST, true);
+int16_t SchedulerJob::getMoonSeparationScore(const Ekos::SchedulerEphemeris::Sample &ephemeris) const
+{
+    if (moon == nullptr) return 100;
 
-    double const moonAltitude = moon->alt().Degrees();
+    double const moonAltitude = ephemeris.moonAltitude;
 
     // Lunar illumination %
-    double const illum = moon->illum() * 100.0;
+    double const illum = ephemeris.moonIllumination;
 
     // Moon/Sky separation p
-    double const separation = moon->angularDistanceTo(&o).Degrees();
+    double const separation = ephemeris.moonSeparation;
 
     // Zenith distance of the moon
     double const zMoon = (90 - moonAltitude);
     // Zenith distance of target
-    double const zTarget = (90 - o.alt().Degrees());
+    double const zTarget = (90 - ephemeris.altitude);
 
     int16_t score = 0;
 
@@ -1132,22 +1152,11 @@ double SchedulerJob::getCurrentMoonSeparation() const
 QDateTime SchedulerJob::calculateNextTime(QDateTime const &when, bool checkIfConstraintsAreMet, int increment,
         QString *reason, bool runningJob, const QDateTime &until) const
 {
-    // FIXME: block calculating target coordinates at a particular time is duplicated in several places
-
     // Retrieve the argument date/time, or fall back to current time - don't use QDateTime's timezone!
     KStarsDateTime ltWhen(when.isValid() ?
                           Qt::UTC == when.timeSpec() ? getGeo()->UTtoLT(KStarsDateTime(when)) : when :
                           getLocalTime());
 
-    // Create a sky object with the target catalog coordinates
-    SkyPoint const target = getTargetCoords();
-    SkyObject o;
-    o.setRA0(target.ra0());
-    o.setDec0(target.dec0());
-
-    // Calculate the UT at the argument time
-    KStarsDateTime const ut = getGeo()->LTtoUT(ltWhen);
-
     double const SETTING_ALTITUDE_CUTOFF = Options::settingAltitudeCutoff();
 
     auto maxMinute = 1e8;
@@ -1184,15 +1193,10 @@ QDateTime SchedulerJob::calculateNextTime(QDateTime const &when, bool checkIfCon
             }
         }
 
-        // Update RA/DEC of the target for the current fraction of the day
-        KSNumbers numbers(ltOffset.djd());
-        o.updateCoordsNow(&numbers);
-
-        // Compute local sidereal time for the current fraction of the day, calculate altitude
-        CachingDms const LST = getGeo()->GSTtoLST(getGeo()->LTtoUT(ltOffset).gst());
-        o.EquatorialToHorizontal(&LST, getGeo()->lat());
-        double const altitude = o.alt().Degrees();
-        double const azimuth = o.az().Degrees();
+        // Locate the target for the current fraction of the day
+        Ekos::SchedulerEphemeris::Sample const ephemeris = getEphemeris(ltOffset);
+        double const altitude = ephemeris.altitude;
+        double const azimuth = ephemeris.azimuth;
 
         bool const altitudeOK = satisfiesAltitudeConstraint(azimuth, altitude, reason);
         if (altitudeOK)
@@ -1200,7 +1204,7 @@ QDateTime SchedulerJob::calculateNextTime(QDateTime const &when, bool checkIfCon
             // Don't test proximity to dawn in this situation, we only cater for altitude here
 
             // Continue searching if Moon separation is not good enough
-            if (0 < getMinMoonSeparation() && getMoonSeparationScore(ltOffset) < 0)
+            if (0 < getMinMoonSeparation() && getMoonSeparationScore(ephemeris) < 0)
             {
                 if (checkIfConstraintsAreMet)
                     continue;
@@ -1216,12 +1220,7 @@ QDateTime SchedulerJob::calculateNextTime(QDateTime const &when, bool checkIfCon
             {
                 if (!runningJob)
                 {
-                    double offset = LST.Hours() - o.ra().Hours();
-                    if (24.0 <= offset)
-                        offset -= 24.0;
-                    else if (offset < 0.0)
-                        offset += 24.0;
-                    if (0.0 <= offset && offset < 12.0)
+                    if (ephemeris.hourAngle < 12.0)
                     {
                         bool const settingAltitudeOK = satisfiesAltitudeConstraint(azimuth, altitude - SETTING_ALTITUDE_CUTOFF);
                         if (!settingAltitudeOK)
@@ -1289,15 +1288,56 @@ QDateTime SchedulerJob::calculateCulmination(QDateTime const &when) const
     return Qt::UTC == observationDateTime.timeSpec() ? getGeo()->UTtoLT(observationDateTime) : observationDateTime;
 }
 
-double SchedulerJob::findAltitude(const SkyPoint &target, const QDateTime &when, bool * is_setting, bool debug)
+void SchedulerJob::prepareEphemeris(const QDateTime &from, int hours) const
 {
-    // FIXME: block calculating target coordinates at a particular time is duplicated in several places
+    KStarsDateTime const ltFrom(from.isValid() ?
+                                Qt::UTC == from.timeSpec() ? getGeo()->UTtoLT(KStarsDateTime(from)) : from :
+                                getLocalTime());
+    long double const jd = getGeo()->LTtoUT(ltFrom).djd();
+    Ekos::SchedulerEphemeris::Instance()->prepare(getGeo(), jd, jd + hours / 24.0L, moon);
+}
+
+void SchedulerJob::detachFromUI()
+{
+    nameCell = nullptr;
+    nameLabel = nullptr;
+    statusCell = nullptr;
+    stageCell = nullptr;
+    stageLabel = nullptr;
+    altitudeCell = nullptr;
+    startupCell = nullptr;
+    completionCell = nullptr;
+    estimatedTimeCell = nullptr;
+    captureCountCell = nullptr;
+    scoreCell = nullptr;
+    leadTimeCell = nullptr;
+}
+
+Ekos::SchedulerEphemeris::Sample SchedulerJob::getEphemeris(const KStarsDateTime &ltWhen) const
+{
+    return Ekos::SchedulerEphemeris::Instance()->sample(getTargetCoords(), getGeo(), getGeo()->LTtoUT(ltWhen).djd(), moon);
+}
 
+double SchedulerJob::findAltitude(const SkyPoint &target, const QDateTime &when, bool * is_setting, bool debug)
+{
     // Retrieve the argument date/time, or fall back to current time - don't use QDateTime's timezone!
     KStarsDateTime ltWhen(when.isValid() ?
                           Qt::UTC == when.timeSpec() ? getGeo()->UTtoLT(KStarsDateTime(when)) : when :
                           getLocalTime());
 
+    if (!debug)
+    {
+        Ekos::SchedulerEphemeris::Sample const ephemeris =
+            Ekos::SchedulerEphemeris::Instance()->sample(target, getGeo(), getGeo()->LTtoUT(ltWhen).djd());
+
+        if (is_setting)
+            *is_setting = ephemeris.hourAngle < 12.0;
+
+        return ephemeris.altitude;
+    }
+
+    // The debug output details the exact computation
+
     // Create a sky object with the target catalog coordinates
     SkyObject o;
     o.setRA0(target.ra0());
@@ -1311,13 +1351,7 @@ double SchedulerJob::findAltitude(const SkyPoint &target, const QDateTime &when,
     CachingDms const LST = getGeo()->GSTtoLST(getGeo()->LTtoUT(ltWhen).gst());
     o.EquatorialToHorizontal(&LST, getGeo()->lat());
 
-    // Hours are reduced to [0,24[, meridian being at 0
-    double offset = LST.Hours() - o.ra().Hours();
-    if (24.0 <= offset)
-        offset -= 24.0;
-    else if (offset < 0.0)
-        offset += 24.0;
-    bool const passed_meridian = 0.0 <= offset && offset < 12.0;
+    bool const passed_meridian = passedMeridian(LST, o);
 
     if (debug)
         qCDebug(KSTARS_EKOS_SCHEDULER) << QString("When:%9 LST:%8 RA:%1 RA0:%2 DEC:%3 DEC0:%4 alt:%5 setting:%6 HA:%7")
@@ -1337,6 +1371,31 @@ double SchedulerJob::findAltitude(const SkyPoint &target, const QDateTime &when,
     return o.alt().Degrees();
 }
 
+QVector<double> SchedulerJob::findAltitudes(const QList<SkyPoint> &targets, const QDateTime &when, QVector<bool> *is_setting)
+{
+    // Retrieve the argument date/time, or fall back to current time - don't use QDateTime's timezone!
+    KStarsDateTime ltWhen(when.isValid() ?
+                          Qt::UTC == when.timeSpec() ? getGeo()->UTtoLT(KStarsDateTime(when)) : when :
+                          getLocalTime());
+
+    // The time-dependent values are the same for all the targets, convert the time once
+    long double const jd = getGeo()->LTtoUT(ltWhen).djd();
+
+    QVector<double> altitudes;
+    altitudes.reserve(targets.size());
+    if (is_setting)
+        is_setting->resize(targets.size());
+    for (int i = 0; i < targets.size(); i++)
+    {
+        Ekos::SchedulerEphemeris::Sample const ephemeris = Ekos::SchedulerEphemeris::Instance()->sample(targets[i], getGeo(), jd);
+        altitudes.append(ephemeris.altitude);
+        if (is_setting)
+            (*is_setting)[i] = ephemeris.hourAngle < 12.0;
+    }
+
+    return altitudes;
+}
+
 void SchedulerJob::calculateDawnDusk(QDateTime const &when, QDateTime &nDawn, QDateTime &nDusk)
 {
     QDateTime startup = when;
@@ -1368,6 +1427,8 @@ void SchedulerJob::calculateDawnDusk(QDateTime const &when, QDateTime &nDawn, QD
 #else
         // Creating these almanac instances seems expensive.
         static QMap<QString, KSAlmanac const * > almanacMap;
+        static std::mutex almanacMutex;
+        const std::lock_guard<std::mutex> lock(almanacMutex);
         const QString key = QString("%1 %2 %3").arg(midnight.toString()).arg(getGeo()->lat()->Degrees()).arg(
                                 getGeo()->lng()->Degrees());
         KSAlmanac const * ksal = almanacMap.value(key, nullptr);
@@ -1410,15 +1471,12 @@ bool SchedulerJob::runsDuringAstronomicalNightTime(const QDateTime &time,
     // now, it's not nighttime in 10 minutes). So, cache the answer and return it if the next
     // call is for a time between this time and the next dawn/dusk (whichever is sooner).
 
-    static QDateTime previousMinDawnDusk, previousTime;
-    static GeoLocation const *previousGeo = nullptr;  // A dangling pointer, I suppose, but we never reference it.
-    static bool previousAnswer;
-    static double previousPreDawnTime = 0;
-    static QDateTime nextSuccess;
-
-    // Lock this method because of all the statics
-    static std::mutex nightTimeMutex;
-    const std::lock_guard<std::mutex> lock(nightTimeMutex);
+    // The cache is per thread, so that jobs evaluated in parallel don't keep invalidating each other's answers.
+    thread_local QDateTime previousMinDawnDusk, previousTime;
+    thread_local GeoLocation const *previousGeo = nullptr;  // A dangling pointer, I suppose, but we never reference it.
+    thread_local bool previousAnswer;
+    thread_local double previousPreDawnTime = 0;
+    thread_local QDateTime nextSuccess;
 
     // We likely can rely on the previous calculations.
     if (previousTime.isValid() && previousMinDawnDusk.isValid() &&
@@ -12,6 +12,7 @@
 #include <QMap>
 #include "ksmoon.h"
 #include "kstarsdatetime.h"
+#include "schedulerephemeris.h"
 #include <QJsonObject>
 
 class ArtificialHorizon;
@@ -566,6 +567,14 @@ class SchedulerJob
          */
         static bool decreasingAltitudeOrder(SchedulerJob const *a, SchedulerJob const *b, QDateTime const &when = QDateTime());
 
+        /** @brief Stable sort of ::SchedulerJob instances with decreasingAltitudeOrder().
+         * @arg begin, end is the range of jobs to sort.
+         * @arg when is the date/time to use to calculate the altitude to sort with, see decreasingAltitudeOrder().
+         * @note The altitudes of all the jobs are computed once, in one batch, instead of twice per comparison.
+         */
+        static void sortByDecreasingAltitude(QList<SchedulerJob *>::iterator begin, QList<SchedulerJob *>::iterator end,
+                                             QDateTime const &when);
+
         /** @brief Compare ::SchedulerJob instances based on startup time.
          * @todo This is a qSort predicate, deprecated in QT5.
          * @arg a, b are ::SchedulerJob instances to compare.
@@ -660,6 +669,17 @@ class SchedulerJob
              */
         static double findAltitude(const SkyPoint &target, const QDateTime &when, bool *is_setting = nullptr, bool debug = false);
 
+        /**
+             * @brief findAltitudes Find altitudes of several targets given a specific time
+             * @param targets Targets
+             * @param when date time to find altitudes
+             * @param is_setting whether each target is setting at the argument time (optional).
+             * @return Altitudes of the targets at the specific date and time given, in the order of targets.
+             * @warning This function uses the current KStars geolocation.
+             */
+        static QVector<double> findAltitudes(const QList<SkyPoint> &targets, const QDateTime &when,
+                                             QVector<bool> *is_setting = nullptr);
+
         /**
              * @brief satisfiesAltitudeConstraint sees if altitude is allowed for this job at the given azimuth.
              * @param azimuth Azimuth
@@ -694,7 +714,30 @@ class SchedulerJob
         {
             startTimeCache.clear();
         }
+
+        /**
+             * @brief prepareEphemeris Compute the target timelines shared by all jobs ahead of time, see SchedulerEphemeris::prepare().
+             * @param from local date and time to start from, now if invalid.
+             * @param hours length of the interval to prepare.
+             * @note Must be called from the main thread for the Moon constraints to be evaluated on other threads.
+             */
+        void prepareEphemeris(const QDateTime &from, int hours) const;
+
+        /**
+             * @brief detachFromUI Forget the table cells and labels of the job.
+             * Copies of a job used for simulations must not update the queue table, they may live on another thread.
+             */
+        void detachFromUI();
     private:
+        /**
+             * @brief getEphemeris Locate the target of this job, from the timelines shared by all jobs.
+             * @param ltWhen local date and time.
+             */
+        Ekos::SchedulerEphemeris::Sample getEphemeris(const KStarsDateTime &ltWhen) const;
+
+        /** @brief getMoonSeparationScore Moon separation score of an ephemeris sample of the target. */
+        int16_t getMoonSeparationScore(const Ekos::SchedulerEphemeris::Sample &ephemeris) const;
+
         bool runsDuringAstronomicalNightTimeInternal(const QDateTime &time, QDateTime *minDawnDusk,
                 QDateTime *nextPossibleSuccess = nullptr) const;
 
@@ -0,0 +1,162 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "fitsbufferpool.h"
+
+#include <QMutexLocker>
+
+#include <cstdlib>
+#include <new>
+
+FITSBufferPool *FITSBufferPool::m_Instance = nullptr;
+
+FITSBufferPool *FITSBufferPool::Instance()
+{
+    static QMutex instanceMutex;
+    QMutexLocker locker(&instanceMutex);
+    if (m_Instance == nullptr)
+        m_Instance = new FITSBufferPool();
+    return m_Instance;
+}
+
+FITSBufferPool::~FITSBufferPool()
+{
+    clear();
+}
+
+uint8_t *FITSBufferPool::acquire(size_t size, bool *reused)
+{
+    {
+        QMutexLocker locker(&m_Mutex);
+        for (int i = m_Idle.size() - 1; i >= 0; i--)
+        {
+            if (m_Idle[i].second != size)
+                continue;
+
+            uint8_t *buffer = m_Idle.takeAt(i).first;
+            m_Outstanding.insert(buffer, size);
+            m_Counters.reuses++;
+            m_Counters.reusedBytes += size;
+            if (reused)
+                *reused = true;
+            return buffer;
+        }
+    }
+
+    // Allocate outside of the lock, this is the slow path.
+    uint8_t *buffer = new uint8_t[size];
+
+    QMutexLocker locker(&m_Mutex);
+    m_Outstanding.insert(buffer, size);
+    m_Counters.allocations++;
+    m_Counters.allocatedBytes += size;
+    if (reused)
+        *reused = false;
+    return buffer;
+}
+
+void FITSBufferPool::release(uint8_t *buffer)
+{
+    if (buffer == nullptr)
+        return;
+
+    uint8_t *evicted = buffer;
+    {
+        QMutexLocker locker(&m_Mutex);
+        auto it = m_Outstanding.find(buffer);
+        if (it != m_Outstanding.end())
+        {
+            m_Idle.append(qMakePair(buffer, it.value()));
+            m_Outstanding.erase(it);
+            // Drop the oldest buffer, it most likely belongs to a geometry that is no longer used.
+            evicted = m_Idle.size() > maxIdleBuffers ? m_Idle.takeFirst().first : nullptr;
+        }
+    }
+
+    delete[] evicted;
+}
+
+uint8_t *FITSBufferPool::acquirePackBuffer(size_t &capacity, bool *reused)
+{
+    {
+        QMutexLocker locker(&m_Mutex);
+        if (!m_IdlePack.isEmpty())
+        {
+            PackBuffer pack = m_IdlePack.takeLast();
+            // Grow it right away rather than letting cfitsio do so in 100 KB steps.
+            if (pack.capacity < capacity)
+            {
+                uint8_t *grown = static_cast<uint8_t *>(realloc(pack.data, capacity));
+                if (grown == nullptr)
+                {
+                    free(pack.data);
+                    return nullptr;
+                }
+                pack.data = grown;
+                pack.capacity = capacity;
+            }
+            capacity = pack.capacity;
+            m_Counters.reuses++;
+            m_Counters.reusedBytes += capacity;
+            if (reused)
+                *reused = true;
+            return pack.data;
+        }
+    }
+
+    uint8_t *buffer = static_cast<uint8_t *>(malloc(capacity));
+    if (buffer == nullptr)
+        return nullptr;
+
+    QMutexLocker locker(&m_Mutex);
+    m_Counters.allocations++;
+    m_Counters.allocatedBytes += capacity;
+    if (reused)
+        *reused = false;
+    return buffer;
+}
+
+void FITSBufferPool::releasePackBuffer(uint8_t *buffer, size_t capacity)
+{
+    if (buffer == nullptr)
+        return;
+
+    uint8_t *evicted = buffer;
+    {
+        QMutexLocker locker(&m_Mutex);
+        m_LastPackCapacity = capacity;
+        if (m_IdlePack.isEmpty())
+        {
+            m_IdlePack.append({buffer, capacity});
+            evicted = nullptr;
+        }
+    }
+
+    free(evicted);
+}
+
+size_t FITSBufferPool::lastPackCapacity() const
+{
+    QMutexLocker locker(&m_Mutex);
+    return m_LastPackCapacity;
+}
+
+FITSBufferPool::Counters FITSBufferPool::counters() const
+{
+    QMutexLocker locker(&m_Mutex);
+    return m_Counters;
+}
+
+void FITSBufferPool::clear()
+{
+    QMutexLocker locker(&m_Mutex);
+    for (auto &idle : m_Idle)
+        delete[] idle.first;
+    m_Idle.clear();
+    for (auto &pack : m_IdlePack)
+        free(pack.data);
+    m_IdlePack.clear();
+}
@@ -0,0 +1,95 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class FITSBufferPool
+ * Recycles the large buffers FITSData decodes frames into.
+ *
+ * A camera streaming frames of the same geometry allocates, fills and frees an identically sized
+ * image buffer for every frame, and compressed frames additionally go through an unpack buffer
+ * that cfitsio grows 100 KB at a time with realloc. The pool keeps a couple of released buffers
+ * around so that the next frame of the same size reuses them instead of going back to the heap.
+ *
+ * Image buffers are plain new[] arrays, release() accepts buffers that were not handed out by the
+ * pool and simply deletes them. Unpack buffers are malloc'ed since cfitsio reallocs them.
+ * All methods are thread safe.
+ */
+class FITSBufferPool
+{
+    public:
+        static FITSBufferPool *Instance();
+
+        struct Counters
+        {
+            // Buffers that had to be allocated from the heap.
+            uint64_t allocations { 0 };
+            uint64_t allocatedBytes { 0 };
+            // Buffers that were recycled from a previous frame.
+            uint64_t reuses { 0 };
+            uint64_t reusedBytes { 0 };
+        };
+
+        /**
+         * @brief acquire Get an image buffer of exactly size bytes, with undefined content.
+         * @param reused if not null, set to whether the buffer was recycled.
+         * @throws std::bad_alloc like new[] if the buffer cannot be allocated.
+         */
+        uint8_t *acquire(size_t size, bool *reused = nullptr);
+        /** @brief release Give back a buffer obtained from acquire(), or delete[] any other buffer. */
+        void release(uint8_t *buffer);
+
+        /**
+         * @brief acquirePackBuffer Get a malloc'ed buffer for fpack decompression.
+         * @param capacity in: the expected unpacked size, out: the actual capacity of the buffer,
+         * which may be larger when a buffer is recycled.
+         * @param reused if not null, set to whether the buffer was recycled.
+         * @return the buffer or nullptr if out of memory.
+         */
+        uint8_t *acquirePackBuffer(size_t &capacity, bool *reused = nullptr);
+        /** @brief releasePackBuffer Give back a malloc'ed buffer of the given capacity, or free it. */
+        void releasePackBuffer(uint8_t *buffer, size_t capacity);
+
+        /** @brief lastPackCapacity Capacity of the last unpack buffer released, a hint for the next frame. */
+        size_t lastPackCapacity() const;
+
+        Counters counters() const;
+        /** @brief clear Free all idle buffers. */
+        void clear();
+
+    private:
+        FITSBufferPool() = default;
+        ~FITSBufferPool();
+
+        static FITSBufferPool *m_Instance;
+
+        struct PackBuffer
+        {
+            uint8_t *data { nullptr };
+            size_t capacity { 0 };
+        };
+
+        // Two idle buffers are enough to cover the viewer holding on to the previous frame while the
+        // next one is decoded.
+        static constexpr int maxIdleBuffers { 2 };
+
+        mutable QMutex m_Mutex;
+        // Size of every buffer handed out by acquire() and not yet released.
+        QHash<uint8_t *, size_t> m_Outstanding;
+        // Released buffers, most recent last.
+        QList<QPair<uint8_t *, size_t>> m_Idle;
+        QList<PackBuffer> m_IdlePack;
+        size_t m_LastPackCapacity { 0 };
+        Counters m_Counters;
+};
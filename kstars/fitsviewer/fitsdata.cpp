@@ -13,6 +13,8 @@
 #include "fitsgradientdetector.h"
 #include "fitscentroiddetector.h"
 #include "fitssepdetector.h"
+#include "fitsstatskernel.h"
+#include "fitsbufferpool.h"
 
 #include "fpack.h"
 
@@ -27,6 +29,7 @@
 #include <QApplication>
 #include <QImage>
 #include <QtConcurrent>
+#include <QThread>
 #include <QImageReader>
 
 #if !defined(KSTARS_LITE) && defined(HAVE_WCSLIB)
@@ -38,6 +41,7 @@
 #include <libraw/libraw.h>
 #endif
 
+#include <algorithm>
 #include <cfloat>
 #include <cmath>
 
@@ -85,7 +89,8 @@ FITSData::FITSData(const QSharedPointer<FITSData> &other)
     this->m_Mode = other->m_Mode;
     this->m_Statistics.channels = other->m_Statistics.channels;
     memcpy(&m_Statistics, &(other->m_Statistics), sizeof(m_Statistics));
-    m_ImageBuffer = new uint8_t[m_Statistics.samples_per_channel * m_Statistics.channels * m_Statistics.bytesPerPixel];
+    m_ImageBufferSize = m_Statistics.samples_per_channel * m_Statistics.channels * m_Statistics.bytesPerPixel;
+    m_ImageBuffer = FITSBufferPool::Instance()->acquire(m_ImageBufferSize);
     memcpy(m_ImageBuffer, other->m_ImageBuffer,
            m_Statistics.samples_per_channel * m_Statistics.channels * m_Statistics.bytesPerPixel);
 }
@@ -120,8 +125,7 @@ FITSData::~FITSData()
     {
         fits_flush_file(fptr, &status);
         fits_close_file(fptr, &status);
-        free(m_PackBuffer);
-        m_PackBuffer = nullptr;
+        releasePackBuffer();
         fptr = nullptr;
     }
 }
@@ -136,8 +140,7 @@ void FITSData::loadCommon(const QString &inFilename)
     {
         fits_flush_file(fptr, &status);
         fits_close_file(fptr, &status);
-        free(m_PackBuffer);
-        m_PackBuffer = nullptr;
+        releasePackBuffer();
         fptr = nullptr;
     }
 
@@ -195,6 +198,8 @@ bool FITSData::loadFITSImage(const QByteArray &buffer, const QString &extension,
     long naxes[3];
 
     m_HistogramConstructed = false;
+    m_LoadCounters = LoadCounters();
+    m_LoadCounters.inputBytes = buffer.size();
 
     if (extension.contains(".fz") || isCompressed)
     {
@@ -218,30 +223,38 @@ bool FITSData::loadFITSImage(const QByteArray &buffer, const QString &extension,
         }
         else
         {
-            size_t m_PackBufferSize = 100000;
-            free(m_PackBuffer);
-            m_PackBuffer = (uint8_t *)malloc(m_PackBufferSize);
-            rc = fp_unpack_data_to_data(buffer.data(), buffer.size(), &m_PackBuffer, &m_PackBufferSize, fpvar) == 0;
+            // Start from the capacity the previous frame needed, or twice the compressed size for the first one,
+            // as cfitsio would otherwise grow the buffer by reallocating it 100 KB at a time.
+            releasePackBuffer();
+            m_PackBufferCapacity = std::max<size_t>(FITSBufferPool::Instance()->lastPackCapacity(), 2 * buffer.size());
+            m_PackBuffer = FITSBufferPool::Instance()->acquirePackBuffer(m_PackBufferCapacity,
+                           &m_LoadCounters.packBufferReused);
+            if (m_PackBuffer == nullptr)
+            {
+                m_LastError = i18n("Failed to allocate memory to unpack compressed fits");
+                qCCritical(KSTARS_FITS) << m_LastError;
+                return false;
+            }
+            rc = fp_unpack_data_to_data(buffer.data(), buffer.size(), &m_PackBuffer, &m_PackBufferCapacity, fpvar) == 0;
 
             if (rc)
             {
                 void *data = reinterpret_cast<void *>(m_PackBuffer);
-                if (fits_open_memfile(&fptr, m_Filename.toLocal8Bit().data(), READONLY, &data, &m_PackBufferSize, 0,
+                if (fits_open_memfile(&fptr, m_Filename.toLocal8Bit().data(), READONLY, &data, &m_PackBufferCapacity, 0,
                                       nullptr, &status))
                 {
                     m_LastError = i18n("Error reading fits buffer: %1.", fitsErrorToString(status));
                     return false;
                 }
 
-                m_Statistics.size = m_PackBufferSize;
+                m_Statistics.size = m_PackBufferCapacity;
             }
             //rc = fp_unpack_data_to_fits(buffer.data(), buffer.size(), &fptr, fpvar) == 0;
         }
 
         if (rc == false)
         {
-            free(m_PackBuffer);
-            m_PackBuffer = nullptr;
+            releasePackBuffer();
             m_LastError = i18n("Failed to unpack compressed fits");
             qCCritical(KSTARS_FITS) << m_LastError;
             return false;
@@ -250,6 +263,7 @@ bool FITSData::loadFITSImage(const QByteArray &buffer, const QString &extension,
         m_isTemporary = true;
         m_isCompressed = true;
         m_Statistics.size = fptr->Fptr->logfilesize;
+        m_LoadCounters.unpackedBytes = m_Statistics.size;
 
     }
     else if (buffer.isEmpty())
@@ -281,15 +295,13 @@ bool FITSData::loadFITSImage(const QByteArray &buffer, const QString &extension,
     if (fits_movabs_hdu(fptr, 1, IMAGE_HDU, &status))
     {
 
-        free(m_PackBuffer);
-        m_PackBuffer = nullptr;
+        releasePackBuffer();
         m_LastError = i18n("Could not locate image HDU: %1", fitsErrorToString(status));
     }
 
     if (fits_get_img_param(fptr, 3, &m_FITSBITPIX, &(m_Statistics.ndim), naxes, &status))
     {
-        free(m_PackBuffer);
-        m_PackBuffer = nullptr;
+        releasePackBuffer();
         m_LastError = i18n("FITS file open error (fits_get_img_param): %1", fitsErrorToString(status));
         return false;
     }
@@ -306,8 +318,7 @@ bool FITSData::loadFITSImage(const QByteArray &buffer, const QString &extension,
     {
         m_LastError = i18n("1D FITS images are not supported in KStars.");
         qCCritical(KSTARS_FITS) << m_LastError;
-        free(m_PackBuffer);
-        m_PackBuffer = nullptr;
+        releasePackBuffer();
         return false;
     }
 
@@ -362,8 +373,7 @@ bool FITSData::loadFITSImage(const QByteArray &buffer, const QString &extension,
     {
         m_LastError = i18n("Image has invalid dimensions %1x%2", naxes[0], naxes[1]);
         qCCritical(KSTARS_FITS) << m_LastError;
-        free(m_PackBuffer);
-        m_PackBuffer = nullptr;
+        releasePackBuffer();
         return false;
     }
 
@@ -387,14 +397,16 @@ bool FITSData::loadFITSImage(const QByteArray &buffer, const QString &extension,
         m_Statistics.channels = 1;
 
     m_ImageBufferSize = m_Statistics.samples_per_channel * m_Statistics.channels * m_Statistics.bytesPerPixel;
-    m_ImageBuffer = new uint8_t[m_ImageBufferSize];
-    if (m_ImageBuffer == nullptr)
+    try
+    {
+        m_ImageBuffer = FITSBufferPool::Instance()->acquire(m_ImageBufferSize, &m_LoadCounters.imageBufferReused);
+    }
+    catch (const std::bad_alloc &)
     {
         qCWarning(KSTARS_FITS) << "FITSData: Not enough memory for image_buffer channel. Requested: "
                                << m_ImageBufferSize << " bytes.";
         clearImageBuffers();
-        free(m_PackBuffer);
-        m_PackBuffer = nullptr;
+        releasePackBuffer();
         return false;
     }
 
@@ -408,6 +420,7 @@ bool FITSData::loadFITSImage(const QByteArray &buffer, const QString &extension,
         m_LastError = i18n("Error reading image: %1", fitsErrorToString(status));
         return false;
     }
+    m_LoadCounters.decodedBytes = m_ImageBufferSize;
 
     parseHeader();
 
@@ -525,7 +538,7 @@ bool FITSData::loadCanonicalImage(const QByteArray &buffer, const QString &exten
     clearImageBuffers();
     m_ImageBufferSize = m_Statistics.samples_per_channel * m_Statistics.channels * static_cast<uint16_t>
                         (m_Statistics.bytesPerPixel);
-    m_ImageBuffer = new uint8_t[m_ImageBufferSize];
+    m_ImageBuffer = FITSBufferPool::Instance()->acquire(m_ImageBufferSize);
     if (m_ImageBuffer == nullptr)
     {
         m_LastError = i18n("FITSData: Not enough memory for image_buffer channel. Requested: %1 bytes ", m_ImageBufferSize);
@@ -640,7 +653,7 @@ bool FITSData::loadRAWImage(const QByteArray &buffer, const QString &extension)
     m_Statistics.samples_per_channel = m_Statistics.width * m_Statistics.height;
     clearImageBuffers();
     m_ImageBufferSize = m_Statistics.samples_per_channel * m_Statistics.channels * m_Statistics.bytesPerPixel;
-    m_ImageBuffer = new uint8_t[m_ImageBufferSize];
+    m_ImageBuffer = FITSBufferPool::Instance()->acquire(m_ImageBufferSize);
     if (m_ImageBuffer == nullptr)
     {
         m_LastError = i18n("FITSData: Not enough memory for image_buffer channel. Requested: %1 bytes ", m_ImageBufferSize);
@@ -984,9 +997,16 @@ bool FITSData::saveImage(const QString &newFilename)
     return true;
 }
 
+void FITSData::releasePackBuffer()
+{
+    FITSBufferPool::Instance()->releasePackBuffer(m_PackBuffer, m_PackBufferCapacity);
+    m_PackBuffer = nullptr;
+    m_PackBufferCapacity = 0;
+}
+
 void FITSData::clearImageBuffers()
 {
-    delete[] m_ImageBuffer;
+    FITSBufferPool::Instance()->release(m_ImageBuffer);
     m_ImageBuffer = nullptr;
     if(m_ImageRoiBuffer != nullptr )
     {
@@ -1033,554 +1053,221 @@ void FITSData::makeRoiBuffer(QRect roi)
 }
 void FITSData::calculateStats(bool refresh, bool roi)
 {
-    // Calculate min max
-    if(roi == false)
-    {
-        calculateMinMax(refresh);
-        calculateMedian(refresh);
-
-        // Try to read mean/median/stddev if in file
-        if (refresh == false && fptr)
-        {
-            int status = 0;
-            int nfound = 0;
-            if (fits_read_key_dbl(fptr, "MEAN1", &m_Statistics.mean[0], nullptr, &status) == 0)
-                nfound++;
-            // NB. These could fail if missing, which is OK.
-            fits_read_key_dbl(fptr, "MEAN2", & m_Statistics.mean[1], nullptr, &status);
-            fits_read_key_dbl(fptr, "MEAN3", &m_Statistics.mean[2], nullptr, &status);
-
-            status = 0;
-            if (fits_read_key_dbl(fptr, "STDDEV1", &m_Statistics.stddev[0], nullptr, &status) == 0)
-                nfound++;
-            // NB. These could fail if missing, which is OK.
-            fits_read_key_dbl(fptr, "STDDEV2", &m_Statistics.stddev[1], nullptr, &status);
-            fits_read_key_dbl(fptr, "STDDEV3", &m_Statistics.stddev[2], nullptr, &status);
-
-            // If all is OK, we're done
-            if (nfound == 2)
-                return;
-        }
-
-        // Get standard deviation and mean in one run
-        switch (m_Statistics.dataType)
-        {
-            case TBYTE:
-                runningAverageStdDev<uint8_t>();
-                break;
-
-            case TSHORT:
-                runningAverageStdDev<int16_t>();
-                break;
+    FITSImage::Statistic &stats = roi ? m_ROIStatistics : m_Statistics;
 
-            case TUSHORT:
-                runningAverageStdDev<uint16_t>();
-                break;
-
-            case TLONG:
-                runningAverageStdDev<int32_t>();
-                break;
-
-            case TULONG:
-                runningAverageStdDev<uint32_t>();
-                break;
-
-            case TFLOAT:
-                runningAverageStdDev<float>();
-                break;
-
-            case TLONGLONG:
-                runningAverageStdDev<int64_t>();
-                break;
+    bool haveMinMax = false, haveMedian = false, haveMeanStdDev = false;
 
-            case TDOUBLE:
-                runningAverageStdDev<double>();
-                break;
+    // Try to read min/max/median/mean/stddev if in file
+    if (roi == false && refresh == false && fptr)
+        readStatisticsFromHeader(haveMinMax, haveMedian, haveMeanStdDev);
 
-            default:
-                return;
-        }
+    // If all is OK, we're done
+    if (haveMinMax && haveMedian && haveMeanStdDev)
+        return;
 
-        // FIXME That's not really SNR, must implement a proper solution for this value
-        m_Statistics.SNR = m_Statistics.mean[0] / m_Statistics.stddev[0];
-    }
-    else
+    // Compute whatever is missing in a single pass over the data
+    FITSImage::Statistic result = stats;
+    switch (stats.dataType)
     {
-        calculateMinMax(refresh, roi);
-        calculateMedian(refresh, roi);
-
-        switch (m_ROIStatistics.dataType)
-        {
-            case TBYTE:
-                runningAverageStdDev<uint8_t>(roi);
-                break;
+        case TBYTE:
+            calculateStatsInternal<uint8_t>(result, roi, !haveMedian);
+            break;
 
-            case TSHORT:
-                runningAverageStdDev<int16_t>(roi);
-                break;
+        case TSHORT:
+            calculateStatsInternal<int16_t>(result, roi, !haveMedian);
+            break;
 
-            case TUSHORT:
-                runningAverageStdDev<uint16_t>(roi);
-                break;
+        case TUSHORT:
+            calculateStatsInternal<uint16_t>(result, roi, !haveMedian);
+            break;
 
-            case TLONG:
-                runningAverageStdDev<int32_t>(roi);
-                break;
+        case TLONG:
+            calculateStatsInternal<int32_t>(result, roi, !haveMedian);
+            break;
 
-            case TULONG:
-                runningAverageStdDev<uint32_t>(roi);
-                break;
+        case TULONG:
+            calculateStatsInternal<uint32_t>(result, roi, !haveMedian);
+            break;
 
-            case TFLOAT:
-                runningAverageStdDev<float>(roi);
-                break;
+        case TFLOAT:
+            calculateStatsInternal<float>(result, roi, !haveMedian);
+            break;
 
-            case TLONGLONG:
-                runningAverageStdDev<int64_t>(roi);
-                break;
+        case TLONGLONG:
+            calculateStatsInternal<int64_t>(result, roi, !haveMedian);
+            break;
 
-            case TDOUBLE:
-                runningAverageStdDev<double>(roi);
-                break;
+        case TDOUBLE:
+            calculateStatsInternal<double>(result, roi, !haveMedian);
+            break;
 
-            default:
-                return;
-        }
+        default:
+            return;
     }
-}
 
-void FITSData::calculateMinMax(bool refresh, bool roi)
-{
-    if(roi == false)
+    for (int n = 0; n < 3; n++)
     {
-        int status, nfound = 0;
-
-        status = 0;
-
-        // Only fetch from header if we have a single channel
-        // Otherwise, calculate manually.
-        if (fptr != nullptr && !refresh)
+        if (!haveMinMax)
         {
-
-            status = 0;
-
-            if (fits_read_key_dbl(fptr, "DATAMIN", &(m_Statistics.min[0]), nullptr, &status) == 0)
-                nfound++;
-            else if (fits_read_key_dbl(fptr, "MIN1", &(m_Statistics.min[0]), nullptr, &status) == 0)
-                nfound++;
-
-            // NB. These could fail if missing, which is OK.
-            fits_read_key_dbl(fptr, "MIN2", &m_Statistics.min[1], nullptr, &status);
-            fits_read_key_dbl(fptr, "MIN3", &m_Statistics.min[2], nullptr, &status);
-
-            status = 0;
-
-            if (fits_read_key_dbl(fptr, "DATAMAX", &(m_Statistics.max[0]), nullptr, &status) == 0)
-                nfound++;
-            else if (fits_read_key_dbl(fptr, "MAX1", &(m_Statistics.max[0]), nullptr, &status) == 0)
-                nfound++;
-
-            // NB. These could fail if missing, which is OK.
-            fits_read_key_dbl(fptr, "MAX2", &m_Statistics.max[1], nullptr, &status);
-            fits_read_key_dbl(fptr, "MAX3", &m_Statistics.max[2], nullptr, &status);
-
-            // If we found both keywords, no need to calculate them, unless they are both zeros
-            if (nfound == 2 && !(m_Statistics.min[0] == 0 && m_Statistics.max[0] == 0))
-                return;
+            stats.min[n] = result.min[n];
+            stats.max[n] = result.max[n];
         }
-
-        m_Statistics.min[0] = 1.0E30;
-        m_Statistics.max[0] = -1.0E30;
-
-        m_Statistics.min[1] = 1.0E30;
-        m_Statistics.max[1] = -1.0E30;
-
-        m_Statistics.min[2] = 1.0E30;
-        m_Statistics.max[2] = -1.0E30;
-
-        switch (m_Statistics.dataType)
+        if (!haveMedian)
+            stats.median[n] = result.median[n];
+        if (!haveMeanStdDev)
         {
-            case TBYTE:
-                calculateMinMax<uint8_t>();
-                break;
-
-            case TSHORT:
-                calculateMinMax<int16_t>();
-                break;
-
-            case TUSHORT:
-                calculateMinMax<uint16_t>();
-                break;
-
-            case TLONG:
-                calculateMinMax<int32_t>();
-                break;
-
-            case TULONG:
-                calculateMinMax<uint32_t>();
-                break;
-
-            case TFLOAT:
-                calculateMinMax<float>();
-                break;
-
-            case TLONGLONG:
-                calculateMinMax<int64_t>();
-                break;
-
-            case TDOUBLE:
-                calculateMinMax<double>();
-                break;
-
-            default:
-                break;
+            stats.mean[n] = result.mean[n];
+            stats.stddev[n] = result.stddev[n];
         }
     }
-    else
-    {
-        m_ROIStatistics.min[0] = 1.0E30;
-        m_ROIStatistics.max[0] = -1.0E30;
-
-        m_ROIStatistics.min[1] = 1.0E30;
-        m_ROIStatistics.max[1] = -1.0E30;
-
-        m_ROIStatistics.min[2] = 1.0E30;
-        m_ROIStatistics.max[2] = -1.0E30;
-
-        switch (m_Statistics.dataType)
-        {
-            case TBYTE:
-                calculateMinMax<uint8_t>(roi);
-                break;
-
-            case TSHORT:
-                calculateMinMax<int16_t>(roi);
-                break;
-
-            case TUSHORT:
-                calculateMinMax<uint16_t>(roi);
-                break;
-
-            case TLONG:
-                calculateMinMax<int32_t>(roi);
-                break;
 
-            case TULONG:
-                calculateMinMax<uint32_t>(roi);
-                break;
-
-            case TFLOAT:
-                calculateMinMax<float>(roi);
-                break;
-
-            case TLONGLONG:
-                calculateMinMax<int64_t>(roi);
-                break;
-
-            case TDOUBLE:
-                calculateMinMax<double>(roi);
-                break;
-
-            default:
-                break;
-        }
-
-    }
+    // FIXME That's not really SNR, must implement a proper solution for this value
+    if (!roi && !haveMeanStdDev)
+        m_Statistics.SNR = m_Statistics.mean[0] / m_Statistics.stddev[0];
 }
 
-void FITSData::calculateMedian(bool refresh, bool roi)
+void FITSData::readStatisticsFromHeader(bool &haveMinMax, bool &haveMedian, bool &haveMeanStdDev)
 {
-    if(!roi)
-    {
-        int status, nfound = 0;
-
-        status = 0;
-
-        // Only fetch from header if we have a single channel
-        // Otherwise, calculate manually.
-        if (fptr != nullptr && !refresh)
-        {
-            status = 0;
-            if (fits_read_key_dbl(fptr, "MEDIAN1", &m_Statistics.median[0], nullptr, &status) == 0)
-                nfound++;
-
-            // NB. These could fail if missing, which is OK.
-            fits_read_key_dbl(fptr, "MEDIAN2", &m_Statistics.median[1], nullptr, &status);
-            fits_read_key_dbl(fptr, "MEDIAN3", &m_Statistics.median[2], nullptr, &status);
-
-            if (nfound == 1)
-                return;
-        }
-
-        m_Statistics.median[RED_CHANNEL] = 0;
-        m_Statistics.median[GREEN_CHANNEL] = 0;
-        m_Statistics.median[BLUE_CHANNEL] = 0;
-
-        switch (m_Statistics.dataType)
-        {
-            case TBYTE:
-                calculateMedian<uint8_t>();
-                break;
-
-            case TSHORT:
-                calculateMedian<int16_t>();
-                break;
-
-            case TUSHORT:
-                calculateMedian<uint16_t>();
-                break;
-
-            case TLONG:
-                calculateMedian<int32_t>();
-                break;
-
-            case TULONG:
-                calculateMedian<uint32_t>();
-                break;
-
-            case TFLOAT:
-                calculateMedian<float>();
-                break;
-
-            case TLONGLONG:
-                calculateMedian<int64_t>();
-                break;
-
-            case TDOUBLE:
-                calculateMedian<double>();
-                break;
-
-            default:
-                break;
-        }
-    }
-    else
-    {
-        m_ROIStatistics.median[RED_CHANNEL] = 0;
-        m_ROIStatistics.median[GREEN_CHANNEL] = 0;
-        m_ROIStatistics.median[BLUE_CHANNEL] = 0;
+    int status = 0, nfound = 0;
 
-        switch (m_ROIStatistics.dataType)
-        {
-            case TBYTE:
-                calculateMedian<uint8_t>(roi);
-                break;
+    if (fits_read_key_dbl(fptr, "DATAMIN", &(m_Statistics.min[0]), nullptr, &status) == 0)
+        nfound++;
+    else if (fits_read_key_dbl(fptr, "MIN1", &(m_Statistics.min[0]), nullptr, &status) == 0)
+        nfound++;
 
-            case TSHORT:
-                calculateMedian<int16_t>(roi);
-                break;
+    // NB. These could fail if missing, which is OK.
+    fits_read_key_dbl(fptr, "MIN2", &m_Statistics.min[1], nullptr, &status);
+    fits_read_key_dbl(fptr, "MIN3", &m_Statistics.min[2], nullptr, &status);
 
-            case TUSHORT:
-                calculateMedian<uint16_t>(roi);
-                break;
+    status = 0;
 
-            case TLONG:
-                calculateMedian<int32_t>(roi);
-                break;
+    if (fits_read_key_dbl(fptr, "DATAMAX", &(m_Statistics.max[0]), nullptr, &status) == 0)
+        nfound++;
+    else if (fits_read_key_dbl(fptr, "MAX1", &(m_Statistics.max[0]), nullptr, &status) == 0)
+        nfound++;
 
-            case TULONG:
-                calculateMedian<uint32_t>(roi);
-                break;
+    // NB. These could fail if missing, which is OK.
+    fits_read_key_dbl(fptr, "MAX2", &m_Statistics.max[1], nullptr, &status);
+    fits_read_key_dbl(fptr, "MAX3", &m_Statistics.max[2], nullptr, &status);
 
-            case TFLOAT:
-                calculateMedian<float>(roi);
-                break;
+    // If we found both keywords, no need to calculate them, unless they are both zeros
+    haveMinMax = (nfound == 2 && !(m_Statistics.min[0] == 0 && m_Statistics.max[0] == 0));
 
-            case TLONGLONG:
-                calculateMedian<int64_t>(roi);
-                break;
-
-            case TDOUBLE:
-                calculateMedian<double>(roi);
-                break;
+    status = 0;
+    haveMedian = (fits_read_key_dbl(fptr, "MEDIAN1", &m_Statistics.median[0], nullptr, &status) == 0);
 
-            default:
-                break;
-        }
+    // NB. These could fail if missing, which is OK.
+    fits_read_key_dbl(fptr, "MEDIAN2", &m_Statistics.median[1], nullptr, &status);
+    fits_read_key_dbl(fptr, "MEDIAN3", &m_Statistics.median[2], nullptr, &status);
 
-    }
-}
+    status = 0;
+    nfound = 0;
+    if (fits_read_key_dbl(fptr, "MEAN1", &m_Statistics.mean[0], nullptr, &status) == 0)
+        nfound++;
+    // NB. These could fail if missing, which is OK.
+    fits_read_key_dbl(fptr, "MEAN2", & m_Statistics.mean[1], nullptr, &status);
+    fits_read_key_dbl(fptr, "MEAN3", &m_Statistics.mean[2], nullptr, &status);
 
-template <typename T>
-void FITSData::calculateMedian(bool roi)
-{
-    auto * buffer = reinterpret_cast<T *>(roi ? m_ImageRoiBuffer : m_ImageBuffer);
-    const uint32_t maxMedianSize = 500000;
-    uint32_t medianSize = roi ? m_ROIStatistics.samples_per_channel : m_Statistics.samples_per_channel;
-    uint8_t downsample = 1;
-    if (medianSize > maxMedianSize)
-    {
-        downsample = (static_cast<double>(medianSize) / maxMedianSize) + 0.999;
-        medianSize /= downsample;
-    }
-    std::vector<T> samples;
-    samples.reserve(medianSize);
+    status = 0;
+    if (fits_read_key_dbl(fptr, "STDDEV1", &m_Statistics.stddev[0], nullptr, &status) == 0)
+        nfound++;
+    // NB. These could fail if missing, which is OK.
+    fits_read_key_dbl(fptr, "STDDEV2", &m_Statistics.stddev[1], nullptr, &status);
+    fits_read_key_dbl(fptr, "STDDEV3", &m_Statistics.stddev[2], nullptr, &status);
 
-    for (uint8_t n = 0; n < m_Statistics.channels; n++)
-    {
-        auto *oneChannel = buffer + n * (roi ? m_ROIStatistics.samples_per_channel : m_Statistics.samples_per_channel);
-        for (uint32_t upto = 0; upto < (roi ? m_ROIStatistics.samples_per_channel : m_Statistics.samples_per_channel);
-                upto += downsample)
-            samples.push_back(oneChannel[upto]);
-        const uint32_t middle = samples.size() / 2;
-        std::nth_element(samples.begin(), samples.begin() + middle, samples.end());
-        roi ? m_ROIStatistics.median[n] = samples[middle] : m_Statistics.median[n] = samples[middle];
-    }
+    haveMeanStdDev = (nfound == 2);
 }
 
 template <typename T>
-QPair<T, T> FITSData::getParitionMinMax(uint32_t start, uint32_t stride, bool roi)
+void FITSData::calculateStatsInternal(FITSImage::Statistic &result, bool roi, bool withMedian)
 {
-    auto * buffer = reinterpret_cast<T *>(roi ? m_ImageRoiBuffer : m_ImageBuffer);
-    T min = std::numeric_limits<T>::max();
-    T max = std::numeric_limits<T>::min();
+    auto * const buffer = reinterpret_cast<T const *>(roi ? m_ImageRoiBuffer : m_ImageBuffer);
+    const uint32_t samples = roi ? m_ROIStatistics.samples_per_channel : m_Statistics.samples_per_channel;
+    constexpr uint32_t bins = FITSStatsKernel::histogramBins<T>();
+    constexpr int32_t offset = FITSStatsKernel::histogramOffset<T>();
 
-    uint32_t end = start + stride;
+    // One partition per core, but large enough to amortize the dispatch and, for 8/16 bit data,
+    // the merge of the per-partition histograms.
+    const uint32_t minPartitionSize = bins > 0 ? 16 * bins : 65536;
+    const uint32_t nPartitions = qBound<uint32_t>(1, samples / minPartitionSize, QThread::idealThreadCount());
+    const uint32_t stride = samples / nPartitions;
 
-    for (uint32_t i = start; i < end; i++)
+    for (int n = 0; n < 3; n++)
     {
-        min = qMin(buffer[i], min);
-        max = qMax(buffer[i], max);
-        //        if (buffer[i] < min)
-        //            min = buffer[i];
-        //        else if (buffer[i] > max)
-        //            max = buffer[i];
+        result.min[n] = 1.0E30;
+        result.max[n] = -1.0E30;
+        result.median[n] = 0;
     }
 
-    return qMakePair(min, max);
-}
-
-template <typename T>
-void FITSData::calculateMinMax(bool roi)
-{
-    T min = std::numeric_limits<T>::max();
-    T max = std::numeric_limits<T>::min();
-
-
-    // Create N threads
-    const uint8_t nThreads = 16;
-
     for (int n = 0; n < m_Statistics.channels; n++)
     {
-        uint32_t cStart = n * (roi ? m_ROIStatistics.samples_per_channel : m_Statistics.samples_per_channel);
+        T const * const channel = buffer + n * samples;
 
-        // Calculate how many elements we process per thread
-        uint32_t tStride = (roi ? m_ROIStatistics.samples_per_channel : m_Statistics.samples_per_channel) / nThreads;
+        std::vector<std::vector<uint32_t>> histograms(bins > 0 ? nPartitions : 0);
+        QList<QFuture<FITSStatsKernel::Partial>> futures;
 
-        // Calculate the final stride since we can have some left over due to division above
-        uint32_t fStride = tStride + ((roi ? m_ROIStatistics.samples_per_channel : m_Statistics.samples_per_channel) -
-                                      (tStride * nThreads));
+        for (uint32_t i = 0; i < nPartitions; i++)
+        {
+            T const * const start = channel + i * stride;
+            // The last partition picks up the remainder of the division above
+            const uint32_t count = (i == nPartitions - 1) ? samples - i * stride : stride;
 
-        // Start location for inspecting elements
-        uint32_t tStart = cStart;
+            if constexpr (bins > 0)
+            {
+                histograms[i].assign(bins, 0);
+                uint32_t *histogram = histograms[i].data();
+                futures.append(QtConcurrent::run([start, count, histogram]()
+                {
+                    return FITSStatsKernel::accumulate(start, count, histogram);
+                }));
+            }
+            else
+            {
+                futures.append(QtConcurrent::run([start, count]()
+                {
+                    return FITSStatsKernel::accumulate(start, count);
+                }));
+            }
+        }
 
-        // List of futures
-        QList<QFuture<QPair<T, T>>> futures;
+        FITSStatsKernel::Partial total;
+        for (auto &future : futures)
+            total.merge(future.result());
 
-        for (int i = 0; i < nThreads; i++)
+        if constexpr (bins > 0)
         {
-            // Run threads
-            futures.append(QtConcurrent::run(this, &FITSData::getParitionMinMax<T>, tStart, (i == (nThreads - 1)) ? fStride : tStride,
-                                             roi));
-            tStart += tStride;
-        }
+            for (uint32_t i = 1; i < nPartitions; i++)
+            {
+                for (uint32_t bin = 0; bin < bins; bin++)
+                    histograms[0][bin] += histograms[i][bin];
+            }
 
-        // Now wait for results
-        for (int i = 0; i < nThreads; i++)
-        {
-            QPair<T, T> result = futures[i].result();
-            min = qMin(result.first, min);
-            max = qMax(result.second, max);
+            total = FITSStatsKernel::fromHistogram(histograms[0].data(), bins, offset);
+            if (withMedian)
+                result.median[n] = FITSStatsKernel::histogramMedian(histograms[0].data(), bins, offset, total.count);
         }
+        else if (withMedian)
+            result.median[n] = FITSStatsKernel::sampledMedian(channel, samples);
 
-        if(!roi)
-        {
-            m_Statistics.min[n] = min;
-            m_Statistics.max[n] = max;
-        }
-        else
+        if (total.count > 0)
         {
-            m_ROIStatistics.min[n] = min;
-            m_ROIStatistics.max[n] = max;
+            result.min[n] = total.min;
+            result.max[n] = total.max;
         }
+        result.mean[n] = total.mean();
+        result.stddev[n] = total.stddev();
     }
-
 }
 
 template <typename T>
-QPair<double, double> FITSData::getSquaredSumAndMean(uint32_t start, uint32_t stride, bool roi)
+void FITSData::calculateMeanStdDev()
 {
-    uint32_t m_n       = 2;
-    double m_oldM = 0, m_newM = 0, m_oldS = 0, m_newS = 0;
-
-    auto * buffer = reinterpret_cast<T *>(roi ? m_ImageRoiBuffer : m_ImageBuffer);
-    uint32_t end = start + stride;
-
-    for (uint32_t i = start; i < end; i++)
-    {
-        m_newM = m_oldM + (buffer[i] - m_oldM) / m_n;
-        m_newS = m_oldS + (buffer[i] - m_oldM) * (buffer[i] - m_newM);
-
-        m_oldM = m_newM;
-        m_oldS = m_newS;
-        m_n++;
-    }
-
-    return qMakePair<double, double>(m_newM, m_newS);
-}
-
-template <typename T>
-void FITSData::runningAverageStdDev(bool roi )
-{
-    // Create N threads
-    const uint8_t nThreads = 16;
-
+    FITSImage::Statistic result = m_Statistics;
+    calculateStatsInternal<T>(result, false, false);
     for (int n = 0; n < m_Statistics.channels; n++)
     {
-        uint32_t cStart = n * (roi ? m_ROIStatistics.samples_per_channel : m_Statistics.samples_per_channel);
-
-        // Calculate how many elements we process per thread
-        uint32_t tStride = (roi ? m_ROIStatistics.samples_per_channel : m_Statistics.samples_per_channel) / nThreads;
-
-        // Calculate the final stride since we can have some left over due to division above
-        uint32_t fStride = tStride + ((roi ? m_ROIStatistics.samples_per_channel : m_Statistics.samples_per_channel) -
-                                      (tStride * nThreads));
-
-        // Start location for inspecting elements
-        uint32_t tStart = cStart;
-
-        // List of futures
-        QList<QFuture<QPair<double, double>>> futures;
-
-        for (int i = 0; i < nThreads; i++)
-        {
-            // Run threads
-            futures.append(QtConcurrent::run(this, &FITSData::getSquaredSumAndMean<T>, tStart,
-                                             (i == (nThreads - 1)) ? fStride : tStride, roi));
-            tStart += tStride;
-        }
-
-        double mean = 0, squared_sum = 0;
-
-        // Now wait for results
-        for (int i = 0; i < nThreads; i++)
-        {
-            QPair<double, double> result = futures[i].result();
-            mean += result.first;
-            squared_sum += result.second;
-        }
-
-        double variance = squared_sum / (roi ? m_ROIStatistics.samples_per_channel : m_Statistics.samples_per_channel);
-        if(!roi)
-        {
-            m_Statistics.mean[n]   = mean / nThreads;
-            m_Statistics.stddev[n] = sqrt(variance);
-        }
-        else
-        {
-            m_ROIStatistics.mean[n] = mean / nThreads;
-            m_ROIStatistics.stddev[n] = sqrt(variance);
-        }
+        m_Statistics.mean[n] = result.mean[n];
+        m_Statistics.stddev[n] = result.stddev[n];
     }
 }
 
@@ -2386,8 +2073,7 @@ void FITSData::applyFilter(FITSScale type, uint8_t * targetImage, QVector<double
                     m_Statistics.max[i] = max[i];
                 }
                 //if (type != FITS_AUTO && type != FITS_LINEAR)
-                runningAverageStdDev<T>();
-                //QtConcurrent::run(this, &FITSData::runningAverageStdDev<T>);
+                calculateMeanStdDev<T>();
             }
         }
         break;
@@ -2491,7 +2177,7 @@ void FITSData::applyFilter(FITSScale type, uint8_t * targetImage, QVector<double
             delete[] extension;
 
             if (calcStats)
-                runningAverageStdDev<T>();
+                calculateMeanStdDev<T>();
         }
         break;
 
@@ -2974,7 +2660,7 @@ bool FITSData::rotFITS(int rotate, int mirror)
     int BBP = m_Statistics.bytesPerPixel;
 
     /* Allocate buffer for rotated image */
-    rotimage = new uint8_t[m_Statistics.samples_per_channel * m_Statistics.channels * BBP];
+    rotimage = FITSBufferPool::Instance()->acquire(m_Statistics.samples_per_channel * m_Statistics.channels * BBP);
 
     if (rotimage == nullptr)
     {
@@ -3197,7 +2883,7 @@ bool FITSData::rotFITS(int rotate, int mirror)
         }
     }
 
-    delete[] m_ImageBuffer;
+    FITSBufferPool::Instance()->release(m_ImageBuffer);
     m_ImageBuffer = rotimage;
 
     return true;
@@ -3498,7 +3184,7 @@ uint8_t const * FITSData::getImageBuffer() const
 
 void FITSData::setImageBuffer(uint8_t * buffer)
 {
-    delete[] m_ImageBuffer;
+    FITSBufferPool::Instance()->release(m_ImageBuffer);
     m_ImageBuffer = buffer;
 }
 
@@ -3683,10 +3369,10 @@ bool FITSData::debayer_8bit()
 
     if (m_ImageBufferSize != rgb_size)
     {
-        delete[] m_ImageBuffer;
+        FITSBufferPool::Instance()->release(m_ImageBuffer);
         try
         {
-            m_ImageBuffer = new uint8_t[rgb_size];
+            m_ImageBuffer = FITSBufferPool::Instance()->acquire(rgb_size);
         }
         catch (const std::bad_alloc &e)
         {
@@ -3775,10 +3461,10 @@ bool FITSData::debayer_16bit()
 
     if (m_ImageBufferSize != rgb_size)
     {
-        delete[] m_ImageBuffer;
+        FITSBufferPool::Instance()->release(m_ImageBuffer);
         try
         {
-            m_ImageBuffer = new uint8_t[rgb_size];
+            m_ImageBuffer = FITSBufferPool::Instance()->acquire(rgb_size);
         }
         catch (const std::bad_alloc &e)
         {
@@ -117,6 +117,27 @@ class FITSData : public QObject
          */
         bool loadFromBuffer(const QByteArray &buffer, const QString &extension, const QString &inFilename = QString());
 
+        /**
+         * @brief The LoadCounters struct accounts for the memory traffic of the last load, to keep an eye on
+         * the bandwidth spent per frame when streaming large frames at high rates.
+         */
+        struct LoadCounters
+        {
+            /// Size of the FITS or fpacked input.
+            size_t inputBytes { 0 };
+            /// Bytes written by fpack decompression, 0 if the input was not compressed.
+            size_t unpackedBytes { 0 };
+            /// Bytes written to the image buffer when decoding the pixels.
+            size_t decodedBytes { 0 };
+            /// Whether the image and unpack buffers were recycled from a previous frame.
+            bool imageBufferReused { false };
+            bool packBufferReused { false };
+        };
+        const LoadCounters &loadCounters() const
+        {
+            return m_LoadCounters;
+        }
+
         /**
          * @brief parseSolution Parse the WCS solution information from the header into the given struct.
          * @param solution Solution structure to fill out.
@@ -586,8 +607,8 @@ class FITSData : public QObject
         bool loadRAWImage(const QByteArray &buffer, const QString &extension);
 
         void rotWCSFITS(int angle, int mirror);
-        void calculateMinMax(bool refresh = false, bool roi = false);
-        void calculateMedian(bool refresh = false, bool roi = false);
+        // Read MIN/MAX/MEDIAN/MEAN/STDDEV keywords, reporting which groups were found.
+        void readStatisticsFromHeader(bool &haveMinMax, bool &haveMedian, bool &haveMeanStdDev);
         bool checkDebayer();
         void readWCSKeys();
 
@@ -610,13 +631,12 @@ class FITSData : public QObject
         template <typename T>
         void applyFilter(FITSScale type, uint8_t *targetImage, QVector<double> * min = nullptr, QVector<double> * max = nullptr);
 
+        /* Calculate min, max, mean, stddev and median of all channels in a single pass, see FITSStatsKernel */
         template <typename T>
-        void calculateMinMax(bool roi = false);
+        void calculateStatsInternal(FITSImage::Statistic &result, bool roi = false, bool withMedian = true);
+        /* Refresh only mean and standard deviation, e.g. after a filter clamped the data */
         template <typename T>
-        void calculateMedian(bool roi = false);
-
-        template <typename T>
-        QPair<T, T> getParitionMinMax(uint32_t start, uint32_t stride, bool roi);
+        void calculateMeanStdDev();
 
         /* Calculate the Gaussian blur matrix and apply it to the image using the convolution filter */
         QVector<double> createGaussianKernel(int size, double sigma);
@@ -625,12 +645,6 @@ class FITSData : public QObject
         template <typename T>
         void gaussianBlur(int kernelSize, double sigma);
 
-        /* Calculate running average & standard deviation using Welford’s method for computing variance */
-        template <typename T>
-        void runningAverageStdDev( bool roi = false );
-        template <typename T>
-        QPair<double, double> getSquaredSumAndMean(uint32_t start, uint32_t stride, bool roi = false);
-
         template <typename T>
         void convertToQImage(double dataMin, double dataMax, double scale, double zero, QImage &image);
 
@@ -641,6 +655,9 @@ class FITSData : public QObject
         ////////////////////////////////////////////////////////////////////////////////////////
         template <typename T>  void constructHistogramInternal();
 
+        /// Return the fpack buffer to the pool once cfitsio no longer reads from it.
+        void releasePackBuffer();
+
         /// Pointer to CFITSIO FITS file struct
         fitsfile *fptr { nullptr };
         /// Generic data image buffer
@@ -667,6 +684,10 @@ class FITSData : public QObject
         bool HasDebayer { false };
         /// Buffer to hold fpack uncompressed data
         uint8_t *m_PackBuffer {nullptr};
+        /// Above buffer allocated size in bytes
+        size_t m_PackBufferCapacity { 0 };
+        /// Memory traffic of the last load
+        LoadCounters m_LoadCounters;
 
         /// Our very own file name
         QString m_Filename, m_compressedFilename;
@@ -18,6 +18,10 @@
 
 #include <memory>
 #include <math.h>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
 #include <QPointer>
 #include <QtConcurrent>
 
@@ -72,59 +76,8 @@ bool FITSSEPDetector::findSourcesAndBackground(QRect const &boundary)
     Ekos::ProfileGroup group = static_cast<Ekos::ProfileGroup>(getValue("optionsProfileGroup", 1).toInt());
     QScopedPointer<StellarSolver, QScopedPointerDeleteLater> solver(new StellarSolver(m_ImageData->getStatistics(),
             m_ImageData->getImageBuffer()));
-    QString filename = "";
     QPointer<FITSData> image(m_ImageData);
-    switch(group)
-    {
-        case Ekos::AlignProfiles:
-            //So it should not be here if it is Align.
-            break;
-        case Ekos::GuideProfiles:
-            filename = "SavedGuideProfiles.ini";
-            break;
-        case Ekos::FocusProfiles:
-            filename = "SavedFocusProfiles.ini";
-            break;
-        case Ekos::HFRProfiles:
-            filename = "SavedHFRProfiles.ini";
-            break;
-    }
-
-    QString savedOptionsProfiles = QDir(KSPaths::writableLocation(QStandardPaths::AppLocalDataLocation)).filePath(filename);
-    QList<SSolver::Parameters> optionsList;
-    if(QFile(savedOptionsProfiles).exists())
-        optionsList = StellarSolver::loadSavedOptionsProfiles(savedOptionsProfiles);
-    else
-    {
-        switch(group)
-        {
-            case Ekos::AlignProfiles:
-                optionsList = Ekos::getDefaultAlignOptionsProfiles();
-                break;
-            case Ekos::GuideProfiles:
-                optionsList = Ekos::getDefaultGuideOptionsProfiles();
-                break;
-            case Ekos::FocusProfiles:
-                optionsList = Ekos::getDefaultFocusOptionsProfiles();
-                break;
-            case Ekos::HFRProfiles:
-                optionsList = Ekos::getDefaultHFROptionsProfiles();
-                break;
-        }
-    }
-    if (optionsProfileIndex >= 0 && optionsList.count() > optionsProfileIndex)
-    {
-        auto params = optionsList[optionsProfileIndex];
-        params.partition = Options::stellarSolverPartition();
-        solver->setParameters(params);
-        qCDebug(KSTARS_FITS) << "Sextract with: " << optionsList[optionsProfileIndex].listName;
-    }
-    else
-    {
-        auto params = SSolver::Parameters();  // This is default
-        params.partition = Options::stellarSolverPartition();
-        solver->setParameters(params);
-    }
+    solver->setParameters(getParameters(group, optionsProfileIndex));
 
     QList<FITSImage::Star> stars;
     const bool runHFR = group != Ekos::AlignProfiles;
@@ -189,6 +142,79 @@ bool FITSSEPDetector::findSourcesAndBackground(QRect const &boundary)
 #endif
 }
 
+#ifdef HAVE_STELLARSOLVER
+SSolver::Parameters FITSSEPDetector::getParameters(Ekos::ProfileGroup group, int optionsProfileIndex)
+{
+    // Reading the saved profiles on each detection costs more than detecting stars in a small guide frame,
+    // they are kept until their file changes.
+    struct SavedProfiles
+    {
+        QDateTime lastModified;
+        QList<SSolver::Parameters> profiles;
+    };
+    static QMutex mutex;
+    static QHash<int, SavedProfiles> cache;
+
+    QString filename = "";
+    switch(group)
+    {
+        case Ekos::AlignProfiles:
+            //So it should not be here if it is Align.
+            break;
+        case Ekos::GuideProfiles:
+            filename = "SavedGuideProfiles.ini";
+            break;
+        case Ekos::FocusProfiles:
+            filename = "SavedFocusProfiles.ini";
+            break;
+        case Ekos::HFRProfiles:
+            filename = "SavedHFRProfiles.ini";
+            break;
+    }
+
+    QString savedOptionsProfiles = QDir(KSPaths::writableLocation(QStandardPaths::AppLocalDataLocation)).filePath(filename);
+    const QFileInfo savedOptionsInfo(savedOptionsProfiles);
+    const QDateTime lastModified = savedOptionsInfo.exists() ? savedOptionsInfo.lastModified() : QDateTime();
+
+    QMutexLocker locker(&mutex);
+    auto saved = cache.find(group);
+    if (saved == cache.end() || saved->lastModified != lastModified)
+    {
+        QList<SSolver::Parameters> optionsList;
+        if(savedOptionsInfo.exists())
+            optionsList = StellarSolver::loadSavedOptionsProfiles(savedOptionsProfiles);
+        else
+        {
+            switch(group)
+            {
+                case Ekos::AlignProfiles:
+                    optionsList = Ekos::getDefaultAlignOptionsProfiles();
+                    break;
+                case Ekos::GuideProfiles:
+                    optionsList = Ekos::getDefaultGuideOptionsProfiles();
+                    break;
+                case Ekos::FocusProfiles:
+                    optionsList = Ekos::getDefaultFocusOptionsProfiles();
+                    break;
+                case Ekos::HFRProfiles:
+                    optionsList = Ekos::getDefaultHFROptionsProfiles();
+                    break;
+            }
+        }
+        saved = cache.insert(group, {lastModified, optionsList});
+    }
+
+    SSolver::Parameters params;  // This is default
+    if (optionsProfileIndex >= 0 && saved->profiles.count() > optionsProfileIndex)
+    {
+        params = saved->profiles[optionsProfileIndex];
+        qCDebug(KSTARS_FITS) << "Sextract with: " << params.listName;
+    }
+    params.partition = Options::stellarSolverPartition();
+    return params;
+}
+#endif
+
 template <typename T>
 void FITSSEPDetector::getFloatBuffer(float * buffer, int x, int y, int w, int h, FITSData const *data) const
 {
@@ -13,6 +13,10 @@
 #include "fitsstardetector.h"
 #include "skybackground.h"
 
+#ifdef HAVE_STELLARSOLVER
+#include "ekos/auxiliary/stellarsolverprofile.h"
+#endif
+
 class FITSSEPDetector : public FITSStarDetector
 {
         Q_OBJECT
@@ -29,6 +33,13 @@ class FITSSEPDetector : public FITSStarDetector
          */
         bool findSourcesAndBackground(QRect const &boundary = QRect());
 
+#ifdef HAVE_STELLARSOLVER
+        /** @brief Parameters of the options profile at @p optionsProfileIndex in @p group, the default ones if there is none.
+         * The saved profiles of a group are only read again when their file changes.
+         */
+        static SSolver::Parameters getParameters(Ekos::ProfileGroup group, int optionsProfileIndex);
+#endif
+
     protected:
         /** @internal Consolidate a float data buffer from FITS data.
          * @param buffer is the destination float block.
@@ -0,0 +1,440 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "fitsstatskernel.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FITS_STATS_AVX
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FITS_STATS_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define FITS_STATS_NEON
+#endif
+
+namespace FITSStatsKernel
+{
+
+void Partial::merge(const Partial &other)
+{
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    if (other.count == 0)
+        return;
+    if (count == 0)
+    {
+        average = other.average;
+        m2 = other.m2;
+        count = other.count;
+        return;
+    }
+
+    const double n = static_cast<double>(count) + other.count;
+    const double delta = other.average - average;
+    average += delta * other.count / n;
+    m2 += other.m2 + delta * delta * (static_cast<double>(count) * other.count / n);
+    count += other.count;
+}
+
+double Partial::mean() const
+{
+    return count > 0 ? average : 0;
+}
+
+double Partial::stddev() const
+{
+    if (count == 0)
+        return 0;
+
+    // Rounding may bring the variance of a constant image slightly below zero.
+    return std::sqrt(std::max(0.0, m2 / count));
+}
+
+namespace
+{
+
+// Converts the sums of (sample - shift) and of its square over count samples into mean and M2.
+// With shift close to the mean both sums stay small and the subtraction below keeps its precision.
+void setMoments(Partial &result, double shift, double sum, double sumSquares, uint32_t count)
+{
+    result.count = count;
+    if (count == 0)
+        return;
+
+    result.average = shift + sum / count;
+    result.m2 = std::max(0.0, sumSquares - sum * sum / count);
+}
+
+template <typename T>
+Partial accumulateHistogram(const T *data, uint32_t count, uint32_t *histogram)
+{
+    constexpr int32_t offset = histogramOffset<T>();
+    uint32_t i = 0;
+
+    // Unrolled so that consecutive increments of the same bin do not serialize on one store.
+    for (; i + 4 <= count; i += 4)
+    {
+        const int32_t a = data[i] + offset;
+        const int32_t b = data[i + 1] + offset;
+        const int32_t c = data[i + 2] + offset;
+        const int32_t d = data[i + 3] + offset;
+        histogram[a]++;
+        histogram[b]++;
+        histogram[c]++;
+        histogram[d]++;
+    }
+    for (; i < count; i++)
+        histogram[data[i] + offset]++;
+
+    Partial result;
+    result.count = count;
+    return result;
+}
+
+// Four independent accumulators let the compiler vectorize the integer paths and hide latency
+// on the others.
+template <typename T>
+Partial accumulateScalar(const T *data, uint32_t count)
+{
+    Partial result;
+    if (count == 0)
+        return result;
+
+    const double shift = static_cast<double>(data[0]);
+    T mn[4], mx[4];
+    double sum[4] = {0}, sq[4] = {0};
+    for (int k = 0; k < 4; k++)
+    {
+        mn[k] = std::numeric_limits<T>::max();
+        mx[k] = std::numeric_limits<T>::lowest();
+    }
+
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        for (int k = 0; k < 4; k++)
+        {
+            const T v = data[i + k];
+            // Comparisons written so that NaN samples never replace the running extrema.
+            mn[k] = v < mn[k] ? v : mn[k];
+            mx[k] = v > mx[k] ? v : mx[k];
+            const double dv = static_cast<double>(v) - shift;
+            sum[k] += dv;
+            sq[k] += dv * dv;
+        }
+    }
+    for (; i < count; i++)
+    {
+        const T v = data[i];
+        mn[0] = v < mn[0] ? v : mn[0];
+        mx[0] = v > mx[0] ? v : mx[0];
+        const double dv = static_cast<double>(v) - shift;
+        sum[0] += dv;
+        sq[0] += dv * dv;
+    }
+
+    for (int k = 0; k < 4; k++)
+    {
+        result.min = std::min(result.min, static_cast<double>(mn[k]));
+        result.max = std::max(result.max, static_cast<double>(mx[k]));
+    }
+    setMoments(result, shift, sum[0] + sum[1] + sum[2] + sum[3], sq[0] + sq[1] + sq[2] + sq[3], count);
+    return result;
+}
+
+}
+
+Partial accumulate(const uint8_t *data, uint32_t count, uint32_t *histogram)
+{
+    return accumulateHistogram(data, count, histogram);
+}
+
+Partial accumulate(const int16_t *data, uint32_t count, uint32_t *histogram)
+{
+    return accumulateHistogram(data, count, histogram);
+}
+
+Partial accumulate(const uint16_t *data, uint32_t count, uint32_t *histogram)
+{
+    return accumulateHistogram(data, count, histogram);
+}
+
+Partial accumulate(const int32_t *data, uint32_t count)
+{
+    return accumulateScalar(data, count);
+}
+
+Partial accumulate(const uint32_t *data, uint32_t count)
+{
+    return accumulateScalar(data, count);
+}
+
+Partial accumulate(const int64_t *data, uint32_t count)
+{
+    return accumulateScalar(data, count);
+}
+
+Partial accumulate(const float *data, uint32_t count)
+{
+    uint32_t i = 0;
+    Partial result;
+    if (count == 0)
+        return result;
+
+    const double shift = data[0];
+    double sum = 0, sumSquares = 0;
+
+#if defined(FITS_STATS_AVX)
+    const __m256d vshift = _mm256_set1_pd(shift);
+    __m256 vmin = _mm256_set1_ps(std::numeric_limits<float>::max());
+    __m256 vmax = _mm256_set1_ps(std::numeric_limits<float>::lowest());
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    __m256d q0 = _mm256_setzero_pd(), q1 = _mm256_setzero_pd();
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 v = _mm256_loadu_ps(data + i);
+        // MINPS/MAXPS return the second operand when the first is NaN
+        vmin = _mm256_min_ps(v, vmin);
+        vmax = _mm256_max_ps(v, vmax);
+        const __m256d lo = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(v)), vshift);
+        const __m256d hi = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)), vshift);
+        s0 = _mm256_add_pd(s0, lo);
+        s1 = _mm256_add_pd(s1, hi);
+        q0 = _mm256_add_pd(q0, _mm256_mul_pd(lo, lo));
+        q1 = _mm256_add_pd(q1, _mm256_mul_pd(hi, hi));
+    }
+    alignas(32) float mn[8], mx[8];
+    alignas(32) double s[4], q[4];
+    _mm256_store_ps(mn, vmin);
+    _mm256_store_ps(mx, vmax);
+    _mm256_store_pd(s, _mm256_add_pd(s0, s1));
+    _mm256_store_pd(q, _mm256_add_pd(q0, q1));
+    for (int k = 0; k < 8; k++)
+    {
+        result.min = std::min(result.min, static_cast<double>(mn[k]));
+        result.max = std::max(result.max, static_cast<double>(mx[k]));
+    }
+    for (int k = 0; k < 4; k++)
+    {
+        sum += s[k];
+        sumSquares += q[k];
+    }
+#elif defined(FITS_STATS_SSE2)
+    const __m128d vshift = _mm_set1_pd(shift);
+    __m128 vmin = _mm_set1_ps(std::numeric_limits<float>::max());
+    __m128 vmax = _mm_set1_ps(std::numeric_limits<float>::lowest());
+    __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+    __m128d q0 = _mm_setzero_pd(), q1 = _mm_setzero_pd();
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 v = _mm_loadu_ps(data + i);
+        vmin = _mm_min_ps(v, vmin);
+        vmax = _mm_max_ps(v, vmax);
+        const __m128d lo = _mm_sub_pd(_mm_cvtps_pd(v), vshift);
+        const __m128d hi = _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), vshift);
+        s0 = _mm_add_pd(s0, lo);
+        s1 = _mm_add_pd(s1, hi);
+        q0 = _mm_add_pd(q0, _mm_mul_pd(lo, lo));
+        q1 = _mm_add_pd(q1, _mm_mul_pd(hi, hi));
+    }
+    alignas(16) float mn[4], mx[4];
+    alignas(16) double s[2], q[2];
+    _mm_store_ps(mn, vmin);
+    _mm_store_ps(mx, vmax);
+    _mm_store_pd(s, _mm_add_pd(s0, s1));
+    _mm_store_pd(q, _mm_add_pd(q0, q1));
+    for (int k = 0; k < 4; k++)
+    {
+        result.min = std::min(result.min, static_cast<double>(mn[k]));
+        result.max = std::max(result.max, static_cast<double>(mx[k]));
+    }
+    for (int k = 0; k < 2; k++)
+    {
+        sum += s[k];
+        sumSquares += q[k];
+    }
+#elif defined(FITS_STATS_NEON)
+    const float64x2_t vshift = vdupq_n_f64(shift);
+    float32x4_t vmin = vdupq_n_f32(std::numeric_limits<float>::max());
+    float32x4_t vmax = vdupq_n_f32(std::numeric_limits<float>::lowest());
+    float64x2_t s0 = vdupq_n_f64(0), s1 = vdupq_n_f64(0);
+    float64x2_t q0 = vdupq_n_f64(0), q1 = vdupq_n_f64(0);
+    for (; i + 4 <= count; i += 4)
+    {
+        const float32x4_t v = vld1q_f32(data + i);
+        // The "number" variants ignore NaN like the x86 paths do.
+        vmin = vminnmq_f32(v, vmin);
+        vmax = vmaxnmq_f32(v, vmax);
+        const float64x2_t lo = vsubq_f64(vcvt_f64_f32(vget_low_f32(v)), vshift);
+        const float64x2_t hi = vsubq_f64(vcvt_high_f64_f32(v), vshift);
+        s0 = vaddq_f64(s0, lo);
+        s1 = vaddq_f64(s1, hi);
+        q0 = vfmaq_f64(q0, lo, lo);
+        q1 = vfmaq_f64(q1, hi, hi);
+    }
+    if (i > 0)
+    {
+        result.min = vminvq_f32(vmin);
+        result.max = vmaxvq_f32(vmax);
+    }
+    sum = vaddvq_f64(vaddq_f64(s0, s1));
+    sumSquares = vaddvq_f64(vaddq_f64(q0, q1));
+#endif
+
+    setMoments(result, shift, sum, sumSquares, i);
+    if (i < count)
+        result.merge(accumulateScalar(data + i, count - i));
+
+    return result;
+}
+
+Partial accumulate(const double *data, uint32_t count)
+{
+    uint32_t i = 0;
+    Partial result;
+    if (count == 0)
+        return result;
+
+    const double shift = data[0];
+    double sum = 0, sumSquares = 0;
+
+#if defined(FITS_STATS_AVX)
+    const __m256d vshift = _mm256_set1_pd(shift);
+    __m256d vmin = _mm256_set1_pd(std::numeric_limits<double>::max());
+    __m256d vmax = _mm256_set1_pd(std::numeric_limits<double>::lowest());
+    __m256d s = _mm256_setzero_pd(), q = _mm256_setzero_pd();
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m256d v = _mm256_loadu_pd(data + i);
+        vmin = _mm256_min_pd(v, vmin);
+        vmax = _mm256_max_pd(v, vmax);
+        const __m256d d = _mm256_sub_pd(v, vshift);
+        s = _mm256_add_pd(s, d);
+        q = _mm256_add_pd(q, _mm256_mul_pd(d, d));
+    }
+    alignas(32) double mn[4], mx[4], ss[4], qq[4];
+    _mm256_store_pd(mn, vmin);
+    _mm256_store_pd(mx, vmax);
+    _mm256_store_pd(ss, s);
+    _mm256_store_pd(qq, q);
+    for (int k = 0; k < 4; k++)
+    {
+        result.min = std::min(result.min, mn[k]);
+        result.max = std::max(result.max, mx[k]);
+        sum += ss[k];
+        sumSquares += qq[k];
+    }
+#elif defined(FITS_STATS_SSE2)
+    const __m128d vshift = _mm_set1_pd(shift);
+    __m128d vmin = _mm_set1_pd(std::numeric_limits<double>::max());
+    __m128d vmax = _mm_set1_pd(std::numeric_limits<double>::lowest());
+    __m128d s = _mm_setzero_pd(), q = _mm_setzero_pd();
+    for (; i + 2 <= count; i += 2)
+    {
+        const __m128d v = _mm_loadu_pd(data + i);
+        vmin = _mm_min_pd(v, vmin);
+        vmax = _mm_max_pd(v, vmax);
+        const __m128d d = _mm_sub_pd(v, vshift);
+        s = _mm_add_pd(s, d);
+        q = _mm_add_pd(q, _mm_mul_pd(d, d));
+    }
+    alignas(16) double mn[2], mx[2], ss[2], qq[2];
+    _mm_store_pd(mn, vmin);
+    _mm_store_pd(mx, vmax);
+    _mm_store_pd(ss, s);
+    _mm_store_pd(qq, q);
+    for (int k = 0; k < 2; k++)
+    {
+        result.min = std::min(result.min, mn[k]);
+        result.max = std::max(result.max, mx[k]);
+        sum += ss[k];
+        sumSquares += qq[k];
+    }
+#elif defined(FITS_STATS_NEON)
+    const float64x2_t vshift = vdupq_n_f64(shift);
+    float64x2_t vmin = vdupq_n_f64(std::numeric_limits<double>::max());
+    float64x2_t vmax = vdupq_n_f64(std::numeric_limits<double>::lowest());
+    float64x2_t s = vdupq_n_f64(0), q = vdupq_n_f64(0);
+    for (; i + 2 <= count; i += 2)
+    {
+        const float64x2_t v = vld1q_f64(data + i);
+        vmin = vminnmq_f64(v, vmin);
+        vmax = vmaxnmq_f64(v, vmax);
+        const float64x2_t d = vsubq_f64(v, vshift);
+        s = vaddq_f64(s, d);
+        q = vfmaq_f64(q, d, d);
+    }
+    if (i > 0)
+    {
+        result.min = vminvq_f64(vmin);
+        result.max = vmaxvq_f64(vmax);
+    }
+    sum = vaddvq_f64(s);
+    sumSquares = vaddvq_f64(q);
+#endif
+
+    setMoments(result, shift, sum, sumSquares, i);
+    if (i < count)
+        result.merge(accumulateScalar(data + i, count - i));
+
+    return result;
+}
+
+Partial fromHistogram(const uint32_t *histogram, uint32_t bins, int32_t offset)
+{
+    Partial result;
+    double sum = 0;
+    for (uint32_t bin = 0; bin < bins; bin++)
+    {
+        const uint32_t frequency = histogram[bin];
+        if (frequency == 0)
+            continue;
+
+        const double value = static_cast<int32_t>(bin) - offset;
+        result.min = std::min(result.min, value);
+        result.max = std::max(result.max, value);
+        sum += value * frequency;
+        result.count += frequency;
+    }
+    if (result.count == 0)
+        return result;
+
+    // The histogram is small next to the image, so a second pass for the deviations is cheap.
+    result.average = sum / result.count;
+    for (uint32_t bin = 0; bin < bins; bin++)
+    {
+        const uint32_t frequency = histogram[bin];
+        if (frequency == 0)
+            continue;
+
+        const double deviation = static_cast<int32_t>(bin) - offset - result.average;
+        result.m2 += deviation * deviation * frequency;
+    }
+    return result;
+}
+
+double histogramMedian(const uint32_t *histogram, uint32_t bins, int32_t offset, uint64_t count)
+{
+    if (count == 0)
+        return 0;
+
+    const uint64_t rank = count / 2;
+    uint64_t cumulative = 0;
+    for (uint32_t bin = 0; bin < bins; bin++)
+    {
+        cumulative += histogram[bin];
+        if (cumulative > rank)
+            return static_cast<int32_t>(bin) - offset;
+    }
+    return static_cast<int32_t>(bins - 1) - offset;
+}
+
+}
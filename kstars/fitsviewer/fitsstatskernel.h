@@ -0,0 +1,135 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * @namespace FITSStatsKernel
+ * Single-pass statistics kernels used by FITSData::calculateStats().
+ *
+ * Each accumulate() call walks a contiguous span of samples exactly once and returns the partial
+ * minimum, maximum, mean and sum of squared deviations of the span. The sums are taken relative to
+ * the first sample of the span, so that frames with a large offset and little noise do not lose
+ * their variance to cancellation. Partials from several spans (threads) are combined with
+ * Partial::merge() using the pairwise update of Chan et al. For 8 and 16 bit integer data the
+ * kernel instead fills a full resolution histogram, from which the exact median and all the other
+ * statistics are derived without touching the image again.
+ *
+ * Float and double spans are vectorized with AVX, SSE2 or NEON depending on the build target,
+ * with a scalar fallback for everything else.
+ */
+namespace FITSStatsKernel
+{
+
+struct Partial
+{
+    double min { std::numeric_limits<double>::max() };
+    double max { std::numeric_limits<double>::lowest() };
+    double average { 0 };
+    /** Sum of squared deviations from average, M2 in Welford's notation. */
+    double m2 { 0 };
+    uint64_t count { 0 };
+
+    void merge(const Partial &other);
+    double mean() const;
+    /** Population standard deviation, as used throughout the FITS viewer. */
+    double stddev() const;
+};
+
+/** Number of histogram bins needed to hold every value of T, 0 if T is not histogrammed. */
+template <typename T> constexpr uint32_t histogramBins()
+{
+    return 0;
+}
+template <> constexpr uint32_t histogramBins<uint8_t>()
+{
+    return 1u << 8;
+}
+template <> constexpr uint32_t histogramBins<int16_t>()
+{
+    return 1u << 16;
+}
+template <> constexpr uint32_t histogramBins<uint16_t>()
+{
+    return 1u << 16;
+}
+
+/** Offset added to a sample of type T to obtain its histogram bin. */
+template <typename T> constexpr int32_t histogramOffset()
+{
+    return 0;
+}
+template <> constexpr int32_t histogramOffset<int16_t>()
+{
+    return 32768;
+}
+
+/**
+ * @brief accumulate Add count samples of data to the per-thread histogram. The histogram must hold
+ * histogramBins<T>() zero-initialized bins. Only the count member of the returned partial is set,
+ * the remaining statistics are obtained with fromHistogram() once all histograms are merged.
+ */
+Partial accumulate(const uint8_t *data, uint32_t count, uint32_t *histogram);
+Partial accumulate(const int16_t *data, uint32_t count, uint32_t *histogram);
+Partial accumulate(const uint16_t *data, uint32_t count, uint32_t *histogram);
+
+/**
+ * @brief accumulate Compute min, max, mean and sum of squared deviations of count samples in one pass.
+ */
+Partial accumulate(const int32_t *data, uint32_t count);
+Partial accumulate(const uint32_t *data, uint32_t count);
+Partial accumulate(const float *data, uint32_t count);
+Partial accumulate(const int64_t *data, uint32_t count);
+Partial accumulate(const double *data, uint32_t count);
+
+/**
+ * @brief fromHistogram Derive min, max, mean and sum of squared deviations from a merged histogram.
+ * @param histogram bins filled by accumulate().
+ * @param bins number of bins.
+ * @param offset histogramOffset<T>() of the data type that filled the histogram.
+ */
+Partial fromHistogram(const uint32_t *histogram, uint32_t bins, int32_t offset);
+
+/**
+ * @brief histogramMedian Exact median of a merged histogram, i.e. the sample of rank count / 2 once
+ * sorted, which matches the selection done by std::nth_element on the raw samples.
+ */
+double histogramMedian(const uint32_t *histogram, uint32_t bins, int32_t offset, uint64_t count);
+
+/**
+ * @brief sampledMedian Median of a bounded, evenly spaced subset of count samples. Types wider than
+ * 16 bits cannot be histogrammed exactly, so their median is selected from the subset instead.
+ */
+template <typename T>
+double sampledMedian(T const *data, uint32_t count)
+{
+    if (count == 0)
+        return 0;
+
+    const uint32_t maxMedianSize = 500000;
+    uint32_t medianSize = count;
+    uint32_t downsample = 1;
+    if (medianSize > maxMedianSize)
+    {
+        downsample = (static_cast<double>(medianSize) / maxMedianSize) + 0.999;
+        medianSize /= downsample;
+    }
+    std::vector<T> subset;
+    subset.reserve(medianSize + 1);
+
+    for (uint32_t upto = 0; upto < count; upto += downsample)
+        subset.push_back(data[upto]);
+    const uint32_t middle = subset.size() / 2;
+    std::nth_element(subset.begin(), subset.begin() + middle, subset.end());
+    return subset[middle];
+}
+
+}
@@ -7,7 +7,10 @@
 
 #include <fitsio.h>
 #include <math.h>
+#include <limits>
+#include <type_traits>
 #include <QtConcurrent>
+#include <QThread>
 
 namespace
 {
@@ -45,120 +48,167 @@ T median(T const *values, int size, int sampleBy)
     return median(samples);
 }
 
-// This stretches one channel given the input parameters.
+// Number of blocks of output rows the stretch is split into. A few blocks per core keeps
+// all cores busy when some blocks finish early, without queuing one task per row.
+int rowBlockCount(int rows)
+{
+    return std::max(1, std::min(rows, QThread::idealThreadCount() * 4));
+}
+
+// Calls blockFunction(firstRow, endRow) over contiguous blocks of output rows
+// in parallel, blocks until done.
+template <typename F>
+void runRowBlocks(int outputRows, const F &blockFunction)
+{
+    const int blockSize = (outputRows + rowBlockCount(outputRows) - 1) / rowBlockCount(outputRows);
+
+    QVector<QFuture<void>> futures;
+    for (int first = 0; first < outputRows; first += blockSize)
+    {
+        const int end = std::min(outputRows, first + blockSize);
+        futures.append(QtConcurrent::run([ = ]()
+        {
+            blockFunction(first, end);
+        }));
+    }
+    for(QFuture<void> future : futures)
+        future.waitForFinished();
+}
+
+// The stretch of a single channel, evaluated one sample at a time.
 // Based on the spec in section 8.5.6
 // https://pixinsight.com/doc/docs/XISF-1.0-spec/XISF-1.0-spec.html
-// Uses multiple threads, blocks until done.
 // The extension parameters are not used.
-// Sampling is applied to the output (that is, with sampling=2, we compute every other output
-// sample both in width and height, so the output would have about 4X fewer pixels.
 template <typename T>
-void stretchOneChannel(T *input_buffer, QImage *output_image,
-                       const StretchParams &stretch_params,
-                       int input_range, int image_height, int image_width, int sampling)
+class ChannelStretch
 {
-    QVector<QFuture<void>> futures;
+    public:
+        ChannelStretch(const StretchParams1Channel &params, int inputRange)
+        {
+            // Maximum possible input value (e.g. 1024*64 - 1 for a 16 bit unsigned int).
+            const float maxInput = inputRange > 1 ? inputRange - 1 : inputRange;
+
+            midtones = params.midtones;
+            // Precomputed expressions moved out of the loop.
+            // highlights - shadows, protecting for divide-by-0, in a 0->1.0 scale.
+            const float hsRangeFactor = params.highlights == params.shadows ? 1.0f : 1.0f / (params.highlights - params.shadows);
+            // Shadow and highlight values translated to the ADU scale.
+            nativeShadows = params.shadows * maxInput;
+            nativeHighlights = params.highlights * maxInput;
+            // Constants based on above needed for the stretch calculations.
+            k1 = (midtones - 1) * hsRangeFactor * maxOutput / maxInput;
+            k2 = ((2 * midtones) - 1) * hsRangeFactor / maxInput;
+        }
 
-    // We're outputting uint8, so the max output is 255.
-    constexpr int maxOutput = 255;
+        uint8_t operator()(const T input) const
+        {
+            if (input < nativeShadows) return 0;
+            else if (input >= nativeHighlights) return maxOutput;
+            else
+            {
+                const T inputFloored = (input - nativeShadows);
+                return (inputFloored * k1) / (inputFloored * k2 - midtones);
+            }
+        }
+
+    private:
+        // We're outputting uint8, so the max output is 255.
+        static constexpr int maxOutput = 255;
+
+        T nativeShadows;
+        T nativeHighlights;
+        float k1;
+        float k2;
+        float midtones;
+};
 
-    // Maximum possible input value (e.g. 1024*64 - 1 for a 16 bit unsigned int).
-    const float maxInput = input_range > 1 ? input_range - 1 : input_range;
+// 8 and 16 bit integer samples can take at most 65536 values, so their stretch is tabulated.
+template <typename T>
+constexpr bool hasLookupTable()
+{
+    return std::is_integral<T>::value && sizeof(T) <= 2;
+}
+
+// Index of the sample in its channel's lookup table.
+template <typename T>
+inline int lookupIndex(const T input)
+{
+    return static_cast<int>(input) - std::numeric_limits<T>::min();
+}
 
-    const float midtones   = stretch_params.grey_red.midtones;
-    const float highlights = stretch_params.grey_red.highlights;
-    const float shadows    = stretch_params.grey_red.shadows;
+template <typename T>
+void buildLookupTable(const StretchParams1Channel &params, int inputRange, std::vector<uint8_t> *table)
+{
+    const ChannelStretch<T> stretch(params, inputRange);
+    const int size = std::numeric_limits<T>::max() - std::numeric_limits<T>::min() + 1;
+    table->resize(size);
+    for (int index = 0; index < size; ++index)
+        (*table)[index] = stretch(static_cast<T>(index + std::numeric_limits<T>::min()));
+}
 
-    // Precomputed expressions moved out of the loop.
-    // highlights - shadows, protecting for divide-by-0, in a 0->1.0 scale.
-    const float hsRangeFactor = highlights == shadows ? 1.0f : 1.0f / (highlights - shadows);
-    // Shadow and highlight values translated to the ADU scale.
-    const T nativeShadows = shadows * maxInput;
-    const T nativeHighlights = highlights * maxInput;
-    // Constants based on above needed for the stretch calculations.
-    const float k1 = (midtones - 1) * hsRangeFactor * maxOutput / maxInput;
-    const float k2 = ((2 * midtones) - 1) * hsRangeFactor / maxInput;
+// This stretches one channel given the input parameters.
+// Uses multiple threads, blocks until done.
+// Sampling is applied to the output (that is, with sampling=2, we compute every other output
+// sample both in width and height, so the output would have about 4X fewer pixels.
+// If lookupTables is not null, its first table is used instead of evaluating the stretch.
+template <typename T>
+void stretchOneChannel(T *input_buffer, QImage *output_image,
+                       const StretchParams &stretch_params,
+                       int input_range, int image_height, int image_width, int sampling,
+                       const std::vector<uint8_t> *lookupTables)
+{
+    Q_UNUSED(image_height);
+    const ChannelStretch<std::remove_const_t<T>> stretch(stretch_params.grey_red, input_range);
+    const uint8_t *lookupTable = lookupTables ? lookupTables[0].data() : nullptr;
 
-    // Increment the input index by the sampling, the output index increments by 1.
-    for (int j = 0, jout = 0; j < image_height; j += sampling, jout++)
+    runRowBlocks(output_image->height(), [&](int firstRow, int endRow)
     {
-        futures.append(QtConcurrent::run([ = ]()
+        // Increment the input index by the sampling, the output index increments by 1.
+        for (int jout = firstRow, j = firstRow * sampling; jout < endRow; j += sampling, jout++)
         {
             T * inputLine  = input_buffer + j * image_width;
             auto * scanLine = output_image->scanLine(jout);
 
-            for (int i = 0, iout = 0; i < image_width; i += sampling, iout++)
+            if constexpr (hasLookupTable<T>())
             {
-                const T input = inputLine[i];
-                if (input < nativeShadows) scanLine[iout] = 0;
-                else if (input >= nativeHighlights) scanLine[iout] = maxOutput;
-                else
+                if (lookupTable)
                 {
-                    const T inputFloored = (input - nativeShadows);
-                    scanLine[iout] = (inputFloored * k1) / (inputFloored * k2 - midtones);
+                    for (int i = 0, iout = 0; i < image_width; i += sampling, iout++)
+                        scanLine[iout] = lookupTable[lookupIndex(inputLine[i])];
+                    continue;
                 }
             }
-        }));
-    }
-    for(QFuture<void> future : futures)
-        future.waitForFinished();
+            for (int i = 0, iout = 0; i < image_width; i += sampling, iout++)
+                scanLine[iout] = stretch(inputLine[i]);
+        }
+    });
 }
 
 // This is like the above 1-channel stretch, but extended for 3 channels.
-// This could have been more modular, but the three channels are combined
-// into a single qRgb value at the end, so it seems the simplest thing is to
-// replicate the code. It is assume the colors are not interleaved--the red image
+// The three channels are combined into a single qRgb value at the end.
+// It is assume the colors are not interleaved--the red image
 // is stored fully, then the green, then the blue.
 // Sampling is applied to the output (that is, with sampling=2, we compute every other output
 // sample both in width and height, so the output would have about 4X fewer pixels.
 template <typename T>
 void stretchThreeChannels(T *inputBuffer, QImage *outputImage,
                           const StretchParams &stretchParams,
-                          int inputRange, int imageHeight, int imageWidth, int sampling)
+                          int inputRange, int imageHeight, int imageWidth, int sampling,
+                          const std::vector<uint8_t> *lookupTables)
 {
-    QVector<QFuture<void>> futures;
+    const ChannelStretch<std::remove_const_t<T>> stretchR(stretchParams.grey_red, inputRange);
+    const ChannelStretch<std::remove_const_t<T>> stretchG(stretchParams.green, inputRange);
+    const ChannelStretch<std::remove_const_t<T>> stretchB(stretchParams.blue, inputRange);
 
-    // We're outputting uint8, so the max output is 255.
-    constexpr int maxOutput = 255;
-
-    // Maximum possible input value (e.g. 1024*64 - 1 for a 16 bit unsigned int).
-    const float maxInput = inputRange > 1 ? inputRange - 1 : inputRange;
-
-    const float midtonesR   = stretchParams.grey_red.midtones;
-    const float highlightsR = stretchParams.grey_red.highlights;
-    const float shadowsR    = stretchParams.grey_red.shadows;
-    const float midtonesG   = stretchParams.green.midtones;
-    const float highlightsG = stretchParams.green.highlights;
-    const float shadowsG    = stretchParams.green.shadows;
-    const float midtonesB   = stretchParams.blue.midtones;
-    const float highlightsB = stretchParams.blue.highlights;
-    const float shadowsB    = stretchParams.blue.shadows;
-
-    // Precomputed expressions moved out of the loop.
-    // highlights - shadows, protecting for divide-by-0, in a 0->1.0 scale.
-    const float hsRangeFactorR = highlightsR == shadowsR ? 1.0f : 1.0f / (highlightsR - shadowsR);
-    const float hsRangeFactorG = highlightsG == shadowsG ? 1.0f : 1.0f / (highlightsG - shadowsG);
-    const float hsRangeFactorB = highlightsB == shadowsB ? 1.0f : 1.0f / (highlightsB - shadowsB);
-    // Shadow and highlight values translated to the ADU scale.
-    const T nativeShadowsR = shadowsR * maxInput;
-    const T nativeShadowsG = shadowsG * maxInput;
-    const T nativeShadowsB = shadowsB * maxInput;
-    const T nativeHighlightsR = highlightsR * maxInput;
-    const T nativeHighlightsG = highlightsG * maxInput;
-    const T nativeHighlightsB = highlightsB * maxInput;
-    // Constants based on above needed for the stretch calculations.
-    const float k1R = (midtonesR - 1) * hsRangeFactorR * maxOutput / maxInput;
-    const float k1G = (midtonesG - 1) * hsRangeFactorG * maxOutput / maxInput;
-    const float k1B = (midtonesB - 1) * hsRangeFactorB * maxOutput / maxInput;
-    const float k2R = ((2 * midtonesR) - 1) * hsRangeFactorR / maxInput;
-    const float k2G = ((2 * midtonesG) - 1) * hsRangeFactorG / maxInput;
-    const float k2B = ((2 * midtonesB) - 1) * hsRangeFactorB / maxInput;
+    const uint8_t *lookupTableR = lookupTables ? lookupTables[0].data() : nullptr;
+    const uint8_t *lookupTableG = lookupTables ? lookupTables[1].data() : nullptr;
+    const uint8_t *lookupTableB = lookupTables ? lookupTables[2].data() : nullptr;
 
     const int size = imageWidth * imageHeight;
 
-    for (int j = 0, jout = 0; j < imageHeight; j += sampling, jout++)
+    runRowBlocks(outputImage->height(), [&](int firstRow, int endRow)
     {
-        futures.append(QtConcurrent::run([ = ]()
+        for (int jout = firstRow, j = firstRow * sampling; jout < endRow; j += sampling, jout++)
         {
             // R, G, B input images are stored one after another.
             T * inputLineR  = inputBuffer + j * imageWidth;
@@ -167,56 +217,40 @@ void stretchThreeChannels(T *inputBuffer, QImage *outputImage,
 
             auto * scanLine = reinterpret_cast<QRgb*>(outputImage->scanLine(jout));
 
-            for (int i = 0, iout = 0; i < imageWidth; i += sampling, iout++)
+            if constexpr (hasLookupTable<T>())
             {
-                const T inputR = inputLineR[i];
-                const T inputG = inputLineG[i];
-                const T inputB = inputLineB[i];
-
-                uint8_t red, green, blue;
-
-                if (inputR < nativeShadowsR) red = 0;
-                else if (inputR >= nativeHighlightsR) red = maxOutput;
-                else
-                {
-                    const T inputFloored = (inputR - nativeShadowsR);
-                    red = (inputFloored * k1R) / (inputFloored * k2R - midtonesR);
-                }
-
-                if (inputG < nativeShadowsG) green = 0;
-                else if (inputG >= nativeHighlightsG) green = maxOutput;
-                else
-                {
-                    const T inputFloored = (inputG - nativeShadowsG);
-                    green = (inputFloored * k1G) / (inputFloored * k2G - midtonesG);
-                }
-
-                if (inputB < nativeShadowsB) blue = 0;
-                else if (inputB >= nativeHighlightsB) blue = maxOutput;
-                else
+                if (lookupTableR)
                 {
-                    const T inputFloored = (inputB - nativeShadowsB);
-                    blue = (inputFloored * k1B) / (inputFloored * k2B - midtonesB);
+                    for (int i = 0, iout = 0; i < imageWidth; i += sampling, iout++)
+                        scanLine[iout] = qRgb(lookupTableR[lookupIndex(inputLineR[i])],
+                                              lookupTableG[lookupIndex(inputLineG[i])],
+                                              lookupTableB[lookupIndex(inputLineB[i])]);
+                    continue;
                 }
-                scanLine[iout] = qRgb(red, green, blue);
             }
-        }));
-    }
-    for(QFuture<void> future : futures)
-        future.waitForFinished();
+            for (int i = 0, iout = 0; i < imageWidth; i += sampling, iout++)
+                scanLine[iout] = qRgb(stretchR(inputLineR[i]), stretchG(inputLineG[i]), stretchB(inputLineB[i]));
+        }
+    });
 }
 
 template <typename T>
 void stretchChannels(T *input_buffer, QImage *output_image,
                      const StretchParams &stretch_params,
-                     int input_range, int image_height, int image_width, int num_channels, int sampling)
+                     int input_range, int image_height, int image_width, int num_channels, int sampling,
+                     const std::vector<uint8_t> *lookupTables)
 {
     if (num_channels == 1)
         stretchOneChannel(input_buffer, output_image, stretch_params, input_range,
-                          image_height, image_width, sampling);
+                          image_height, image_width, sampling, lookupTables);
     else if (num_channels == 3)
         stretchThreeChannels(input_buffer, output_image, stretch_params, input_range,
-                             image_height, image_width, sampling);
+                             image_height, image_width, sampling, lookupTables);
+}
+
+bool sameParams(const StretchParams1Channel &a, const StretchParams1Channel &b)
+{
+    return a.shadows == b.shadows && a.highlights == b.highlights && a.midtones == b.midtones;
 }
 
 // See section 8.5.7 in above link  https://pixinsight.com/doc/docs/XISF-1.0-spec/XISF-1.0-spec.html
@@ -323,41 +357,79 @@ void Stretch::run(uint8_t const *input, QImage *outputImage, int sampling)
     Q_ASSERT(outputImage->height() == (image_height + sampling - 1) / sampling);
     recalculateInputRange(input);
 
+    const std::vector<uint8_t> *tables = lookupTables();
+
     switch (dataType)
     {
         case TBYTE:
             stretchChannels(reinterpret_cast<uint8_t const*>(input), outputImage, params,
-                            input_range, image_height, image_width, image_channels, sampling);
+                            input_range, image_height, image_width, image_channels, sampling, tables);
             break;
         case TSHORT:
             stretchChannels(reinterpret_cast<short const*>(input), outputImage, params,
-                            input_range, image_height, image_width, image_channels, sampling);
+                            input_range, image_height, image_width, image_channels, sampling, tables);
             break;
         case TUSHORT:
             stretchChannels(reinterpret_cast<unsigned short const*>(input), outputImage, params,
-                            input_range, image_height, image_width, image_channels, sampling);
+                            input_range, image_height, image_width, image_channels, sampling, tables);
             break;
         case TLONG:
             stretchChannels(reinterpret_cast<long const*>(input), outputImage, params,
-                            input_range, image_height, image_width, image_channels, sampling);
+                            input_range, image_height, image_width, image_channels, sampling, tables);
             break;
         case TFLOAT:
             stretchChannels(reinterpret_cast<float const*>(input), outputImage, params,
-                            input_range, image_height, image_width, image_channels, sampling);
+                            input_range, image_height, image_width, image_channels, sampling, tables);
             break;
         case TLONGLONG:
             stretchChannels(reinterpret_cast<long long const*>(input), outputImage, params,
-                            input_range, image_height, image_width, image_channels, sampling);
+                            input_range, image_height, image_width, image_channels, sampling, tables);
             break;
         case TDOUBLE:
             stretchChannels(reinterpret_cast<double const*>(input), outputImage, params,
-                            input_range, image_height, image_width, image_channels, sampling);
+                            input_range, image_height, image_width, image_channels, sampling, tables);
             break;
         default:
             break;
     }
 }
 
+const std::vector<uint8_t> *Stretch::lookupTables()
+{
+    if (!use_lookup_tables || (dataType != TBYTE && dataType != TSHORT && dataType != TUSHORT))
+        return nullptr;
+
+    // Tables stay valid for as long as the params and input range they were built for.
+    if (lookup_tables_range == input_range &&
+            sameParams(lookup_tables_params.grey_red, params.grey_red) &&
+            sameParams(lookup_tables_params.green, params.green) &&
+            sameParams(lookup_tables_params.blue, params.blue))
+        return lookup_tables;
+
+    for (int channel = 0; channel < image_channels && channel < 3; ++channel)
+    {
+        const StretchParams1Channel &channelParams = channel == 0 ? params.grey_red :
+                (channel == 1 ? params.green : params.blue);
+        switch (dataType)
+        {
+            case TBYTE:
+                buildLookupTable<uint8_t>(channelParams, input_range, &lookup_tables[channel]);
+                break;
+            case TSHORT:
+                buildLookupTable<short>(channelParams, input_range, &lookup_tables[channel]);
+                break;
+            case TUSHORT:
+                buildLookupTable<unsigned short>(channelParams, input_range, &lookup_tables[channel]);
+                break;
+            default:
+                break;
+        }
+    }
+    lookup_tables_params = params;
+    lookup_tables_range = input_range;
+    return lookup_tables;
+}
+
 // The input range for float/double is ambiguous, and we can't tell without the buffer,
 // so we set it to 64K and possibly reduce it when we see the data.
 void Stretch::recalculateInputRange(uint8_t const *input)
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include <QImage>
 
 struct StretchParams1Channel
@@ -80,10 +81,22 @@ class Stretch
          */
         void run(uint8_t const *input, QImage *output_image, int sampling=1);
 
+        /**
+         * @brief setUseLookupTables Enables or disables the lookup table path of run().
+         * @note 8 and 16 bit integer images have at most 65536 distinct sample values,
+         * so by default their stretch is tabulated once per channel and parameter set,
+         * instead of being evaluated for every pixel. Results are identical either way.
+         */
+        void setUseLookupTables(bool enabled) { use_lookup_tables = enabled; }
+
  private:
         // Adjusts input_range for float and double types.
         void recalculateInputRange(const uint8_t *input);
 
+        // Returns the per-channel lookup tables for the current params, rebuilding them if needed,
+        // or nullptr if the data type or settings don't allow the lookup table path.
+        const std::vector<uint8_t> *lookupTables();
+
         // Inputs.
         int image_width;
         int image_height;
@@ -93,4 +106,10 @@ class Stretch
   
         // Parameters.
         StretchParams params;
+
+        // Lookup tables, and the params and input range they were built for.
+        bool use_lookup_tables { true };
+        std::vector<uint8_t> lookup_tables[3];
+        StretchParams lookup_tables_params;
+        int lookup_tables_range { -1 };
 };
@@ -145,6 +145,17 @@ void HIPSManager::readSources()
   m_uid = qHash(param.url);
 }*/
 
+QImage *HIPSManager::subImage(const QImage *image, int x, int y, int size)
+{
+    // A read-only view sharing the pixels of the cached image, which stays in the cache
+    // at least until the next event loop iteration.
+    const uchar *bits = image->constBits() + y * image->bytesPerLine() + x * image->depth() / 8;
+    QImage *view = new QImage(bits, size, size, image->bytesPerLine(), image->format());
+    if (image->format() == QImage::Format_Indexed8)
+        view->setColorTable(image->colorTable());
+    return view;
+}
+
 QImage *HIPSManager::getPix(bool allsky, int level, int pix, bool &freeImage)
 {
     if (Options::hIPSUseOfflineSource() == false && m_currentSource.isEmpty())
@@ -191,7 +202,7 @@ QImage *HIPSManager::getPix(bool allsky, int level, int pix, bool &freeImage)
             int ox = index[pix % 4] % offset;
             int oy = index[pix % 4] / offset;
 
-            QImage *newImage = new QImage(image->copy(ox * size, oy * size, size, size));
+            QImage *newImage = subImage(image, ox * size, oy * size, size);
             freeImage = true;
             return newImage;
         }
@@ -214,7 +225,7 @@ QImage *HIPSManager::getPix(bool allsky, int level, int pix, bool &freeImage)
             int ox = origPix % offset;
             int oy = origPix / offset;
 
-            QImage *newImage = new QImage(image->copy(ox * size, oy * size, size, size));
+            QImage *newImage = subImage(image, ox * size, oy * size, size);
             freeImage = true;
             return newImage;
         }
@@ -51,6 +51,11 @@ class HIPSManager : public QObject
 
         typedef enum { HIPS_EQUATORIAL_FRAME, HIPS_GALACTIC_FRAME, HIPS_OTHER_FRAME } HIPSFrame;
 
+        /**
+         * @brief getPix Get the image of a HiPS pixel, or of its part in the parent pixel or the all sky image.
+         * @param freeImage Set if the returned image is to be deleted by the caller. Such an image is a view
+         * into a cached image and is only valid until control returns to the event loop.
+         */
         QImage *getPix(bool allsky, int level, int pix, bool &freeImage);
 
         void readSources();
@@ -118,6 +123,8 @@ class HIPSManager : public QObject
         QSet <pixCacheKey_t> m_downloadMap;
 
         void addToMemoryCache(pixCacheKey_t &key, pixCacheItem_t *item);
+        /// A size x size view into image at (x, y) that does not copy the pixels
+        static QImage *subImage(const QImage *image, int x, int y, int size);
         pixCacheItem_t *getCacheItem(pixCacheKey_t &key);
 
         // List of all sources in the database
@@ -15,9 +15,49 @@
 #include "skyqpainter.h"
 #include "projections/projector.h"
 
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+// UV Mapping to apply image unto the destination image
+// 4x4 = 16 points are mapped from the source image unto the destination image.
+// Starting from each grandchild pixel, each pix polygon is mapped accordingly.
+// For example, pixel 357 will have 4 child pixels, each of them will have 4 childs pixels and so
+// on. Each healpix pixel appears roughly as a diamond on the sky map.
+// The corners points for HealPIX moves from NORTH -> EAST -> SOUTH -> WEST
+// Hence first point is 0.25, 0.25 in UV coordinate system.
+// Depending on the selected algorithm, the mapping will either utilize nearest neighbour
+// or bilinear interpolation.
+static const QPointF uv[16][4] = {{QPointF(.25, .25), QPointF(0.25, 0), QPointF(0, .0), QPointF(0, .25)},
+    {QPointF(.25, .5), QPointF(0.25, 0.25), QPointF(0, .25), QPointF(0, .5)},
+    {QPointF(.5, .25), QPointF(0.5, 0), QPointF(.25, .0), QPointF(.25, .25)},
+    {QPointF(.5, .5), QPointF(0.5, 0.25), QPointF(.25, .25), QPointF(.25, .5)},
+
+    {QPointF(.25, .75), QPointF(0.25, 0.5), QPointF(0, 0.5), QPointF(0, .75)},
+    {QPointF(.25, 1), QPointF(0.25, 0.75), QPointF(0, .75), QPointF(0, 1)},
+    {QPointF(.5, .75), QPointF(0.5, 0.5), QPointF(.25, .5), QPointF(.25, .75)},
+    {QPointF(.5, 1), QPointF(0.5, 0.75), QPointF(.25, .75), QPointF(.25, 1)},
+
+    {QPointF(.75, .25), QPointF(0.75, 0), QPointF(0.5, .0), QPointF(0.5, .25)},
+    {QPointF(.75, .5), QPointF(0.75, 0.25), QPointF(0.5, .25), QPointF(0.5, .5)},
+    {QPointF(1, .25), QPointF(1, 0), QPointF(.75, .0), QPointF(.75, .25)},
+    {QPointF(1, .5), QPointF(1, 0.25), QPointF(.75, .25), QPointF(.75, .5)},
+
+    {QPointF(.75, .75), QPointF(0.75, 0.5), QPointF(0.5, .5), QPointF(0.5, .75)},
+    {QPointF(.75, 1), QPointF(0.75, 0.75), QPointF(0.5, .75), QPointF(0.5, 1)},
+    {QPointF(1, .75), QPointF(1, 0.5), QPointF(.75, .5), QPointF(.75, .75)},
+    {QPointF(1, 1), QPointF(1, 0.75), QPointF(.75, .75), QPointF(.75, 1)},
+};
+
+// Bands are not worth the thread hand-off below this many rows
+static const int minBandHeight = 32;
+
 HIPSRenderer::HIPSRenderer()
 {
-    m_scanRender.reset(new ScanRender());
     m_HEALpix.reset(new HEALPix());
 }
 
@@ -44,6 +84,7 @@ bool HIPSRenderer::render(uint16_t w, uint16_t h, QImage *hipsImage, const Proje
     level = HIPSManager::Instance()->getUsableLevel(level);
 
     m_renderedMap.clear();
+    m_tiles.clear();
     m_rendered = 0;
     m_blocks = 0;
     m_size = 0;
@@ -92,159 +133,199 @@ bool HIPSRenderer::render(uint16_t w, uint16_t h, QImage *hipsImage, const Proje
     if (size < 0)
         size = HIPSManager::Instance()->getCurrentTileWidth();
 
-    bool old = m_scanRender->isBilinearInterpolationEnabled();
-    m_scanRender->setBilinearInterpolationEnabled(Options::hIPSBiLinearInterpolation() && (size >= HIPSManager::Instance()->getCurrentTileWidth() || allSky));
+    bool bilinear = Options::hIPSBiLinearInterpolation() && (size >= HIPSManager::Instance()->getCurrentTileWidth() || allSky);
+
+    // Projection and tile lookup stay on this thread, the cache and the network are not thread safe.
+    // The tile images are valid until we return to the event loop.
+    collectTiles(allSky, level, centerPix);
 
-    renderRec(allSky, level, centerPix, hipsImage);
+    rasterizeTiles(hipsImage, bilinear);
+
+    for (const Tile &tile : m_tiles)
+    {
+        if (Options::hIPSShowGrid())
+            drawGrid(tile, level, hipsImage);
+
+        if (tile.freeImage)
+            delete tile.image;
+    }
 
-    m_scanRender->setBilinearInterpolationEnabled(old);
+    m_tiles.clear();
 
     return true;
 }
 
-void HIPSRenderer::renderRec(bool allsky, int level, int pix, QImage *pDest)
+void HIPSRenderer::collectTiles(bool allsky, int level, int centerPix)
 {
-    if (m_renderedMap.contains(pix))
-    {
-        return;
-    }
+    // Depth first walk from the center, neighbours are visited in the same order as a recursive walk would,
+    // without the risk of running out of stack on dense levels.
+    QVector<int> pending;
+    pending.append(centerPix);
 
-    if (renderPix(allsky, level, pix, pDest))
+    while (!pending.isEmpty())
     {
-        m_renderedMap.insert(pix);
-        int dirs[8];
-        int nside = 1 << level;
+        int pix = pending.takeLast();
+
+        if (m_renderedMap.contains(pix))
+        {
+            continue;
+        }
 
-        m_HEALpix->neighbours(nside, pix, dirs);
+        if (collectPix(allsky, level, pix))
+        {
+            m_renderedMap.insert(pix);
+            int dirs[8];
+            int nside = 1 << level;
+
+            m_HEALpix->neighbours(nside, pix, dirs);
 
-        renderRec(allsky, level, dirs[0], pDest);
-        renderRec(allsky, level, dirs[2], pDest);
-        renderRec(allsky, level, dirs[4], pDest);
-        renderRec(allsky, level, dirs[6], pDest);
+            pending.append(dirs[6]);
+            pending.append(dirs[4]);
+            pending.append(dirs[2]);
+            pending.append(dirs[0]);
+        }
     }
 }
 
-bool HIPSRenderer::renderPix(bool allsky, int level, int pix, QImage *pDest)
+bool HIPSRenderer::collectPix(bool allsky, int level, int pix)
 {
     SkyPoint cornerSkyCoords[4];
-    QPointF cornerScreenCoords[4];
-    bool freeImage = false;
+    Tile tile;
+    tile.pix = pix;
+    tile.image = nullptr;
+    tile.freeImage = false;
+    tile.top = 0;
+    tile.bottom = -1;
 
     m_HEALpix->getCornerPoints(level, pix, cornerSkyCoords);
     bool isVisible = false;
 
     for (int i = 0; i < 4; i++)
     {
-        cornerScreenCoords[i] = m_projector->toScreen(&cornerSkyCoords[i]);
+        tile.corners[i] = m_projector->toScreen(&cornerSkyCoords[i]);
         isVisible |= m_projector->checkVisibility(&cornerSkyCoords[i]);
     }
 
     //if (SKPLANECheckFrustumToPolygon(trfGetFrustum(), pts, 4))
     // Is the right way to do this?
 
-    if (isVisible)
-    {
-        m_blocks++;
+    if (!isVisible)
+        return false;
 
-        /*for (int i = 0; i < 4; i++)
-        {
-          trfProjectPointNoCheck(&pts[i]);
-        } */
+    m_blocks++;
 
-        QImage *image = HIPSManager::Instance()->getPix(allsky, level, pix, freeImage);
+    tile.image = HIPSManager::Instance()->getPix(allsky, level, pix, tile.freeImage);
 
-        if (image)
-        {
-            m_rendered++;
+    if (tile.image)
+    {
+        m_rendered++;
 
 #if QT_VERSION >= QT_VERSION_CHECK(5,10,0)
-            m_size += image->sizeInBytes();
+        m_size += tile.image->sizeInBytes();
 #else
-            m_size += image->byteCount();
+        m_size += tile.image->byteCount();
 #endif
 
-            // UV Mapping to apply image unto the destination image
-            // 4x4 = 16 points are mapped from the source image unto the destination image.
-            // Starting from each grandchild pixel, each pix polygon is mapped accordingly.
-            // For example, pixel 357 will have 4 child pixels, each of them will have 4 childs pixels and so
-            // on. Each healpix pixel appears roughly as a diamond on the sky map.
-            // The corners points for HealPIX moves from NORTH -> EAST -> SOUTH -> WEST
-            // Hence first point is 0.25, 0.25 in UV coordinate system.
-            // Depending on the selected algorithm, the mapping will either utilize nearest neighbour
-            // or bilinear interpolation.
-            QPointF uv[16][4] = {{QPointF(.25, .25), QPointF(0.25, 0), QPointF(0, .0), QPointF(0, .25)},
-                {QPointF(.25, .5), QPointF(0.25, 0.25), QPointF(0, .25), QPointF(0, .5)},
-                {QPointF(.5, .25), QPointF(0.5, 0), QPointF(.25, .0), QPointF(.25, .25)},
-                {QPointF(.5, .5), QPointF(0.5, 0.25), QPointF(.25, .25), QPointF(.25, .5)},
-
-                {QPointF(.25, .75), QPointF(0.25, 0.5), QPointF(0, 0.5), QPointF(0, .75)},
-                {QPointF(.25, 1), QPointF(0.25, 0.75), QPointF(0, .75), QPointF(0, 1)},
-                {QPointF(.5, .75), QPointF(0.5, 0.5), QPointF(.25, .5), QPointF(.25, .75)},
-                {QPointF(.5, 1), QPointF(0.5, 0.75), QPointF(.25, .75), QPointF(.25, 1)},
-
-                {QPointF(.75, .25), QPointF(0.75, 0), QPointF(0.5, .0), QPointF(0.5, .25)},
-                {QPointF(.75, .5), QPointF(0.75, 0.25), QPointF(0.5, .25), QPointF(0.5, .5)},
-                {QPointF(1, .25), QPointF(1, 0), QPointF(.75, .0), QPointF(.75, .25)},
-                {QPointF(1, .5), QPointF(1, 0.25), QPointF(.75, .25), QPointF(.75, .5)},
-
-                {QPointF(.75, .75), QPointF(0.75, 0.5), QPointF(0.5, .5), QPointF(0.5, .75)},
-                {QPointF(.75, 1), QPointF(0.75, 0.75), QPointF(0.5, .75), QPointF(0.5, 1)},
-                {QPointF(1, .75), QPointF(1, 0.5), QPointF(.75, .5), QPointF(.75, .75)},
-                {QPointF(1, 1), QPointF(1, 0.75), QPointF(.75, .75), QPointF(.75, 1)},
-            };
-
-            int childPixelID[4];
-
-            // Find all the 4 children of the current pixel
-            m_HEALpix->getPixChilds(pix, childPixelID);
-
-            int j = 0;
-            for (int id : childPixelID)
-            {
-                int grandChildPixelID[4];
-                // Find the children of this child (i.e. grand child)
-                // Then we have 4x4 pixels under the primary pixel
-                // The image is interpolated and rendered over these pixels
-                // coordinate to minimize any distortions due to the projection
-                // system.
-                m_HEALpix->getPixChilds(id, grandChildPixelID);
-
-                QPointF fineScreenCoords[4];
+        int childPixelID[4];
 
-                for (int id2 : grandChildPixelID)
-                {
-                    SkyPoint fineSkyPoints[4];
-                    m_HEALpix->getCornerPoints(level + 2, id2, fineSkyPoints);
+        // Find all the 4 children of the current pixel
+        m_HEALpix->getPixChilds(pix, childPixelID);
 
-                    for (int i = 0; i < 4; i++)
-                        fineScreenCoords[i] = m_projector->toScreen(&fineSkyPoints[i]);
-                    m_scanRender->renderPolygon(3, fineScreenCoords, pDest, image, uv[j]);
-                    j++;
-                }
-            }
+        double top = std::numeric_limits<double>::max();
+        double bottom = std::numeric_limits<double>::lowest();
 
-            if (freeImage)
+        int j = 0;
+        for (int id : childPixelID)
+        {
+            int grandChildPixelID[4];
+            // Find the children of this child (i.e. grand child)
+            // Then we have 4x4 pixels under the primary pixel
+            // The image is interpolated and rendered over these pixels
+            // coordinate to minimize any distortions due to the projection
+            // system.
+            m_HEALpix->getPixChilds(id, grandChildPixelID);
+
+            for (int id2 : grandChildPixelID)
             {
-                delete image;
+                SkyPoint fineSkyPoints[4];
+                m_HEALpix->getCornerPoints(level + 2, id2, fineSkyPoints);
+
+                for (int i = 0; i < 4; i++)
+                {
+                    tile.fine[j][i] = m_projector->toScreen(&fineSkyPoints[i]);
+                    top = std::min(top, tile.fine[j][i].y());
+                    bottom = std::max(bottom, tile.fine[j][i].y());
+                }
+                j++;
             }
         }
 
-        if (Options::hIPSShowGrid())
+        // Off screen corners may be projected far away, the scan renderer clips them anyway
+        tile.top = static_cast<int>(std::floor(qBound(-1.0, top, double(INT_MAX / 2))));
+        tile.bottom = static_cast<int>(std::ceil(qBound(-1.0, bottom, double(INT_MAX / 2))));
+    }
+
+    m_tiles.append(tile);
+
+    return true;
+}
+
+void HIPSRenderer::rasterizeTiles(QImage *pDest, bool bilinear)
+{
+    if (m_rendered == 0)
+        return;
+
+    // Each band of rows is scanned by its own renderer. The bands do not overlap and every band draws the
+    // tiles in the same order, so the result does not depend on the scheduling.
+    const int height = pDest->height();
+    const int bandCount = qBound(1, QThread::idealThreadCount(), std::max(1, height / minBandHeight));
+
+    while (static_cast<int>(m_scanRenders.size()) < bandCount)
+        m_scanRenders.emplace_back(new ScanRender());
+
+    // QImage::bits() detaches, which is not thread safe. Detach once here and hand each band a view of the
+    // same pixels.
+    uchar *pixels = pDest->bits();
+    std::vector<QImage> bandImages;
+    bandImages.reserve(bandCount);
+    for (int i = 0; i < bandCount; i++)
+        bandImages.emplace_back(pixels, pDest->width(), height, pDest->bytesPerLine(), pDest->format());
+
+    std::vector<int> bands(bandCount);
+    std::iota(bands.begin(), bands.end(), 0);
+
+    QtConcurrent::blockingMap(bands, [&](const int band)
+    {
+        const int top = height * band / bandCount;
+        const int bottom = height * (band + 1) / bandCount;
+
+        ScanRender *scanRender = m_scanRenders[band].get();
+        scanRender->setBilinearInterpolationEnabled(bilinear);
+        scanRender->setClipRows(top, bottom);
+
+        for (const Tile &tile : m_tiles)
         {
-            QPainter p(pDest);
-            p.setRenderHint(QPainter::Antialiasing);
-            p.setPen(gridColor);
-
-            p.drawLine(cornerScreenCoords[0].x(), cornerScreenCoords[0].y(), cornerScreenCoords[1].x(), cornerScreenCoords[1].y());
-            p.drawLine(cornerScreenCoords[1].x(), cornerScreenCoords[1].y(), cornerScreenCoords[2].x(), cornerScreenCoords[2].y());
-            p.drawLine(cornerScreenCoords[2].x(), cornerScreenCoords[2].y(), cornerScreenCoords[3].x(), cornerScreenCoords[3].y());
-            p.drawLine(cornerScreenCoords[3].x(), cornerScreenCoords[3].y(), cornerScreenCoords[0].x(), cornerScreenCoords[0].y());
-            p.drawText((cornerScreenCoords[0].x() + cornerScreenCoords[1].x() + cornerScreenCoords[2].x() + cornerScreenCoords[3].x()) / 4,
-                       (cornerScreenCoords[0].y() + cornerScreenCoords[1].y() + cornerScreenCoords[2].y() + cornerScreenCoords[3].y()) / 4, QString::number(pix) + " / " + QString::number(level));
-        }
+            if (tile.image == nullptr || tile.bottom < top || tile.top >= bottom)
+                continue;
 
-        return true;
-    }
+            for (int j = 0; j < 16; j++)
+                scanRender->renderPolygon(3, tile.fine[j], &bandImages[band], tile.image, uv[j]);
+        }
+    });
+}
 
-    return false;
+void HIPSRenderer::drawGrid(const Tile &tile, int level, QImage *pDest)
+{
+    const QPointF *cornerScreenCoords = tile.corners;
+
+    QPainter p(pDest);
+    p.setRenderHint(QPainter::Antialiasing);
+    p.setPen(gridColor);
+
+    p.drawLine(cornerScreenCoords[0].x(), cornerScreenCoords[0].y(), cornerScreenCoords[1].x(), cornerScreenCoords[1].y());
+    p.drawLine(cornerScreenCoords[1].x(), cornerScreenCoords[1].y(), cornerScreenCoords[2].x(), cornerScreenCoords[2].y());
+    p.drawLine(cornerScreenCoords[2].x(), cornerScreenCoords[2].y(), cornerScreenCoords[3].x(), cornerScreenCoords[3].y());
+    p.drawLine(cornerScreenCoords[3].x(), cornerScreenCoords[3].y(), cornerScreenCoords[0].x(), cornerScreenCoords[0].y());
+    p.drawText((cornerScreenCoords[0].x() + cornerScreenCoords[1].x() + cornerScreenCoords[2].x() + cornerScreenCoords[3].x()) / 4,
+               (cornerScreenCoords[0].y() + cornerScreenCoords[1].y() + cornerScreenCoords[2].y() + cornerScreenCoords[3].y()) / 4, QString::number(tile.pix) + " / " + QString::number(level));
 }
@@ -13,6 +13,7 @@
 #include "scanrender.h"
 
 #include <memory>
+#include <vector>
 
 class Projector;
 
@@ -23,20 +24,38 @@ public:
   explicit HIPSRenderer();
   //void render(mapView_t *view, CSkPainter *painter, QImage *pDest);
   bool render(uint16_t w, uint16_t h, QImage *hipsImage, const Projector *m_proj);
-  void renderRec(bool allsky, int level, int pix, QImage *pDest);
-  bool renderPix(bool allsky, int level, int pix, QImage *pDest);
 
 signals:
 
 public slots:
 
-private:  
+private:
+  // A visible HiPS pixel: its image and the screen coordinates of its corners and of its 4x4 grandchildren
+  struct Tile
+  {
+    int pix;
+    QImage *image;
+    bool freeImage;
+    QPointF corners[4];
+    QPointF fine[16][4];
+    // Destination rows covered by the grandchildren
+    int top;
+    int bottom;
+  };
+
+  void collectTiles(bool allsky, int level, int centerPix);
+  bool collectPix(bool allsky, int level, int pix);
+  void rasterizeTiles(QImage *pDest, bool bilinear);
+  void drawGrid(const Tile &tile, int level, QImage *pDest);
+
   int m_blocks { 0 };
   int m_rendered { 0 };
   int m_size { 0 };
   QSet<int>  m_renderedMap;
+  QVector<Tile> m_tiles;
   std::unique_ptr<HEALPix> m_HEALpix;
-  std::unique_ptr<ScanRender> m_scanRender;
+  // One scan renderer per band of destination rows
+  std::vector<std::unique_ptr<ScanRender>> m_scanRenders;
   const Projector *m_projector;
   QColor gridColor;
 };
@@ -8,6 +8,11 @@
 
 #include "scanrender.h"
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SCANRENDER_SSE2
+#endif
+
 //#include <omp.h>
 //#define PARALLEL_OMP
 
@@ -19,6 +24,43 @@
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wcast-align"
 
+// Bilinear interpolation of four RGB32 pixels a b / c d, fx and fy being the
+// fractional position in 1/256 units. The weights are rounded to 1/256 so that
+// each channel sum fits 16 bits, which allows the four channels of the four
+// pixels to be weighted in one go.
+static inline quint32 bilinearRGB32(quint32 a, quint32 b, quint32 c, quint32 d, int fx, int fy)
+{
+  const int wa = ((256 - fx) * (256 - fy)) >> 8;
+  const int wb = (fx * (256 - fy)) >> 8;
+  const int wc = ((256 - fx) * fy) >> 8;
+  const int wd = 256 - wa - wb - wc;
+
+#ifdef SCANRENDER_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i ab = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128(static_cast<int>(a)),
+                                                          _mm_cvtsi32_si128(static_cast<int>(b))), zero);
+  const __m128i cd = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128(static_cast<int>(c)),
+                                                          _mm_cvtsi32_si128(static_cast<int>(d))), zero);
+  const __m128i wab = _mm_set_epi16(wb, wb, wb, wb, wa, wa, wa, wa);
+  const __m128i wcd = _mm_set_epi16(wd, wd, wd, wd, wc, wc, wc, wc);
+
+  __m128i sum = _mm_add_epi16(_mm_mullo_epi16(ab, wab), _mm_mullo_epi16(cd, wcd));
+  sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+  sum = _mm_srli_epi16(sum, 8);
+
+  return static_cast<quint32>(_mm_cvtsi128_si32(_mm_packus_epi16(sum, sum)));
+#else
+  quint32 result = 0;
+  for (int shift = 0; shift < 32; shift += 8)
+  {
+    const quint32 channel = (((a >> shift) & 0xff) * wa + ((b >> shift) & 0xff) * wb +
+                             ((c >> shift) & 0xff) * wc + ((d >> shift) & 0xff) * wd) >> 8;
+    result |= channel << shift;
+  }
+  return result;
+#endif
+}
+
 //////////////////////////////
 ScanRender::ScanRender(void)
 //////////////////////////////
@@ -39,6 +81,14 @@ bool ScanRender::isBilinearInterpolationEnabled()
   return(bBilinear);
 }
 
+/////////////////////////////////////////////////
+void ScanRender::setClipRows(int top, int bottom)
+/////////////////////////////////////////////////
+{
+  m_clipTop = qMax(top, 0);
+  m_clipBottom = bottom;
+}
+
 ///////////////////////////////////////////////
 void ScanRender::resetScanPoly(int sx, int sy)
 ///////////////////////////////////////////////
@@ -54,6 +104,8 @@ void ScanRender::resetScanPoly(int sx, int sy)
 
   m_sx = sx;
   m_sy = sy;
+  m_top = m_clipTop;
+  m_bottom = m_clipBottom < 0 ? sy : qMin(m_clipBottom, sy);
 }
 
 //////////////////////////////////////////////////////////
@@ -73,12 +125,12 @@ void ScanRender::scanLine(int x1, int y1, int x2, int y2)
     side = 1;
   }
 
-  if (y2 < 0)
+  if (y2 < m_top)
   {
     return; // offscreen
   }
 
-  if (y1 >= m_sy)
+  if (y1 >= m_bottom)
   {
     return; // offscreen
   }
@@ -94,17 +146,17 @@ void ScanRender::scanLine(int x1, int y1, int x2, int y2)
   float x = x1;
   int   y;
 
-  if (y2 >= m_sy)
+  if (y2 >= m_bottom)
   {
-    y2 = m_sy - 1;
+    y2 = m_bottom - 1;
   }
 
-  if (y1 < 0)
+  if (y1 < m_top)
   { // partially off screen
-    float m = (float) -y1;
+    float m = (float) (m_top - y1);
 
     x += dx * m;
-    y1 = 0;
+    y1 = m_top;
   }
 
   int minY = qMin(y1, y2);
@@ -168,9 +220,9 @@ void ScanRender::scanLine(int x1, int y1, int x2, int y2, float u1, float v1, fl
     side = 1;
   }
 
-  if (y2 < 0)
+  if (y2 < m_top)
     return; // offscreen
-  if (y1 >= m_sy)
+  if (y1 >= m_bottom)
     return; // offscreen
 
   float dy = (float)(y2 - y1);
@@ -182,8 +234,8 @@ void ScanRender::scanLine(int x1, int y1, int x2, int y2, float u1, float v1, fl
   float x = x1;
   int   y;
 
-  if (y2 >= m_sy)
-    y2 = m_sy - 1;
+  if (y2 >= m_bottom)
+    y2 = m_bottom - 1;
 
   float duv[2];
   float uv[2] = {u1, v1};
@@ -191,15 +243,15 @@ void ScanRender::scanLine(int x1, int y1, int x2, int y2, float u1, float v1, fl
   duv[0] = (u2 - u1) / dy;
   duv[1] = (v2 - v1) / dy;
 
-  if (y1 < 0)
+  if (y1 < m_top)
   { // partially off screen
-    float m = (float) -y1;
+    float m = (float) (m_top - y1);
 
     uv[0] += duv[0] * m;
     uv[1] += duv[1] * m;
 
     x += dx * m;
-    y1 = 0;
+    y1 = m_top;
   }
 
   int minY = qMin(y1, y2);
@@ -333,7 +385,7 @@ void ScanRender::renderPolygon(QImage *dst, QImage *src)
     renderPolygonNI(dst, src);
 }
 
-void ScanRender::renderPolygon(int interpolation, QPointF *pts, QImage *pDest, QImage *pSrc, QPointF *uv)
+void ScanRender::renderPolygon(int interpolation, const QPointF *pts, QImage *pDest, QImage *pSrc, const QPointF *uv)
 {
   QPointF Auv = uv[0];
   QPointF Buv = uv[1];
@@ -408,6 +460,8 @@ void ScanRender::renderPolygonNI(QImage *dst, QImage *src)
   int w = dst->width();
   int sw = src->width();
   int sh = src->height();
+  // The source may be a view into a larger image, its rows are not necessarily contiguous
+  int stride = src->bytesPerLine();
   float tsx = src->width() - 1;
   float tsy = src->height() - 1;
   const quint32 *bitsSrc = (quint32 *)src->constBits();
@@ -477,7 +531,7 @@ void ScanRender::renderPolygonNI(QImage *dst, QImage *src)
     {
       for (int x = px1; x < px2; x++)
       {
-        const uchar *pSrc = (uchar *)bitsSrc + (fuv[0] >> 16) + ((fuv[1] >> 16) * sw);
+        const uchar *pSrc = (uchar *)bitsSrc + (fuv[0] >> 16) + ((fuv[1] >> 16) * stride);
         *pDst = qRgb(*pSrc, *pSrc, *pSrc);
         pDst++;
 
@@ -489,7 +543,7 @@ void ScanRender::renderPolygonNI(QImage *dst, QImage *src)
     {                  
       for (int x = px1; x < px2; x++)
       {        
-        int offset = (fuv[0] >> 16) + ((fuv[1] >> 16) * sw);        
+        int offset = (fuv[0] >> 16) + ((fuv[1] >> 16) * (stride >> 2));
 
         const quint32 *pSrc = bitsSrc + offset;
         *pDst = (*pSrc) | (0xFF << 24);
@@ -511,6 +565,9 @@ void ScanRender::renderPolygonBI(QImage *dst, QImage *src)
   int w = dst->width();
   int sw = src->width();
   int sh = src->height();
+  // The source may be a view into a larger image, its rows are not necessarily contiguous
+  int stride8 = src->bytesPerLine();
+  int stride = stride8 >> 2;
   float tsx = src->width() - 1;
   float tsy = src->height() - 1;
   const quint32 *bitsSrc = (quint32 *)src->constBits();
@@ -565,75 +622,42 @@ void ScanRender::renderPolygonBI(QImage *dst, QImage *src)
     duv[0] *= tsx;
     duv[1] *= tsy;
 
-    int size = sw * sh;
-
     quint32 *pDst = bitsDst + (y * w) + px1;
-    if (bw)
+    for (int x = px1; x < px2; x++)
     {
-      for (int x = px1; x < px2; x++)
+      // Neighbours past the last row or column repeat the edge
+      int ix = CLAMP(static_cast<int>(uv[0]), 0, sw - 1);
+      int iy = CLAMP(static_cast<int>(uv[1]), 0, sh - 1);
+      int nx = ix < sw - 1 ? 1 : 0;
+      int ny = iy < sh - 1 ? 1 : 0;
+      float x_diff = CLAMP(uv[0] - ix, 0.0f, 1.0f);
+      float y_diff = CLAMP(uv[1] - iy, 0.0f, 1.0f);
+
+      if (bw)
       {
-        float x_diff = uv[0] - static_cast<int>(uv[0]);
-        float y_diff = uv[1] - static_cast<int>(uv[1]);
-        float x_1diff = 1 - x_diff;
-        float y_1diff = 1 - y_diff;
+        const uchar *row = bitsSrc8 + iy * stride8 + ix;
+        uchar a = row[0];
+        uchar b = row[nx];
+        uchar c = row[ny * stride8];
+        uchar d = row[ny * stride8 + nx];
 
-        int index = ((int)uv[0] + ((int)uv[1] * sw));
-
-        uchar a = bitsSrc8[index];
-        uchar b = bitsSrc8[(index + 1) % size];
-        uchar c = bitsSrc8[(index + sw) % size];
-        uchar d = bitsSrc8[(index + sw + 1) % size];
-
-        int val = (a&0xff)*(x_1diff)*(y_1diff) + (b&0xff)*(x_diff)*(y_1diff) +
-                  (c&0xff)*(y_diff)*(x_1diff)   + (d&0xff)*(x_diff*y_diff);
-
-        *pDst = 0xff000000 |
-                ((((int)val)<<16)&0xff0000) |
-                ((((int)val)<<8)&0xff00) |
-                ((int)val) ;
-        pDst++;
+        int val = a * (1 - x_diff) * (1 - y_diff) + b * x_diff * (1 - y_diff) +
+                  c * y_diff * (1 - x_diff) + d * x_diff * y_diff;
 
-        uv[0] += duv[0];
-        uv[1] += duv[1];
+        *pDst = 0xff000000 | (val << 16) | (val << 8) | val;
       }
-    }
-    else
-    {
-      for (int x = px1; x < px2; x++)
+      else
       {
-        float x_diff = uv[0] - static_cast<int>(uv[0]);
-        float y_diff = uv[1] - static_cast<int>(uv[1]);
-        float x_1diff = 1 - x_diff;
-        float y_1diff = 1 - y_diff;
-
-        int index = ((int)uv[0] + ((int)uv[1] * sw));
-
-        quint32 a = bitsSrc[index];
-        quint32 b = bitsSrc[(index + 1) % size];
-        quint32 c = bitsSrc[(index + sw) % size];
-        quint32 d = bitsSrc[(index + sw + 1) % size];
-
-        int qxy1 = (x_1diff * y_1diff) * 65536;
-        int qxy2 =(x_diff * y_1diff) * 65536;
-        int qxy = (x_diff * y_diff) * 65536;
-        int qyx1 = (y_diff * x_1diff) * 65536;
-
-        // blue element
-        int blue = ((a&0xff)*(qxy1) + (b&0xff)*(qxy2) + (c&0xff)*(qyx1)  + (d&0xff)*(qxy)) >> 16;
-
-        // green element
-        int green = (((a>>8)&0xff)*(qxy1) + ((b>>8)&0xff)*(qxy2) + ((c>>8)&0xff)*(qyx1)  + ((d>>8)&0xff)*(qxy)) >> 16;
-
-        // red element
-        int red = (((a>>16)&0xff)*(qxy1) + ((b>>16)&0xff)*(qxy2) +((c>>16)&0xff)*(qyx1)  + ((d>>16)&0xff)*(qxy)) >> 16;
-
-        *pDst = 0xff000000 | (((red)<<16)&0xff0000) | (((green)<<8)&0xff00) | (blue);
+        const quint32 *row = bitsSrc + iy * stride + ix;
+        *pDst = 0xff000000 | bilinearRGB32(row[0], row[nx], row[ny * stride], row[ny * stride + nx],
+                                           qMin(static_cast<int>(x_diff * 256.0f), 255),
+                                           qMin(static_cast<int>(y_diff * 256.0f), 255));
+      }
 
-        pDst++;
+      pDst++;
 
-        uv[0] += duv[0];
-        uv[1] += duv[1];
-      }
+      uv[0] += duv[0];
+      uv[1] += duv[1];
     }
   }
 }
@@ -654,6 +678,7 @@ void ScanRender::renderPolygonAlphaBI(QImage *dst, QImage *src)
   int sh = src->height();
   float tsx = src->width() - 1;
   float tsy = src->height() - 1;
+  int stride = src->bytesPerLine() >> 2;
   const quint32 *bitsSrc = (quint32 *)src->constBits();  
   quint32 *bitsDst = (quint32 *)dst->bits();
   bkScan_t *scan = scLR;
@@ -706,8 +731,6 @@ void ScanRender::renderPolygonAlphaBI(QImage *dst, QImage *src)
     duv[0] *= tsx;
     duv[1] *= tsy;
 
-    int size = sw * sh;
-
     quint32 *pDst = bitsDst + (y * w) + px1;
     if (bw)
     {
@@ -750,12 +773,16 @@ void ScanRender::renderPolygonAlphaBI(QImage *dst, QImage *src)
         float x_1diff = 1 - x_diff;
         float y_1diff = 1 - y_diff;
 
-        int index = ((int)uv[0] + ((int)uv[1] * sw));
+        int ix = CLAMP((int)uv[0], 0, sw - 1);
+        int iy = CLAMP((int)uv[1], 0, sh - 1);
+        int nx = ix < sw - 1 ? 1 : 0;
+        int ny = iy < sh - 1 ? stride : 0;
+        int index = ix + iy * stride;
 
         quint32 a = bitsSrc[index];
-        quint32 b = bitsSrc[(index + 1) % size];
-        quint32 c = bitsSrc[(index + sw) % size];
-        quint32 d = bitsSrc[(index + sw + 1) % size];
+        quint32 b = bitsSrc[index + nx];
+        quint32 c = bitsSrc[index + ny];
+        quint32 d = bitsSrc[index + ny + nx];
 
         int x1y1 = (x_1diff * y_1diff) * 65536;
         int xy = (x_diff * y_diff) * 65536;
@@ -801,16 +828,16 @@ void ScanRender::renderPolygonAlphaNI(QImage *dst, QImage *src)
 ////////////////////////////////////////////////////////////////
 {
   int w = dst->width();
-  int sw = src->width();
   float tsx = src->width() - 1;
   float tsy = src->height() - 1;
+  int stride = src->bytesPerLine() >> 2;
   const quint32 *bitsSrc = (quint32 *)src->constBits();
   quint32 *bitsDst = (quint32 *)dst->bits();
   bkScan_t *scan = scLR;
   float opacity = 0.00390625f * m_opacity;    
 
 #ifdef PARALLEL_OMP
-  #pragma omp parallel for shared(bitsDst, bitsSrc, scan, tsx, tsy, w, sw)
+  #pragma omp parallel for shared(bitsDst, bitsSrc, scan, tsx, tsy, w, stride)
 #endif
   for (int y = plMinY; y <= plMaxY; y++)
   {
@@ -859,7 +886,7 @@ void ScanRender::renderPolygonAlphaNI(QImage *dst, QImage *src)
 
     for (int x = px1; x < px2; x++)
     {
-      const quint32 *pSrc = bitsSrc + ((int)(uv[0])) + ((int)(uv[1]) * sw);
+      const quint32 *pSrc = bitsSrc + ((int)(uv[0])) + ((int)(uv[1]) * stride);
       QRgb rgbs = *pSrc;
       QRgb rgbd = *pDst;
       float a = qAlpha(*pSrc) * opacity;
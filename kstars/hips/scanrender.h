@@ -26,12 +26,18 @@ class ScanRender
     explicit ScanRender(void);
     void setBilinearInterpolationEnabled(bool enable);
     bool isBilinearInterpolationEnabled(void);
+    /**
+     * @brief setClipRows Restrict the following polygons to the destination rows [top, bottom[.
+     * Renderers with disjoint row ranges can then draw into the same image concurrently.
+     * A negative bottom removes the restriction.
+     */
+    void setClipRows(int top, int bottom);
     void resetScanPoly(int sx, int sy);
     void scanLine(int x1, int y1, int x2, int y2);
     void scanLine(int x1, int y1, int x2, int y2, float u1, float v1, float u2, float v2);
     void renderPolygon(QColor col, QImage *dst);
     void renderPolygon(QImage *dst, QImage *src);
-    void renderPolygon(int interpolation, QPointF *pts, QImage *pDest, QImage *pSrc, QPointF *uv);
+    void renderPolygon(int interpolation, const QPointF *pts, QImage *pDest, QImage *pSrc, const QPointF *uv);
 
     void renderPolygonNI(QImage *dst, QImage *src);
     void renderPolygonBI(QImage *dst, QImage *src);
@@ -49,6 +55,11 @@ private:
     int      plMaxY { 0 };
     int      m_sx { 0 };
     int      m_sy { 0 };
+    // Rows scanned by the current polygon, the clip rows within the destination
+    int      m_top { 0 };
+    int      m_bottom { 0 };
+    int      m_clipTop { 0 };
+    int      m_clipBottom { -1 };
     bkScan_t scLR[MAX_BK_SCANLINES];
     bool     bBilinear { false };
 };
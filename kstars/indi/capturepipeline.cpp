@@ -0,0 +1,228 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "capturepipeline.h"
+
+#include <QMutexLocker>
+#include <QStringList>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+#include <indi_debug.h>
+
+namespace ISD
+{
+
+void LatencyHistogram::add(qint64 nanoseconds)
+{
+    const qint64 milliseconds = nanoseconds / 1000000;
+    int index = 0;
+    while (index < BUCKET_COUNT - 1 && (qint64(1) << index) <= milliseconds)
+        index++;
+
+    m_Buckets[index]++;
+    m_Count++;
+    m_Total += nanoseconds;
+    m_Max = std::max(m_Max, nanoseconds);
+}
+
+double LatencyHistogram::mean() const
+{
+    return m_Count > 0 ? m_Total / 1e6 / m_Count : 0;
+}
+
+double LatencyHistogram::percentile(double percent) const
+{
+    const quint64 rank = qRound64(m_Count * percent / 100.0);
+    quint64 seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++)
+    {
+        seen += m_Buckets[i];
+        if (seen >= rank && seen > 0)
+            return i == BUCKET_COUNT - 1 ? max() : qint64(1) << i;
+    }
+    return 0;
+}
+
+QString LatencyHistogram::toString() const
+{
+    QStringList buckets;
+    for (int i = 0; i < BUCKET_COUNT; i++)
+    {
+        if (m_Buckets[i] > 0)
+            buckets << QString("<%1ms:%2").arg(qint64(1) << i).arg(m_Buckets[i]);
+    }
+    return QString("n=%1 mean=%2ms p50<=%3ms p95<=%4ms max=%5ms [%6]")
+           .arg(m_Count).arg(mean(), 0, 'f', 1).arg(percentile(50)).arg(percentile(95))
+           .arg(max(), 0, 'f', 1).arg(buckets.join(' '));
+}
+
+CapturePipeline::CapturePipeline(int capacity, int maxBacklog, QObject *parent) : QObject(parent), m_Slots(capacity),
+    m_MaxBacklog(maxBacklog)
+{
+    for (auto &worker : m_Workers)
+        worker.setMaxThreadCount(1);
+}
+
+CapturePipeline::~CapturePipeline()
+{
+    // Handlers run on the workers may reference the owner of the pipeline, finish them before it goes away.
+    waitForDone();
+}
+
+void CapturePipeline::setHandler(Stage stage, const Handler &handler)
+{
+    m_Handlers[stage] = handler;
+}
+
+bool CapturePipeline::submit(const QSharedPointer<CaptureFrame> &frame)
+{
+    frame->sequence = m_NextSequence++;
+
+    // Back-pressure, without stalling the thread receiving the frames. Frames of the backlog go first to
+    // keep the order.
+    if (!m_Backlog.isEmpty() || !m_Slots.tryAcquire())
+    {
+        // The exposures still running when the pipeline saturated are kept, but the copies of the frames
+        // are not buffered without limit.
+        if (m_Backlog.size() >= m_MaxBacklog)
+        {
+            qCWarning(KSTARS_INDI) << "Capture pipeline backlog is full, waiting for the analyze stage";
+            m_Slots.acquire();
+            start(m_Backlog.dequeue());
+        }
+        m_Backlog.enqueue(frame);
+        qCWarning(KSTARS_INDI) << "Capture pipeline is full, frame" << frame->sequence << "waits behind"
+                               << m_Backlog.size() - 1 << "frames";
+        updateSaturation();
+        return false;
+    }
+
+    start(frame);
+    return true;
+}
+
+void CapturePipeline::waitForDone()
+{
+    while (!m_Backlog.isEmpty())
+    {
+        m_Slots.acquire();
+        start(m_Backlog.dequeue());
+    }
+    updateSaturation();
+
+    // Each stage queues the next one before completing, so waiting in stage order covers every frame.
+    for (int stage = STAGE_PERSIST; stage < STAGE_DISPLAY; stage++)
+        m_Workers[stage].waitForDone();
+}
+
+LatencyHistogram CapturePipeline::latency(Stage stage) const
+{
+    QMutexLocker locker(&m_LatencyMutex);
+    return m_Latency[stage];
+}
+
+QString CapturePipeline::stageName(Stage stage)
+{
+    switch (stage)
+    {
+        case STAGE_RECEIVE:
+            return "receive";
+        case STAGE_PERSIST:
+            return "persist";
+        case STAGE_DECODE:
+            return "decode";
+        case STAGE_ANALYZE:
+            return "analyze";
+        case STAGE_DISPLAY:
+            return "display";
+        default:
+            return QString();
+    }
+}
+
+void CapturePipeline::start(const QSharedPointer<CaptureFrame> &frame)
+{
+    // The time spent in the backlog counts as receive latency.
+    {
+        QMutexLocker locker(&m_LatencyMutex);
+        m_Latency[STAGE_RECEIVE].add(frame->receivedTimer.nsecsElapsed());
+    }
+    enqueue(STAGE_PERSIST, frame);
+}
+
+void CapturePipeline::drainBacklog()
+{
+    while (!m_Backlog.isEmpty() && m_Slots.tryAcquire())
+        start(m_Backlog.dequeue());
+    updateSaturation();
+}
+
+void CapturePipeline::updateSaturation()
+{
+    const bool saturated = !m_Backlog.isEmpty();
+    if (saturated == m_Saturated)
+        return;
+
+    m_Saturated = saturated;
+    emit this->saturated(saturated);
+}
+
+void CapturePipeline::enqueue(Stage stage, const QSharedPointer<CaptureFrame> &frame)
+{
+    frame->stageTimer.start();
+
+    if (stage == STAGE_DISPLAY)
+    {
+        QMetaObject::invokeMethod(this, [this, frame]()
+        {
+            process(STAGE_DISPLAY, frame);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    QtConcurrent::run(&m_Workers[stage], [this, stage, frame]()
+    {
+        process(stage, frame);
+    });
+}
+
+void CapturePipeline::process(Stage stage, const QSharedPointer<CaptureFrame> &frame)
+{
+    // A failed frame still goes through display so that the failure is reported in order.
+    if (m_Handlers[stage] && (!frame->failed || stage == STAGE_DISPLAY))
+    {
+        if (!m_Handlers[stage](*frame))
+            frame->failed = true;
+    }
+
+    {
+        QMutexLocker locker(&m_LatencyMutex);
+        m_Latency[stage].add(frame->stageTimer.nsecsElapsed());
+    }
+
+    if (stage == STAGE_ANALYZE)
+    {
+        m_Slots.release();
+        QMetaObject::invokeMethod(this, &CapturePipeline::drainBacklog, Qt::QueuedConnection);
+    }
+
+    if (stage < STAGE_DISPLAY)
+    {
+        enqueue(static_cast<Stage>(stage + 1), frame);
+        return;
+    }
+
+    // Summarize where the time goes every few dozen frames.
+    if (frame->sequence % 50 == 49)
+    {
+        for (int i = STAGE_RECEIVE; i < STAGE_COUNT; i++)
+            qCDebug(KSTARS_INDI) << "Capture pipeline" << stageName(static_cast<Stage>(i)) << "latency"
+                                 << latency(static_cast<Stage>(i)).toString();
+    }
+}
+}
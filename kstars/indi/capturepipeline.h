@@ -0,0 +1,191 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "fitsviewer/fitscommon.h"
+
+#include <indiapi.h>
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QQueue>
+#include <QSemaphore>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+#include <array>
+#include <functional>
+
+class FITSData;
+
+namespace ISD
+{
+class CameraChip;
+
+/**
+ * @brief The CaptureFrame struct holds a received frame while it travels through the CapturePipeline.
+ */
+struct CaptureFrame
+{
+    /// Order of arrival, frames always leave the pipeline in this order.
+    quint64 sequence { 0 };
+    /// Private copy of the BLOB data, the INDI client reuses the BLOB memory once processBLOB returns.
+    QByteArray data;
+    /// Copy of the BLOB descriptor, pointing at the above data.
+    IBLOB blob {};
+    CameraChip *chip { nullptr };
+    FITSMode captureMode { FITS_NORMAL };
+    QString format;
+    QString filename;
+    /// Write the frame to filename before decoding it.
+    bool persist { false };
+    /// Decode and analyze the frame, false if it is only saved.
+    bool decode { true };
+    /// Build the histogram in the analyze stage, decided from the options when the frame is received.
+    bool histogram { false };
+    QSharedPointer<FITSData> imageData;
+    /// Set by the stage that failed, the following stages are skipped except for display.
+    bool failed { false };
+    int errorType { 0 };
+    /// Started when the BLOB is received.
+    QElapsedTimer receivedTimer;
+    /// Started when the frame is queued for its current stage.
+    QElapsedTimer stageTimer;
+};
+
+/**
+ * @brief The LatencyHistogram class counts stage latencies in power of two millisecond buckets.
+ */
+class LatencyHistogram
+{
+    public:
+        static constexpr int BUCKET_COUNT { 16 };
+
+        void add(qint64 nanoseconds);
+
+        /// Number of samples in bucket, which covers [2^(bucket-1), 2^bucket[ ms, bucket 0 being < 1 ms.
+        quint64 bucket(int bucket) const
+        {
+            return m_Buckets[bucket];
+        }
+        quint64 count() const
+        {
+            return m_Count;
+        }
+        /// Latencies in milliseconds.
+        double mean() const;
+        double max() const
+        {
+            return m_Max / 1e6;
+        }
+        /// Upper bound of the bucket holding the given percentile (0-100).
+        double percentile(double percent) const;
+
+        QString toString() const;
+
+    private:
+        std::array<quint64, BUCKET_COUNT> m_Buckets {};
+        quint64 m_Count { 0 };
+        qint64 m_Total { 0 };
+        qint64 m_Max { 0 };
+};
+
+/**
+ * @class CapturePipeline
+ * Processes received camera frames in ordered stages: receive, persist, decode, analyze and display.
+ *
+ * The receive stage is done by the caller on the GUI thread and only copies the BLOB. Persist, decode and
+ * analyze each run on a dedicated worker thread, so a frame can be decoded while the next one is written
+ * to disk. Display runs back on the thread of the pipeline. Since every stage has a single thread, frames
+ * leave each stage in the order they were submitted.
+ *
+ * At most capacity frames can be between receive and display. Beyond that, submit() does not block the
+ * receiving thread: the frame waits in a backlog, with a warning, until the analyze stage releases a frame.
+ * The pipeline is saturated while frames wait in the backlog, the camera then holds back its next exposures.
+ * Since every frame holds a copy of its BLOB, the backlog is capped at maxBacklog frames. Frames are never
+ * dropped, past the cap submit() waits for the analyze stage to release a frame.
+ * Handlers of the worker stages must not read the options nor create objects living on the GUI thread,
+ * both are prepared when the frame is received.
+ */
+class CapturePipeline : public QObject
+{
+        Q_OBJECT
+
+    public:
+        typedef enum
+        {
+            STAGE_RECEIVE,
+            STAGE_PERSIST,
+            STAGE_DECODE,
+            STAGE_ANALYZE,
+            STAGE_DISPLAY,
+            STAGE_COUNT
+        } Stage;
+
+        /// Return false to mark the frame as failed.
+        typedef std::function<bool(CaptureFrame &frame)> Handler;
+
+        explicit CapturePipeline(int capacity = 3, int maxBacklog = 3, QObject *parent = nullptr);
+        ~CapturePipeline() override;
+
+        void setHandler(Stage stage, const Handler &handler);
+
+        /**
+         * @brief submit Queue a received frame for the persist stage, without blocking.
+         * @return false if the pipeline is full, the frame then waits in the backlog for a frame to leave
+         * the worker stages. If the backlog is full too, this waits for the analyze stage to release a frame.
+         */
+        bool submit(const QSharedPointer<CaptureFrame> &frame);
+
+        /// Number of frames waiting in the backlog.
+        int backlog() const
+        {
+            return m_Backlog.size();
+        }
+
+        /// Whether frames wait in the backlog, no new exposure should be started until it is drained.
+        bool isSaturated() const
+        {
+            return m_Saturated;
+        }
+
+        /**
+         * @brief waitForDone Wait until all submitted frames, including the backlog, went through the worker
+         * stages. Their display stage may still be pending in the event loop.
+         */
+        void waitForDone();
+
+        LatencyHistogram latency(Stage stage) const;
+        static QString stageName(Stage stage);
+
+    signals:
+        /// Emitted on the thread of the pipeline when frames start or stop waiting in the backlog.
+        void saturated(bool saturated);
+
+    private:
+        void start(const QSharedPointer<CaptureFrame> &frame);
+        void enqueue(Stage stage, const QSharedPointer<CaptureFrame> &frame);
+        // Starts the frames of the backlog while the pipeline has room, on the thread of the pipeline.
+        void drainBacklog();
+        void updateSaturation();
+        void process(Stage stage, const QSharedPointer<CaptureFrame> &frame);
+
+        std::array<Handler, STAGE_COUNT> m_Handlers;
+        std::array<QThreadPool, STAGE_COUNT> m_Workers;
+        QSemaphore m_Slots;
+        // Frames received while the pipeline was full, only accessed on the thread of the pipeline.
+        QQueue<QSharedPointer<CaptureFrame>> m_Backlog;
+        int m_MaxBacklog { 3 };
+        bool m_Saturated { false };
+        quint64 m_NextSequence { 0 };
+
+        mutable QMutex m_LatencyMutex;
+        std::array<LatencyHistogram, STAGE_COUNT> m_Latency;
+};
+}
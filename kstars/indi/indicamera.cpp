@@ -53,16 +53,16 @@ Camera::Camera(GenericDevice *parent) : ConcreteDevice(parent)
 
     connect(m_Parent->getClientManager(), &ClientManager::newBLOBManager, this, &Camera::setBLOBManager, Qt::UniqueConnection);
     m_LastNotificationTS = QDateTime::currentDateTime();
+
+    initCapturePipeline();
 }
 
 Camera::~Camera()
 {
     if (m_ImageViewerWindow)
         m_ImageViewerWindow->close();
-    if (fileWriteThread.isRunning())
-        fileWriteThread.waitForFinished();
-    if (fileWriteBuffer != nullptr)
-        delete [] fileWriteBuffer;
+    // Wait for the frames still being saved.
+    m_CapturePipeline.reset();
 }
 
 void Camera::setBLOBManager(const char *device, INDI::Property prop)
@@ -564,48 +564,6 @@ bool Camera::generateFilename(bool batch_mode, const QString &extension, QString
     return true;
 }
 
-bool Camera::writeImageFile(const QString &filename, IBLOB *bp, bool is_fits)
-{
-    // TODO: Not yet threading the writes for non-fits files.
-    // Would need to deal with the raw conversion, etc.
-    if (is_fits)
-    {
-        // Check if the last write is still ongoing, and if so wait.
-        // It is using the fileWriteBuffer.
-        if (fileWriteThread.isRunning())
-        {
-            fileWriteThread.waitForFinished();
-        }
-
-        // Wait until the file is written before overwritting the filename.
-        fileWriteFilename = filename;
-
-        // Will write blob data in a separate thread, and can't depend on the blob
-        // memory, so copy it first.
-
-        // Check buffer size.
-        if (fileWriteBufferSize != bp->bloblen)
-        {
-            if (fileWriteBuffer != nullptr)
-                delete [] fileWriteBuffer;
-            fileWriteBufferSize = bp->bloblen;
-            fileWriteBuffer = new char[fileWriteBufferSize];
-        }
-
-        // Copy memory, and write file on a separate thread.
-        // Probably too late to return an error if the file couldn't write.
-        memcpy(fileWriteBuffer, bp->blob, bp->bloblen);
-        fileWriteThread = QtConcurrent::run(this, &ISD::Camera::WriteImageFileInternal, fileWriteFilename, fileWriteBuffer,
-                                            bp->bloblen);
-    }
-    else
-    {
-        if (!WriteImageFileInternal(filename, static_cast<char*>(bp->blob), bp->bloblen))
-            return false;
-    }
-    return true;
-}
-
 // Get or Create FITSViewer if we are using FITSViewer
 // or if capture mode is calibrate since for now we are forced to open the file in the viewer
 // this should be fixed in the future and should only use FITSData
@@ -655,6 +613,9 @@ bool Camera::processBLOB(IBLOB *bp)
     if (bp->bvp->p == IP_WO || bp->size == 0)
         return false;
 
+    QElapsedTimer receivedTimer;
+    receivedTimer.start();
+
     BType = BLOB_OTHER;
 
     QString format = QString(bp->format).toLower();
@@ -713,35 +674,19 @@ bool Camera::processBLOB(IBLOB *bp)
     }
 #endif
     // Create file name for sequences.
-    if (targetChip->isBatchMode() && targetChip->getCaptureMode() != FITS_CALIBRATE)
+    bool persist = targetChip->isBatchMode() && targetChip->getCaptureMode() != FITS_CALIBRATE;
+    if (persist)
     {
-        // If either generating file name or writing the image file fails
-        // then return
-        if (!generateFilename(targetChip->isBatchMode(), format, &filename) ||
-                !writeImageFile(filename, bp, BType == BLOB_FITS))
+        // If generating file name fails then return
+        if (!generateFilename(targetChip->isBatchMode(), format, &filename))
         {
-            connect(KSMessageBox::Instance(), &KSMessageBox::accepted, this, [ = ]()
-            {
-                KSMessageBox::Instance()->disconnect(this);
-                emit error(ERROR_SAVE);
-            });
-            KSMessageBox::Instance()->error(i18n("Failed writing image to %1\nPlease check folder, filename & permissions.",
-                                                 filename),
-                                            i18n("Image Write Failed"), 30);
-
-            emit BLOBUpdated(nullptr);
+            reportWriteError(filename);
             return true;
         }
     }
     else
         filename = QDir::tempPath() + QDir::separator() + "image" + format;
 
-    if (targetChip->getCaptureMode() == FITS_NORMAL && targetChip->isBatchMode() == true)
-    {
-        KStars::Instance()->statusBar()->showMessage(i18n("%1 file saved to %2", shortFormat.toUpper(), filename), 0);
-        qCInfo(KSTARS_INDI) << shortFormat.toUpper() << "file saved to" << filename;
-    }
-
     // Don't spam, just one notification per 3 seconds
     if (QDateTime::currentDateTime().secsTo(m_LastNotificationTS) <= -3)
     {
@@ -827,42 +772,144 @@ bool Camera::processBLOB(IBLOB *bp)
     }
 #endif
 
+    // Hand the frame over to the capture pipeline, which saves, decodes and analyzes it on worker threads
+    // and then displays it back on this thread. The INDI client reuses the BLOB memory once we return,
+    // so the pipeline works on its own copy, shared by all the stages. The buffer holds bloblen bytes,
+    // size is the uncompressed size of compressed BLOBs.
+    QSharedPointer<CaptureFrame> frame(new CaptureFrame());
+    frame->receivedTimer = receivedTimer;
+    frame->data = QByteArray(static_cast<const char *>(bp->blob), bp->bloblen);
+    frame->blob = *bp;
+    frame->blob.blob = const_cast<char *>(frame->data.constData());
+    frame->blob.bloblen = frame->data.size();
+    frame->chip = targetChip;
+    frame->captureMode = targetChip->getCaptureMode();
+    frame->format = format;
+    frame->filename = filename;
+    frame->persist = persist;
     // Load FITS if either:
     // #1 FITS Viewer is set to enabled.
     // #2 This is a preview, so we MUST open FITS Viewer even if disabled.
-    //    if (BType == BLOB_FITS)
-    //    {
     // Don't display image if the following conditions are met:
     // 1. Mode is NORMAL or CALIBRATE; and
     // 2. FITS Viewer is disabled; and
     // 3. Batch mode is enabled.
     // 4. Summary view is false.
-    if (targetChip->getCaptureMode() == FITS_NORMAL &&
-            Options::useFITSViewer() == false &&
-            Options::useSummaryPreview() == false &&
-            targetChip->isBatchMode())
+    frame->decode = !(targetChip->getCaptureMode() == FITS_NORMAL &&
+                      Options::useFITSViewer() == false &&
+                      Options::useSummaryPreview() == false &&
+                      targetChip->isBatchMode());
+    // The worker stages neither read the options nor create objects, both are done here on our thread.
+    if (frame->decode)
     {
-        emit BLOBUpdated(bp);
-        emit newImage(nullptr);
-        return true;
+        // Build the histogram the FITS viewer would otherwise compute on the GUI thread.
+        frame->histogram = (frame->captureMode == FITS_NORMAL || frame->captureMode == FITS_CALIBRATE) &&
+                           Options::useFITSViewer() && !Options::nonLinearHistogram();
+        frame->imageData.reset(new FITSData(frame->captureMode), &QObject::deleteLater);
     }
 
-    QByteArray buffer = QByteArray::fromRawData(reinterpret_cast<char *>(bp->blob), bp->size);
-    QSharedPointer<FITSData> imageData;
-    imageData.reset(new FITSData(targetChip->getCaptureMode()), &QObject::deleteLater);
-    if (!imageData->loadFromBuffer(buffer, shortFormat, filename))
+    m_CapturePipeline->submit(frame);
+    return true;
+}
+
+void Camera::initCapturePipeline()
+{
+    m_CapturePipeline.reset(new CapturePipeline());
+    connect(m_CapturePipeline.get(), &CapturePipeline::saturated, this, [this](bool saturated)
+    {
+        if (saturated)
+            return;
+        primaryChip->resumeExposure();
+        if (guideChip)
+            guideChip->resumeExposure();
+    });
+
+    m_CapturePipeline->setHandler(CapturePipeline::STAGE_PERSIST, [this](CaptureFrame & frame)
     {
-        emit error(ERROR_LOAD);
+        if (!frame.persist)
+            return true;
+
+        if (!WriteImageFileInternal(frame.filename, const_cast<char *>(frame.data.constData()), frame.data.size()))
+        {
+            frame.errorType = ERROR_SAVE;
+            return false;
+        }
         return true;
-    }
+    });
 
-    handleImage(targetChip, filename, bp, imageData);
-    return true;
+    m_CapturePipeline->setHandler(CapturePipeline::STAGE_DECODE, [this](CaptureFrame & frame)
+    {
+        if (!frame.decode)
+            return true;
+
+        // The data was created on our thread when the frame was received, only its content is loaded here.
+        if (!frame.imageData->loadFromBuffer(frame.data, frame.format.mid(1), frame.filename))
+        {
+            frame.errorType = ERROR_LOAD;
+            return false;
+        }
+
+        const FITSData::LoadCounters &counters = frame.imageData->loadCounters();
+        qCDebug(KSTARS_INDI) << "Image ingest bytes copied: BLOB" << frame.data.size()
+                             << "unpacked" << counters.unpackedBytes << "decoded" << counters.decodedBytes
+                             << "image buffer reused" << counters.imageBufferReused;
+        return true;
+    });
+
+    m_CapturePipeline->setHandler(CapturePipeline::STAGE_ANALYZE, [](CaptureFrame & frame)
+    {
+        if (frame.histogram && !frame.imageData->isHistogramConstructed())
+            frame.imageData->constructHistogram();
+        return true;
+    });
+
+    m_CapturePipeline->setHandler(CapturePipeline::STAGE_DISPLAY, [this](CaptureFrame & frame)
+    {
+        if (frame.failed)
+        {
+            if (frame.errorType == ERROR_SAVE)
+                reportWriteError(frame.filename);
+            else
+                emit error(static_cast<ErrorType>(frame.errorType));
+            return false;
+        }
+
+        if (frame.persist && frame.captureMode == FITS_NORMAL)
+        {
+            QString shortFormat = frame.format.mid(1).toUpper();
+            KStars::Instance()->statusBar()->showMessage(i18n("%1 file saved to %2", shortFormat, frame.filename), 0);
+            qCInfo(KSTARS_INDI) << shortFormat << "file saved to" << frame.filename;
+        }
+
+        if (!frame.decode)
+        {
+            emit BLOBUpdated(&frame.blob);
+            emit newImage(nullptr);
+            return true;
+        }
+
+        handleImage(frame.chip, frame.captureMode, frame.filename, &frame.blob, frame.imageData);
+        return true;
+    });
+}
+
+void Camera::reportWriteError(const QString &filename)
+{
+    connect(KSMessageBox::Instance(), &KSMessageBox::accepted, this, [ = ]()
+    {
+        KSMessageBox::Instance()->disconnect(this);
+        emit error(ERROR_SAVE);
+    });
+    KSMessageBox::Instance()->error(i18n("Failed writing image to %1\nPlease check folder, filename & permissions.",
+                                         filename),
+                                    i18n("Image Write Failed"), 30);
+
+    emit BLOBUpdated(nullptr);
 }
 
-void Camera::handleImage(CameraChip *targetChip, const QString &filename, IBLOB *bp, QSharedPointer<FITSData> data)
+void Camera::handleImage(CameraChip *targetChip, FITSMode captureMode, const QString &filename, IBLOB *bp,
+                         QSharedPointer<FITSData> data)
 {
-    FITSMode captureMode = targetChip->getCaptureMode();
 
     // Add metadata
     data->setProperty("device", getDeviceName());
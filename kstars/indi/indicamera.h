@@ -8,6 +8,7 @@
 
 #include "indiconcretedevice.h"
 #include "indicamerachip.h"
+#include "capturepipeline.h"
 
 #include "wsmedia.h"
 #include "auxiliary/imageviewer.h"
@@ -217,6 +218,12 @@ class Camera : public ConcreteDevice
         }
         bool setFastCount(uint32_t count);
 
+        // Whether received frames wait for the capture pipeline, new exposures are then held back.
+        bool isPipelineSaturated() const
+        {
+            return m_CapturePipeline && m_CapturePipeline->isSaturated();
+        }
+
         const QMap<QString, double> &getExposurePresets() const
         {
             return m_ExposurePresets;
@@ -252,12 +259,14 @@ class Camera : public ConcreteDevice
     private:
         void processStream(IBLOB *bp);
         bool generateFilename(bool batch_mode, const QString &extension, QString *filename);
-        // Saves an image to disk on a separate thread.
-        bool writeImageFile(const QString &filename, IBLOB *bp, bool is_fits);
+        // Sets up the stages that save, decode, analyze and display received images.
+        void initCapturePipeline();
         bool WriteImageFileInternal(const QString &filename, char *buffer, const size_t size);
+        void reportWriteError(const QString &filename);
         // Creates or finds the FITSViewer.
         QPointer<FITSViewer> getFITSViewer();
-        void handleImage(CameraChip *targetChip, const QString &filename, IBLOB *bp, QSharedPointer<FITSData> data);
+        void handleImage(CameraChip *targetChip, FITSMode captureMode, const QString &filename, IBLOB *bp,
+                         QSharedPointer<FITSData> data);
 
         bool ISOMode { true };
         bool HasGuideHead { false };
@@ -307,10 +316,7 @@ class Camera : public ConcreteDevice
         QMap<QString, double> m_ExposurePresets;
         QPair<double, double> m_ExposurePresetsMinMax;
 
-        // Used when writing the image fits file to disk in a separate thread.
-        char *fileWriteBuffer { nullptr };
-        int fileWriteBufferSize { 0 };
-        QString fileWriteFilename;
-        QFuture<void> fileWriteThread;
+        // Saves, decodes and analyzes received images off the GUI thread.
+        std::unique_ptr<CapturePipeline> m_CapturePipeline;
 };
 }
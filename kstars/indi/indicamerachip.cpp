@@ -357,6 +357,15 @@ bool CameraChip::capture(double exposure)
     if (expProp == nullptr)
         return false;
 
+    // Received frames are waiting to be processed, don't add one more until they are.
+    if (m_Camera->isPipelineSaturated())
+    {
+        qCInfo(KSTARS_INDI) << "Capture pipeline is saturated, holding back the" << exposure << "s exposure";
+        m_PendingExposure = exposure;
+        return true;
+    }
+    m_PendingExposure = -1;
+
     // If we have exposure presets, let's limit the exposure value
     // to the preset values if it falls within their range of max/min
     if (Options::forceDSLRPresets())
@@ -406,10 +415,22 @@ bool CameraChip::capture(double exposure)
     return true;
 }
 
+void CameraChip::resumeExposure()
+{
+    if (m_PendingExposure < 0)
+        return;
+
+    const double exposure = m_PendingExposure;
+    m_PendingExposure = -1;
+    capture(exposure);
+}
+
 bool CameraChip::abortExposure()
 {
     ISwitchVectorProperty *abortProp = nullptr;
 
+    m_PendingExposure = -1;
+
     switch (m_Type)
     {
         case PRIMARY_CCD:
@@ -525,6 +546,10 @@ bool CameraChip::isCapturing()
 {
     INumberVectorProperty *expProp = nullptr;
 
+    // The exposure held back still counts as started.
+    if (m_PendingExposure >= 0)
+        return true;
+
     switch (m_Type)
     {
         case PRIMARY_CCD:
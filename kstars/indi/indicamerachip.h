@@ -44,6 +44,8 @@ class CameraChip
 
         bool resetFrame();
         bool capture(double exposure);
+        // Starts the exposure held back while the capture pipeline was saturated, if any.
+        void resumeExposure();
         bool setFrameType(CCDFrameType fType);
         bool setFrameType(const QString &name);
         CCDFrameType getFrameType();
@@ -131,6 +133,8 @@ class CameraChip
         bool CanBin { false };
         bool CanSubframe { false };
         bool CanAbort { false };
+        // Exposure requested while the capture pipeline was saturated, negative if none.
+        double m_PendingExposure { -1 };
 
         ISD::Camera *m_Camera { nullptr };
         ChipType m_Type;
@@ -9,6 +9,8 @@
 
 #include "kstarsdatetime.h" //for J2000 define
 
+#include <Eigen/Geometry>
+
 // 63 elements
 const int KSNumbers::arguments[NUTTERMS][5] = {
     { 0, 0, 0, 0, 1 },   { -2, 0, 0, 2, 2 },  { 0, 0, 0, 2, 2 },   { 0, 0, 0, 0, 2 },  { 0, 1, 0, 0, 0 },
@@ -365,4 +367,17 @@ void KSNumbers::updateValues(long double jd)
     {
         item *= UA2km;
     }
+
+    // Nutation rotates the equator by dEcLong around the pole of the ecliptic, then tilts it by dObliq
+    const double meanObliquity = Obliquity.radians();
+    const Eigen::Matrix3d nutation =
+        (Eigen::AngleAxisd(meanObliquity + deltaObliquity * dms::DegToRad, Eigen::Vector3d::UnitX()) *
+         Eigen::AngleAxisd(deltaEcLong * dms::DegToRad, Eigen::Vector3d::UnitZ()) *
+         Eigen::AngleAxisd(-meanObliquity, Eigen::Vector3d::UnitX())).toRotationMatrix();
+    // SkyPoint::precess() precesses with p2(), i.e. P1
+    Apparent        = nutation * P1;
+    ApparentInverse = Apparent.transpose();
+
+    const double speedOfLight = 299792.458; // km/s
+    Aberration = Eigen::Vector3d(vearth[0], vearth[1], vearth[2]) / speedOfLight;
 }
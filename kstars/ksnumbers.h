@@ -111,6 +111,38 @@ class KSNumbers
     inline const Eigen::Matrix3d &p1b() const { return P1B; }
     inline const Eigen::Matrix3d &p2b() const { return P2B; }
 
+    /**
+     * @return the rotation from J2000 mean coordinates to the true equator and equinox of date,
+     * i.e. precession followed by nutation.
+     */
+    inline const Eigen::Matrix3d &apparentMatrix() const { return Apparent; }
+
+    /** @return the rotation from the true equator and equinox of date to J2000, the inverse of apparentMatrix() */
+    inline const Eigen::Matrix3d &inverseApparentMatrix() const { return ApparentInverse; }
+
+    /**
+     * @return the velocity of the Earth divided by the speed of light. Like libnova, it is
+     * expressed in J2000 axes and applied as is to coordinates of date.
+     */
+    inline const Eigen::Vector3d &aberrationVector() const { return Aberration; }
+
+    /**
+     * @short Computes the apparent direction of a catalog direction
+     *
+     * Applies the same corrections as SkyPoint::updateCoords() with a single rotation and one
+     * vector addition instead of separate precession, nutation and aberration steps.
+     *
+     * @param j2000 Direction in J2000 mean coordinates, need not be normalized
+     * @return the unit vector of the apparent direction of date
+     */
+    inline Eigen::Vector3d apparentDirection(const Eigen::Vector3d &j2000) const
+    {
+        Eigen::Vector3d v = (Apparent * j2000).normalized();
+        // First order aberration, v + a - (a.v)v
+        v += Aberration - Aberration.dot(v) * v;
+        return v.normalized();
+    }
+
     /**
      * @short compute constant values that need to be computed only once per instance of the application
      */
@@ -136,6 +168,8 @@ class KSNumbers
     double CX, SX, CY, SY, CZ, SZ;
     double CXB, SXB, CYB, SYB, CZB, SZB;
     Eigen::Matrix3d P1, P2, P1B, P2B;
+    Eigen::Matrix3d Apparent, ApparentInverse;
+    Eigen::Vector3d Aberration;
     double deltaObliquity, deltaEcLong;
     double e, T;
     long double days; // JD for which the last update was called
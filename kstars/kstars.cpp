@@ -415,7 +415,7 @@ void KStars::applyConfig(bool doApplyFocus)
     //Focus
     if (doApplyFocus)
     {
-        SkyObject *fo = data()->objectNamed(Options::focusObject());
+        SkyObject *fo = focusObjectNamed(Options::focusObject());
         if (fo && fo != map()->focusObject())
         {
             map()->setClickedObject(fo);
@@ -29,6 +29,7 @@ class KActionMenu;
 class KConfigDialog;
 
 class KStarsData;
+class SkyObject;
 class SkyPoint;
 class SkyMap;
 class GeoLocation;
@@ -808,6 +809,12 @@ class KStars : public KXmlGuiWindow
         /** Initialize focus position */
         void initFocus();
 
+        /**
+         * @return the saved focus object @p name, or nullptr if there is none.
+         * Asteroids, comets and satellites are loaded in the background, this waits for them if the object is not found.
+         */
+        SkyObject *focusObjectNamed(const QString &name);
+
         /** Build the KStars main window */
         void buildGUI();
 
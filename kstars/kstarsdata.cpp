@@ -11,6 +11,7 @@
 #include "auxiliary/kspaths.h"
 #include "skycomponents/supernovaecomponent.h"
 #include "skycomponents/skymapcomposite.h"
+#include "startuptaskgraph.h"
 #include "ksnotification.h"
 #include "skyobjectuserdata.h"
 #include <kio/job_base.h>
@@ -181,21 +182,40 @@ bool KStarsData::initialize()
         fixcitydb.close();
     }
 
-    //Load Cities//
+    //Load Cities, while the user data and sky objects load on the main thread//
     emit progressText(i18n("Loading city data"));
-    if (!readCityData())
+    StartupTaskGraph startup;
+    bool citiesFound = false;
+    const int cities = startup.addTask("Cities", [this, &citiesFound]()
     {
-        fatalErrorMessage("citydb.sqlite");
-        return false;
-    }
+        citiesFound = readCityData();
+    }, [this, &citiesFound]()
+    {
+        // The custom locations database is used from the main thread later on
+        citiesFound = readUserCityData() && citiesFound;
+    });
+    startup.start();
 
     //Initialize User Database//
     emit progressText(i18n("Loading User Information"));
-    m_ksuserdb.Initialize();
+    startup.measure("User database", [this]()
+    {
+        m_ksuserdb.Initialize();
+    });
 
     //Initialize SkyMapComposite//
     emit progressText(i18n("Loading sky objects"));
-    m_SkyComposite.reset(new SkyMapComposite());
+    startup.measure("Sky objects", [this]()
+    {
+        m_SkyComposite.reset(new SkyMapComposite());
+    });
+
+    startup.wait(cities);
+    if (!citiesFound)
+    {
+        fatalErrorMessage("citydb.sqlite");
+        return false;
+    }
     //Load Image URLs//
     //#ifndef Q_OS_ANDROID
     //On Android these 2 calls produce segfault. WARNING
@@ -472,9 +492,14 @@ bool KStarsData::readCityData()
     }
     citydb.close();
 
+    return citiesFound;
+}
+
+bool KStarsData::readUserCityData()
+{
     // Reading local database
     QSqlDatabase mycitydb = QSqlDatabase::addDatabase("QSQLITE", "mycitydb");
-    dbfile = QDir(KSPaths::writableLocation(QStandardPaths::AppLocalDataLocation)).filePath("mycitydb.sqlite");
+    QString dbfile = QDir(KSPaths::writableLocation(QStandardPaths::AppLocalDataLocation)).filePath("mycitydb.sqlite");
 
     if (QFile::exists(dbfile))
     {
@@ -506,7 +531,7 @@ bool KStarsData::readCityData()
         }
     }
 
-    return citiesFound;
+    return true;
 }
 
 bool KStarsData::readTimeZoneRulebook()
@@ -465,15 +465,23 @@ class KStarsData : public QObject
 
       private:
         /**
-         * Populate list of geographic locations from "citydb.sqlite" database. Also check for custom
-         * locations file "mycitydb.sqlite" database, but don't require it.  Each line in the file
+         * Populate list of geographic locations from "citydb.sqlite" database. Each line in the file
          * provides the information required to create one GeoLocation object.
-         * @short Fill list of geographic locations from file(s)
+         * @short Fill list of geographic locations from file
          * @return true if at least one city read successfully.
+         * @note Runs on a worker thread at startup, while the time zone rules and the list of
+         * locations are left alone by the main thread.
          * @see KStarsData::processCity()
          */
         bool readCityData();
 
+        /**
+         * Append the custom locations of "mycitydb.sqlite" database to the list of geographic
+         * locations, but don't require it.
+         * @return false if the database exists but could not be read.
+         */
+        bool readUserCityData();
+
         /** Read the data file that contains daylight savings time rules. */
         bool readTimeZoneRulebook();
 
@@ -469,6 +469,8 @@ void KStars::changeViewOption(const QString &op, const QString &val)
         Options::setShowHorizon(bVal);
     if (op == "ShowGround" && bOk)
         Options::setShowGround(bVal);
+    if (op == "ShowStarLoadStatistics" && bOk)
+        Options::setShowStarLoadStatistics(bVal);
     if (op == "ShowSun" && bOk)
         Options::setShowSun(bVal);
     if (op == "ShowMoon" && bOk)
@@ -853,6 +853,20 @@ void KStars::datainitFinished()
 #endif
 }
 
+SkyObject *KStars::focusObjectNamed(const QString &name)
+{
+    if (name == i18n("nothing"))
+        return nullptr;
+
+    SkyObject *object = data()->objectNamed(name);
+    if (object == nullptr && data()->skyComposite()->isLoading())
+    {
+        data()->skyComposite()->waitForLoading();
+        object = data()->objectNamed(name);
+    }
+    return object;
+}
+
 void KStars::initFocus()
 {
     //Case 1: tracking on an object
@@ -868,7 +882,7 @@ void KStars::initFocus()
         }
         else
         {
-            oFocus = data()->objectNamed(Options::focusObject());
+            oFocus = focusObjectNamed(Options::focusObject());
         }
 
         if (oFocus)
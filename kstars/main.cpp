@@ -21,6 +21,7 @@
 #if !defined(KSTARS_LITE)
 #include "kstars.h"
 #include "skymap.h"
+#include "skycomponents/skymapcomposite.h"
 #endif
 
 #if !defined(KSTARS_LITE)
@@ -255,6 +256,9 @@ int main(int argc, char *argv[])
                          SLOT(slotConsoleMessage(QString)));
         dat->initialize();
 
+        //Dumps are drawn without an event loop, so wait for the components loading in the background
+        dat->skyComposite()->waitForLoading();
+
         //Set Geographic Location
         dat->setLocationFromOptions();
 
@@ -15,6 +15,7 @@
 #include "skymap.h"
 
 #include <QStandardItemModel>
+#include <QTreeWidgetItem>
 #include <QStatusBar>
 
 static const char *satgroup_strings_context = "Satellite group name";
@@ -63,6 +64,9 @@ OpsSatellites::OpsSatellites() : QFrame(KStars::Instance())
     connect(m_ConfigDialog->button(QDialogButtonBox::Cancel), SIGNAL(clicked()), SLOT(slotCancel()));
     connect(FilterEdit, SIGNAL(textChanged(QString)), this, SLOT(slotFilterReg(QString)));
     connect(m_Model, SIGNAL(itemChanged(QStandardItem*)), this, SLOT(slotItemChanged(QStandardItem*)));
+    connect(PredictPassesButton, SIGNAL(clicked()), this, SLOT(slotPredictPasses()));
+    connect(KStarsData::Instance()->skyComposite()->satellites()->passPredictor(), &SatellitePassPredictor::passesPredicted,
+            this, &OpsSatellites::showPasses);
 
     #if QT_VERSION < QT_VERSION_CHECK(5, 15, 0)
     connect(satelliteButtonGroup, static_cast<void (QButtonGroup::*)(int)>(&QButtonGroup::buttonPressed), this,
@@ -189,6 +193,42 @@ void OpsSatellites::saveSatellitesList()
     Options::setSelectedSatellites(selected_satellites);
 }
 
+void OpsSatellites::slotPredictPasses()
+{
+    // Predict the passes of the satellites checked in the list
+    if (isDirty)
+        saveSatellitesList();
+
+    PassesTreeWidget->clear();
+    if (!KStarsData::Instance()->skyComposite()->satellites()->predictPasses(kcfg_SatellitePassHours->value()))
+        showPasses();
+}
+
+void OpsSatellites::showPasses()
+{
+    KStarsData *data = KStarsData::Instance();
+
+    PassesTreeWidget->clear();
+
+    for (const auto &pass : data->skyComposite()->satellites()->passPredictor()->passes(data->ut()))
+    {
+        const KStarsDateTime rise = data->geo()->UTtoLT(pass.rise);
+
+        QTreeWidgetItem *item = new QTreeWidgetItem(PassesTreeWidget);
+        item->setText(0, pass.satellite);
+        item->setText(1, QLocale().toString(rise.date(), QLocale::ShortFormat) + ' ' + rise.time().toString("hh:mm:ss"));
+        item->setText(2, QString::number(pass.riseAzimuth, 'f', 0) + QChar(176));
+        item->setText(3, data->geo()->UTtoLT(pass.culmination).time().toString("hh:mm:ss"));
+        item->setText(4, QString::number(pass.maxAltitude, 'f', 0) + QChar(176));
+        item->setText(5, data->geo()->UTtoLT(pass.set).time().toString("hh:mm:ss"));
+        item->setText(6, QString::number(pass.setAzimuth, 'f', 0) + QChar(176));
+        item->setText(7, pass.visible ? i18n("Yes") : i18n("No"));
+    }
+
+    for (int i = 0; i < PassesTreeWidget->columnCount(); i++)
+        PassesTreeWidget->resizeColumnToContents(i);
+}
+
 void OpsSatellites::slotApply()
 {
     if (isDirty == false)
@@ -54,6 +54,9 @@ class OpsSatellites : public QFrame, public Ui::OpsSatellites
      */
     void saveSatellitesList();
 
+    /** Fills the list of passes with the predicted passes of the selected satellites */
+    void showPasses();
+
   private slots:
     void slotUpdateTLEs();
     void slotShowSatellites(bool on);
@@ -61,6 +64,7 @@ class OpsSatellites : public QFrame, public Ui::OpsSatellites
     void slotCancel();
     void slotFilterReg(const QString &);
     void slotItemChanged(QStandardItem *);
+    void slotPredictPasses();
 
 private:
   KConfigDialog *m_ConfigDialog { nullptr };
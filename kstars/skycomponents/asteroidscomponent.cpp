@@ -40,7 +40,27 @@
 AsteroidsComponent::AsteroidsComponent(SolarSystemComposite *parent)
     : BinaryListComponent(this, "asteroids"), SolarSystemListComponent(parent)
 {
-    loadData();
+}
+
+QList<KSAsteroid *> AsteroidsComponent::readData()
+{
+    QFile binfile(filepath_bin);
+    if (!binfile.exists())
+        return QList<KSAsteroid *>();
+
+    return readBinary(binfile);
+}
+
+void AsteroidsComponent::setData(const QList<KSAsteroid *> &asteroids)
+{
+    if (asteroids.isEmpty())
+    {
+        loadData();
+        return;
+    }
+
+    clearData();
+    appendObjects(asteroids);
 }
 
 bool AsteroidsComponent::selected()
@@ -34,10 +34,25 @@ class AsteroidsComponent : public QObject, public SolarSystemListComponent,
          * @short Default constructor.
          *
          * @p parent pointer to the parent SolarSystemComposite
+         *
+         * The asteroids are loaded at startup through readData() and setData(), see SkyMapComposite.
          */
         explicit AsteroidsComponent(SolarSystemComposite *parent);
         virtual ~AsteroidsComponent() override = default;
 
+        /**
+         * @short Reads the asteroids of the binary file, without adding them to the component.
+         *
+         * Safe to call from a worker thread. Nothing is read if the binary file was not written yet.
+         */
+        QList<KSAsteroid *> readData();
+
+        /**
+         * @short Replaces the asteroids with those read by readData(), taking ownership of them.
+         * If none were read, the asteroids are loaded from the text file instead.
+         */
+        void setData(const QList<KSAsteroid *> &asteroids);
+
         void draw(SkyPainter *skyp) override;
         bool selected() override;
         SkyObject *objectNearest(SkyPoint *p, double &maxrad) override;
@@ -86,6 +86,22 @@ protected:
      */
     virtual void loadDataFromBinary(QFile &binfile);
 
+    /**
+     * @brief readBinary
+     * @param binfile the binary file
+     * @short Reads the objects of the given binary without adding them to the component.
+     *
+     * Only the file is touched, so that it can be called from a worker thread.
+     */
+    QList<T *> readBinary(QFile &binfile) const;
+
+    /**
+     * @brief appendObjects
+     * @param objects objects read by `readBinary`
+     * @short Adds the objects to the component and to the lists of object names.
+     */
+    void appendObjects(const QList<T *> &objects);
+
     /**
      * @brief writeBinary
      * @short Opens the default binfile and calls `writeBinary([FILE])`
@@ -187,6 +203,14 @@ void  BinaryListComponent<T, Component>::loadDataFromBinary()
 template<class T, typename Component>
 void  BinaryListComponent<T, Component>::loadDataFromBinary(QFile &binfile)
 {
+    appendObjects(readBinary(binfile));
+}
+
+template<class T, typename Component>
+QList<T *> BinaryListComponent<T, Component>::readBinary(QFile &binfile) const
+{
+    QList<T *> objects;
+
     // Open our binary file and create a Stream
     if (binfile.open(QIODevice::ReadOnly))
     {
@@ -200,15 +224,24 @@ void  BinaryListComponent<T, Component>::loadDataFromBinary(QFile &binfile)
         while(!in.atEnd()){
             T *new_object = nullptr;
             in >> new_object;
-
-            parent->appendListObject(new_object);
-            // Add name to the list of object names
-            parent->objectNames(T::TYPE).append(new_object->name());
-            parent->objectLists(T::TYPE).append(QPair<QString, const SkyObject *>(new_object->name(), new_object));
+            objects.append(new_object);
         }
         binfile.close();
     }
     else qWarning() << "Failed loading binary data from" << binfile.fileName();
+
+    return objects;
+}
+
+template<class T, typename Component>
+void  BinaryListComponent<T, Component>::appendObjects(const QList<T *> &objects)
+{
+    for(auto new_object : objects){
+        parent->appendListObject(new_object);
+        // Add name to the list of object names
+        parent->objectNames(T::TYPE).append(new_object->name());
+        parent->objectLists(T::TYPE).append(QPair<QString, const SkyObject *>(new_object->name(), new_object));
+    }
 }
 
 template<class T, typename Component>
@@ -19,8 +19,10 @@
 #include "kspaths.h"
 #include "import_skycomp.h"
 
+#include <QElapsedTimer>
 #include <QtConcurrent>
 
+#include <algorithm>
 #include <cmath>
 
 constexpr std::size_t expectedKnownMagObjectsPerTrixel = 500;
@@ -47,9 +49,101 @@ CatalogsComponent::CatalogsComponent(SkyComposite *parent, const QString &db_fil
 
     m_catalog_colors = m_db_manager.get_catalog_colors();
     tryImportSkyComponents();
+
+    QObject::connect(&m_snapshotCompiler, &QFutureWatcher<std::pair<bool, QString>>::finished,
+                     [this]()
+    {
+        snapshotCompiled();
+    });
+    openSnapshot();
     qCInfo(KSTARS) << "Loaded DSO catalogs.";
 }
 
+CatalogsComponent::~CatalogsComponent()
+{
+    // The compiler writes next to the database
+    m_snapshotCompiler.waitForFinished();
+}
+
+void CatalogsComponent::dropCache()
+{
+    m_mainCache.clear();
+    m_unknownMagCache.clear();
+    m_catalog_colors = m_db_manager.get_catalog_colors();
+    openSnapshot();
+}
+
+void CatalogsComponent::openSnapshot()
+{
+    m_snapshot.close();
+    m_cacheStatistics = CacheStatistics();
+
+    const auto &statistics = m_db_manager.get_master_statistics();
+    if (!statistics.first)
+        return;
+
+    if (m_snapshot.open(m_db_manager.db_file_name(), m_db_manager.htmesh_level(),
+                        statistics.second.total_count))
+    {
+        m_cacheStatistics.snapshot = true;
+        return;
+    }
+
+    // Compiling takes seconds for large catalogs, the DSOs are loaded
+    // from the database meanwhile. The catalogs may have changed since
+    // a compilation in progress started, it is run again once done.
+    if (m_snapshotCompiler.isRunning())
+        m_recompileSnapshot = true;
+    else
+        compileSnapshot();
+}
+
+void CatalogsComponent::compileSnapshot()
+{
+    m_recompileSnapshot = false;
+
+    const QString db_file = m_db_manager.db_file_name();
+    m_snapshotCompiler.setFuture(QtConcurrent::run([db_file]()
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        // Database connections may only be used by the thread which opened them
+        CatalogsDB::DBManager manager{ db_file };
+        const auto &success = manager.compile_master_snapshot();
+        if (success.first)
+            qCInfo(KSTARS) << "Compiled the DSO snapshot in" << timer.elapsed() << "ms";
+        return success;
+    }));
+}
+
+void CatalogsComponent::snapshotCompiled()
+{
+    if (m_recompileSnapshot)
+    {
+        compileSnapshot();
+        return;
+    }
+
+    const auto &success = m_snapshotCompiler.result();
+    const auto &statistics = m_db_manager.get_master_statistics();
+    if (!success.first || !statistics.first ||
+            !m_snapshot.open(m_db_manager.db_file_name(), m_db_manager.htmesh_level(),
+                             statistics.second.total_count))
+    {
+        qCWarning(KSTARS) << "Could not compile the DSO snapshot, loading DSOs from the database:"
+                          << success.second;
+        return;
+    }
+
+    // The cached objects were read from the database, the snapshot
+    // appends to the trixels it has filled itself only.
+    m_mainCache.clear();
+    m_unknownMagCache.clear();
+    m_cacheStatistics          = CacheStatistics();
+    m_cacheStatistics.snapshot = true;
+}
+
 double compute_maglim()
 {
     double maglim = Options::magLimitDrawDeepSky();
@@ -129,17 +223,46 @@ void CatalogsComponent::draw(SkyPainter *skyp)
     // galaxies of unknown magnitude, and many of them also of unknown
     // size, remains smooth.
 
-    // Helper lambda to fill the appropriate cache for a given trixel
+    // Helper lambda to fill the appropriate cache for a given trixel. With
+    // the snapshot, objects of known magnitude are only loaded down to
+    // the magnitude limit and the rest is appended when the limit grows.
     auto fillCache = [&](
         TrixelCache<ObjectList>::element& cacheElement,
         ObjectList (CatalogsDB::DBManager::*fillFunction)(const int),
+        bool knownMag,
         Trixel trixel
         ) -> void {
-        if (!cacheElement.is_set())
+        const bool isSet = cacheElement.is_set();
+        if (isSet && (!knownMag || !m_snapshot.is_open()))
+        {
+            m_cacheStatistics.hits++;
+            return;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        size_t loaded = 0;
+
+        if (m_snapshot.is_open())
+        {
+            if (!isSet)
+                cacheElement = ObjectList{};
+
+            loaded = knownMag ? m_snapshot.read_known_mag(trixel, maglim, cacheElement.data())
+                              : m_snapshot.read_null_mag(trixel, cacheElement.data());
+
+            if (isSet && loaded == 0)
+            {
+                m_cacheStatistics.hits++;
+                return;
+            }
+        }
+        else
         {
             try
             {
                 cacheElement = (m_db_manager.*fillFunction)(trixel);
+                loaded = cacheElement.data().size();
             }
             catch (const CatalogsDB::DatabaseError &e)
             {
@@ -154,15 +277,19 @@ void CatalogsComponent::draw(SkyPainter *skyp)
                 throw; // do not silently fail
             }
         }
+
+        const quint64 elapsed = timer.nsecsElapsed() / 1000;
+        m_cacheStatistics.misses++;
+        m_cacheStatistics.missTime += elapsed;
+        m_cacheStatistics.maxMissTime = std::max(m_cacheStatistics.maxMissTime, elapsed);
+        m_cacheStatistics.objectsLoaded += loaded;
     };
 
     // Helper lambda to JIT update and draw
     auto drawObjects = [&](std::vector<CatalogObject*>& objects) {
-        // TODO: If we are sure that JITupdate has no side effects
-        // that may cause races etc, it will be worth parallelizing
+        CatalogObject::JITupdate(objects);
 
         for (CatalogObject *object : objects) {
-            object->JITupdate();
             auto &color = m_catalog_colors[object->catalogId()][color_scheme];
             if (!color.isValid())
             {
@@ -198,7 +325,7 @@ void CatalogsComponent::draw(SkyPainter *skyp)
 
         // Fill the cache for this trixel
         auto &objectsKnownMag = m_mainCache[trixel];
-        fillCache(objectsKnownMag, &CatalogsDB::DBManager::get_objects_in_trixel_no_nulls, trixel);
+        fillCache(objectsKnownMag, &CatalogsDB::DBManager::get_objects_in_trixel_no_nulls, true, trixel);
         drawListKnownMag.clear();
 
         // Filter based on magnitude and size
@@ -243,7 +370,7 @@ void CatalogsComponent::draw(SkyPainter *skyp)
 
             // Fill cache
             auto &objectsUnknownMag = m_unknownMagCache[trixel];
-            fillCache(objectsUnknownMag, &CatalogsDB::DBManager::get_objects_in_trixel_null_mag, trixel);
+            fillCache(objectsUnknownMag, &CatalogsDB::DBManager::get_objects_in_trixel_null_mag, false, trixel);
 
             // Filter
             QtConcurrent::blockingMap(
@@ -9,12 +9,14 @@
 
 #include "skycomponent.h"
 #include "catalogsdb.h"
+#include "mastersnapshot.h"
 #include "catalogobject.h"
 #include "skymesh.h"
 #include "trixelcache.h"
 #include "Options.h"
 
 #include "polyfills/qstring_hash.h"
+#include <QFutureWatcher>
 #include <unordered_map>
 
 class SkyMesh;
@@ -55,7 +57,8 @@ class CatalogsComponent : public SkyComponent
         explicit CatalogsComponent(SkyComposite *parent, const QString &db_filename,
                                    bool load_default = false);
 
-        ~CatalogsComponent() override = default;
+        /** Waits for the snapshot of the master catalog being compiled, if any. */
+        ~CatalogsComponent() override;
 
         /**
          * Draws the objects in the currently visible trixels by
@@ -106,15 +109,36 @@ class CatalogsComponent : public SkyComponent
 
         /**
          * Clear the internal cache and effectively reload all objects
-         * from the database.
+         * from the database. The snapshot of the master catalog is
+         * reopened, and recompiled in the background if it is out of
+         * date.
+         */
+        void dropCache();
+
+        /**
+         * Hit and miss figures of the trixel caches since the last
+         * `dropCache`, shown by the star loading debug overlay.
          */
-        void dropCache()
+        struct CacheStatistics
         {
-            m_mainCache.clear();
-            m_unknownMagCache.clear();
-            m_catalog_colors = m_db_manager.get_catalog_colors();
+            /// Trixel lookups that found all the required objects in the cache
+            quint64 hits { 0 };
+            /// Trixel lookups that had to load objects
+            quint64 misses { 0 };
+            /// Time spent loading objects on misses, in microseconds
+            quint64 missTime { 0 };
+            /// Longest single miss, in microseconds
+            quint64 maxMissTime { 0 };
+            quint64 objectsLoaded { 0 };
+            /// Whether the objects are loaded from the snapshot rather than the database
+            bool snapshot { false };
         };
 
+        inline const CacheStatistics &cacheStatistics() const
+        {
+            return m_cacheStatistics;
+        }
+
         /**
          * Wether to show the DSOs.
          */
@@ -177,6 +201,26 @@ class CatalogsComponent : public SkyComponent
          */
         CatalogsDB::ColorMap m_catalog_colors;
 
+        /**
+         * The memory mapped snapshot of the master catalog the caches
+         * are filled from. If it can't be opened, the caches are filled
+         * from the database.
+         */
+        CatalogsDB::MasterSnapshot m_snapshot;
+
+        /**
+         * Compiles the snapshot on a worker thread when it is missing or
+         * out of date.
+         */
+        QFutureWatcher<std::pair<bool, QString>> m_snapshotCompiler;
+
+        /**
+         * Whether the catalogs changed while the snapshot was compiled.
+         */
+        bool m_recompileSnapshot { false };
+
+        CacheStatistics m_cacheStatistics;
+
         //@{
         /** Helpers */
 
@@ -191,5 +235,22 @@ class CatalogsComponent : public SkyComponent
          */
         void tryImportSkyComponents();
 
+        /**
+         * Open the snapshot of the master catalog, or start compiling it
+         * if it is missing or out of date.
+         */
+        void openSnapshot();
+
+        /**
+         * Compile the snapshot of the master catalog on a worker thread.
+         */
+        void compileSnapshot();
+
+        /**
+         * Open the snapshot once compiled, and drop the objects cached
+         * from the database.
+         */
+        void snapshotCompiled();
+
         //@}
 };
@@ -39,7 +39,6 @@
 CometsComponent::CometsComponent(SolarSystemComposite *parent)
     : SolarSystemListComponent(parent)
 {
-    loadData();
 }
 
 bool CometsComponent::selected()
@@ -78,16 +77,16 @@ bool CometsComponent::selected()
  */
 void CometsComponent::loadData()
 {
-    QString name, orbit_class;
-
     emitProgressText(i18n("Loading comets"));
-    qCInfo(KSTARS) << "Loading comets";
+    setData(readData());
+}
 
-    qDeleteAll(m_ObjectList);
-    m_ObjectList.clear();
+QList<KSComet *> CometsComponent::readData()
+{
+    QList<KSComet *> comets;
+    QString name, orbit_class;
 
-    objectNames(SkyObject::COMET).clear();
-    objectLists(SkyObject::COMET).clear();
+    qCInfo(KSTARS) << "Loading comets";
 
     QString file_name = KSPaths::locate(QStandardPaths::AppLocalDataLocation, QString("cometels.json.gz"));
 
@@ -147,18 +146,33 @@ void CometsComponent::loadData()
 
             com->setOrbitClass(orbit_class);
             com->setAngularSize(0.005);
-            appendListObject(com);
-
-            // Add *short* name to the list of object names
-            objectNames(SkyObject::COMET).append(com->name());
-            objectLists(SkyObject::COMET).append(QPair<QString, const SkyObject *>(com->name(), com));
+            comets.append(com);
         });
     }
     catch (const std::runtime_error&)
     {
         qCInfo(KSTARS) << "Loading comets failed.";
         qCInfo(KSTARS) << " -> was trying to read " + file_name;
-        return;
+    }
+
+    return comets;
+}
+
+void CometsComponent::setData(const QList<KSComet *> &comets)
+{
+    qDeleteAll(m_ObjectList);
+    m_ObjectList.clear();
+
+    objectNames(SkyObject::COMET).clear();
+    objectLists(SkyObject::COMET).clear();
+
+    for (KSComet *com : comets)
+    {
+        appendListObject(com);
+
+        // Add *short* name to the list of object names
+        objectNames(SkyObject::COMET).append(com->name());
+        objectLists(SkyObject::COMET).append(QPair<QString, const SkyObject *>(com->name(), com));
     }
 }
 
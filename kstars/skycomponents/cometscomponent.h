@@ -13,6 +13,7 @@
 #include <QList>
 #include <QPointer>
 
+class KSComet;
 class SkyLabeler;
 
 /**
@@ -32,11 +33,23 @@ class CometsComponent : public QObject, public SolarSystemListComponent
          * @short Default constructor.
          *
          * @p parent pointer to the parent SolarSystemComposite
+         *
+         * The comets are loaded at startup through readData() and setData(), see SkyMapComposite.
          */
         explicit CometsComponent(SolarSystemComposite *parent);
 
         virtual ~CometsComponent() override = default;
 
+        /**
+         * @short Reads the comets of the data file, without adding them to the component.
+         *
+         * Safe to call from a worker thread.
+         */
+        static QList<KSComet *> readData();
+
+        /** @short Replaces the comets with those read by readData(), taking ownership of them. */
+        void setData(const QList<KSComet *> &comets);
+
         bool selected() override;
         void draw(SkyPainter *skyp) override;
         void updateDataFile(bool isAutoUpdate = false);
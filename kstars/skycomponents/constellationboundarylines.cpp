@@ -17,24 +17,46 @@
 #include "skymap.h"
 #endif
 #include "skypainter.h"
-#include "htmesh/MeshIterator.h"
 #include "skycomponents/skymapcomposite.h"
 
-#include <QHash>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// The lookup grid, cells are 7.5 minutes of RA by 1 degree of Dec
+constexpr int RA_CELLS  = 24 * 8;
+constexpr int DEC_CELLS = 180;
+constexpr double RA_CELL  = 24.0 / RA_CELLS;
+constexpr double DEC_CELL = 180.0 / DEC_CELLS;
+
+// Points classified by each parallel task
+constexpr int BATCH_SIZE = 1024;
+
+int raCell(double ra)
+{
+    const int cell = static_cast<int>(std::floor(ra / RA_CELL)) % RA_CELLS;
+    return cell < 0 ? cell + RA_CELLS : cell;
+}
+
+int decCell(double dec)
+{
+    return qBound(0, static_cast<int>(std::floor((dec + 90.0) / DEC_CELL)), DEC_CELLS - 1);
+}
+
+// Boundaries crossing 0h are stored with negative RAs
+QPointF boundaryPoint(PolyList *polyList, double ra, double dec)
+{
+    return QPointF((ra > 12.0 && polyList->wrapRA()) ? ra - 24.0 : ra, dec);
+}
+}
 
 ConstellationBoundaryLines::ConstellationBoundaryLines(SkyComposite *parent)
     : NoPrecessIndex(parent, i18n("Constellation Boundaries"))
 {
-    m_skyMesh      = SkyMesh::Instance();
-    m_polyIndexCnt = 0;
-    for (int i = 0; i < m_skyMesh->size(); i++)
-    {
-        m_polyIndex.append(std::shared_ptr<PolyListList>(new PolyListList()));
-    }
-
     KStarsData *data = KStarsData::Instance();
-    int verbose      = 0; // -1 => create cbounds-$x.idx on stdout
-    //  0 => normal
     const char *fname = "cbounds.dat";
     int flag = 0;
     double ra, dec = 0, lastRa, lastDec;
@@ -44,15 +66,6 @@ ConstellationBoundaryLines::ConstellationBoundaryLines(SkyComposite *parent)
 
     intro();
 
-    // Open the .idx file and skip past the first line
-    KSFileReader idxReader, *idxFile = nullptr;
-    QString idxFname = QString("cbounds-%1.idx").arg(SkyMesh::Instance()->level());
-    if (idxReader.open(idxFname))
-    {
-        idxReader.readLine();
-        idxFile = &idxReader;
-    }
-
     // now open the file that contains the points
     KSFileReader fileReader;
     if (!fileReader.open(fname))
@@ -76,11 +89,9 @@ ConstellationBoundaryLines::ConstellationBoundaryLines(SkyComposite *parent)
             lineList.reset();
 
             if (polyList.get())
-                appendPoly(polyList, idxFile, verbose);
+                m_polyLists.append(polyList);
             QString cName = line.mid(1);
             polyList.reset(new PolyList(cName));
-            if (verbose == -1)
-                printf(":\n");
             lastRa = lastDec = -1000.0;
             continue;
         }
@@ -136,7 +147,9 @@ ConstellationBoundaryLines::ConstellationBoundaryLines(SkyComposite *parent)
     if (lineList.get())
         appendLine(lineList);
     if (polyList.get())
-        appendPoly(polyList, idxFile, verbose);
+        m_polyLists.append(polyList);
+
+    buildLookup();
 }
 
 bool ConstellationBoundaryLines::selected()
@@ -154,123 +167,127 @@ void ConstellationBoundaryLines::preDraw(SkyPainter *skyp)
     skyp->setPen(QPen(QBrush(color), 1, Qt::SolidLine));
 }
 
-void ConstellationBoundaryLines::appendPoly(std::shared_ptr<PolyList> &polyList, KSFileReader *file, int debug)
+void ConstellationBoundaryLines::buildLookup()
 {
-    if (!file || debug == -1)
-        return appendPoly(polyList, debug);
+    m_boundingRects.clear();
+    for (const auto &polyList : m_polyLists)
+        m_boundingRects.append(polyList->poly()->boundingRect());
 
-    while (file->hasMoreLines())
-    {
-        QString line = file->readLine();
-        if (line.at(0) == ':')
-            return;
-        Trixel trixel = line.toInt();
+    m_cellOwner.fill(-1, RA_CELLS * DEC_CELLS);
+    m_cellCandidates.fill(QVector<int>(), RA_CELLS * DEC_CELLS);
 
-        m_polyIndex[trixel]->append(polyList);
+    // Cells crossed by boundaries: edges are split in pieces no longer than half a cell,
+    // every cell overlapped by the bounding box of a piece is crossed.
+    for (int id = 0; id < m_polyLists.size(); id++)
+    {
+        const QPolygonF *poly = m_polyLists[id]->poly();
+        for (int i = 0; i < poly->size(); i++)
+        {
+            const QPointF a = poly->at(i);
+            const QPointF b = poly->at((i + 1) % poly->size());
+            const int pieces = 1 + static_cast<int>(2 * std::max(std::fabs(b.x() - a.x()) / RA_CELL,
+                                                    std::fabs(b.y() - a.y()) / DEC_CELL));
+            for (int k = 0; k < pieces; k++)
+            {
+                const QPointF p = a + (b - a) * k / pieces;
+                const QPointF q = a + (b - a) * (k + 1) / pieces;
+                const int raFirst = static_cast<int>(std::floor(std::min(p.x(), q.x()) / RA_CELL));
+                const int raLast  = static_cast<int>(std::floor(std::max(p.x(), q.x()) / RA_CELL));
+                for (int r = raFirst; r <= raLast; r++)
+                {
+                    for (int d = decCell(std::min(p.y(), q.y())); d <= decCell(std::max(p.y(), q.y())); d++)
+                    {
+                        QVector<int> &candidates = m_cellCandidates[d * RA_CELLS + raCell((r + 0.5) * RA_CELL)];
+                        if (!candidates.contains(id))
+                            candidates.append(id);
+                    }
+                }
+            }
+        }
     }
-}
-
-void ConstellationBoundaryLines::appendPoly(const std::shared_ptr<PolyList> &polyList, int debug)
-{
-    if (debug >= 0 && debug < m_skyMesh->debug())
-        debug = m_skyMesh->debug();
 
-    const IndexHash &indexHash     = m_skyMesh->indexPoly(polyList->poly());
-    IndexHash::const_iterator iter = indexHash.constBegin();
-    while (iter != indexHash.constEnd())
+    // Cells no boundary crosses lie within the constellation containing their center
+    for (int d = 0; d < DEC_CELLS; d++)
     {
-        Trixel trixel = iter.key();
-        iter++;
-
-        if (debug == -1)
-            printf("%d\n", trixel);
-
-        m_polyIndex[trixel]->append(polyList);
+        for (int r = 0; r < RA_CELLS; r++)
+        {
+            const int cell = d * RA_CELLS + r;
+            if (m_cellCandidates[cell].isEmpty())
+                m_cellOwner[cell] = constellationId((r + 0.5) * RA_CELL, -90.0 + (d + 0.5) * DEC_CELL);
+        }
     }
-
-    if (debug > 9)
-        printf("PolyList: %3d: %d\n", ++m_polyIndexCnt, indexHash.size());
 }
 
-PolyList *ConstellationBoundaryLines::ContainingPoly(const SkyPoint *p) const
+int ConstellationBoundaryLines::constellationId(double ra, double dec) const
 {
-    //printf("called ContainingPoly(p)\n");
-
-    // we save the pointers in a hash because most often there is only one
-    // constellation and we can avoid doing the expensive boundary calculations
-    // and just return it if we know it is unique.  We can avoid this minor
-    // complication entirely if we use index(p) instead of aperture(p, r)
-    // because index(p) always returns a single trixel index.
+    if (m_cellOwner.isEmpty())
+        return -1;
 
-    QHash<PolyList *, bool> polyHash;
-    QHash<PolyList *, bool>::const_iterator iter;
+    const int cell = decCell(dec) * RA_CELLS + raCell(ra);
+    if (m_cellOwner[cell] >= 0)
+        return m_cellOwner[cell];
 
-    //printf("\n");
-
-    // the boundaries don't precess so we use index() not aperture()
-    m_skyMesh->index(p, 1.0, IN_CONSTELL_BUF);
-    MeshIterator region(m_skyMesh, IN_CONSTELL_BUF);
-    while (region.hasNext())
+    // Cells crossed by a boundary, and cells not filled yet while the grid is built
+    const QVector<int> &candidates = m_cellCandidates[cell];
+    const bool building = candidates.isEmpty();
+    for (int id = 0, count = building ? m_polyLists.size() : candidates.size(); id < count; id++)
     {
-        Trixel trixel = region.next();
-        //printf("Trixel: %4d %s\n", trixel, m_skyMesh->indexToName( trixel ) );
-
-        std::shared_ptr<PolyListList> polyListList = m_polyIndex[trixel];
+        const int candidate = building ? id : candidates[id];
+        PolyList *polyList = m_polyLists[candidate].get();
+        const QPointF point = boundaryPoint(polyList, ra, dec);
+        if (m_boundingRects[candidate].contains(point) && polyList->poly()->containsPoint(point, Qt::OddEvenFill))
+            return candidate;
+    }
 
-        //printf("    size: %d\n", polyListList->size() );
+    return -1;
+}
 
-        for (const auto &item : *polyListList)
-        {
-            polyHash.insert(item.get(), true);
-        }
-    }
+//-------------------------------------------------------------------
+// The routines for providing public access to the boundary index
+// start here.  (Some of them may not be needed (or working)).
+//-------------------------------------------------------------------
 
-    iter = polyHash.constBegin();
+int ConstellationBoundaryLines::constellationId(const SkyPoint *p) const
+{
+    return constellationId(p->ra().Hours(), p->dec().Degrees());
+}
 
-    // Don't bother with boundaries if there is only one
-    if (polyHash.size() == 1)
-        return iter.key();
+QVector<int> ConstellationBoundaryLines::constellationIds(const QVector<const SkyPoint *> &points) const
+{
+    QVector<int> ids(points.size());
+    int *output = ids.data();
 
-    QPointF point(p->ra().Hours(), p->dec().Degrees());
-    QPointF wrapPoint(p->ra().Hours() - 24.0, p->dec().Degrees());
-    bool wrapRA = p->ra().Hours() > 12.0;
+    QVector<int> batches;
+    for (int first = 0; first < points.size(); first += BATCH_SIZE)
+        batches.append(first);
 
-    while (iter != polyHash.constEnd())
+    auto classifyBatch = [&](const int &first)
     {
-        PolyList *polyList = iter.key();
-        iter++;
+        const int last = std::min(first + BATCH_SIZE, static_cast<int>(points.size()));
+        for (int i = first; i < last; i++)
+            output[i] = constellationId(points[i]);
+    };
 
-        //qDebug() << Q_FUNC_INFO << QString("checking %1 boundary\n").arg( polyList->name() );
+    if (batches.size() > 1)
+        QtConcurrent::blockingMap(batches, classifyBatch);
+    else if (!batches.isEmpty())
+        classifyBatch(batches.first());
 
-        const QPolygonF *poly = polyList->poly();
-        if (wrapRA && polyList->wrapRA())
-        {
-            if (poly->containsPoint(wrapPoint, Qt::OddEvenFill))
-                return polyList;
-        }
-        else
-        {
-            if (poly->containsPoint(point, Qt::OddEvenFill))
-                return polyList;
-        }
-    }
-
-    return nullptr;
+    return ids;
 }
 
-//-------------------------------------------------------------------
-// The routines for providing public access to the boundary index
-// start here.  (Some of them may not be needed (or working)).
-//-------------------------------------------------------------------
+QString ConstellationBoundaryLines::constellationName(int id) const
+{
+    if (id < 0 || id >= m_polyLists.size())
+        return i18n("Unknown");
+
+    PolyList *polyList = m_polyLists[id].get();
+    return (Options::useLocalConstellNames() ?
+                i18nc("Constellation name (optional)", polyList->name().toUpper().toLocal8Bit().data()) :
+                polyList->name());
+}
 
 QString ConstellationBoundaryLines::constellationName(const SkyPoint *p) const
 {
-    PolyList *polyList = ContainingPoly(p);
-    if (polyList)
-    {
-        return (Options::useLocalConstellNames() ?
-                    i18nc("Constellation name (optional)", polyList->name().toUpper().toLocal8Bit().data()) :
-                    polyList->name());
-    }
-    return i18n("Unknown");
+    return constellationName(constellationId(p));
 }
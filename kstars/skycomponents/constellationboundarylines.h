@@ -8,20 +8,24 @@
 
 #include "noprecessindex.h"
 
-#include <QHash>
 #include <QPolygonF>
+#include <QRectF>
+#include <QVector>
 
-class PolyList;
-class ConstellationBoundary;
-class KSFileReader;
+#include <memory>
 
-typedef QVector<std::shared_ptr<PolyList>> PolyListList;
-typedef QVector<std::shared_ptr<PolyListList>> PolyIndex;
+class PolyList;
+class SkyPoint;
 
 /**
  * @class ConstellationBoundary
  * Collection of lines comprising the borders between constellations
  *
+ * Finding the constellation containing a point goes through a grid of cells over RA and Dec,
+ * precomputed when the boundaries are loaded. Most cells lie within a single constellation, which
+ * is returned as is. Only the cells crossed by a boundary test the point against the few
+ * constellations whose boundaries cross them.
+ *
  * @author Jason Harris
  * @version 0.1
  */
@@ -43,23 +47,32 @@ class ConstellationBoundaryLines : public NoPrecessIndex
 
     QString constellationName(const SkyPoint *p) const;
 
+    /**
+     * @return the identifier of the constellation containing @p p, or -1 if it is not known.
+     * Identifiers index the constellations in the order of cbounds.dat, see constellationName(int).
+     */
+    int constellationId(const SkyPoint *p) const;
+
+    /** @short Identifiers of the constellations containing many points, found in parallel, in the order of @p points. */
+    QVector<int> constellationIds(const QVector<const SkyPoint *> &points) const;
+
+    /** @return the name of the constellation @p id, localized if so configured, or "Unknown" for -1. */
+    QString constellationName(int id) const;
+
     bool selected() override;
 
     void preDraw(SkyPainter *skyp) override;
 
   private:
-    void appendPoly(const std::shared_ptr<PolyList> &polyList, int debug = 0);
-
-    /**
-     * @short reads the indices from the KSFileReader instead of using
-     * the SkyMesh to create them.  If the file pointer is null or if
-     * debug == -1 then we fall back to using the index.
-     */
-    void appendPoly(std::shared_ptr<PolyList> &polyList, KSFileReader *file, int debug);
-
-    PolyList *ContainingPoly(const SkyPoint *p) const;
+    // Fills the lookup grid from the boundaries
+    void buildLookup();
+    int constellationId(double ra, double dec) const;
 
-    SkyMesh *m_skyMesh { nullptr };
-    PolyIndex m_polyIndex;
-    int m_polyIndexCnt { 0 };
+    // Constellation boundaries, in hours of RA and degrees of Dec
+    QVector<std::shared_ptr<PolyList>> m_polyLists;
+    QVector<QRectF> m_boundingRects;
+    // Constellation filling each cell of the grid, -1 if the cell is crossed by a boundary
+    QVector<int> m_cellOwner;
+    // Constellations whose boundaries cross each cell
+    QVector<QVector<int>> m_cellCandidates;
 };
@@ -22,6 +22,9 @@
 #include <qplatformdefs.h>
 #include <QtConcurrent>
 #include <QElapsedTimer>
+#include <QMutexLocker>
+
+#include <algorithm>
 
 #include <kstars_debug.h>
 
@@ -42,11 +45,60 @@ DeepStarComponent::DeepStarComponent(SkyComposite *parent, QString fileName, flo
 
 DeepStarComponent::~DeepStarComponent()
 {
+    // The prefetcher reads the data file through the star block lists
+    m_prefetcher.cancel();
     if (fileOpened)
         starReader.closeFile();
     fileOpened = false;
 }
 
+void DeepStarComponent::prefetch(double radius, const QVector<StarBlockPrefetcher::Task> &deferred)
+{
+#ifndef KSTARS_LITE
+    QVector<StarBlockPrefetcher::Task> tasks = deferred;
+
+    const double zoomFactor = m_prefetcher.predictedZoomFactor();
+    const float maglim      = StarComponent::zoomMagnitudeLimit(zoomFactor);
+    if (maglim >= triggerMag)
+    {
+        // The field of view shrinks as the zoom factor grows. Pad it to reach the neighbouring trixels.
+        const double predictedRadius = std::min(90.0, radius * Options::zoomFactor() / zoomFactor);
+        SkyPoint focus               = m_prefetcher.predictedFocus();
+        m_skyMesh->aperture(&focus, 1.25 * predictedRadius + 1.5, PREFETCH_BUF);
+
+        MeshIterator region(m_skyMesh, PREFETCH_BUF);
+        while (region.hasNext())
+        {
+            Trixel trixel = region.next();
+            if (trixel >= m_starBlockList.size())
+                continue;
+
+            const std::shared_ptr<StarBlockList> &sbl = m_starBlockList.at(trixel);
+            QMutexLocker locker(sbl->mutex());
+            if (!sbl->isFilledToMag(maglim))
+                tasks.append(qMakePair(sbl, maglim));
+        }
+    }
+
+    // Stars missing from the map are redrawn as soon as they are loaded
+    std::function<void()> onLoaded;
+    if (!deferred.isEmpty())
+    {
+        onLoaded = []()
+        {
+            SkyMap *map = SkyMap::Instance();
+            if (map)
+                QMetaObject::invokeMethod(map, [map]() { map->forceUpdate(); }, Qt::QueuedConnection);
+        };
+    }
+
+    m_prefetcher.request(tasks, onLoaded);
+#else
+    Q_UNUSED(radius)
+    Q_UNUSED(deferred)
+#endif
+}
+
 bool DeepStarComponent::loadStaticStars()
 {
     FILE *dataFile;
@@ -245,9 +297,7 @@ void DeepStarComponent::draw(SkyPainter *skyp)
     StarObject::updateCoordsCpuTime = 0.;
     StarObject::starsUpdated        = 0;
 #endif
-    SkyMap *map       = SkyMap::Instance();
-    KStarsData *data  = KStarsData::Instance();
-    UpdateID updateID = data->updateID();
+    SkyMap *map = SkyMap::Instance();
 
     //FIXME_FOV -- maybe not clamp like that...
     float radius = map->projector()->fov();
@@ -272,14 +322,24 @@ void DeepStarComponent::draw(SkyPainter *skyp)
 
     float maglim = StarComponent::zoomMagnitudeLimit();
 
+    m_drawStatistics = DrawStatistics();
+
+    SkyPoint *focus = map->focus();
+    if (!staticStars && Options::prefetchStarBlocks())
+        m_prefetcher.updateViewport(*focus, Options::zoomFactor());
+
     if (maglim < triggerMag)
+    {
+        // Zooming in may soon bring us above the trigger magnitude
+        if (!staticStars && Options::prefetchStarBlocks())
+            prefetch(radius, QVector<StarBlockPrefetcher::Task>());
         return;
+    }
 
     m_zoomMagLimit = maglim;
 
     m_skyMesh->inDraw(true);
 
-    SkyPoint *focus = map->focus();
     m_skyMesh->aperture(focus, radius + 1.0, DRAW_BUF); // divide by 2 for testing
 
     MeshIterator region(m_skyMesh, DRAW_BUF);
@@ -289,17 +349,28 @@ void DeepStarComponent::draw(SkyPainter *skyp)
         maglim = hideStarsMag;
 
     StarBlockFactory *m_StarBlockFactory = StarBlockFactory::Instance();
-    //    m_StarBlockFactory->drawID = m_skyMesh->drawID();
+    // Blocks marked in this draw are not recycled before the next one, as in StarComponent::draw(). Loading
+    // a trixel, here or in the prefetcher, grows the cache rather than taking blocks from the trixels in view.
+    if (!staticStars)
+    {
+        QMutexLocker locker(m_StarBlockFactory->mutex());
+        m_StarBlockFactory->drawID = m_skyMesh->drawID();
+    }
     //    qDebug() << Q_FUNC_INFO << "Mesh size = " << m_skyMesh->size() << "; drawID = " << m_skyMesh->drawID();
     QElapsedTimer t;
     int nTrixels = 0;
 
-    t_dynamicLoad = 0;
-    t_updateCache = 0;
-    t_drawUnnamed = 0;
-
     visibleStarCount = 0;
 
+    // Precession, nutation and aberration are gathered once for all the blocks
+    const StarBlock::Frame frame = StarBlock::Frame::current();
+    SkyPoint position;
+
+    // While the map moves, draw the stars that are already loaded rather than waiting for the disk. The
+    // prefetcher loads the rest and requests a new draw.
+    const bool deferLoading = !staticStars && Options::prefetchStarBlocks() && map->isSlewing();
+    QVector<StarBlockPrefetcher::Task> deferred;
+
     t.start();
 
     // Mark used blocks in the LRU Cache. Not required for static stars
@@ -308,6 +379,8 @@ void DeepStarComponent::draw(SkyPainter *skyp)
         while (region.hasNext())
         {
             Trixel currentRegion = region.next();
+            QMutexLocker listLocker(m_starBlockList.at(currentRegion)->mutex());
+            QMutexLocker locker(m_StarBlockFactory->mutex());
             for (int i = 0; i < m_starBlockList.at(currentRegion)->getBlockCount(); ++i)
             {
                 std::shared_ptr<StarBlock> prevBlock = ((i >= 1) ? m_starBlockList.at(currentRegion)->block(
@@ -323,7 +396,7 @@ void DeepStarComponent::draw(SkyPainter *skyp)
                     break;
             }
         }
-        t_updateCache = t.elapsed();
+        m_drawStatistics.updateCacheTime = t.nsecsElapsed() / 1000;
         region.reset();
     }
 
@@ -341,9 +414,24 @@ void DeepStarComponent::draw(SkyPainter *skyp)
         if (currentRegion >= m_starBlockList.size())
             continue;
 
+        // The prefetcher may be filling the trixel
+        QMutexLocker listLocker(m_starBlockList.at(currentRegion)->mutex());
+
         if (!staticStars)
         {
-            m_starBlockList.at(currentRegion)->fillToMag(maglim);
+            const std::shared_ptr<StarBlockList> &sbl = m_starBlockList.at(currentRegion);
+            if (deferLoading && !sbl->isFilledToMag(maglim))
+            {
+                deferred.append(qMakePair(sbl, maglim));
+            }
+            else
+            {
+                const long loaded = sbl->getStarCount();
+                t.restart();
+                sbl->fillToMag(maglim);
+                m_drawStatistics.recordsLoaded += sbl->getStarCount() - loaded;
+                m_drawStatistics.dynamicLoadTime += t.nsecsElapsed() / 1000;
+            }
         }
 
         //        if (!staticStars && !m_starBlockList.at(currentRegion)->fillToMag(maglim) &&
@@ -352,21 +440,15 @@ void DeepStarComponent::draw(SkyPainter *skyp)
         //            qCWarning(KSTARS) << "SBL::fillToMag( " << maglim << " ) failed for trixel " << currentRegion;
         //        }
 
-        t_dynamicLoad += t.restart();
+        t.restart();
 
         //        qDebug() << Q_FUNC_INFO << "Drawing SBL for trixel " << currentRegion << ", SBL has "
         //                 <<  m_starBlockList[ currentRegion ]->getBlockCount() << " blocks";
 
-        // REMARK: The following should never carry state, except for const parameters like updateID and maglim
-        std::function<void(std::shared_ptr<StarBlock>)> mapFunction = [&updateID, &maglim](std::shared_ptr<StarBlock> myBlock)
+        // REMARK: The following should never carry state, except for const parameters like frame and maglim
+        std::function<void(std::shared_ptr<StarBlock>)> mapFunction = [&frame, &maglim](std::shared_ptr<StarBlock> myBlock)
         {
-            for (StarObject &star : myBlock->contents())
-            {
-                if (star.updateID != updateID)
-                    star.JITupdate();
-                if (star.mag() > maglim)
-                    break;
-            }
+            myBlock->updateCoords(frame, maglim);
         };
 
         QtConcurrent::blockingMap(m_starBlockList.at(currentRegion)->contents(), mapFunction);
@@ -378,26 +460,30 @@ void DeepStarComponent::draw(SkyPainter *skyp)
             //                currentRegion << ". SB has " << block->getStarCount() << " stars";
             for (int j = 0; j < block->getStarCount(); j++)
             {
-                StarObject *curStar = block->star(j);
-
                 //                qDebug() << Q_FUNC_INFO << "We claim that he's from trixel " << currentRegion
                 //<< ", and indexStar says he's from " << m_skyMesh->indexStar( curStar );
 
-                float mag = curStar->mag();
+                float mag = block->mag(j);
 
                 if (mag > maglim)
                     break;
 
-                if (skyp->drawPointSource(curStar, mag, curStar->spchar()))
+                if (skyp->drawPointSource(block->position(j, position), mag, block->spchar(j)))
                     visibleStarCount++;
             }
         }
 
         // DEBUG: Uncomment to identify problems with Star Block Factory / preservation of Magnitude Order in the LRU Cache
         //        verifySBLIntegrity();
-        t_drawUnnamed += t.restart();
+        m_drawStatistics.drawTime += t.nsecsElapsed() / 1000;
     }
+    m_drawStatistics.trixels = nTrixels;
+    m_drawStatistics.deferredTrixels = deferred.size();
+    m_drawStatistics.visibleStars = visibleStarCount;
     m_skyMesh->inDraw(false);
+
+    if (!staticStars && Options::prefetchStarBlocks())
+        prefetch(radius, deferred);
 #ifdef PROFILE_SINCOS
     trig_calls_here += dms::trig_function_calls;
     trig_redundancy_here += dms::redundant_trig_function_calls;
@@ -461,6 +547,9 @@ bool DeepStarComponent::openDataFile()
         ret = fread(&MSpT, 2, 1, starReader.getFileHandle());
         if (starReader.getByteSwap())
             MSpT = bswap_16(MSpT);
+        // Dynamically loaded stars are read from a memory mapping of the catalog
+        if (!staticStars && !starReader.mapFile())
+            qCWarning(KSTARS) << "Could not map deep star catalog" << dataFileName << "in memory, reading it from file.";
         fileOpened = true;
         qCInfo(KSTARS) << "  Sky Mesh Size: " << m_skyMesh->size();
         for (long int i = 0; i < m_skyMesh->size(); i++)
@@ -494,6 +583,11 @@ StarObject *DeepStarComponent::findByHDIndex(int HDnum)
 SkyObject *DeepStarComponent::objectNearest(SkyPoint *p, double &maxrad)
 {
     StarObject *oBest = nullptr;
+#ifndef KSTARS_LITE
+    std::shared_ptr<StarBlock> bestBlock;
+    int bestIndex = -1;
+    SkyPoint position;
+#endif
 
 #ifdef KSTARS_LITE
     m_zoomMagLimit = StarComponent::zoomMagnitudeLimit();
@@ -513,6 +607,11 @@ SkyObject *DeepStarComponent::objectNearest(SkyPoint *p, double &maxrad)
         if ((int)currentRegion >= m_starBlockList.size())
             continue;
 
+        QMutexLocker locker(m_starBlockList.at(currentRegion)->mutex());
+#ifndef KSTARS_LITE
+        bestBlock.reset();
+#endif
+
         for (int i = 0; i < m_starBlockList.at(currentRegion)->getBlockCount(); ++i)
         {
             std::shared_ptr<StarBlock> block = m_starBlockList.at(currentRegion)->block(i);
@@ -520,9 +619,6 @@ SkyObject *DeepStarComponent::objectNearest(SkyPoint *p, double &maxrad)
             {
 #ifdef KSTARS_LITE
                 StarObject *star = &(block->star(j)->star);
-#else
-                StarObject *star = block->star(j);
-#endif
                 if (!star)
                     continue;
                 if (star->mag() > m_zoomMagLimit)
@@ -534,8 +630,27 @@ SkyObject *DeepStarComponent::objectNearest(SkyPoint *p, double &maxrad)
                     oBest  = star;
                     maxrad = r;
                 }
+#else
+                if (block->mag(j) > m_zoomMagLimit)
+                    continue;
+
+                // Only the nearest star needs a StarObject
+                double r = block->position(j, position)->angularDistanceTo(p).Degrees();
+                if (r < maxrad)
+                {
+                    bestBlock = block;
+                    bestIndex = j;
+                    maxrad    = r;
+                }
+#endif
             }
         }
+
+#ifndef KSTARS_LITE
+        // Blocks may be recycled once the list is released
+        if (bestBlock)
+            oBest = bestBlock->star(bestIndex);
+#endif
     }
 
     // TODO: What if we are looking around a point that's not on
@@ -570,12 +685,17 @@ bool DeepStarComponent::starsInAperture(QList<StarObject *> &list, const SkyPoin
     if (maglim < -28)
         maglim = m_FaintMagnitude;
 
+#ifndef KSTARS_LITE
+    SkyPoint position;
+#endif
+
     while (region.hasNext())
     {
         Trixel currentRegion = region.next();
         // FIXME: Build a better way to iterate over all stars.
         // Ideally, StarBlockList should have such a facility.
         std::shared_ptr<StarBlockList> sbl = m_starBlockList[currentRegion];
+        QMutexLocker locker(sbl->mutex());
         sbl->fillToMag(maglim);
         for (int i = 0; i < sbl->getBlockCount(); ++i)
         {
@@ -584,13 +704,16 @@ bool DeepStarComponent::starsInAperture(QList<StarObject *> &list, const SkyPoin
             {
 #ifdef KSTARS_LITE
                 StarObject *star = &(block->star(j)->star);
-#else
-                StarObject *star = block->star(j);
-#endif
                 if (star->mag() > maglim)
                     break; // Stars are organized by magnitude, so this should work
                 if (star->angularDistanceTo(&center).Degrees() <= radius)
                     list.append(star);
+#else
+                if (block->mag(j) > maglim)
+                    break; // Stars are organized by magnitude, so this should work
+                if (block->position(j, position)->angularDistanceTo(&center).Degrees() <= radius)
+                    list.append(block->star(j));
+#endif
             }
         }
     }
@@ -620,6 +743,18 @@ void DeepStarComponent::byteSwap(StarData *stardata)
     stardata->bv_index = bswap_16(stardata->bv_index);
 }
 
+void DeepStarComponent::byteSwap(DeepStarData *stardata, int count)
+{
+    for (int i = 0; i < count; ++i)
+        byteSwap(stardata + i);
+}
+
+void DeepStarComponent::byteSwap(StarData *stardata, int count)
+{
+    for (int i = 0; i < count; ++i)
+        byteSwap(stardata + i);
+}
+
 bool DeepStarComponent::verifySBLIntegrity()
 {
     float faintMag = -5.0;
@@ -19,6 +19,7 @@
 #include "ksnumbers.h"
 #include "listcomponent.h"
 #include "starblockfactory.h"
+#include "starblockprefetcher.h"
 #include "skyobjects/deepstardata.h"
 #include "skyobjects/stardata.h"
 
@@ -76,8 +77,34 @@ class DeepStarComponent : public ListComponent
 
     inline BinFileHelper *getStarReader() { return &starReader; }
 
+    /** @short Mutex serializing the reads of the catalog file when it is not mapped in memory */
+    inline QMutex *readMutex() { return &m_readMutex; }
+
     bool verifySBLIntegrity();
 
+    /**
+     * @short Timing and loading figures of the last draw, shown by the star loading debug overlay
+     */
+    struct DrawStatistics
+    {
+        /// Time spent loading stars from the catalog file, in microseconds
+        quint64 dynamicLoadTime { 0 };
+        /// Time spent updating the LRU cache of star blocks, in microseconds
+        quint64 updateCacheTime { 0 };
+        /// Time spent updating and drawing the stars, in microseconds
+        quint64 drawTime { 0 };
+        /// Number of star records loaded from the catalog file
+        quint64 recordsLoaded { 0 };
+        int trixels { 0 };
+        /// Visible trixels left for the prefetcher to load while the map moves
+        int deferredTrixels { 0 };
+        unsigned long visibleStars { 0 };
+    };
+
+    inline const DrawStatistics &drawStatistics() const { return m_drawStatistics; }
+
+    inline const QString &fileName() const { return dataFileName; }
+
     /**
      * @short Add to the given list, the stars from this component,
      * that lie within the specified circular aperture, and that are
@@ -98,6 +125,9 @@ class DeepStarComponent : public ListComponent
     // TODO: Find the right place for this method
     static void byteSwap(DeepStarData *stardata);
     static void byteSwap(StarData *stardata);
+    /** @short Byte swap count consecutive records in place */
+    static void byteSwap(DeepStarData *stardata, int count);
+    static void byteSwap(StarData *stardata, int count);
 
     static StarBlockFactory m_StarBlockFactory;
 
@@ -117,9 +147,17 @@ class DeepStarComponent : public ListComponent
     quint16 MSpT { 0 };
 
     // Time keeping variables
-    long unsigned t_dynamicLoad { 0 };
-    long unsigned t_drawUnnamed { 0 };
-    long unsigned t_updateCache { 0 };
+    DrawStatistics m_drawStatistics;
+
+    /**
+     * @short Request the prefetcher to load the trixels the sky map is heading to
+     * @param radius Radius of the current field of view, in degrees
+     * @param deferred Visible trixels the draw did not load, to be loaded first
+     */
+    void prefetch(double radius, const QVector<StarBlockPrefetcher::Task> &deferred);
+
+    StarBlockPrefetcher m_prefetcher;
+    QMutex m_readMutex;
 
     QVector<std::shared_ptr<StarBlockList>> m_starBlockList;
     QHash<int, StarObject *> m_CatalogNumber;
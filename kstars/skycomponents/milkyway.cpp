@@ -17,21 +17,11 @@
 #include "skypainter.h"
 #include "skycomponents/skiphashlist.h"
 
-#include <QtConcurrent>
-
 MilkyWay::MilkyWay(SkyComposite *parent) : LineListIndex(parent, i18n("Milky Way"))
 {
     intro();
-    // Milky way
-    //loadContours("milkyway.dat", i18n("Loading Milky Way"));
-    // Magellanic clouds
-    //loadContours("lmc.dat", i18n("Loading Large Magellanic Clouds"));
-    //loadContours("smc.dat", i18n("Loading Small Magellanic Clouds"));
-    //summary();
-
-    QtConcurrent::run(this, &MilkyWay::loadContours, QString("milkyway.dat"), i18n("Loading Milky Way"));
-    QtConcurrent::run(this, &MilkyWay::loadContours, QString("lmc.dat"), i18n("Loading Large Magellanic Clouds"));
-    QtConcurrent::run(this, &MilkyWay::loadContours, QString("smc.dat"), i18n("Loading Small Magellanic Clouds"));
+    // Contours of the Milky Way and Magellanic clouds are read on worker threads at startup,
+    // and indexed through appendContours() once read, see SkyMapComposite.
 }
 
 const IndexHash &MilkyWay::getIndexHash(LineList *lineList)
@@ -73,22 +63,21 @@ void MilkyWay::draw(SkyPainter *skyp)
     }
 }
 
-void MilkyWay::loadContours(QString fname, QString greeting)
+QList<std::shared_ptr<LineList>> MilkyWay::readContours(const QString &fname)
 {
     KSFileReader fileReader;
+    QList<std::shared_ptr<LineList>> contours;
     std::shared_ptr<LineList> skipList;
     int iSkip = 0;
 
     if (!fileReader.open(fname))
-        return;
+        return contours;
 
-    fileReader.setProgress(greeting, 2136, 5);
     while (fileReader.hasMoreLines())
     {
         QString line = fileReader.readLine();
         QChar firstChar = line.at(0);
 
-        fileReader.showProgress();
         if (firstChar == '#')
             continue;
 
@@ -105,7 +94,7 @@ void MilkyWay::loadContours(QString fname, QString greeting)
         if (firstChar == 'M')
         {
             if (skipList.get())
-                appendBoth(skipList);
+                contours.append(skipList);
             skipList.reset();
             iSkip    = 0;
         }
@@ -122,5 +111,13 @@ void MilkyWay::loadContours(QString fname, QString greeting)
         iSkip++;
     }
     if (skipList.get())
+        contours.append(skipList);
+
+    return contours;
+}
+
+void MilkyWay::appendContours(const QList<std::shared_ptr<LineList>> &contours)
+{
+    for (const auto &skipList : contours)
         appendBoth(skipList);
 }
@@ -32,8 +32,14 @@ class MilkyWay : public LineListIndex
      */
     explicit MilkyWay(SkyComposite *parent);
 
-    /** Load skiplists from file */
-    void loadContours(QString fname, QString greeting);
+    /**
+     * @short Reads the skiplists of a contour file, without indexing them.
+     * Safe to call from a worker thread.
+     */
+    static QList<std::shared_ptr<LineList>> readContours(const QString &fname);
+
+    /** @short Indexes skiplists read by readContours() for drawing. */
+    void appendContours(const QList<std::shared_ptr<LineList>> &contours);
 
     void draw(SkyPainter *skyp) override;
     bool selected() override;
@@ -18,11 +18,9 @@
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QProgressDialog>
-#include <QtConcurrent>
 
 SatellitesComponent::SatellitesComponent(SkyComposite *parent) : SkyComponent(parent)
 {
-    QtConcurrent::run(this, &SatellitesComponent::loadData);
 }
 
 SatellitesComponent::~SatellitesComponent()
@@ -32,15 +30,20 @@ SatellitesComponent::~SatellitesComponent()
 }
 
 void SatellitesComponent::loadData()
+{
+    emitProgressText(i18n("Loading satellites"));
+    setGroups(readGroups());
+}
+
+QList<SatelliteGroup *> SatellitesComponent::readGroups()
 {
     KSFileReader fileReader;
     QString line;
     QStringList group_infos;
+    QList<SatelliteGroup *> groups;
 
     if (!fileReader.open("satellites.dat"))
-        return;
-
-    emitProgressText(i18n("Loading satellites"));
+        return groups;
 
     while (fileReader.hasMoreLines())
     {
@@ -48,9 +51,18 @@ void SatellitesComponent::loadData()
         if (line.trimmed().isEmpty() || line.at(0) == '#')
             continue;
         group_infos = line.split(';');
-        m_groups.append(new SatelliteGroup(group_infos.at(0), group_infos.at(1), QUrl(group_infos.at(2))));
+        groups.append(new SatelliteGroup(group_infos.at(0), group_infos.at(1), QUrl(group_infos.at(2))));
     }
 
+    return groups;
+}
+
+void SatellitesComponent::setGroups(const QList<SatelliteGroup *> &groups)
+{
+    qDeleteAll(m_groups);
+    m_groups = groups;
+    nameHash.clear();
+
     objectNames(SkyObject::SATELLITE).clear();
     objectLists(SkyObject::SATELLITE).clear();
 
@@ -70,6 +82,27 @@ void SatellitesComponent::loadData()
     }
 }
 
+bool SatellitesComponent::predictPasses(double hours)
+{
+    QList<Satellite *> satellites;
+    for (SatelliteGroup *group : m_groups)
+    {
+        for (Satellite *sat : *group)
+        {
+            if (sat->selected())
+                satellites.append(sat);
+        }
+    }
+
+    KStarsData *data = KStarsData::Instance();
+    return m_passPredictor.predict(satellites, data->geo(), data->ut(), hours);
+}
+
+SatellitePassPredictor *SatellitesComponent::passPredictor()
+{
+    return &m_passPredictor;
+}
+
 bool SatellitesComponent::selected()
 {
     return Options::showSatellites();
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "satellitegroup.h"
+#include "satellitepasspredictor.h"
 #include "skycomponent.h"
 
 #include <QList>
@@ -26,6 +27,8 @@ class SatellitesComponent : public SkyComponent
         /**
          * @short Constructor
          * @param parent pointer to the parent SkyComposite
+         *
+         * The satellites are loaded at startup through readGroups() and setGroups(), see SkyMapComposite.
          */
         explicit SatellitesComponent(SkyComposite *parent = nullptr);
 
@@ -93,10 +96,31 @@ class SatellitesComponent : public SkyComponent
 
         void loadData();
 
+        /**
+         * @short Reads the satellite groups and their TLE files, without adding them to the component.
+         *
+         * Safe to call from a worker thread.
+         */
+        static QList<SatelliteGroup *> readGroups();
+
+        /** @short Replaces the satellite groups with those read by readGroups(), taking ownership of them. */
+        void setGroups(const QList<SatelliteGroup *> &groups);
+
+        /**
+         * @short Predicts the passes of the selected satellites over the current location, for
+         * the next @p hours, unless the cached prediction still covers them.
+         * @return true if a prediction was started. The passes are then available from passPredictor()
+         * once it emits passesPredicted(), otherwise they are available right away.
+         */
+        bool predictPasses(double hours);
+
+        SatellitePassPredictor *passPredictor();
+
     protected:
         void drawTrails(SkyPainter *skyp) override;
 
     private:
         QList<SatelliteGroup *> m_groups; // List of all groups
         QHash<QString, Satellite *> nameHash;
+        SatellitePassPredictor m_passPredictor;
 };
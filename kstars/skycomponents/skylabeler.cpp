@@ -6,27 +6,30 @@
 
 #include "skylabeler.h"
 
+#include <algorithm>
 #include <cstdio>
 
 #include <QPainter>
 #include <QPixmap>
+#include <QtAlgorithms>
 
 #include "Options.h"
 #include "kstarsdata.h" // MINZOOM
 #include "skymap.h"
 #include "projections/projector.h"
 
-//---------------------------------------------------------------------------//
-// A Little data container class
-//---------------------------------------------------------------------------//
-
-typedef struct LabelRun
+namespace
 {
-    LabelRun(int s, int e) : start(s), end(e) {}
-    int start;
-    int end;
+// Columns of the virtual screen on each side of the actual screen
+constexpr int SCREEN_MARGIN = 1024;
 
-} LabelRun;
+// Bits first to last, included, of a word of the virtual screen
+quint64 bitRange(int first, int last)
+{
+    const quint64 upTo = (last == 63) ? ~quint64(0) : (quint64(1) << (last + 1)) - 1;
+    return upTo & (~quint64(0) << first);
+}
+}
 
 //----- Now for the main event ----------------------------------------------//
 
@@ -81,7 +84,8 @@ double SkyLabeler::ZoomOffset()
 //----- Constructor ---------------------------------------------------------//
 
 SkyLabeler::SkyLabeler()
-    : m_fontMetrics(QFont()), m_picture(-1), labelList(NUM_LABEL_TYPES)
+    : m_typeHits(NUM_LABEL_TYPES), m_typeMisses(NUM_LABEL_TYPES), m_fontMetrics(QFont()), m_picture(-1),
+      labelList(NUM_LABEL_TYPES)
 {
 #ifdef KSTARS_LITE
     //Painter is needed to get default font and we use it only once to have only one warning
@@ -99,14 +103,6 @@ SkyLabeler::SkyLabeler()
 
 SkyLabeler::~SkyLabeler()
 {
-    for (auto &row : screenRows)
-    {
-        for (auto &item : *row)
-        {
-            delete item;
-        }
-        delete row;
-    }
 }
 
 bool SkyLabeler::drawGuideLabel(QPointF &o, const QString &text, double angle)
@@ -271,47 +267,7 @@ void SkyLabeler::reset(SkyMap *skyMap)
     m_offset = SkyLabeler::ZoomOffset();
 
     // ----- Prepare Virtual Screen -----
-    m_yScale = (m_fontMetrics.height() + 1.0);
-
-    int maxY = int(skyMap->height() / m_yScale);
-    if (maxY < 1)
-        maxY = 1; // prevents a crash below?
-
-    int m_maxX = skyMap->width();
-    m_size     = (maxY + 1) * m_maxX;
-
-    // Resize if needed:
-    if (maxY > m_maxY)
-    {
-        screenRows.resize(m_maxY);
-        for (int y = m_maxY; y <= maxY; y++)
-        {
-            screenRows.append(new LabelRow());
-        }
-        //printf("resize: %d -> %d, size:%d\n", m_maxY, maxY, screenRows.size());
-    }
-
-    // Clear all pre-existing rows as needed
-
-    int minMaxY = (maxY < m_maxY) ? maxY : m_maxY;
-
-    for (int y = 0; y <= minMaxY; y++)
-    {
-        LabelRow *row = screenRows[y];
-
-        for (auto &item : *row)
-        {
-            delete item;
-        }
-        row->clear();
-    }
-
-    // never decrease m_maxY:
-    if (m_maxY < maxY)
-        m_maxY = maxY;
-
-    // reset the counters
-    m_marks = m_hits = m_misses = m_elements = 0;
+    resetScreen(skyMap->width(), skyMap->height());
 
     //----- Clear out labelList -----
     for (auto &item : labelList)
@@ -336,54 +292,36 @@ void SkyLabeler::reset()
     m_offset = ZoomOffset();
 
     // ----- Prepare Virtual Screen -----
-    m_yScale = (m_fontMetrics.height() + 1.0);
-
-    int maxY = int(skyMap->height() / m_yScale);
-    if (maxY < 1)
-        maxY = 1; // prevents a crash below?
-
-    int m_maxX = skyMap->width();
-    m_size     = (maxY + 1) * m_maxX;
+    resetScreen(skyMap->width(), skyMap->height());
 
-    // Resize if needed:
-    if (maxY > m_maxY)
+    //----- Clear out labelList -----
+    for (int i = 0; i < labelList.size(); i++)
     {
-        screenRows.resize(m_maxY);
-        for (int y = m_maxY; y <= maxY; y++)
-        {
-            screenRows.append(new LabelRow());
-        }
-        //printf("resize: %d -> %d, size:%d\n", m_maxY, maxY, screenRows.size());
+        labelList[i].clear();
     }
+}
+#endif
 
-    // Clear all pre-existing rows as needed
+void SkyLabeler::resetScreen(int width, int height)
+{
+    m_yScale = (m_fontMetrics.height() + 1.0);
 
-    int minMaxY = (maxY < m_maxY) ? maxY : m_maxY;
+    m_maxY = int(height / m_yScale);
+    if (m_maxY < 1)
+        m_maxY = 1; // prevents a crash below?
 
-    for (int y = 0; y <= minMaxY; y++)
-    {
-        LabelRow *row = screenRows[y];
-        for (int i = 0; i < row->size(); i++)
-        {
-            delete row->at(i);
-        }
-        row->clear();
-    }
+    m_maxX    = width;
+    m_size    = (m_maxY + 1) * m_maxX;
+    m_columns = m_maxX + 2 * SCREEN_MARGIN;
+    m_words   = (m_columns + 63) / 64;
 
-    // never decrease m_maxY:
-    if (m_maxY < maxY)
-        m_maxY = maxY;
+    m_screen.fill(0, (m_maxY + 1) * m_words);
 
     // reset the counters
-    m_marks = m_hits = m_misses = m_elements = 0;
-
-    //----- Clear out labelList -----
-    for (int i = 0; i < labelList.size(); i++)
-    {
-        labelList[i].clear();
-    }
+    m_marks = m_hits = m_misses = 0;
+    m_typeHits.fill(0);
+    m_typeMisses.fill(0);
 }
-#endif
 
 void SkyLabeler::draw(QPainter &p)
 {
@@ -400,10 +338,8 @@ void SkyLabeler::draw(QPainter &p)
     //m_p.begin(&m_picture);
 }
 
-// We use Run Length Encoding to hold the information instead of an array of
-// chars.  This is both faster and smaller but the code is more complicated.
-//
-// This code is easy to break and hard to fix.
+// The virtual screen is a bitset, checking and marking a label only touches
+// the words it spans in each strip.
 
 bool SkyLabeler::markText(const QPointF &p, const QString &text, qreal padding_factor)
 {
@@ -432,13 +368,10 @@ bool SkyLabeler::markRegion(qreal left, qreal right, qreal top, qreal bot)
     }
 
     // setup x coordinates of rectangular region
-    int minX = int(left);
-    int maxX = int(right);
+    int minX = column(int(left));
+    int maxX = column(int(right));
     if (maxX < minX)
-    {
-        maxX = minX;
-        minX = int(right);
-    }
+        std::swap(minX, maxX);
 
     // setup y coordinates
     int maxY = int(bot / m_yScale);
@@ -464,114 +397,103 @@ bool SkyLabeler::markRegion(qreal left, qreal right, qreal top, qreal bot)
     // We must check all rows before we start marking
     for (int y = minY; y <= maxY; y++)
     {
-        LabelRow *row = screenRows[y];
-        int i;
-        for (i = 0; i < row->size(); i++)
+        if (isMarked(y, minX, maxX))
         {
-            if (row->at(i)->end < minX)
-                continue; // skip past these
-            if (row->at(i)->start > maxX)
-                break;
             m_misses++;
             return false;
         }
     }
 
     m_hits++;
-    m_marks += (maxX - minX + 1) * (maxY - minY + 1);
-
-    // Okay, there was no overlap so let's insert the current rectangle into
-    // screenRows.
 
+    // Okay, there was no overlap so let's mark the current rectangle, along
+    // with the gaps narrower than m_minDeltaX it leaves to its neighbors.
     for (int y = minY; y <= maxY; y++)
     {
-        LabelRow *row = screenRows[y];
-
-        // Simplest case: an empty row
-        if (row->size() < 1)
-        {
-            row->append(new LabelRun(minX, maxX));
-            m_elements++;
-            continue;
-        }
-
-        // Find out our place in the universe (or row).
-        // H'mm.  Maybe we could cache these numbers above.
-        int i;
-        for (i = 0; i < row->size(); i++)
-        {
-            if (row->at(i)->end >= minX)
-                break;
-        }
-
-        // i now points to first label PAST ours
-
-        // if we are first, append or merge at start of list
-        if (i == 0)
-        {
-            if (row->at(0)->start - maxX < m_minDeltaX)
-            {
-                row->at(0)->start = minX;
-            }
-            else
-            {
-                row->insert(0, new LabelRun(minX, maxX));
-                m_elements++;
-            }
-            continue;
-        }
-
-        // if we are past the last label, merge or append at end
-        else if (i == row->size())
-        {
-            if (minX - row->at(i - 1)->end < m_minDeltaX)
-            {
-                row->at(i - 1)->end = maxX;
-            }
-            else
-            {
-                row->append(new LabelRun(minX, maxX));
-                m_elements++;
-            }
-            continue;
-        }
-
-        // if we got here, we must insert or merge the new label
-        //  between [i-1] and [i]
+        int first = minX;
+        int last  = maxX;
+
+        const int before = lastMarked(y, std::max(0, minX - m_minDeltaX + 1), minX - 1);
+        if (before >= 0)
+            first = before + 1;
+
+        const int after = firstMarked(y, maxX + 1, std::min(m_columns - 1, maxX + m_minDeltaX - 1));
+        if (after >= 0)
+            last = after - 1;
+
+        // Only the columns of the actual screen count towards the fill ratio
+        const int screenFirst = std::max(first, SCREEN_MARGIN);
+        const int screenLast  = std::min(last, SCREEN_MARGIN + m_maxX - 1);
+        if (screenFirst <= screenLast)
+            m_marks += mark(y, screenFirst, screenLast);
+        if (first < screenFirst)
+            mark(y, first, std::min(last, screenFirst - 1));
+        if (last > screenLast)
+            mark(y, std::max(first, screenLast + 1), last);
+    }
 
-        bool mergeHead = (minX - row->at(i - 1)->end < m_minDeltaX);
-        bool mergeTail = (row->at(i)->start - maxX < m_minDeltaX);
+    return true;
+}
 
-        // double merge => combine all 3 into one
-        if (mergeHead && mergeTail)
-        {
-            row->at(i - 1)->end = row->at(i)->end;
-            delete row->at(i);
-            row->removeAt(i);
-            m_elements--;
-        }
+int SkyLabeler::column(int x) const
+{
+    return qBound(0, x + SCREEN_MARGIN, m_columns - 1);
+}
 
-        // Merge label with [i-1]
-        else if (mergeHead)
-        {
-            row->at(i - 1)->end = maxX;
-        }
+bool SkyLabeler::isMarked(int y, int first, int last) const
+{
+    const quint64 *strip = m_screen.constData() + y * m_words;
+    for (int w = first / 64; w <= last / 64; w++)
+    {
+        const int from = (w == first / 64) ? first % 64 : 0;
+        const int to   = (w == last / 64) ? last % 64 : 63;
+        if (strip[w] & bitRange(from, to))
+            return true;
+    }
+    return false;
+}
 
-        // Merge label with [i]
-        else if (mergeTail)
-        {
-            row->at(i)->start = minX;
-        }
+int SkyLabeler::firstMarked(int y, int first, int last) const
+{
+    const quint64 *strip = m_screen.constData() + y * m_words;
+    for (int w = first / 64; first <= last && w <= last / 64; w++)
+    {
+        const int from      = (w == first / 64) ? first % 64 : 0;
+        const int to        = (w == last / 64) ? last % 64 : 63;
+        const quint64 marks = strip[w] & bitRange(from, to);
+        if (marks)
+            return w * 64 + qCountTrailingZeroBits(marks);
+    }
+    return -1;
+}
 
-        // insert between the two
-        else
-        {
-            row->insert(i, new LabelRun(minX, maxX));
-            m_elements++;
-        }
+int SkyLabeler::lastMarked(int y, int first, int last) const
+{
+    const quint64 *strip = m_screen.constData() + y * m_words;
+    for (int w = last / 64; first <= last && w >= first / 64; w--)
+    {
+        const int from      = (w == first / 64) ? first % 64 : 0;
+        const int to        = (w == last / 64) ? last % 64 : 63;
+        const quint64 marks = strip[w] & bitRange(from, to);
+        if (marks)
+            return w * 64 + 63 - qCountLeadingZeroBits(marks);
     }
+    return -1;
+}
 
-    return true;
+int SkyLabeler::mark(int y, int first, int last)
+{
+    quint64 *strip = m_screen.data() + y * m_words;
+    int count      = 0;
+    for (int w = first / 64; w <= last / 64; w++)
+    {
+        const int from      = (w == first / 64) ? first % 64 : 0;
+        const int to        = (w == last / 64) ? last % 64 : 63;
+        const quint64 marks = bitRange(from, to) & ~strip[w];
+        count += qPopulationCount(marks);
+        strip[w] |= marks;
+    }
+    return count;
 }
 
 void SkyLabeler::addLabel(SkyObject *obj, SkyLabeler::label_t type)
@@ -633,11 +555,16 @@ void SkyLabeler::drawQueuedLabels()
 void SkyLabeler::drawQueuedLabelsType(SkyLabeler::label_t type)
 {
     LabelList list = labelList[type];
+    const int hits   = m_hits;
+    const int misses = m_misses;
 
     for (const auto &item : list)
     {
         drawNameLabel(item.obj, item.o);
     }
+
+    m_typeHits[type] += m_hits - hits;
+    m_typeMisses[type] += m_misses - misses;
 }
 
 //Rude name labels don't check for collisions with other labels,
@@ -687,47 +614,20 @@ void SkyLabeler::printInfo()
     printf("  hits=%d  misses=%d  ratio=%.1f%%\n", m_hits, m_misses, hitRatio());
     printf("  yScale=%.1f maxY=%d\n", m_yScale, m_maxY);
 
-    printf("  screenRows=%d elements=%d virtualSize=%.1f Kbytes\n", screenRows.size(), m_elements,
-           float(m_size) / 1024.0);
-
-//    static const char *labelName[NUM_LABEL_TYPES];
-//
-//    labelName[STAR_LABEL]         = "Star";
-//    labelName[ASTEROID_LABEL]     = "Asteroid";
-//    labelName[COMET_LABEL]        = "Comet";
-//    labelName[PLANET_LABEL]       = "Planet";
-//    labelName[JUPITER_MOON_LABEL] = "Jupiter Moon";
-//    labelName[SATURN_MOON_LABEL]  = "Saturn Moon";
-//    labelName[DEEP_SKY_LABEL]     = "Deep Sky Object";
-//    labelName[CONSTEL_NAME_LABEL] = "Constellation Name";
-//
-//    for (int i = 0; i < NUM_LABEL_TYPES; i++)
-//    {
-//        printf("  %20ss: %d\n", labelName[i], labelList[i].size());
-//    }
-//
-//    // Check for errors in the data structure
-//    for (int y = 0; y <= m_maxY; y++)
-//    {
-//        LabelRow *row = screenRows[y];
-//        int size      = row->size();
-//        if (size < 2)
-//            continue;
-//
-//        bool error = false;
-//        for (int i = 1; i < size; i++)
-//        {
-//            if (row->at(i - 1)->end > row->at(i)->start)
-//                error = true;
-//        }
-//        if (!error)
-//            continue;
-//
-//        printf("ERROR: %3d: ", y);
-//        for (int i = 0; i < row->size(); i++)
-//        {
-//            printf("(%d, %d) ", row->at(i)->start, row->at(i)->end);
-//        }
-//        printf("\n");
-//    }
+    printf("  strips=%d words=%d virtualSize=%.1f Kbytes\n", m_maxY + 1, m_screen.size(),
+           float(m_screen.size() * sizeof(quint64)) / 1024.0);
+
+    static const char *labelName[NUM_LABEL_TYPES] =
+    {
+        "Star", "Asteroid", "Comet", "Planet", "Jupiter Moon", "Saturn Moon",
+        "Deep Sky Object", "Constellation Name", "Satellite", "Rude"
+    };
+
+    for (int i = 0; i < NUM_LABEL_TYPES; i++)
+    {
+        if (labelList[i].isEmpty())
+            continue;
+        printf("  %20ss: %d queued  hits=%d  misses=%d\n", labelName[i], labelList[i].size(),
+               m_typeHits[i], m_typeMisses[i]);
+    }
 }
@@ -18,10 +18,6 @@ class QString;
 class QPointF;
 class SkyMap;
 class Projector;
-struct LabelRun;
-
-typedef QList<LabelRun *> LabelRow;
-typedef QVector<LabelRow *> ScreenRows;
 
 /**
  *@class SkyLabeler
@@ -35,21 +31,14 @@ typedef QVector<LabelRow *> ScreenRows;
  * and return true.
  *
  * Since we need to check for overlap for every label every time it is
- * potentially drawn on the screen, efficiency is essential.  So instead of
- * having a 2-dimensional array of boolean values we use Run Length Encoding
- * and store the virtual array in a QVector of QLists.  Each element of the
- * vector, a LabelRow, corresponds to a horizontal strip of pixels on the actual
- * screen.  How many vertical pixels are in each strip is controlled by
- * m_yDensity.  The higher the density, the fewer vertical pixels per strip and
- * hence a larger number of strips are needed to cover the screen.  As
- * m_yDensity increases so does the density of the strips.
- *
- * The information in the X-dimension is completed run length encoded. A
- * consecutive run of pixels in one strip that are covered by one or more labels
- * is stored in a LabelRun object that merely stores the start pixel and the end
- * pixel.  A LabelRow is a list of LabelRun's stored in ascending order.  This
- * saves a lot of space over an explicit array and it also makes checking for
- * overlaps faster and even makes inserting new overlaps faster on average.
+ * potentially drawn on the screen, efficiency is essential.  So the virtual
+ * screen is stored as a bitset.  Each horizontal strip of pixels on the actual
+ * screen, as high as the font, is a row of bits, one per pixel column, packed
+ * 64 to a word.  Checking a label only tests the few words it spans in each
+ * strip it covers, however many labels were marked before, and marking it
+ * sets the same words.  Gaps narrower than m_minDeltaX left between labels of
+ * a strip are filled as labels are marked.  The virtual screen extends a
+ * little beyond the edges of the actual screen, for labels running over them.
  *
  * Synopsis:
  *
@@ -290,7 +279,8 @@ class SkyLabeler
     //----- Diagnostics and Information -----//
 
     /**
-         * @short diagnostic. the *percentage* of pixels that have been filled.
+         * @short diagnostic. the *percentage* of pixels of the actual screen that
+         * have been filled, the margins are not counted.
          * Expect return values between 0.0 and 100.0.  A fillRatio above 20
          * is pretty busy and crowded.  I think a fillRatio of about 10 looks
          * good.  The fillRatio will be lowered of the screen is zoomed out
@@ -322,10 +312,35 @@ class SkyLabeler
 #endif
 
     int hits() { return m_hits; }
+    int misses() { return m_misses; }
     int marks() { return m_marks; }
 
   private:
-    ScreenRows screenRows;
+    friend class TestSkyLabeler;
+
+    /**
+     * @short clears the virtual screen and resizes it to a sky map of the
+     * given size, with strips as high as the current font.
+     */
+    void resetScreen(int width, int height);
+
+    /** @short returns the column of the virtual screen at pixel x. */
+    int column(int x) const;
+
+    /** @short returns true if any column from first to last is set in strip y. */
+    bool isMarked(int y, int first, int last) const;
+
+    /** @short returns the first or last column set from first to last in strip y, or -1. */
+    int firstMarked(int y, int first, int last) const;
+    int lastMarked(int y, int first, int last) const;
+
+    /** @short sets the columns from first to last in strip y, returns how many were clear. */
+    int mark(int y, int first, int last);
+
+    /// Virtual screen, m_words words for each of the m_maxY + 1 strips
+    QVector<quint64> m_screen;
+    int m_words { 0 };
+    int m_columns { 0 };
     int m_maxX { 0 };
     int m_maxY { 0 };
     int m_size { 0 };
@@ -334,8 +349,10 @@ class SkyLabeler
     int m_marks { 0 };
     int m_hits { 0 };
     int m_misses { 0 };
-    int m_elements { 0 };
     int m_errors { 0 };
+    /// Hits and misses of each type of queued label
+    QVector<int> m_typeHits;
+    QVector<int> m_typeMisses;
     qreal m_yScale { 0 };
     double m_offset { 0 };
     QFont m_stdFont, m_skyFont;
@@ -7,6 +7,7 @@
 #include "skymapcomposite.h"
 
 #include "artificialhorizoncomponent.h"
+#include "asteroidscomponent.h"
 #include "catalogsdb.h"
 #include "constellationartcomponent.h"
 #include "constellationboundarylines.h"
@@ -15,6 +16,7 @@
 #include "culturelist.h"
 #include "deepstarcomponent.h"
 #include "catalogscomponent.h"
+#include "cometscomponent.h"
 #include "ecliptic.h"
 #include "equator.h"
 #include "equatorialcoordinategrid.h"
@@ -66,24 +68,44 @@ SkyMapComposite::SkyMapComposite(SkyComposite *parent)
     // You can also set the debug level of individual
     // appendLine() and appendPoly() calls.
 
+    // Data sets indexed in the SkyMesh or read from databases load on the main thread,
+    // the others are read on worker threads meanwhile, see loadInBackground()
+    m_StartupTasks.reset(new StartupTaskGraph());
+
     //Add all components
     //Stars must come before constellation lines
 #ifdef KSTARS_LITE
     addComponent(m_MilkyWay = new MilkyWay(this), 50);
-    addComponent(m_Stars = StarComponent::Create(this), 10);
+    addComponent(m_Satellites = new SatellitesComponent(this), 7);
+    const int solarSystem = m_StartupTasks->measure("Solar system", [this]()
+    {
+        addComponent(m_SolarSystem = new SolarSystemComposite(this), 2);
+    });
+    loadInBackground(solarSystem);
+
+    m_StartupTasks->measure("Stars", [this]()
+    {
+        addComponent(m_Stars = StarComponent::Create(this), 10);
+    });
     addComponent(m_EquatorialCoordinateGrid = new EquatorialCoordinateGrid(this));
     addComponent(m_HorizontalCoordinateGrid = new HorizontalCoordinateGrid(this));
 
     // Do add to components.
-    addComponent(m_CBoundLines = new ConstellationBoundaryLines(this), 80);
-    m_Cultures.reset(new CultureList());
-    addComponent(m_CLines = new ConstellationLines(this, m_Cultures.get()), 85);
-    addComponent(m_CNames = new ConstellationNamesComponent(this, m_Cultures.get()), 90);
+    m_StartupTasks->measure("Constellations", [this]()
+    {
+        addComponent(m_CBoundLines = new ConstellationBoundaryLines(this), 80);
+        m_Cultures.reset(new CultureList());
+        addComponent(m_CLines = new ConstellationLines(this, m_Cultures.get()), 85);
+        addComponent(m_CNames = new ConstellationNamesComponent(this, m_Cultures.get()), 90);
+    });
     addComponent(m_Equator = new Equator(this), 95);
     addComponent(m_Ecliptic = new Ecliptic(this), 95);
     addComponent(m_Horizon = new HorizonComponent(this), 100);
-    addComponent(
-        m_ConstellationArt = new ConstellationArtComponent(this, m_Cultures.get()), 100);
+    m_StartupTasks->measure("Constellation art", [this]()
+    {
+        addComponent(
+            m_ConstellationArt = new ConstellationArtComponent(this, m_Cultures.get()), 100);
+    });
 
     addComponent(m_ArtificialHorizon = new ArtificialHorizonComponent(this), 110);
 
@@ -91,30 +113,157 @@ SkyMapComposite::SkyMapComposite(SkyComposite *parent)
 
     Options::setShowCatalogNames(allcatalogs);
 
-    addComponent(m_SolarSystem = new SolarSystemComposite(this), 2);
-
     //addComponent( m_ObservingList = new TargetListComponent( this , 0, QPen(),
     //                                                       &Options::obsListSymbol, &Options::obsListText ), 120 );
     addComponent(m_StarHopRouteList = new TargetListComponent(this, 0, QPen()), 130);
-    addComponent(m_Satellites = new SatellitesComponent(this), 7);
     addComponent(m_Supernovae = new SupernovaeComponent(this), 7);
+
+    // Sky items are created for the objects loaded when loading finishes
+    m_StartupTasks->start();
+    m_StartupTasks->waitForAll();
     SkyMapLite::Instance()->loadingFinished();
 #else
     addComponent(m_MilkyWay = new MilkyWay(this), 50);
-    addComponent(m_Stars = StarComponent::Create(this), 10);
+    addComponent(m_Satellites = new SatellitesComponent(this), 7);
+    const int solarSystem = m_StartupTasks->measure("Solar system", [this]()
+    {
+        addComponent(m_SolarSystem = new SolarSystemComposite(this), 2);
+    });
+    loadInBackground(solarSystem);
+
+    m_StartupTasks->measure("Stars", [this]()
+    {
+        addComponent(m_Stars = StarComponent::Create(this), 10);
+    });
     addComponent(m_EquatorialCoordinateGrid = new EquatorialCoordinateGrid(this));
     addComponent(m_HorizontalCoordinateGrid = new HorizontalCoordinateGrid(this));
     addComponent(m_LocalMeridianComponent = new LocalMeridianComponent(this));
 
     // Do add to components.
-    addComponent(m_CBoundLines = new ConstellationBoundaryLines(this), 80);
-    m_Cultures.reset(new CultureList());
-    addComponent(m_CLines = new ConstellationLines(this, m_Cultures.get()), 85);
-    addComponent(m_CNames = new ConstellationNamesComponent(this, m_Cultures.get()), 90);
+    m_StartupTasks->measure("Constellations", [this]()
+    {
+        addComponent(m_CBoundLines = new ConstellationBoundaryLines(this), 80);
+        m_Cultures.reset(new CultureList());
+        addComponent(m_CLines = new ConstellationLines(this, m_Cultures.get()), 85);
+        addComponent(m_CNames = new ConstellationNamesComponent(this, m_Cultures.get()), 90);
+    });
     addComponent(m_Equator = new Equator(this), 95);
     addComponent(m_Ecliptic = new Ecliptic(this), 95);
     addComponent(m_Horizon = new HorizonComponent(this), 100);
 
+    m_StartupTasks->measure("Deep-sky catalogs", [this]()
+    {
+        loadCatalogs();
+    });
+
+    m_StartupTasks->measure("Constellation art", [this]()
+    {
+        addComponent(
+            m_ConstellationArt = new ConstellationArtComponent(this, m_Cultures.get()), 100);
+    });
+
+    // Hips
+    addComponent(m_HiPS = new HIPSComponent(this));
+
+    addComponent(m_Terrain = new TerrainComponent(this));
+
+    // Mosaic Component
+#ifdef HAVE_INDI
+    addComponent(m_Mosaic = new MosaicComponent(this));
+#endif
+
+    addComponent(m_ArtificialHorizon = new ArtificialHorizonComponent(this), 110);
+
+    addComponent(m_Flags = new FlagComponent(this), 4);
+
+    addComponent(m_ObservingList = new TargetListComponent(this, nullptr, QPen(),
+            &Options::obsListSymbol,
+            &Options::obsListText),
+                 120);
+    addComponent(m_StarHopRouteList = new TargetListComponent(this, nullptr, QPen()),
+                 130);
+    addComponent(m_Supernovae = new SupernovaeComponent(this), 7);
+
+    // The sky map is shown without waiting for the components loading in the background,
+    // they are placed and drawn as they are loaded.
+    connect(m_StartupTasks.get(), &StartupTaskGraph::taskFinished, this, []()
+    {
+        if (SkyMap::Instance() == nullptr)
+            return;
+
+        KStarsData *data = KStarsData::Instance();
+        data->setFullTimeUpdate();
+        data->updateTime(data->geo());
+    });
+    m_StartupTasks->start();
+#endif
+    connect(this, SIGNAL(progressText(QString)), KStarsData::Instance(),
+            SIGNAL(progressText(QString)));
+}
+
+void SkyMapComposite::loadInBackground(int solarSystem)
+{
+    const QList<QPair<QString, QString>> contourFiles =
+    {
+        { "Milky Way", "milkyway.dat" },
+        { "Large Magellanic Cloud", "lmc.dat" },
+        { "Small Magellanic Cloud", "smc.dat" }
+    };
+    for (const auto &contourFile : contourFiles)
+    {
+        auto contours = std::make_shared<QList<std::shared_ptr<LineList>>>();
+        const QString fname = contourFile.second;
+        m_StartupTasks->addTask(contourFile.first, [contours, fname]()
+        {
+            *contours = MilkyWay::readContours(fname);
+        }, [this, contours]()
+        {
+            m_MilkyWay->appendContours(*contours);
+        });
+    }
+
+    // Asteroids and comets are created once the textures of the solar system are known
+    auto asteroids = std::make_shared<QList<KSAsteroid *>>();
+    m_StartupTasks->addTask("Asteroids", [this, asteroids]()
+    {
+        *asteroids = m_SolarSystem->asteroidsComponent()->readData();
+    }, [this, asteroids]()
+    {
+        m_SolarSystem->asteroidsComponent()->setData(*asteroids);
+    }, { solarSystem });
+
+    auto comets = std::make_shared<QList<KSComet *>>();
+    m_StartupTasks->addTask("Comets", [comets]()
+    {
+        *comets = CometsComponent::readData();
+    }, [this, comets]()
+    {
+        m_SolarSystem->cometsComponent()->setData(*comets);
+    }, { solarSystem });
+
+    auto satellites = std::make_shared<QList<SatelliteGroup *>>();
+    m_StartupTasks->addTask("Satellites", [satellites]()
+    {
+        *satellites = SatellitesComponent::readGroups();
+    }, [this, satellites]()
+    {
+        m_Satellites->setGroups(*satellites);
+    });
+}
+
+void SkyMapComposite::waitForLoading()
+{
+    m_StartupTasks->waitForAll();
+}
+
+bool SkyMapComposite::isLoading() const
+{
+    return !m_StartupTasks->isFinished();
+}
+
+#ifndef KSTARS_LITE
+void SkyMapComposite::loadCatalogs()
+{
     const auto &path = CatalogsDB::dso_db_path();
     try
     {
@@ -147,38 +296,8 @@ SkyMapComposite::SkyMapComposite(SkyComposite *parent)
             KStars::Instance()->close();
         }
     }
-
-    addComponent(
-        m_ConstellationArt = new ConstellationArtComponent(this, m_Cultures.get()), 100);
-
-    // Hips
-    addComponent(m_HiPS = new HIPSComponent(this));
-
-    addComponent(m_Terrain = new TerrainComponent(this));
-
-    // Mosaic Component
-#ifdef HAVE_INDI
-    addComponent(m_Mosaic = new MosaicComponent(this));
-#endif
-
-    addComponent(m_ArtificialHorizon = new ArtificialHorizonComponent(this), 110);
-
-    addComponent(m_SolarSystem = new SolarSystemComposite(this), 2);
-
-    addComponent(m_Flags = new FlagComponent(this), 4);
-
-    addComponent(m_ObservingList = new TargetListComponent(this, nullptr, QPen(),
-            &Options::obsListSymbol,
-            &Options::obsListText),
-                 120);
-    addComponent(m_StarHopRouteList = new TargetListComponent(this, nullptr, QPen()),
-                 130);
-    addComponent(m_Satellites = new SatellitesComponent(this), 7);
-    addComponent(m_Supernovae = new SupernovaeComponent(this), 7);
-#endif
-    connect(this, SIGNAL(progressText(QString)), KStarsData::Instance(),
-            SIGNAL(progressText(QString)));
 }
+#endif
 
 void SkyMapComposite::update(KSNumbers *num)
 {
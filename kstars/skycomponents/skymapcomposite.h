@@ -12,6 +12,7 @@
 #include "skylabeler.h"
 #include "skymesh.h"
 #include "skyobject.h"
+#include "startuptaskgraph.h"
 #include "config-kstars.h"
 #include <QList>
 
@@ -72,6 +73,17 @@ class SkyMapComposite : public QObject, public SkyComposite
 
         virtual ~SkyMapComposite() override = default;
 
+        /**
+         * @short Blocks until the components loading in the background are loaded.
+         *
+         * The sky map is shown before the Milky Way, asteroids, comets and satellites are loaded,
+         * they are added to the map from the event loop as they are read.
+         */
+        void waitForLoading();
+
+        /** @return true while components are loading in the background. */
+        bool isLoading() const;
+
         void update(KSNumbers *num = nullptr) override;
 
         /**
@@ -274,6 +286,16 @@ class SkyMapComposite : public QObject, public SkyComposite
         QHash<int, QStringList> &getObjectNames() override;
         QHash<int, QVector<QPair<QString, const SkyObject *>>> &getObjectLists() override;
 
+        /**
+         * @short Reads the data sets which need neither the SkyMesh nor a database on worker threads.
+         * @p solarSystem startup step creating the solar system, which asteroids and comets wait for.
+         */
+        void loadInBackground(int solarSystem);
+#ifndef KSTARS_LITE
+        /** @short Opens the DSO database, offering to start over with an empty one if it is broken. */
+        void loadCatalogs();
+#endif
+
         std::unique_ptr<CultureList> m_Cultures;
         ConstellationBoundaryLines *m_CBoundLines{ nullptr };
         ConstellationNamesComponent *m_CNames{ nullptr };
@@ -305,6 +327,8 @@ class SkyMapComposite : public QObject, public SkyComposite
 
         SkyMesh *m_skyMesh;
         std::unique_ptr<SkyLabeler> m_skyLabeler;
+        // Destroyed before the components, waiting for the workers reading their data
+        std::unique_ptr<StartupTaskGraph> m_StartupTasks;
 
         KSNumbers m_reindexNum;
 
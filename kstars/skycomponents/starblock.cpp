@@ -8,10 +8,30 @@
 
 #include "starblock.h"
 #include "skyobjects/starobject.h"
+#include "deepstarcomponent.h"
 #include "starcomponent.h"
 #include "skyobjects/stardata.h"
 #include "skyobjects/deepstardata.h"
 
+#ifndef KSTARS_LITE
+#include "kstarsdata.h"
+#include "ksnumbers.h"
+#include "Options.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+// Proper motions are neglected below 0.01 arcsec, see StarObject::getIndexCoords()
+constexpr double pmThreshold = 0.01 * (M_PI / (180.0 * 3600.0)) * (M_PI / (180.0 * 3600.0));
+
+// Update once per solar minute, as in StarObject::JITupdate()
+constexpr double recomputeInterval = 0.00069444;
+}
+#endif
+
 #ifdef KSTARS_LITE
 #include "skymaplite.h"
 #include "kstarslite/skyitems/skynodes/pointsourcenode.h"
@@ -31,7 +51,7 @@ StarNode::~StarNode()
 #endif
 
 StarBlock::StarBlock(int nstars)
-    : faintMag(-5), brightMag(35), parent(nullptr), prev(nullptr), next(nullptr), drawID(0), nStars(0),
+    : faintMag(-5), brightMag(35), parent(nullptr), prev(nullptr), next(nullptr), drawID(0), nStars(0), maxStars(nstars),
 #ifdef KSTARS_LITE
       stars(nstars, StarNode())
 #else
@@ -40,6 +60,51 @@ StarBlock::StarBlock(int nstars)
 {
 }
 
+#ifndef KSTARS_LITE
+StarBlock::StarBlock(int nstars, Layout layout)
+    : faintMag(-5), brightMag(35), parent(nullptr), prev(nullptr), next(nullptr), drawID(0), nStars(0), maxStars(nstars),
+      m_layout(layout)
+{
+    if (layout == OBJECT_LAYOUT)
+    {
+        stars = QVector<StarObject>(nstars, StarObject());
+        return;
+    }
+
+    x0.resize(nstars);
+    y0.resize(nstars);
+    z0.resize(nstars);
+    pmX.resize(nstars);
+    pmY.resize(nstars);
+    pmZ.resize(nstars);
+    mags.resize(nstars);
+    spTypes.resize(nstars);
+    x.resize(nstars);
+    y.resize(nstars);
+    z.resize(nstars);
+    alts.resize(nstars);
+    azs.resize(nstars);
+}
+
+StarBlock::Frame::Frame(const KSNumbers *num, const CachingDms *lst, const CachingDms *lat, UpdateID updateID,
+                        UpdateID updateNumID)
+    : num(num), lst(lst), lat(lat), updateID(updateID), updateNumID(updateNumID), jd(num->getJD()),
+      julianMillenia(num->julianMillenia())
+{
+    lst->SinCos(sinLST, cosLST);
+    lat->SinCos(sinLat, cosLat);
+
+    alwaysRecompute = Options::alwaysRecomputeCoordinates();
+    relativistic    = Options::useRelativistic();
+}
+
+StarBlock::Frame StarBlock::Frame::current()
+{
+    KStarsData *data = KStarsData::Instance();
+    return Frame(data->updateNum(), data->lst(), data->geo()->lat(), data->updateID(), data->updateNumID());
+}
+#endif
+
 void StarBlock::reset()
 {
     if (parent)
@@ -49,6 +114,16 @@ void StarBlock::reset()
     faintMag  = -5.0;
     brightMag = 35.0;
     nStars    = 0;
+
+#ifndef KSTARS_LITE
+    // Created StarObjects are kept: pointers to them may still be around, as with the object layout
+    recordSource    = nullptr;
+    equatorialCount = 0;
+    horizontalCount = 0;
+    lastPrecessJD   = J2000;
+    updateNumID     = 0;
+    updateID        = 0;
+#endif
 }
 
 #ifdef KSTARS_LITE
@@ -86,6 +161,17 @@ StarObject *StarBlock::addStar(const StarData &data)
 {
     if (isFull())
         return nullptr;
+    if (m_layout == COMPACT_LAYOUT)
+    {
+        if (!recordSource)
+        {
+            if (starRecords.isEmpty())
+                starRecords.resize(maxStars);
+            starRecords[nStars] = data;
+        }
+        deepRecords = false;
+        return addCompactStar(data);
+    }
     StarObject &star = stars[nStars++];
 
     star.init(&data);
@@ -100,6 +186,17 @@ StarObject *StarBlock::addStar(const DeepStarData &data)
 {
     if (isFull())
         return nullptr;
+    if (m_layout == COMPACT_LAYOUT)
+    {
+        if (!recordSource)
+        {
+            if (deepStarRecords.isEmpty())
+                deepStarRecords.resize(maxStars);
+            deepStarRecords[nStars] = data;
+        }
+        deepRecords = true;
+        return addCompactStar(data);
+    }
     StarObject &star = stars[nStars++];
 
     star.init(&data);
@@ -110,3 +207,337 @@ StarObject *StarBlock::addStar(const DeepStarData &data)
     return &star;
 }
 #endif
+
+int StarBlock::addStars(const StarData *data, int count, float maglim, const uchar *source, bool byteSwap)
+{
+#ifndef KSTARS_LITE
+    if (m_layout == COMPACT_LAYOUT && nStars == 0)
+    {
+        recordSource   = source;
+        recordByteSwap = byteSwap;
+    }
+#else
+    Q_UNUSED(source)
+    Q_UNUSED(byteSwap)
+#endif
+    int consumed = 0;
+    while (consumed < count && !isFull())
+    {
+        addStar(data[consumed++]);
+        if (faintMag > maglim)
+            break;
+    }
+    return consumed;
+}
+
+int StarBlock::addStars(const DeepStarData *data, int count, float maglim, const uchar *source, bool byteSwap)
+{
+#ifndef KSTARS_LITE
+    if (m_layout == COMPACT_LAYOUT && nStars == 0)
+    {
+        recordSource   = source;
+        recordByteSwap = byteSwap;
+    }
+#else
+    Q_UNUSED(source)
+    Q_UNUSED(byteSwap)
+#endif
+    int consumed = 0;
+    while (consumed < count && !isFull())
+    {
+        addStar(data[consumed++]);
+        if (faintMag > maglim)
+            break;
+    }
+    return consumed;
+}
+
+#ifndef KSTARS_LITE
+template <typename T>
+StarObject *StarBlock::addCompactStar(const T &data)
+{
+    // Decode the record the same way as the object layout does
+    static thread_local StarObject scratch;
+    scratch.init(&data);
+
+    const int i = nStars++;
+    initCompactStar(i, scratch);
+    if (scratch.mag() > faintMag)
+        faintMag = scratch.mag();
+    if (scratch.mag() < brightMag)
+        brightMag = scratch.mag();
+
+    // A StarObject created for the star that held this slot before the block was recycled
+    if (i < static_cast<int>(starObjects.size()) && starObjects[i])
+        return initStar(i);
+    return nullptr;
+}
+
+void StarBlock::initCompactStar(int i, const StarObject &star)
+{
+    double sinRa, cosRa, sinDec, cosDec;
+    star.ra0().SinCos(sinRa, cosRa);
+    star.dec0().SinCos(sinDec, cosDec);
+
+    x0[i] = x[i] = cosDec * cosRa;
+    y0[i] = y[i] = cosDec * sinRa;
+    z0[i] = z[i] = sinDec;
+
+    // Proper motion as a vector tangent to the sphere, see StarObject::getIndexCoords()
+    double pmRA = star.pmRA() * (M_PI / (180.0 * 3600.0)), pmDec = star.pmDec() * (M_PI / (180.0 * 3600.0));
+    if (std::isnan(pmRA) || std::isnan(pmDec))
+        pmRA = pmDec = 0.0;
+    pmX[i] = -pmRA * sinRa - pmDec * sinDec * cosRa;
+    pmY[i] = pmRA * cosRa - pmDec * sinDec * sinRa;
+    pmZ[i] = pmDec * cosDec;
+
+    mags[i]    = star.mag();
+    spTypes[i] = star.spchar();
+    alts[i] = azs[i] = 0.0;
+}
+
+StarObject *StarBlock::initStar(int i)
+{
+    StarObject *star = starObjects[i].get();
+    initFromRecord(i, *star);
+    return star;
+}
+
+void StarBlock::initFromRecord(int i, StarObject &star) const
+{
+    if (deepRecords)
+    {
+        if (!recordSource)
+        {
+            star.init(&deepStarRecords[i]);
+            return;
+        }
+        DeepStarData data;
+        memcpy(&data, recordSource + i * sizeof(DeepStarData), sizeof(DeepStarData));
+        if (recordByteSwap)
+            DeepStarComponent::byteSwap(&data);
+        star.init(&data);
+    }
+    else
+    {
+        if (!recordSource)
+        {
+            star.init(&starRecords[i]);
+            return;
+        }
+        StarData data;
+        memcpy(&data, recordSource + i * sizeof(StarData), sizeof(StarData));
+        if (recordByteSwap)
+            DeepStarComponent::byteSwap(&data);
+        star.init(&data);
+    }
+}
+
+void StarBlock::syncStar(int i)
+{
+    // Stars past horizontalCount keep their catalog coordinates, JITupdate() will take care of them
+    if (i >= horizontalCount)
+        return;
+
+    StarObject &star = *starObjects[i];
+    CachingDms ra, dec;
+    apparentRaDec(i, ra, dec);
+    star.setRA(ra);
+    star.setDec(dec);
+    star.setAlt(alts[i]);
+    star.setAz(azs[i]);
+    star.updateNumID = updateNumID;
+    star.updateID    = updateID;
+}
+
+void StarBlock::apparentRaDec(int i, CachingDms &ra, CachingDms &dec) const
+{
+    const double cosDec = std::sqrt(double(x[i]) * x[i] + double(y[i]) * y[i]);
+    ra.setUsing_atan2(y[i], x[i]);
+    ra.reduceToRange(dms::ZERO_TO_2PI);
+    // Unlike asin(z), stays accurate near the poles with single precision components
+    dec.setUsing_atan2(z[i], cosDec);
+}
+
+StarObject *StarBlock::star(int i)
+{
+    if (m_layout == OBJECT_LAYOUT)
+        return &stars[i];
+
+    if (starObjects.empty())
+        starObjects.resize(maxStars);
+    if (!starObjects[i])
+    {
+        starObjects[i].reset(new StarObject());
+        initStar(i);
+        syncStar(i);
+    }
+    return starObjects[i].get();
+}
+
+const SkyPoint *StarBlock::position(int i, SkyPoint &buffer)
+{
+    if (m_layout == OBJECT_LAYOUT)
+        return &stars[i];
+
+    CachingDms ra, dec;
+    apparentRaDec(i, ra, dec);
+    buffer.setRA(ra);
+    buffer.setDec(dec);
+    buffer.setAlt(alts[i]);
+    buffer.setAz(azs[i]);
+    return &buffer;
+}
+
+void StarBlock::updateCoords(const Frame &frame, float maglim)
+{
+    if (m_layout == OBJECT_LAYOUT)
+    {
+        // Same as StarObject::JITupdate(), with the catalog coordinates moved to the epoch in one batch
+        static thread_local QVector<StarObject *> stale;
+        stale.clear();
+        int count = 0;
+        while (count < nStars)
+        {
+            StarObject &star = stars[count++];
+            if (star.updateID != frame.updateID && star.updateNumID != frame.updateNumID)
+                stale.append(&star);
+            if (star.mag() > maglim)
+                break;
+        }
+        StarObject::updateCoordsBatch(stale.constData(), stale.size(), frame.num);
+
+        for (int i = 0; i < count; ++i)
+        {
+            StarObject &star = stars[i];
+            if (star.updateID == frame.updateID)
+                continue;
+            star.updateNumID = frame.updateNumID;
+            star.EquatorialToHorizontal(frame.lst, frame.lat);
+            star.updateID = frame.updateID;
+        }
+        return;
+    }
+
+    // Stars are sorted by magnitude
+    int count = 0;
+    while (count < nStars && mags[count] <= maglim)
+        ++count;
+
+    if (updateNumID != frame.updateNumID)
+    {
+        if (frame.alwaysRecompute || frame.relativistic || std::abs(lastPrecessJD - frame.jd) >= recomputeInterval)
+        {
+            equatorialCount = 0;
+            lastPrecessJD   = frame.jd;
+        }
+        updateNumID = frame.updateNumID;
+    }
+    if (updateID != frame.updateID)
+    {
+        horizontalCount = 0;
+        updateID        = frame.updateID;
+    }
+
+    if (equatorialCount < count)
+    {
+        updateEquatorial(frame, equatorialCount, count);
+        horizontalCount = std::min(horizontalCount, equatorialCount);
+        equatorialCount = count;
+    }
+    if (horizontalCount < count)
+    {
+        updateHorizontal(frame, horizontalCount, count);
+        horizontalCount = count;
+    }
+
+    const int created = std::min(count, static_cast<int>(starObjects.size()));
+    for (int i = 0; i < created; ++i)
+    {
+        if (starObjects[i])
+            syncStar(i);
+    }
+}
+
+void StarBlock::updateEquatorial(const Frame &frame, int begin, int end)
+{
+    if (frame.relativistic)
+    {
+        // The bending of light depends on the distance to the sun, leave it to StarObject
+        static thread_local StarObject scratch;
+        for (int i = begin; i < end; ++i)
+        {
+            initFromRecord(i, scratch);
+            scratch.updateCoords(frame.num);
+
+            double sinRa, cosRa, sinDec, cosDec;
+            scratch.ra().SinCos(sinRa, cosRa);
+            scratch.dec().SinCos(sinDec, cosDec);
+            x[i] = cosDec * cosRa;
+            y[i] = cosDec * sinRa;
+            z[i] = sinDec;
+        }
+        return;
+    }
+
+    const double t = frame.julianMillenia;
+    Eigen::Vector3d s;
+    for (int i = begin; i < end; ++i)
+    {
+        s[0] = x0[i];
+        s[1] = y0[i];
+        s[2] = z0[i];
+        const double pmSquared = double(pmX[i]) * pmX[i] + double(pmY[i]) * pmY[i] + double(pmZ[i]) * pmZ[i];
+        if (pmSquared * t * t >= pmThreshold)
+        {
+            s[0] += t * pmX[i];
+            s[1] += t * pmY[i];
+            s[2] += t * pmZ[i];
+        }
+
+        const Eigen::Vector3d v = frame.num->apparentDirection(s);
+        x[i] = v[0];
+        y[i] = v[1];
+        z[i] = v[2];
+    }
+}
+
+void StarBlock::updateHorizontal(const Frame &frame, int begin, int end)
+{
+    // Same as SkyPoint::EquatorialToHorizontal(), with the sines and cosines read from the direction
+    for (int i = begin; i < end; ++i)
+    {
+        const double sinDec = z[i];
+        const double cosDec = std::sqrt(double(x[i]) * x[i] + double(y[i]) * y[i]);
+        double sinRa = 0.0, cosRa = 1.0;
+        if (cosDec > 0.0)
+        {
+            sinRa = y[i] / cosDec;
+            cosRa = x[i] / cosDec;
+        }
+        const double sinHA = frame.sinLST * cosRa - frame.cosLST * sinRa;
+        const double cosHA = frame.cosLST * cosRa + frame.sinLST * sinRa;
+
+        const double sinAlt = sinDec * frame.sinLat + cosDec * frame.cosLat * cosHA;
+        const double altRad = std::asin(sinAlt);
+        double cosAlt       = std::sqrt(1 - sinAlt * sinAlt);
+        if (cosAlt == 0.)
+            cosAlt = std::cos(altRad);
+
+        const double arg = (sinDec - frame.sinLat * sinAlt) / (frame.cosLat * cosAlt);
+        double azRad;
+        if (arg <= -1.0)
+            azRad = dms::PI;
+        else if (arg >= 1.0)
+            azRad = 0.0;
+        else
+            azRad = std::acos(arg);
+
+        if (sinHA > 0.0 && azRad != 0.0)
+            azRad = 2.0 * dms::PI - azRad;
+
+        alts[i] = altRad / dms::DegToRad;
+        azs[i]  = azRad / dms::DegToRad;
+    }
+}
+#endif
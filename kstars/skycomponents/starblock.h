@@ -11,6 +11,18 @@
 
 #include <QVector>
 
+#include <memory>
+#include <vector>
+
+#ifndef KSTARS_LITE
+#include "skyobjects/deepstardata.h"
+#include "skyobjects/stardata.h"
+#include "skyobjects/starobject.h"
+#endif
+
+class CachingDms;
+class KSNumbers;
+class SkyPoint;
 class StarObject;
 class StarBlockList;
 class PointSourceNode;
@@ -35,6 +47,11 @@ struct StarNode
  *
  * Holds a block of stars and various peripheral variables to mark its place in data structures
  *
+ * Blocks of dynamically loaded stars use a compact layout: instead of full StarObjects, the block keeps
+ * float arrays of the J2000 direction, proper motion, magnitude and spectral type of its stars, which
+ * updateCoords() turns into apparent and horizontal coordinates for the whole block at once. A
+ * StarObject is only created for the star star() is called for, e.g. the star nearest to the cursor.
+ *
  * @author  Akarsh Simha
  * @version 1.0
  */
@@ -49,6 +66,45 @@ class StarBlock
     typedef StarObject StarBlockEntry;
 #endif
 
+#ifndef KSTARS_LITE
+    /** How the stars of a block are stored */
+    enum Layout
+    {
+        OBJECT_LAYOUT, /**< StarObjects, that may be referenced from outside of the block */
+        COMPACT_LAYOUT /**< Arrays of coordinates, StarObjects are created on demand */
+    };
+
+    /**
+     * @struct StarBlock::Frame
+     * @short Time and place the coordinates of the stars are computed for, gathered once per draw
+     */
+    struct Frame
+    {
+        /**
+         * @param num      Time dependent numbers to precess, nutate and aberrate stars with
+         * @param lst      Local sidereal time
+         * @param lat      Latitude of the observer
+         * @param updateID    ID of the current update of the horizontal coordinates
+         * @param updateNumID ID of the current update of num
+         */
+        Frame(const KSNumbers *num, const CachingDms *lst, const CachingDms *lat, UpdateID updateID, UpdateID updateNumID);
+
+        /** @return the frame of the current KStarsData update */
+        static Frame current();
+
+        const KSNumbers *num;
+        const CachingDms *lst;
+        const CachingDms *lat;
+        UpdateID updateID;
+        UpdateID updateNumID;
+        long double jd;
+        double julianMillenia;
+        double sinLST, cosLST, sinLat, cosLat;
+        bool alwaysRecompute;
+        bool relativistic;
+    };
+#endif
+
     /**
      * Constructor
      *
@@ -58,6 +114,16 @@ class StarBlock
      */
     explicit StarBlock(int nstars = 100);
 
+#ifndef KSTARS_LITE
+    /**
+     * Constructor
+     *
+     * @param nstars   Number of stars to hold in this StarBlock
+     * @param layout   How to store the stars
+     */
+    StarBlock(int nstars, Layout layout);
+#endif
+
     ~StarBlock() = default;
 
     /**
@@ -68,11 +134,37 @@ class StarBlock
      * have names.
      *
      * @param  data    data to initialize star with.
-     * @return pointer to star initialized with data. nullptr if block is full.
+     * @return pointer to star initialized with data. nullptr if block is full, or if the block
+     * is compact and star() has not been called on it yet.
      */
     StarBlockEntry *addStar(const StarData &data);
     StarBlockEntry *addStar(const DeepStarData &data);
 
+    /**
+     * @short Initialize stars from a contiguous span of records sorted by magnitude.
+     *
+     * Stops when the block is full, or right after adding a star fainter than maglim,
+     * as adding the records one by one with addStar() would.
+     *
+     * When @p data is a copy of records of a catalog mapped in memory, a compact block reads the records
+     * back from @p source to create its StarObjects instead of keeping a copy of them.
+     *
+     * @param  data    first record of the span.
+     * @param  count   number of records in the span.
+     * @param  maglim  magnitude limit to load stars to.
+     * @param  source  the same records in the mapped catalog, nullptr if there is none.
+     * @param  byteSwap whether the bytes of the records in @p source need to be swapped.
+     * @return number of records consumed from the span.
+     */
+    int addStars(const StarData *data, int count, float maglim, const uchar *source = nullptr, bool byteSwap = false);
+    int addStars(const DeepStarData *data, int count, float maglim, const uchar *source = nullptr,
+                 bool byteSwap = false);
+
+    /**
+     * @return Number of stars that can still be added to this block
+     */
+    inline int getFreeCount() const { return size() - nStars; }
+
     /**
      * @short Returns true if the StarBlock is full
      *
@@ -89,8 +181,9 @@ class StarBlock
      *
      * @return The number of stars that this StarBlock can hold
      */
-    inline int size() const { return stars.size(); }
+    inline int size() const { return maxStars; }
 
+#ifdef KSTARS_LITE
     /**
      * @short  Return the i-th star in this StarBlock
      *
@@ -98,11 +191,53 @@ class StarBlock
      * @return A pointer to the i-th StarObject
      */
     inline StarBlockEntry *star(int i) { return &stars[i]; }
+#else
+    /**
+     * @short  Return the i-th star in this StarBlock
+     *
+     * Creates the StarObject of a star of a compact block on first use. It is kept up to date by
+     * updateCoords() until the block is recycled.
+     *
+     * @param  i Index of StarBlock to return
+     * @return A pointer to the i-th StarObject
+     */
+    StarBlockEntry *star(int i);
+
+    inline Layout layout() const { return m_layout; }
+
+    /** @return the magnitude of the i-th star */
+    inline float mag(int i) const { return m_layout == COMPACT_LAYOUT ? mags[i] : stars[i].mag(); }
+
+    /** @return the first letter of the spectral type of the i-th star */
+    inline char spchar(int i) const { return m_layout == COMPACT_LAYOUT ? spTypes[i] : stars[i].spchar(); }
+
+    /**
+     * @short  Return the position of the i-th star, as of the last call to updateCoords()
+     *
+     * @param  i Index of the star
+     * @param  buffer SkyPoint to fill with the coordinates of a compact star
+     * @return the star itself, or buffer for compact blocks
+     */
+    const SkyPoint *position(int i, SkyPoint &buffer);
+
+    /**
+     * @short  Update the apparent and horizontal coordinates of the stars up to the given magnitude
+     *
+     * Compact blocks apply proper motion, precession, nutation, aberration and the conversion to
+     * horizontal coordinates to all their stars in one loop, skipping the work when the frame did not
+     * change since the last call. Other blocks update each StarObject.
+     *
+     * @param  frame  Time and place to compute the coordinates for
+     * @param  maglim Magnitude limit of the stars to update
+     */
+    void updateCoords(const Frame &frame, float maglim);
+#endif
 
     /**
      * @return a reference to the internal container of this
      * @note This is bad -- is there a way of providing non-const access to the list's elements
      * without allowing altering of the list alone?
+     * @note Compact blocks leave it empty, use star() instead.
      */
 
     inline QVector<StarBlockEntry> &contents() { return stars; }
@@ -146,6 +281,53 @@ class StarBlock
 
     /** Number of initialized stars in StarBlock. */
     int nStars { 0 };
+    /** Number of stars the block can hold. */
+    int maxStars { 0 };
     /** Array of stars. */
     QVector<StarBlockEntry> stars;
+
+#ifndef KSTARS_LITE
+    template <typename T>
+    StarObject *addCompactStar(const T &data);
+    void initCompactStar(int i, const StarObject &star);
+    StarObject *initStar(int i);
+    void initFromRecord(int i, StarObject &star) const;
+    void syncStar(int i);
+    void apparentRaDec(int i, CachingDms &ra, CachingDms &dec) const;
+    void updateEquatorial(const Frame &frame, int begin, int end);
+    void updateHorizontal(const Frame &frame, int begin, int end);
+
+    Layout m_layout { OBJECT_LAYOUT };
+
+    // Compact layout, one entry per star
+    /**
+     * Catalog records, to create StarObjects from. Only one of them is used, depending on the catalog,
+     * and neither when the records are read back from the mapped catalog.
+     */
+    QVector<StarData> starRecords;
+    QVector<DeepStarData> deepStarRecords;
+    bool deepRecords { false };
+    /** First record of the block in the mapped catalog, the records of a block are consecutive */
+    const uchar *recordSource { nullptr };
+    bool recordByteSwap { false };
+    /** J2000 direction. Single precision is good to about 0.01 arcsec on a unit vector. */
+    QVector<float> x0, y0, z0;
+    /** Proper motion, in radians per millennium */
+    QVector<float> pmX, pmY, pmZ;
+    QVector<float> mags;
+    QVector<char> spTypes;
+    /** Apparent direction */
+    QVector<float> x, y, z;
+    /** Horizontal coordinates, in degrees */
+    QVector<float> alts, azs;
+    /** StarObjects created by star(), null for the stars it was not called for */
+    std::vector<std::unique_ptr<StarObject>> starObjects;
+
+    /** Stars whose apparent and horizontal coordinates are up to date */
+    int equatorialCount { 0 };
+    int horizontalCount { 0 };
+    long double lastPrecessJD { J2000 };
+    UpdateID updateNumID { 0 };
+    UpdateID updateID { 0 };
+#endif
 };
@@ -7,6 +7,7 @@
 #include "starblockfactory.h"
 
 #include "starblock.h"
+#include "starblocklist.h"
 #include "starobject.h"
 
 #include <kstars_debug.h>
@@ -16,6 +17,19 @@
 
 StarBlockFactory *StarBlockFactory::pInstance = nullptr;
 
+namespace
+{
+// Blocks of dynamically loaded stars are mostly drawn, their StarObjects are created on demand
+StarBlock *newBlock()
+{
+#ifdef KSTARS_LITE
+    return new StarBlock;
+#else
+    return new StarBlock(100, StarBlock::COMPACT_LAYOUT);
+#endif
+}
+}
+
 StarBlockFactory *StarBlockFactory::Instance()
 {
     if (!pInstance)
@@ -45,17 +59,19 @@ std::shared_ptr<StarBlock> StarBlockFactory::getBlock()
 
     if (nBlocks < nCache)
     {
-        freeBlock.reset(new StarBlock);
+        freeBlock.reset(newBlock());
         if (freeBlock.get())
         {
             ++nBlocks;
             return freeBlock;
         }
     }
-    if (last && (last->drawID != drawID || last->drawID == 0))
+    // The list of the block may be in use by another thread, in which case a new block is allocated
+    StarBlockList *lastParent = last ? last->parent : nullptr;
+    if (last && (last->drawID != drawID || last->drawID == 0) && (!lastParent || lastParent->mutex()->tryLock()))
     {
         //        qCDebug(KSTARS) << "Recycling block with drawID =" << last->drawID << "and current drawID =" << drawID;
-        if (last->parent->block(last->parent->getBlockCount() - 1) != last)
+        if (lastParent && lastParent->block(lastParent->getBlockCount() - 1) != last)
             qCDebug(KSTARS) << "ERROR: Goof up here!";
         freeBlock = last;
         last      = last->prev;
@@ -68,11 +84,13 @@ std::shared_ptr<StarBlock> StarBlockFactory::getBlock()
             first = nullptr;
         }
         freeBlock->reset();
+        if (lastParent)
+            lastParent->mutex()->unlock();
         freeBlock->prev = nullptr;
         freeBlock->next = nullptr;
         return freeBlock;
     }
-    freeBlock.reset(new StarBlock);
+    freeBlock.reset(newBlock());
     if (freeBlock.get())
         ++nBlocks;
 
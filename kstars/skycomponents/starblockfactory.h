@@ -8,6 +8,8 @@
 
 #include "typedef.h"
 
+#include <QMutex>
+
 class StarBlock;
 
 /**
@@ -83,6 +85,14 @@ class StarBlockFactory
      */
     void printStructure() const;
 
+    /**
+     * @short  Mutex guarding the LRU cache and the drawID
+     *
+     * Hold it while getting, marking or freeing blocks. The stars of a block are guarded by the
+     * mutex of its StarBlockList.
+     */
+    inline QMutex *mutex() { return &blockMutex; }
+
     quint32 drawID; // A number identifying the current draw cycle
 
   private:
@@ -103,6 +113,7 @@ class StarBlockFactory
     std::shared_ptr<StarBlock> first, last; // Pointers to the beginning and end of the linked list
     int nBlocks;             // Number of blocks we currently have in the cache
     int nCache;              // Number of blocks to start recycling cached blocks at
+    QMutex blockMutex;
 
     static StarBlockFactory *pInstance;
 };
@@ -17,6 +17,11 @@
 #endif
 
 #include <QDebug>
+#include <QMutexLocker>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <cstring>
 
 StarBlockList::StarBlockList(const Trixel &tr, DeepStarComponent *parent)
 {
@@ -92,7 +97,13 @@ bool StarBlockList::fillToMag(float maglim)
 
     Q_ASSERT(nBlocks == (unsigned int)blocks.size());
 
-    BinFileHelper::unsigned_KDE_fseek(dataFile, readOffset, SEEK_SET);
+    // When the catalog is mapped in memory, records are handed to the blocks in spans instead of being
+    // read one by one from the file.
+    const uchar *mappedData = dSReader->getMappedData();
+    // Without a mapping, the lists of the catalog share the file position
+    QMutexLocker readLocker(mappedData ? nullptr : parent->readMutex());
+    if (!mappedData)
+        BinFileHelper::unsigned_KDE_fseek(dataFile, readOffset, SEEK_SET);
 
     /*
     qDebug() << Q_FUNC_INFO << "Reading trixel" << trixel << ", id on disk =" << trixelId << ", currently nStars =" << nStars
@@ -106,6 +117,7 @@ bool StarBlockList::fillToMag(float maglim)
 
         if (nBlocks == 0 || blocks[nBlocks - 1]->isFull())
         {
+            QMutexLocker locker(SBFactory->mutex());
             std::shared_ptr<StarBlock> newBlock = SBFactory->getBlock();
 
             if (!newBlock.get())
@@ -123,6 +135,45 @@ bool StarBlockList::fillToMag(float maglim)
 
             ++nBlocks;
         }
+        if (mappedData)
+        {
+            std::shared_ptr<StarBlock> &block = blocks[nBlocks - 1];
+            const int count = std::min<unsigned long>(block->getFreeCount(),
+                              dSReader->getRecordCount(trixelId) - nStars);
+            const int recordSize = dSReader->guessRecordSize() == 32 ? sizeof(StarData) : sizeof(DeepStarData);
+            if (readOffset + count * recordSize > dSReader->getMappedSize())
+            {
+                qWarning() << "ERROR: Star records of trixel" << trixel << "lie beyond the end of the data file";
+                return false;
+            }
+
+            // Records are not aligned in the file, copy them out in one go
+            int consumed = 0;
+            if (dSReader->guessRecordSize() == 32)
+            {
+                QVarLengthArray<StarData, 128> records(count);
+                memcpy(records.data(), mappedData + readOffset, count * sizeof(StarData));
+                if (dSReader->getByteSwap())
+                    DeepStarComponent::byteSwap(records.data(), count);
+                consumed = block->addStars(records.data(), count, maglim, mappedData + readOffset,
+                                           dSReader->getByteSwap());
+            }
+            else
+            {
+                QVarLengthArray<DeepStarData, 128> records(count);
+                memcpy(records.data(), mappedData + readOffset, count * sizeof(DeepStarData));
+                if (dSReader->getByteSwap())
+                    DeepStarComponent::byteSwap(records.data(), count);
+                consumed = block->addStars(records.data(), count, maglim, mappedData + readOffset,
+                                           dSReader->getByteSwap());
+            }
+
+            readOffset += consumed * recordSize;
+            faintMag = block->getFaintMag();
+            nStars += consumed;
+            continue;
+        }
+
         // TODO: Make this more general
         if (dSReader->guessRecordSize() == 32)
         {
@@ -154,6 +205,11 @@ bool StarBlockList::fillToMag(float maglim)
     return ((maglim < faintMag) ? true : false);
 }
 
+bool StarBlockList::isFilledToMag(float maglim) const
+{
+    return staticStars || maglim < faintMag || nStars >= parent->getStarReader()->getRecordCount(trixel);
+}
+
 void StarBlockList::setStaticBlock(std::shared_ptr<StarBlock> &block)
 {
     if (!block)
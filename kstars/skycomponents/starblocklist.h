@@ -8,6 +8,8 @@
 
 #include "typedef.h"
 
+#include <QMutex>
+
 class DeepStarComponent;
 class StarBlock;
 
@@ -32,11 +34,21 @@ class StarBlockList
     /**
      * @short Ensures that the list is loaded with stars to given magnitude limit
      *
+     * The caller holds mutex(). The StarBlockFactory mutex is only taken to get and mark new blocks.
+     *
      * @param maglim Magnitude limit to load stars upto
      * @return true on success, false on failure (data file not found, bad seek etc)
      */
     bool fillToMag(float maglim);
 
+    /**
+     * @short Checks whether fillToMag() has anything left to load for the given magnitude limit
+     *
+     * @param maglim Magnitude limit to check
+     * @return true if the list holds all the stars of its trixel up to maglim
+     */
+    bool isFilledToMag(float maglim) const;
+
     /**
      * @short Sets the first StarBlock in the list to point to the given StarBlock
      *
@@ -92,6 +104,14 @@ class StarBlockList
      */
     inline Trixel getTrixel() const { return trixel; }
 
+    /**
+     * @short  Mutex guarding the blocks of this list and their stars
+     *
+     * Hold it while filling the list or reading its stars. StarBlockFactory only recycles the blocks
+     * of a list whose mutex is free.
+     */
+    inline QMutex *mutex() { return &m_mutex; }
+
   private:
     Trixel trixel;
     unsigned long nStars { 0 };
@@ -101,4 +121,5 @@ class StarBlockList
     unsigned int nBlocks { 0 };
     bool staticStars { false };
     DeepStarComponent *parent { nullptr };
+    QMutex m_mutex;
 };
@@ -0,0 +1,118 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "starblockprefetcher.h"
+
+#include "starblocklist.h"
+
+#include <QMutexLocker>
+#include <QtConcurrent>
+
+#include <cmath>
+
+StarBlockPrefetcher::StarBlockPrefetcher()
+{
+    // Trixels are read one after the other, there is no point in several threads competing for the disk
+    m_worker.setMaxThreadCount(1);
+}
+
+StarBlockPrefetcher::~StarBlockPrefetcher()
+{
+    cancel();
+}
+
+void StarBlockPrefetcher::updateViewport(const SkyPoint &focus, double zoomFactor)
+{
+    if (m_lastZoomFactor <= 0)
+    {
+        m_lastFocus           = focus;
+        m_lastZoomFactor      = zoomFactor;
+        m_predictedFocus      = focus;
+        m_predictedZoomFactor = zoomFactor;
+        return;
+    }
+
+    // Shortest way in RA, the focus may have crossed 0h
+    double dRA = focus.ra().Degrees() - m_lastFocus.ra().Degrees();
+    if (dRA > 180.0)
+        dRA -= 360.0;
+    else if (dRA < -180.0)
+        dRA += 360.0;
+    const double dDec = focus.dec().Degrees() - m_lastFocus.dec().Degrees();
+
+    const double dec = qBound(-90.0, focus.dec().Degrees() + lookAhead * dDec, 90.0);
+    m_predictedFocus = SkyPoint(dms(focus.ra().Degrees() + lookAhead * dRA).reduce(), dms(dec));
+
+    // Zoom goes by steps of a constant ratio, extrapolate it geometrically. Jumps, like centering on
+    // an object, are not a trend and are capped.
+    const double zoomRatio = qBound(0.5, zoomFactor / m_lastZoomFactor, 2.0);
+    m_predictedZoomFactor  = zoomFactor * std::pow(zoomRatio, lookAhead);
+
+    m_lastFocus      = focus;
+    m_lastZoomFactor = zoomFactor;
+}
+
+void StarBlockPrefetcher::request(const QVector<Task> &tasks, const std::function<void()> &onLoaded)
+{
+    QMutexLocker locker(&m_requestMutex);
+
+    m_tasks    = tasks;
+    m_onLoaded = onLoaded;
+
+    if (!m_running && !m_tasks.isEmpty())
+    {
+        m_running = true;
+        QtConcurrent::run(&m_worker, [this]()
+        {
+            run();
+        });
+    }
+}
+
+void StarBlockPrefetcher::cancel()
+{
+    {
+        QMutexLocker locker(&m_requestMutex);
+        m_tasks.clear();
+        m_onLoaded = std::function<void()>();
+    }
+    m_worker.waitForDone();
+}
+
+bool StarBlockPrefetcher::isBusy() const
+{
+    QMutexLocker locker(&m_requestMutex);
+    return m_running;
+}
+
+void StarBlockPrefetcher::run()
+{
+    forever
+    {
+        Task task;
+        std::function<void()> onLoaded;
+        {
+            QMutexLocker locker(&m_requestMutex);
+            if (m_tasks.isEmpty())
+            {
+                m_running = false;
+                return;
+            }
+            task = m_tasks.takeFirst();
+            // Notify once the last list of the request is filled
+            if (m_tasks.isEmpty())
+                std::swap(onLoaded, m_onLoaded);
+        }
+
+        {
+            QMutexLocker locker(task.first->mutex());
+            task.first->fillToMag(task.second);
+        }
+
+        if (onLoaded)
+            onLoaded();
+    }
+}
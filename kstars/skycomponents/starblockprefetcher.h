@@ -0,0 +1,89 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "skypoint.h"
+
+#include <QMutex>
+#include <QPair>
+#include <QThreadPool>
+#include <QVector>
+
+#include <functional>
+#include <memory>
+
+class StarBlockList;
+
+/**
+ * @class StarBlockPrefetcher
+ * Fills the StarBlockLists of a DeepStarComponent on a background thread.
+ *
+ * Every draw reports the focus and zoom factor of the sky map, which the prefetcher extrapolates
+ * to guess where the map is heading. DeepStarComponent then requests the trixels around the
+ * predicted focus to be filled to the magnitude limit of the predicted zoom, along with the
+ * visible trixels it chose not to load during the draw.
+ *
+ * Only the latest request is kept: a new request replaces whatever is left of the previous one,
+ * the worker finishing the trixel it is busy with first. Star blocks are shared with the draw
+ * path, the worker holds the mutex of the StarBlockList it fills.
+ */
+class StarBlockPrefetcher
+{
+  public:
+    /** A list to fill and the magnitude limit to fill it to */
+    typedef QPair<std::shared_ptr<StarBlockList>, float> Task;
+
+    StarBlockPrefetcher();
+
+    /** Cancels the pending request and waits for the trixel being filled */
+    ~StarBlockPrefetcher();
+
+    /**
+     * @short Records the focus and zoom factor of the current draw and extrapolates the next ones
+     *
+     * @param focus Focus of the sky map
+     * @param zoomFactor Zoom factor of the sky map
+     */
+    void updateViewport(const SkyPoint &focus, double zoomFactor);
+
+    /** @return the focus the sky map is expected to reach in a few draws */
+    inline const SkyPoint &predictedFocus() const { return m_predictedFocus; }
+
+    /** @return the zoom factor the sky map is expected to reach in a few draws */
+    inline double predictedZoomFactor() const { return m_predictedZoomFactor; }
+
+    /**
+     * @short Replaces the pending request
+     *
+     * @param tasks Lists to fill, most urgent first
+     * @param onLoaded If set, called from the worker thread once all the tasks are done
+     */
+    void request(const QVector<Task> &tasks, const std::function<void()> &onLoaded = std::function<void()>());
+
+    /** @short Drops the pending request and waits for the trixel being filled */
+    void cancel();
+
+    /** @return true if a request is being processed */
+    bool isBusy() const;
+
+  private:
+    void run();
+
+    // Number of draws to extrapolate the motion of the sky map over
+    static constexpr int lookAhead { 3 };
+
+    SkyPoint m_lastFocus;
+    double m_lastZoomFactor { 0 };
+    SkyPoint m_predictedFocus;
+    double m_predictedZoomFactor { 0 };
+
+    QThreadPool m_worker;
+    mutable QMutex m_requestMutex;
+    QVector<Task> m_tasks;
+    std::function<void()> m_onLoaded;
+    bool m_running { false };
+};
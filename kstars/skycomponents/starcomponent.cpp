@@ -27,6 +27,7 @@
 #include "kstars_debug.h"
 
 #include <qplatformdefs.h>
+#include <QMutexLocker>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -216,10 +217,15 @@ float StarComponent::faintMagnitude() const
 }
 
 float StarComponent::zoomMagnitudeLimit()
+{
+    return zoomMagnitudeLimit(Options::zoomFactor());
+}
+
+float StarComponent::zoomMagnitudeLimit(double zoomFactor)
 {
     //adjust maglimit for ZoomLevel
     double lgmin = log10(MINZOOM);
-    double lgz   = log10(Options::zoomFactor());
+    double lgz   = log10(zoomFactor);
 
     // Old formula:
     //    float maglim = ( 2.000 + 2.444 * Options::memUsage() / 10.0 ) * ( lgz - lgmin ) + Options::magLimitDrawStarZoomOut();
@@ -304,7 +310,10 @@ void StarComponent::draw(SkyPainter *skyp)
     if (hideFaintStars && maglim > hideStarsMag)
         maglim = hideStarsMag;
 
-    m_StarBlockFactory->drawID = m_skyMesh->drawID();
+    {
+        QMutexLocker locker(m_StarBlockFactory->mutex());
+        m_StarBlockFactory->drawID = m_skyMesh->drawID();
+    }
 
     int nTrixels = 0;
 
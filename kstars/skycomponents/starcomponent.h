@@ -78,6 +78,12 @@ class StarComponent : public ListComponent
 
     static float zoomMagnitudeLimit();
 
+    /** @return the magnitude limit stars are drawn to at the given zoom factor */
+    static float zoomMagnitudeLimit(double zoomFactor);
+
+    /** @return the components of the dynamically loaded deep star catalogs */
+    const QVector<DeepStarComponent *> &deepStarComponents() const { return m_DeepStarComponents; }
+
     SkyObject *objectNearest(SkyPoint *p, double &maxrad) override;
 
     virtual SkyObject *findStarByGenetiveName(const QString name);
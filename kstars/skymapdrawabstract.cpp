@@ -30,6 +30,9 @@
 #include "skycomponents/constellationboundarylines.h"
 #include "skycomponents/skylabeler.h"
 #include "skycomponents/skymapcomposite.h"
+#include "skycomponents/starcomponent.h"
+#include "skycomponents/deepstarcomponent.h"
+#include "skycomponents/catalogscomponent.h"
 #include "skyqpainter.h"
 #include "projections/projector.h"
 #include "projections/lambertprojector.h"
@@ -85,6 +88,9 @@ void SkyMapDrawAbstract::drawOverlays(QPainter &p, bool drawFov)
 
     drawZoomBox(p);
 
+    if (Options::showStarLoadStatistics())
+        drawStarLoadStatistics(p);
+
     // FIXME: Maybe we should take care of this differently. Maybe
     // drawOverlays should remain in SkyMap, since it just calls
     // certain drawing functions which are implemented in
@@ -119,6 +125,49 @@ void SkyMapDrawAbstract::drawZoomBox(QPainter &p)
     }
 }
 
+void SkyMapDrawAbstract::drawStarLoadStatistics(QPainter &p)
+{
+    StarComponent *stars = StarComponent::Instance();
+    if (stars == nullptr)
+        return;
+
+    QStringList lines;
+    for (const DeepStarComponent *component : stars->deepStarComponents())
+    {
+        const DeepStarComponent::DrawStatistics &stats = component->drawStatistics();
+        lines << QString("%1: load %2 us (%3 stars, %4 trixels, %5 deferred), cache %6 us, draw %7 us (%8 visible)")
+              .arg(component->fileName())
+              .arg(stats.dynamicLoadTime)
+              .arg(stats.recordsLoaded)
+              .arg(stats.trixels)
+              .arg(stats.deferredTrixels)
+              .arg(stats.updateCacheTime)
+              .arg(stats.drawTime)
+              .arg(stats.visibleStars);
+    }
+
+    const CatalogsComponent *catalogs = m_KStarsData->skyComposite()->catalogsComponent();
+    if (catalogs != nullptr)
+    {
+        const CatalogsComponent::CacheStatistics &stats = catalogs->cacheStatistics();
+        lines << QString("DSOs (%1): %2 hits, %3 misses, %4 us per miss (max %5 us), %6 objects loaded")
+              .arg(stats.snapshot ? "snapshot" : "database")
+              .arg(stats.hits)
+              .arg(stats.misses)
+              .arg(stats.misses > 0 ? stats.missTime / stats.misses : 0)
+              .arg(stats.maxMissTime)
+              .arg(stats.objectsLoaded);
+    }
+
+    if (lines.isEmpty())
+        return;
+
+    p.setPen(m_KStarsData->colorScheme()->colorNamed("UserLabelColor"));
+    const int lineHeight = p.fontMetrics().height();
+    for (int i = 0; i < lines.size(); ++i)
+        p.drawText(QPointF(10, (i + 1) * lineHeight + 5), lines[i]);
+}
+
 void SkyMapDrawAbstract::drawObjectLabels(QList<SkyObject *> &labelObjects)
 {
     bool checkSlewing =
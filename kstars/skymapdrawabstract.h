@@ -80,6 +80,12 @@ class SkyMapDrawAbstract
         	*/
     void drawAngleRuler(QPainter &psky);
 
+    /**Print the loading and drawing figures of each deep star catalog, and the cache figures of the
+            *DSO catalogs, in the top left corner when the ShowStarLoadStatistics option is set.
+            *@param psky reference to the QPainter on which to draw (this should be the Sky pixmap).
+            */
+    void drawStarLoadStatistics(QPainter &psky);
+
     /** @short Draw the current Sky map to a pixmap which is to be printed or exported to a file.
         	*
         	*@param pd pointer to the QPaintDevice on which to draw.
@@ -92,6 +92,29 @@ void CatalogObject::JITupdate()
     }
 }
 
+void CatalogObject::JITupdate(const std::vector<CatalogObject *> &objects)
+{
+    KStarsData *data{ KStarsData::Instance() };
+
+    std::vector<SkyPoint *> outdated;
+    for (CatalogObject *object : objects)
+    {
+        if (object->m_updateID != data->updateID() && object->m_updateNumID != data->updateNumID())
+            outdated.push_back(object);
+    }
+    SkyPoint::updateCoordsBatch(outdated.data(), static_cast<int>(outdated.size()), data->updateNum());
+
+    for (CatalogObject *object : objects)
+    {
+        if (object->m_updateID == data->updateID())
+            continue;
+
+        object->m_updateID    = data->updateID();
+        object->m_updateNumID = data->updateNumID();
+        object->EquatorialToHorizontal(data->lst(), data->geo()->lat());
+    }
+}
+
 void CatalogObject::initPopupMenu(KSPopupMenu *pmenu)
 {
 #ifndef KSTARS_LITE
@@ -16,6 +16,7 @@
 #include <QImage>
 #include <array>
 #include <utility>
+#include <vector>
 
 class KSPopupMenu;
 class KStarsData;
@@ -151,6 +152,12 @@ class CatalogObject : public SkyObject
      */
     void JITupdate();
 
+    /**
+     * Same as calling JITupdate() on each object, with the coordinates
+     * of the objects updated in one batch.
+     */
+    static void JITupdate(const std::vector<CatalogObject *> &objects);
+
     /**
      * Initialize the popup menu for a `CatalogObject`.
      */
@@ -6,11 +6,13 @@
 
 #include "satellite.h"
 
+#include "geolocation.h"
 #include "ksplanetbase.h"
 #ifndef KSTARS_LITE
 #include "kspopupmenu.h"
 #endif
 #include "kstarsdata.h"
+#include "kstarsdatetime.h"
 #include "kssun.h"
 #include "Options.h"
 #include "skymapcomposite.h"
@@ -703,16 +705,114 @@ void Satellite::init()
     }
 }
 
-int Satellite::updatePos()
+Satellite::Observer Satellite::observer()
 {
     KStarsData *data = KStarsData::Instance();
-    return sgp4((data->clock()->utc().djd() - m_tle_jd) * MINPD);
+    KSSun *sun = dynamic_cast<KSSun *>(data->skyComposite()->findByName(i18n("Sun")));
+
+    return observer(data->clock()->utc().djd(), data->geo(), *data->lst(), sun->alt().Degrees());
 }
 
-int Satellite::sgp4(double tsince)
+Satellite::Observer Satellite::observer(long double jd, GeoLocation *geo, const dms &lst, double sunAltitude)
 {
-    KStarsData *data = KStarsData::Instance();
+    Observer observer;
+    double jul_utc = jd;
+
+    observer.jd          = jd;
+    observer.lst         = lst;
+    observer.lat         = *geo->lat();
+    observer.sunAltitude = sunAltitude;
+
+    // Observer ECI position
+    double thetageo, c, sq, achcp;
+
+    observer.sinlat   = sin(geo->lat()->radians());
+    observer.coslat   = cos(geo->lat()->radians());
+    thetageo          = geo->LMST(jul_utc);
+    observer.sintheta = sin(thetageo);
+    observer.costheta = cos(thetageo);
+    c                 = 1.0 / sqrt(1.0 + F * (F - 2.0) * observer.sinlat * observer.sinlat);
+    sq                = (1.0 - F) * (1.0 - F) * c;
+    achcp             = (RADIUSEARTHKM * c + MEANALT) * observer.coslat;
+    observer.posx     = achcp * observer.costheta;
+    observer.posy     = achcp * observer.sintheta;
+    observer.posz     = (RADIUSEARTHKM * sq + MEANALT) * observer.sinlat;
+
+    // Find ECI coordinates of the sun
+    double mjd, year, T, M, L, e, C, O, Lsa, nu, R, eps;
+
+    mjd  = jul_utc - 2415020.0;
+    year = 1900.0 + mjd / 365.25;
+    T    = (mjd + deltaET(year) / (MINPD * 60.0)) / 36525.0;
+    M    = DEG2RAD * (Modulus(358.47583 + Modulus(35999.04975 * T, 360.0) - (0.000150 + 0.0000033 * T) * T * T, 360.0));
+    L    = DEG2RAD * (Modulus(279.69668 + Modulus(36000.76892 * T, 360.0) + 0.0003025 * T * T, 360.0));
+    e    = 0.01675104 - (0.0000418 + 0.000000126 * T) * T;
+    C    = DEG2RAD * ((1.919460 - (0.004789 + 0.000014 * T) * T) * sin(M) + (0.020094 - 0.000100 * T) * sin(2 * M) +
+                      0.000293 * sin(3 * M));
+    O    = DEG2RAD * (Modulus(259.18 - 1934.142 * T, 360.0));
+    Lsa  = Modulus(L + C - DEG2RAD * (0.00569 - 0.00479 * sin(O)), TWOPI);
+    nu   = Modulus(M + C, TWOPI);
+    R    = 1.0000002 * (1.0 - e * e) / (1.0 + e * cos(nu));
+    eps  = DEG2RAD * (23.452294 - (0.0130125 + (0.00000164 - 0.000000503 * T) * T) * T + 0.00256 * cos(O));
+    R    = AU * R;
+
+    observer.sunx = R * cos(Lsa);
+    observer.suny = R * sin(Lsa) * cos(eps);
+    observer.sunz = R * sin(Lsa) * sin(eps);
+    observer.sunw = R;
 
+    return observer;
+}
+
+Satellite::Observer Satellite::observer(long double jd, GeoLocation *geo)
+{
+    Observer observer = Satellite::observer(jd, geo, geo->GSTtoLST(KStarsDateTime(jd).gst()), 0.0);
+
+    // Elevation of the Sun, as for the satellites
+    double range_posx = observer.sunx - observer.posx;
+    double range_posy = observer.suny - observer.posy;
+    double range_posz = observer.sunz - observer.posz;
+    double range      = sqrt(range_posx * range_posx + range_posy * range_posy + range_posz * range_posz);
+    double top_z      = observer.coslat * observer.costheta * range_posx + observer.coslat * observer.sintheta * range_posy +
+                        observer.sinlat * range_posz;
+
+    observer.sunAltitude = arcSin(top_z / range) / DEG2RAD;
+    return observer;
+}
+
+Satellite::Position Satellite::propagate(const Observer &observer)
+{
+    Position position;
+    position.rc = sgp4((observer.jd - m_tle_jd) * MINPD, observer, position);
+    return position;
+}
+
+void Satellite::setPosition(const Position &position, const Observer &observer)
+{
+    if (position.rc != 0)
+        return;
+
+    m_velocity    = position.velocity;
+    m_altitude    = position.altitude;
+    m_range       = position.range;
+    m_is_eclipsed = position.eclipsed;
+    m_is_visible  = position.visible;
+
+    setAz(position.az);
+    setAlt(position.alt);
+    HorizontalToEquatorial(&observer.lst, &observer.lat);
+}
+
+int Satellite::updatePos()
+{
+    const Observer now = observer();
+    const Position position = propagate(now);
+    setPosition(position, now);
+    return position.rc;
+}
+
+int Satellite::sgp4(double tsince, const Observer &observer, Position &position)
+{
     int ktr;
     double am, axnl, aynl, betal, cosim, cnod, cos2u, coseo1 = 0, cosi, cosip, cosisq, cossu, cosu, delm, delomg, em,
                                                       ecose, el2, eo1, ep, esine, argpm, argpp, argpdf, pl,
@@ -720,13 +820,11 @@ int Satellite::sgp4(double tsince)
                                                       t3, t4, tem5, temp, temp1, temp2, tempa, tempe, templ, u, ux, uy, uz, vx, vy, vz, inclm, mm, nm, nodem, xinc,
                                                       xincp, xl, xlm, mp, xmdf, xmx, xmy, nodedf, xnode, nodep, tc, sat_posx, sat_posy, sat_posz, sat_posw, sat_velx,
                                                       sat_vely, sat_velz, sinlat, obs_posx, obs_posy, obs_posz, obs_posw, /*obs_velx, obs_vely, obs_velz,*/
-                                                      coslat, thetageo, sintheta, costheta, c, sq, achcp, vkmpersec;
+                                                      coslat, sintheta, costheta, vkmpersec;
     //    double emsq;
 
     const double temp4 = 1.5e-12;
 
-    double jul_utc = data->clock()->utc().djd();
-
     vkmpersec = RADIUSEARTHKM * XKE / 60.0;
 
     // Update for secular gravity and atmospheric drag
@@ -1119,7 +1217,7 @@ int Satellite::sgp4(double tsince)
     sat_velx   = (mvt * ux + rvdot * vx) * vkmpersec;
     sat_vely   = (mvt * uy + rvdot * vy) * vkmpersec;
     sat_velz   = (mvt * uz + rvdot * vz) * vkmpersec;
-    m_velocity = sqrt(sat_velx * sat_velx + sat_vely * sat_vely + sat_velz * sat_velz);
+    position.velocity = sqrt(sat_velx * sat_velx + sat_vely * sat_vely + sat_velz * sat_velz);
 
     //     printf("tsince=%.15f\n", tsince);
     //     printf("sat_posx=%.15f\n", sat_posx);
@@ -1136,29 +1234,25 @@ int Satellite::sgp4(double tsince)
     }
 
     // Observer ECI position and velocity
-    sinlat   = sin(data->geo()->lat()->radians());
-    coslat   = cos(data->geo()->lat()->radians());
-    thetageo = data->geo()->LMST(jul_utc);
-    sintheta = sin(thetageo);
-    costheta = cos(thetageo);
-    c        = 1.0 / sqrt(1.0 + F * (F - 2.0) * sinlat * sinlat);
-    sq       = (1.0 - F) * (1.0 - F) * c;
-    achcp    = (RADIUSEARTHKM * c + MEANALT) * coslat;
-    obs_posx = achcp * costheta;
-    obs_posy = achcp * sintheta;
-    obs_posz = (RADIUSEARTHKM * sq + MEANALT) * sinlat;
+    sinlat   = observer.sinlat;
+    coslat   = observer.coslat;
+    sintheta = observer.sintheta;
+    costheta = observer.costheta;
+    obs_posx = observer.posx;
+    obs_posy = observer.posy;
+    obs_posz = observer.posz;
     obs_posw = sqrt(obs_posx * obs_posx + obs_posy * sat_posy + obs_posz * obs_posz);
     /*obs_velx = -MFACTOR * obs_posy;
     obs_vely = MFACTOR * obs_posx;
     obs_velz = 0.;*/
 
-    m_altitude = sat_posw - obs_posw + MEANALT;
+    position.altitude = sat_posw - obs_posw + MEANALT;
 
     // Az and Dec
     double range_posx = sat_posx - obs_posx;
     double range_posy = sat_posy - obs_posy;
     double range_posz = sat_posz - obs_posz;
-    m_range           = sqrt(range_posx * range_posx + range_posy * range_posy + range_posz * range_posz);
+    position.range    = sqrt(range_posx * range_posx + range_posy * range_posy + range_posz * range_posz);
     //     double range_velx = sat_velx - obs_velx;
     //     double range_vely = sat_velx - obs_vely;
     //     double range_velz = sat_velx - obs_velz;
@@ -1172,38 +1266,19 @@ int Satellite::sgp4(double tsince)
         azimuth += M_PI;
     if (azimuth < 0.)
         azimuth += TWOPI;
-    double elevation = arcSin(top_z / m_range);
+    double elevation = arcSin(top_z / position.range);
 
     //     printf("azimuth=%.15f\n\r", azimuth / DEG2RAD);
     //     printf("elevation=%.15f\n\r", elevation / DEG2RAD);
 
-    setAz(azimuth / DEG2RAD);
-    setAlt(elevation / DEG2RAD);
-    HorizontalToEquatorial(data->lst(), data->geo()->lat());
+    position.az  = azimuth / DEG2RAD;
+    position.alt = elevation / DEG2RAD;
 
     // is the satellite visible ?
-    // Find ECI coordinates of the sun
-    double mjd, year, T, M, L, e, C, O, Lsa, nu, R, eps;
-
-    mjd  = jul_utc - 2415020.0;
-    year = 1900.0 + mjd / 365.25;
-    T    = (mjd + deltaET(year) / (MINPD * 60.0)) / 36525.0;
-    M    = DEG2RAD * (Modulus(358.47583 + Modulus(35999.04975 * T, 360.0) - (0.000150 + 0.0000033 * T) * T * T, 360.0));
-    L    = DEG2RAD * (Modulus(279.69668 + Modulus(36000.76892 * T, 360.0) + 0.0003025 * T * T, 360.0));
-    e    = 0.01675104 - (0.0000418 + 0.000000126 * T) * T;
-    C    = DEG2RAD * ((1.919460 - (0.004789 + 0.000014 * T) * T) * sin(M) + (0.020094 - 0.000100 * T) * sin(2 * M) +
-                      0.000293 * sin(3 * M));
-    O    = DEG2RAD * (Modulus(259.18 - 1934.142 * T, 360.0));
-    Lsa  = Modulus(L + C - DEG2RAD * (0.00569 - 0.00479 * sin(O)), TWOPI);
-    nu   = Modulus(M + C, TWOPI);
-    R    = 1.0000002 * (1.0 - e * e) / (1.0 + e * cos(nu));
-    eps  = DEG2RAD * (23.452294 - (0.0130125 + (0.00000164 - 0.000000503 * T) * T) * T + 0.00256 * cos(O));
-    R    = AU * R;
-
-    double sun_posx = R * cos(Lsa);
-    double sun_posy = R * sin(Lsa) * cos(eps);
-    double sun_posz = R * sin(Lsa) * sin(eps);
-    double sun_posw = R;
+    double sun_posx = observer.sunx;
+    double sun_posy = observer.suny;
+    double sun_posz = observer.sunz;
+    double sun_posw = observer.sunw;
 
     // Calculates satellite's eclipse status and depth
     double sd_sun, sd_earth, delta, depth;
@@ -1221,10 +1296,9 @@ int Satellite::sgp4(double tsince)
     double earth_w = sat_posw;
     delta      = PIO2 - arcSin((sun_posx * earth_x + sun_posy * earth_y + sun_posz * earth_z) / (sun_posw * earth_w));
     depth      = sd_earth - sd_sun - delta;
-    KSSun *sun = dynamic_cast<KSSun *>(data->skyComposite()->findByName(i18n("Sun")));
 
-    m_is_eclipsed = sd_earth >= sd_sun && depth >= 0;
-    m_is_visible  = !m_is_eclipsed && sun->alt().Degrees() <= -12.0 && elevation >= 0.0;
+    position.eclipsed = sd_earth >= sd_sun && depth >= 0;
+    position.visible  = !position.eclipsed && observer.sunAltitude <= -12.0 && elevation >= 0.0;
 
     return (0);
 }
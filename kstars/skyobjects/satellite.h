@@ -10,6 +10,7 @@
 
 #include <QString>
 
+class GeoLocation;
 class KSPopupMenu;
 
 /**
@@ -34,6 +35,65 @@ class Satellite : public SkyObject
         /** @short Destructor */
         virtual ~Satellite() override = default;
 
+        /**
+         * @short Observer and Sun positions, shared by the satellites propagated for the same time.
+         * See observer().
+         */
+        struct Observer
+        {
+            /// Julian day, UTC
+            long double jd { 0 };
+            /// Local sidereal time and latitude of the observer
+            dms lst, lat;
+            /// Sine and cosine of the latitude and of the local mean sidereal time of the observer
+            double sinlat { 0 }, coslat { 0 }, sintheta { 0 }, costheta { 0 };
+            /// ECI position of the observer in km
+            double posx { 0 }, posy { 0 }, posz { 0 };
+            /// ECI position of the Sun in km
+            double sunx { 0 }, suny { 0 }, sunz { 0 }, sunw { 0 };
+            /// Altitude of the Sun above the horizon in degrees
+            double sunAltitude { 0 };
+        };
+
+        /** @short Position of a satellite as computed by propagate(), applied by setPosition(). */
+        struct Position
+        {
+            /// Error code, see sgp4ErrorString(). The other fields are only set when it is 0.
+            int rc { 0 };
+            /// Horizontal coordinates in degrees
+            double az { 0 }, alt { 0 };
+            /// Velocity in km/s, altitude and range from the observer in km
+            double velocity { 0 }, altitude { 0 }, range { 0 };
+            bool eclipsed { false };
+            bool visible { false };
+        };
+
+        /** @return the observer at the current time and location of KStars */
+        static Observer observer();
+
+        /**
+         * @return the observer at @p geo for the Julian day @p jd (UTC).
+         * @param lst local sidereal time at @p geo for @p jd
+         * @param sunAltitude altitude of the Sun in degrees, for the visibility of satellites
+         */
+        static Observer observer(long double jd, GeoLocation *geo, const dms &lst, double sunAltitude);
+
+        /**
+         * @return the observer at @p geo for the Julian day @p jd (UTC), with the altitude of the Sun
+         * taken from the low precision ephemeris used for eclipses.
+         */
+        static Observer observer(long double jd, GeoLocation *geo);
+
+        /**
+         * @short Computes the position of the satellite seen by @p observer, without updating it.
+         * Satellites can be propagated on different threads, a satellite must not be propagated
+         * by two threads at once.
+         */
+        Position propagate(const Observer &observer);
+
+        /** @short Updates the satellite to @p position, computed by propagate() for @p observer. */
+        void setPosition(const Position &position, const Observer &observer);
+
         /** @short Update satellite position */
         int updatePos();
 
@@ -77,10 +137,10 @@ class Satellite : public SkyObject
         void init();
 
         /** @short Compute satellite position */
-        int sgp4(double tsince);
+        int sgp4(double tsince, const Observer &observer, Position &position);
 
         /** @return Arcsine of the argument */
-        double arcSin(double arg);
+        static double arcSin(double arg);
 
         /**
          * Provides the difference between UT (approximately the same as UTC)
@@ -88,10 +148,10 @@ class Satellite : public SkyObject
          * This function is based on a least squares fit of data from 1950
          * to 1991 and will need to be updated periodically.
          */
-        double deltaET(double year);
+        static double deltaET(double year);
 
         /** @return arg1 mod arg2 */
-        double Modulus(double arg1, double arg2);
+        static double Modulus(double arg1, double arg2);
 
         // TLE
         /// Satellite Number
@@ -11,6 +11,15 @@
 #include "skyobjects/satellite.h"
 
 #include <QTextStream>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+namespace
+{
+// Satellites propagated by each parallel task
+constexpr int BATCH_SIZE = 64;
+}
 
 SatelliteGroup::SatelliteGroup(const QString& name, const QString& tle_filename, const QUrl& update_url)
 {
@@ -51,22 +60,53 @@ void SatelliteGroup::readTLE()
 
 void SatelliteGroup::updateSatellitesPos()
 {
-    QMutableListIterator<Satellite *> sats(*this);
-
-    while (sats.hasNext())
+    QVector<Satellite *> satellites;
+    for (Satellite *sat : *this)
     {
-        Satellite *sat = sats.next();
-
         if (sat->selected())
-        {
-            int rc = sat->updatePos();
-            // If position cannot be calculated, remove it from list
-            if (rc != 0)
-                sats.remove();
-        }
+            satellites.append(sat);
+    }
+    if (satellites.isEmpty())
+        return;
+
+    const Satellite::Observer observer = Satellite::observer();
+    const QVector<Satellite::Position> positions = propagate(satellites, observer);
+
+    for (int i = 0; i < satellites.size(); i++)
+    {
+        // If position cannot be calculated, remove it from list
+        if (positions[i].rc != 0)
+            removeOne(satellites[i]);
+        else
+            satellites[i]->setPosition(positions[i], observer);
     }
 }
 
+QVector<Satellite::Position> SatelliteGroup::propagate(const QVector<Satellite *> &satellites,
+        const Satellite::Observer &observer)
+{
+    QVector<Satellite::Position> positions(satellites.size());
+    Satellite::Position *output = positions.data();
+
+    QVector<int> batches;
+    for (int first = 0; first < satellites.size(); first += BATCH_SIZE)
+        batches.append(first);
+
+    auto propagateBatch = [&](const int &first)
+    {
+        const int last = std::min(first + BATCH_SIZE, static_cast<int>(satellites.size()));
+        for (int i = first; i < last; i++)
+            output[i] = satellites[i]->propagate(observer);
+    };
+
+    if (batches.size() > 1)
+        QtConcurrent::blockingMap(batches, propagateBatch);
+    else if (!batches.isEmpty())
+        propagateBatch(batches.first());
+
+    return positions;
+}
+
 QUrl SatelliteGroup::tleFilename()
 {
     // Return absolute path with "file:" before the path
@@ -6,10 +6,11 @@
 
 #pragma once
 
+#include "satellite.h"
+
 #include <QString>
 #include <QUrl>
-
-class Satellite;
+#include <QVector>
 
 /**
  * @class SatelliteGroup
@@ -34,9 +35,19 @@ class SatelliteGroup : public QList<Satellite *>
 
     /**
      * Compute current position of the each satellites in the group.
+     *
+     * The selected satellites are propagated in parallel batches, their positions are then
+     * applied on the calling thread. Satellites whose position cannot be computed are removed.
      */
     void updateSatellitesPos();
 
+    /**
+     * @short Computes the positions of @p satellites seen by @p observer in parallel batches,
+     * without updating them.
+     * @return the positions, in the order of @p satellites
+     */
+    static QVector<Satellite::Position> propagate(const QVector<Satellite *> &satellites, const Satellite::Observer &observer);
+
     /**
      * @return TLE filename
      */
@@ -0,0 +1,317 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "satellitepasspredictor.h"
+
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+
+#include <kstars_debug.h>
+
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+// Precision of the times of rise, culmination and set, in days
+constexpr long double PRECISION = 1.0L / 86400.0L;
+// Ratio of the golden section search
+constexpr long double GOLDEN = 0.6180339887498948482L;
+
+// Coarse steps of the predictions, shared by all satellites
+QVector<Satellite::Observer> grid(GeoLocation *geo, long double start, long double end, int step)
+{
+    QVector<Satellite::Observer> observers;
+    const long double days = step / 86400.0L;
+    for (int i = 0; start + i * days <= end; i++)
+        observers.append(Satellite::observer(start + i * days, geo));
+    return observers;
+}
+
+QVector<SatellitePassPredictor::Pass> predictPasses(Satellite *satellite, GeoLocation *geo,
+        const QVector<Satellite::Observer> &observers, double minAltitude)
+{
+    QVector<SatellitePassPredictor::Pass> passes;
+    if (observers.size() < 2)
+        return passes;
+
+    auto positionAt = [&](long double jd)
+    {
+        return satellite->propagate(Satellite::observer(jd, geo));
+    };
+    auto isUp = [&](const Satellite::Position &position)
+    {
+        return position.rc == 0 && position.alt >= minAltitude;
+    };
+
+    // Time at which the satellite rises or sets between two steps, where it is up at one of them only
+    auto crossing = [&](long double below, long double above)
+    {
+        while (std::abs(above - below) > PRECISION)
+        {
+            const long double middle = (below + above) / 2;
+            if (isUp(positionAt(middle)))
+                above = middle;
+            else
+                below = middle;
+        }
+        return above;
+    };
+
+    // Time of the highest altitude between two times
+    auto culmination = [&](long double first, long double last)
+    {
+        auto altitude = [&](long double jd)
+        {
+            const Satellite::Position position = positionAt(jd);
+            return position.rc == 0 ? position.alt : -90.0;
+        };
+
+        long double low = last - (last - first) * GOLDEN, high = first + (last - first) * GOLDEN;
+        double lowAltitude = altitude(low), highAltitude = altitude(high);
+        while (last - first > PRECISION)
+        {
+            if (lowAltitude > highAltitude)
+            {
+                last         = high;
+                high         = low;
+                highAltitude = lowAltitude;
+                low          = last - (last - first) * GOLDEN;
+                lowAltitude  = altitude(low);
+            }
+            else
+            {
+                first        = low;
+                low          = high;
+                lowAltitude  = highAltitude;
+                high         = first + (last - first) * GOLDEN;
+                highAltitude = altitude(high);
+            }
+        }
+        return (first + last) / 2;
+    };
+
+    SatellitePassPredictor::Pass pass;
+    // Passes in progress at the start are skipped
+    bool wasUp = true, inPass = false;
+    int highest = 0;
+    double highestAltitude = -90.0;
+
+    for (int i = 0; i < observers.size(); i++)
+    {
+        const Satellite::Observer &observer = observers[i];
+        const Satellite::Position position = satellite->propagate(observer);
+        // The satellite has decayed
+        if (position.rc != 0)
+            break;
+
+        const bool up = isUp(position);
+        if (up && !wasUp)
+        {
+            const long double rise = crossing(observers[i - 1].jd, observer.jd);
+            pass             = SatellitePassPredictor::Pass();
+            pass.satellite   = satellite->name();
+            pass.rise        = KStarsDateTime(rise);
+            pass.riseAzimuth = positionAt(rise).az;
+            pass.visible     = position.visible;
+            highest          = i;
+            highestAltitude  = position.alt;
+            inPass           = true;
+        }
+        else if (up && inPass)
+        {
+            pass.visible = pass.visible || position.visible;
+            if (position.alt > highestAltitude)
+            {
+                highest         = i;
+                highestAltitude = position.alt;
+            }
+        }
+        else if (!up && wasUp && inPass)
+        {
+            const long double set = crossing(observer.jd, observers[i - 1].jd);
+            const long double top = culmination(std::max(pass.rise.djd(), observers[highest - 1].jd),
+                                                std::min(set, observers[highest + 1].jd));
+            const Satellite::Position culminating = positionAt(top);
+
+            pass.set         = KStarsDateTime(set);
+            pass.setAzimuth  = positionAt(set).az;
+            pass.culmination = KStarsDateTime(top);
+            pass.maxAltitude = culminating.alt;
+            pass.sunlit      = !culminating.eclipsed;
+            pass.visible     = pass.visible || culminating.visible;
+            passes.append(pass);
+            inPass = false;
+        }
+        wasUp = up;
+    }
+
+    return passes;
+}
+}
+
+SatellitePassPredictor::SatellitePassPredictor(QObject *parent) : QObject(parent)
+{
+    connect(&m_Watcher, &QFutureWatcher<QVector<Pass>>::finished, this, &SatellitePassPredictor::applyPrediction);
+}
+
+SatellitePassPredictor::~SatellitePassPredictor()
+{
+    cancel();
+}
+
+void SatellitePassPredictor::setStep(int seconds)
+{
+    m_Step = std::max(1, seconds);
+    m_Key.clear();
+}
+
+void SatellitePassPredictor::setMinAltitude(double degrees)
+{
+    m_MinAltitude = degrees;
+    m_Key.clear();
+}
+
+bool SatellitePassPredictor::predict(const QList<Satellite *> &satellites, const GeoLocation *geo,
+                                     const KStarsDateTime &start, double hours)
+{
+    const QByteArray key = cacheKey(satellites, geo);
+    const long double first = start.djd();
+    const long double last  = first + hours / 24.0;
+
+    auto covers = [&](const QByteArray &cachedKey, long double cachedStart, long double cachedEnd)
+    {
+        return !cachedKey.isEmpty() && cachedKey == key && cachedStart <= first && (cachedEnd - first) * 2 >= last - first;
+    };
+    if (isRunning() ? covers(m_PendingKey, m_PendingStart, m_PendingEnd) : covers(m_Key, m_Start, m_End))
+        return false;
+
+    cancel();
+    if (satellites.isEmpty())
+    {
+        m_Passes.clear();
+        m_Key   = key;
+        m_Start = first;
+        m_End   = last;
+        emit passesPredicted();
+        return true;
+    }
+
+    m_Geo          = *geo;
+    m_PendingKey   = key;
+    m_PendingStart = first;
+    m_PendingEnd   = last;
+
+    // The satellites are copied, the copies are propagated while the satellites stay in the hands of the sky map
+    for (Satellite *satellite : satellites)
+        m_Copies.append(satellite->clone());
+
+    const QVector<Satellite *> copies = m_Copies;
+    const int step = m_Step;
+    const double minAltitude = m_MinAltitude;
+    m_Watcher.setFuture(QtConcurrent::run([this, copies, first, last, step, minAltitude]()
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        GeoLocation *geo = &m_Geo;
+        const QVector<Satellite::Observer> observers = grid(geo, first, last, step);
+        QVector<QVector<Pass>> results(copies.size());
+
+        QVector<int> indexes(copies.size());
+        std::iota(indexes.begin(), indexes.end(), 0);
+        QtConcurrent::blockingMap(indexes, [&](const int &i)
+        {
+            if (!m_Canceled)
+                results[i] = predictPasses(copies[i], geo, observers, minAltitude);
+        });
+
+        QVector<Pass> all;
+        for (const auto &result : results)
+            all.append(result);
+        std::sort(all.begin(), all.end(), [](const Pass & a, const Pass & b)
+        {
+            return a.rise.djd() < b.rise.djd();
+        });
+
+        if (!m_Canceled)
+            qCInfo(KSTARS) << QString("Predicted %1 passes of %2 satellites over %3 hours in %4 ms").arg(all.size())
+                           .arg(copies.size()).arg(static_cast<double>((last - first) * 24), 0, 'f', 1).arg(timer.elapsed());
+        return all;
+    }));
+
+    return true;
+}
+
+void SatellitePassPredictor::cancel()
+{
+    if (m_Copies.isEmpty())
+        return;
+
+    m_Canceled = true;
+    m_Watcher.waitForFinished();
+    // The notification of a finished prediction may still be waiting for the event loop, drop it.
+    m_Watcher.setFuture(QFuture<QVector<Pass>>());
+    qDeleteAll(m_Copies);
+    m_Copies.clear();
+    m_PendingKey.clear();
+    m_Canceled = false;
+}
+
+void SatellitePassPredictor::waitForPrediction()
+{
+    if (m_Copies.isEmpty())
+        return;
+
+    m_Watcher.waitForFinished();
+    applyPrediction();
+}
+
+QVector<SatellitePassPredictor::Pass> SatellitePassPredictor::passes(const KStarsDateTime &from) const
+{
+    QVector<Pass> passes;
+    for (const auto &pass : m_Passes)
+    {
+        if (pass.set.djd() > from.djd())
+            passes.append(pass);
+    }
+    return passes;
+}
+
+QVector<SatellitePassPredictor::Pass> SatellitePassPredictor::predict(Satellite *satellite, GeoLocation *geo,
+        long double start, long double end, int step, double minAltitude)
+{
+    return predictPasses(satellite, geo, grid(geo, start, end, std::max(1, step)), minAltitude);
+}
+
+QByteArray SatellitePassPredictor::cacheKey(const QList<Satellite *> &satellites, const GeoLocation *geo)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (const Satellite *satellite : satellites)
+        hash.addData(satellite->tle().toUtf8());
+    hash.addData(QString("%1 %2 %3").arg(geo->lng()->Degrees(), 0, 'f', 6).arg(geo->lat()->Degrees(), 0, 'f', 6)
+                 .arg(geo->elevation()).toUtf8());
+    return hash.result();
+}
+
+void SatellitePassPredictor::applyPrediction()
+{
+    // Nothing left to apply if the prediction was canceled or already applied by waitForPrediction()
+    if (m_Copies.isEmpty() || !m_Watcher.future().isFinished())
+        return;
+
+    m_Passes = m_Watcher.future().result();
+    m_Key    = m_PendingKey;
+    m_Start  = m_PendingStart;
+    m_End    = m_PendingEnd;
+
+    qDeleteAll(m_Copies);
+    m_Copies.clear();
+    m_PendingKey.clear();
+
+    emit passesPredicted();
+}
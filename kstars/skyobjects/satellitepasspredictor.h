@@ -0,0 +1,117 @@
+/*
+    SPDX-FileCopyrightText: 2022 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "geolocation.h"
+#include "kstarsdatetime.h"
+#include "satellite.h"
+
+#include <QByteArray>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QVector>
+
+#include <atomic>
+
+/**
+ * @class SatellitePassPredictor
+ * @short Predicts the passes of satellites over a location, on worker threads.
+ *
+ * Each satellite is propagated by coarse steps over the requested span of time. Its rise and set
+ * are then refined by bisection between the steps around them, and its culmination by a golden
+ * section search around the highest step. Satellites are spread over worker threads. Each thread
+ * works on copies of the satellites, so the satellites drawn on the sky map can be updated in the
+ * meantime.
+ *
+ * Predictions are cached. A new one only starts when the satellites, their TLEs or the location
+ * change, or when less than half of the predicted span remains ahead.
+ */
+class SatellitePassPredictor : public QObject
+{
+        Q_OBJECT
+
+    public:
+        /** @short A pass of a satellite above the minimum altitude. */
+        struct Pass
+        {
+            QString satellite;
+            KStarsDateTime rise;
+            KStarsDateTime culmination;
+            KStarsDateTime set;
+            /** Azimuths at rise and set, altitude at culmination, in degrees */
+            double riseAzimuth { 0 };
+            double setAzimuth { 0 };
+            double maxAltitude { 0 };
+            /** True if the satellite is in the sunlight at culmination */
+            bool sunlit { false };
+            /** True if the satellite can be seen at some point of the pass, see Satellite::isVisible() */
+            bool visible { false };
+        };
+
+        explicit SatellitePassPredictor(QObject *parent = nullptr);
+
+        /** @short Waits for the prediction in progress, if any. */
+        ~SatellitePassPredictor() override;
+
+        /** @short Interval between the coarse steps, in seconds. Passes shorter than it may be missed. */
+        void setStep(int seconds);
+
+        /** @short Altitude above which a satellite is considered up, in degrees. */
+        void setMinAltitude(double degrees);
+
+        /**
+         * @short Starts predicting the passes of @p satellites at @p geo, from @p start for @p hours.
+         * @return false if the cached prediction still covers the request, nothing is started then.
+         */
+        bool predict(const QList<Satellite *> &satellites, const GeoLocation *geo, const KStarsDateTime &start, double hours);
+
+        /** @short Stops the prediction in progress, if any, and drops its results. */
+        void cancel();
+
+        /** @short Waits for the prediction in progress, if any, and caches its results. */
+        void waitForPrediction();
+
+        bool isRunning() const
+        {
+            return !m_Copies.isEmpty();
+        }
+
+        /** @return the passes ending after @p from, in order of rise. Passes in progress at either end of the span are left out. */
+        QVector<Pass> passes(const KStarsDateTime &from) const;
+
+        /** @short Predicts the passes of @p satellite at @p geo between @p start and @p end, on the calling thread. */
+        static QVector<Pass> predict(Satellite *satellite, GeoLocation *geo, long double start, long double end, int step,
+                                     double minAltitude);
+
+    signals:
+        /** @short Emitted when the passes of a new prediction are available. */
+        void passesPredicted();
+
+    private:
+        // Identifies the satellites and the location a prediction is made for
+        static QByteArray cacheKey(const QList<Satellite *> &satellites, const GeoLocation *geo);
+        // Caches the results of the finished prediction
+        void applyPrediction();
+
+        int m_Step { 60 };
+        double m_MinAltitude { 0 };
+
+        // The prediction in progress, the copies of the satellites it works on and what it is for
+        QFutureWatcher<QVector<Pass>> m_Watcher;
+        std::atomic<bool> m_Canceled { false };
+        QVector<Satellite *> m_Copies;
+        GeoLocation m_Geo { dms(0.0), dms(0.0) };
+        QByteArray m_PendingKey;
+        long double m_PendingStart { 0 };
+        long double m_PendingEnd { 0 };
+
+        // The cached prediction
+        QVector<Pass> m_Passes;
+        QByteArray m_Key;
+        long double m_Start { 0 };
+        long double m_End { 0 };
+};
@@ -578,6 +578,45 @@ void SkyPoint::aberrate(const KSNumbers *num, bool reverse)
 #endif
 }
 
+void SkyPoint::updateCoordsBatch(SkyPoint *const *points, int count, const KSNumbers *num, bool forceRecompute)
+{
+    const bool relativistic = Options::useRelativistic();
+
+    for (int i = 0; i < count; ++i)
+    {
+        SkyPoint *p = points[i];
+        if (relativistic && p->checkBendLight())
+        {
+            p->updateCoords(num, false, nullptr, nullptr, forceRecompute);
+            continue;
+        }
+        if (!p->needsRecompute(num, forceRecompute))
+            continue;
+
+        double cosRA0, sinRA0, cosDec0, sinDec0;
+        p->RA0.SinCos(sinRA0, cosRA0);
+        p->Dec0.SinCos(sinDec0, cosDec0);
+        p->setApparentFromJ2000(num, cosRA0 * cosDec0, sinRA0 * cosDec0, sinDec0);
+    }
+}
+
+void SkyPoint::setApparentFromJ2000(const KSNumbers *num, double x, double y, double z)
+{
+    const Eigen::Vector3d v = num->apparentDirection(Eigen::Vector3d(x, y, z));
+
+    RA.setUsing_atan2(v[1], v[0]);
+    RA.reduceToRange(dms::ZERO_TO_2PI);
+    Dec.setUsing_asin(v[2]);
+    lastPrecessJD = num->getJD();
+}
+
+bool SkyPoint::needsRecompute(const KSNumbers *num, bool forceRecompute) const
+{
+    // Same short circuit as updateCoords()
+    return Options::alwaysRecomputeCoordinates() || forceRecompute ||
+           std::abs(lastPrecessJD - num->getJD()) >= 0.00069444; // Update once per solar minute
+}
+
 // Note: This method is one of the major rate determining factors in how fast the map pans / zooms in or out
 void SkyPoint::updateCoords(const KSNumbers *num, bool /*includePlanets*/, const CachingDms *lat, const CachingDms *LST,
                             bool forceRecompute)
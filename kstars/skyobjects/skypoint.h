@@ -384,6 +384,26 @@ class SkyPoint
             updateCoords(num, false, nullptr, nullptr, true);
         }
 
+        /**
+         * @short Determine the current coordinates of several points for the same epoch
+         *
+         * Each point ends up as if updateCoords() was called on it, but precession, nutation and
+         * aberration are applied at once with the rotation and aberration vector cached in num.
+         * The results agree with updateCoords() to about (1 + tan²(Dec)) milliarcseconds, the
+         * difference coming from the second order terms of the step by step corrections.
+         *
+         * @note Points are updated from their catalog coordinates, proper motions are ignored.
+         * Use StarObject::updateCoordsBatch() for stars.
+         * @note Points whose light is bent by the sun go through updateCoords() when relativistic
+         * corrections are enabled.
+         * @param points the points to update
+         * @param count the number of points
+         * @param num pointer to KSNumbers object containing current values of time-dependent variables.
+         * @param forceRecompute reapplies the corrections even if the time passed since the last
+         * computation is not significant.
+         */
+        static void updateCoordsBatch(SkyPoint *const *points, int count, const KSNumbers *num, bool forceRecompute = false);
+
         /**
          * Computes the apparent coordinates for this SkyPoint for any epoch,
          * accounting for the effects of precession, nutation, and aberration.
@@ -746,6 +766,15 @@ class SkyPoint
          */
         void precess(const KSNumbers *num);
 
+        /**
+         * Set the current coordinates from a direction in J2000 mean coordinates, applying the
+         * precession, nutation and aberration cached in num. Used by the batch updates.
+         */
+        void setApparentFromJ2000(const KSNumbers *num, double x, double y, double z);
+
+        /** @return true if the coordinates need to be recomputed for the epoch of num */
+        bool needsRecompute(const KSNumbers *num, bool forceRecompute) const;
+
 #ifdef UNIT_TEST
         friend class TestSkyPoint; // Test class
 #endif
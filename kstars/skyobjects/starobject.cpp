@@ -287,6 +287,41 @@ void StarObject::updateCoords(const KSNumbers *num, bool, const CachingDms *, co
 #endif
 }
 
+void StarObject::updateCoordsBatch(StarObject *const *stars, int count, const KSNumbers *num, bool forceRecompute)
+{
+    const bool relativistic = Options::useRelativistic();
+    const double scale      = num->julianMillenia() * (M_PI / (180.0 * 3600.0));
+
+    for (int i = 0; i < count; ++i)
+    {
+        StarObject *star = stars[i];
+        if (relativistic && star->checkBendLight())
+        {
+            star->updateCoords(num, false, nullptr, nullptr, forceRecompute);
+            continue;
+        }
+        if (!star->needsRecompute(num, forceRecompute))
+            continue;
+
+        double cosDec, sinDec, cosRa, sinRa;
+        star->dec0().SinCos(sinDec, cosDec);
+        star->ra0().SinCos(sinRa, cosRa);
+        double x = cosDec * cosRa, y = cosDec * sinRa, z = sinDec;
+
+        // Proper motion along the tangent plane, as in getIndexCoords()
+        const double pmms = star->pmMagnitudeSquared();
+        if (!std::isnan(pmms) && pmms * num->julianMillenia() * num->julianMillenia() >= .01)
+        {
+            const double net_pmRA = star->pmRA() * scale, net_pmDec = star->pmDec() * scale;
+            x += - net_pmRA * sinRa - net_pmDec * sinDec * cosRa;
+            y += net_pmRA * cosRa - net_pmDec * sinDec * sinRa;
+            z += net_pmDec * cosDec;
+        }
+
+        star->setApparentFromJ2000(num, x, y, z);
+    }
+}
+
 bool StarObject::getIndexCoords(const KSNumbers *num, CachingDms &ra, CachingDms &dec)
 {
     static double pmms;
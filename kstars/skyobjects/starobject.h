@@ -171,6 +171,18 @@ class StarObject : public SkyObject
     void updateCoords(const KSNumbers *num, bool includePlanets = true, const CachingDms *lat = nullptr,
                       const CachingDms *LST = nullptr, bool forceRecompute = false) override;
 
+    /**
+     * @short Determine the current coordinates of several stars for the same epoch
+     *
+     * Same as SkyPoint::updateCoordsBatch(), with the proper motion of each star applied first.
+     *
+     * @param stars the stars to update
+     * @param count the number of stars
+     * @param num pointer to KSNumbers object containing current values of time-dependent variables.
+     * @param forceRecompute defines whether the data should be recomputed forcefully.
+     */
+    static void updateCoordsBatch(StarObject *const *stars, int count, const KSNumbers *num, bool forceRecompute = false);
+
     /**
      * @short Fills ra and dec with the coordinates of the star with the proper
      * motion correction but without precision and its friends.  It is used
@@ -444,6 +444,9 @@ void ObsListWizard::applyFilters(bool doBuildList)
     if (doBuildList)
         obsList().clear();
 
+    if (olw->SelectByDate->isChecked())
+        prepareObservableFilter();
+
     //We don't need to call applyRegionFilter() if no region filter is selected, *and*
     //we are just counting items (i.e., doBuildList is false)
     bool needRegion = true;
@@ -490,6 +493,18 @@ void ObsListWizard::applyFilters(bool doBuildList)
             ObjectCount -= StarCount;
             ObjectCount += starIndex;
         }
+        // Constellations of all the candidate stars are looked up at once, in parallel
+        ConstellationBoundaryLines *boundaries = data->skyComposite()->constellationBoundary();
+        QVector<int> constellations;
+        if (needRegion && isItemSelected(i18n("by constellation"), olw->RegionList))
+        {
+            QVector<const SkyPoint *> points;
+            points.reserve(starIndex);
+            for (int i = 0; i < starIndex; ++i)
+                points.append(starList[i]);
+            constellations = boundaries->constellationIds(points);
+        }
+
         for (int i = 0; i < starIndex; ++i)
         {
             SkyObject *o = (SkyObject *)(starList[i]);
@@ -503,7 +518,8 @@ void ObsListWizard::applyFilters(bool doBuildList)
             }
 
             if (needRegion)
-                filterPass = applyRegionFilter(o, doBuildList, !doBuildList);
+                filterPass = applyRegionFilter(o, doBuildList, !doBuildList,
+                                               constellations.isEmpty() ? QString() : boundaries->constellationName(constellations[i]));
             //Filter objects visible from geo at Date if region filter passes
             if (olw->SelectByDate->isChecked() && filterPass)
                 applyObservableFilter(o, doBuildList, !doBuildList);
@@ -850,12 +866,13 @@ void ObsListWizard::applyFilters(bool doBuildList)
                                    "Your observing list currently has %1 objects", ObjectCount));
 }
 
-bool ObsListWizard::applyRegionFilter(SkyObject *o, bool doBuildList, bool doAdjustCount)
+bool ObsListWizard::applyRegionFilter(SkyObject *o, bool doBuildList, bool doAdjustCount, const QString &constellation)
 {
     //select by constellation
     if (isItemSelected(i18n("by constellation"), olw->RegionList))
     {
-        QString c = KStarsData::Instance()->skyComposite()->constellationBoundary()->constellationName(o);
+        QString c = constellation.isEmpty() ?
+                    KStarsData::Instance()->skyComposite()->constellationBoundary()->constellationName(o) : constellation;
 
         if (isItemSelected(c, olw->ConstellationList))
         {
@@ -937,15 +954,12 @@ bool ObsListWizard::applyRegionFilter(SkyObject *o, bool doBuildList, bool doAdj
     return true;
 }
 
-bool ObsListWizard::applyObservableFilter(SkyObject *o, bool doBuildList, bool doAdjustCount)
+void ObsListWizard::prepareObservableFilter()
 {
-    SkyPoint p = *o;
-
     //Check altitude of object every hour from 18:00 to midnight
     //If it's ever above 15 degrees, flag it as visible
     KStarsDateTime Evening(olw->Date->date(), QTime(18, 0, 0), Qt::LocalTime);
     KStarsDateTime Midnight(olw->Date->date().addDays(1), QTime(0, 0, 0), Qt::LocalTime);
-    double minAlt = 15, maxAlt = 90;
 
     // Or use user-selected values, if they're valid
     if (olw->timeFrom->time().isValid() && olw->timeTo->time().isValid())
@@ -966,21 +980,19 @@ bool ObsListWizard::applyObservableFilter(SkyObject *o, bool doBuildList, bool d
         }
     }
 
-    minAlt = olw->minAlt->value();
-    maxAlt = olw->maxAlt->value();
+    // The times are local to the selected location
+    m_Observability.reset(new ObservabilityEngine(geo, geo->LTtoUT(Evening), geo->LTtoUT(Midnight), 3600));
+}
+
+bool ObsListWizard::applyObservableFilter(SkyObject *o, bool doBuildList, bool doAdjustCount)
+{
+    const ObservabilityEngine::Constraints constraints { olw->minAlt->value(), olw->maxAlt->value() };
+    const auto visibility = m_Observability->evaluate(ObservabilityEngine::position(*o), constraints);
 
     // This is the "relaxed" search mode
     // where if the object obeys the restrictions in 50% of the time of the range
     // then it qualifies as "visible"
-    double totalCount = 0, visibleCount = 0;
-    for (KStarsDateTime t = Evening; t < Midnight; t = t.addSecs(3600.0))
-    {
-        dms LST = geo->GSTtoLST(t.gst());
-        p.EquatorialToHorizontal(&LST, geo->lat());
-        totalCount++;
-        if (p.alt().Degrees() >= minAlt && p.alt().Degrees() <= maxAlt)
-            visibleCount++;
-    }
+    double totalCount = m_Observability->sampleCount(), visibleCount = visibility.samples;
 
     // If the object is within the min/max alt at least coverage % of the time range
     // then consider it visible
@@ -7,10 +7,13 @@
 #pragma once
 
 #include "ui_obslistwizard.h"
+#include "auxiliary/observabilityengine.h"
 #include "skyobjects/skypoint.h"
 
 #include <QDialog>
 
+#include <memory>
+
 class QListWidget;
 class QPushButton;
 
@@ -63,8 +66,14 @@ class ObsListWizard : public QDialog
     void initialize();
     void applyFilters(bool doBuildList);
 
-    /** @return true if the object passes the filter region constraints, false otherwise.*/
-    bool applyRegionFilter(SkyObject *o, bool doBuildList, bool doAdjustCount = true);
+    /**
+     * @return true if the object passes the filter region constraints, false otherwise.
+     * @param constellation name of the constellation of the object if already known, it is looked up otherwise.
+     */
+    bool applyRegionFilter(SkyObject *o, bool doBuildList, bool doAdjustCount = true,
+                           const QString &constellation = QString());
+    /** @short Computes the sidereal times of the selected date and time range, for applyObservableFilter() */
+    void prepareObservableFilter();
     bool applyObservableFilter(SkyObject *o, bool doBuildList, bool doAdjustCount = true);
 
     /**
@@ -105,6 +114,7 @@ class ObsListWizard : public QDialog
     double rCirc { 0 };
     SkyPoint pCirc;
     GeoLocation *geo { nullptr };
+    std::unique_ptr<ObservabilityEngine> m_Observability;
     QPushButton *nextB { nullptr };
     QPushButton *backB { nullptr };
 };
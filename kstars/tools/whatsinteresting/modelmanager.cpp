@@ -212,12 +212,21 @@ void ModelManager::loadObjectsIntoModel(SkyObjListModel &model, QList<SkyObjItem
 {
     KStarsData *data = KStarsData::Instance();
 
-    foreach (SkyObjItem *soitem, skyObjectList)
+    // The visibility of the whole list is evaluated at once
+    QVector<bool> isVisible;
+    if (showOnlyVisible)
     {
-        bool isVisible =
-            (showOnlyVisible) ? (m_ObsConditions->isVisible(data->geo(), data->lst(), soitem->getSkyObject())) : true;
-        if (isVisible)
-            model.addSkyObject(soitem);
+        QList<SkyObject *> objects;
+        objects.reserve(skyObjectList.size());
+        for (auto soitem : skyObjectList)
+            objects.append(soitem->getSkyObject());
+        isVisible = m_ObsConditions->isVisible(data->geo(), data->ut(), objects);
+    }
+
+    for (int i = 0; i < skyObjectList.size(); i++)
+    {
+        if (!showOnlyVisible || isVisible[i])
+            model.addSkyObject(skyObjectList[i]);
     }
 }
 
@@ -6,6 +6,8 @@
 
 #include "obsconditions.h"
 
+#include "auxiliary/observabilityengine.h"
+
 #include <QDebug>
 
 #include <cmath>
@@ -83,19 +85,27 @@ double ObsConditions::getTrueMagLim()
     return m_LM + 5 * log10(m_Aperture / 7.5);
 }
 
-bool ObsConditions::isVisible(GeoLocation *geo, dms *lst, SkyObject *so)
+QVector<bool> ObsConditions::isVisible(const GeoLocation *geo, const KStarsDateTime &ut, const QList<SkyObject *> &objects)
 {
-    if (so->type() == SkyObject::SATELLITE)
+    QVector<ObservabilityEngine::Position> positions;
+    positions.reserve(objects.size());
+    for (auto so : objects)
+        positions.append(ObservabilityEngine::position(*so));
+
+    //check altitude of objects at this time.
+    const ObservabilityEngine engine(geo, ut);
+    const auto visibilities = engine.evaluate(positions);
+    const double trueMagLim = getTrueMagLim();
+
+    QVector<bool> visible(objects.size());
+    for (int i = 0; i < objects.size(); i++)
     {
-        return so->alt().Degrees() > 6.0;
+        if (objects[i]->type() == SkyObject::SATELLITE)
+            visible[i] = objects[i]->alt().Degrees() > 6.0;
+        else
+            visible[i] = visibilities[i].startAltitude > 6.0 && objects[i]->mag() < trueMagLim;
     }
-    KStarsDateTime ut = geo->LTtoUT(KStarsDateTime(QDateTime::currentDateTime().toLocalTime()));
-    SkyPoint sp       = so->recomputeCoords(ut, geo);
-
-    //check altitude of object at this time.
-    sp.EquatorialToHorizontal(lst, geo->lat());
-
-    return (sp.alt().Degrees() > 6.0 && so->mag() < getTrueMagLim());
+    return visible;
 }
 
 void ObsConditions::setObsConditions(int bortle, double aperture, ObsConditions::Equipment equip,
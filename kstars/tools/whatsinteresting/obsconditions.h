@@ -85,14 +85,14 @@ class ObsConditions
     double getTrueMagLim();
 
     /**
-     * @brief Evaluate visibility of sky-object based on current observing conditions.
+     * @brief Evaluate visibility of sky-objects based on current observing conditions.
      *
      * @param geo       Geographic location of user.
-     * @param lst       Local standard time expressed as a dms object.
-     * @param so        SkyObject for which visibility is to be evaluated.
-     * @return Visibility of sky-object based on current observing conditions as a boolean.
+     * @param ut        Universal time at which visibility is evaluated.
+     * @param objects   SkyObjects for which visibility is to be evaluated.
+     * @return Visibility of each sky-object based on current observing conditions, in the order of objects.
      */
-    bool isVisible(GeoLocation *geo, dms *lst, SkyObject *so);
+    QVector<bool> isVisible(const GeoLocation *geo, const KStarsDateTime &ut, const QList<SkyObject *> &objects);
 
     /**
      * @brief Create QMap<int, double> to be initialised to static member variable m_LMMap